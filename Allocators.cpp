@@ -0,0 +1,200 @@
+#include "Allocators.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+
+std::vector<FixedPool*> FixedPool::pools;
+std::vector<Arena*> Arena::arenas;
+
+///////////////////////////////////////////////////////////////////////////////
+// ------ FIXED POOL ----------------------------------------------------------
+///////////////////////////////////////////////////////////////////////////////
+
+FixedPool::FixedPool(const char* name, size_t blockSize, size_t blockAlign, size_t blocksPerChunk) :
+	name(name),
+	blockAlign(blockAlign < alignof(FreeBlock) ? alignof(FreeBlock) : blockAlign),
+	blocksPerChunk(blocksPerChunk),
+	freeList(nullptr),
+	allocations(0),
+	frees(0),
+	peak(0)
+{
+	// Every block has to be able to hold a free list link, and
+	// stay aligned when laid out back to back
+	this->blockSize = blockSize < sizeof(FreeBlock) ? sizeof(FreeBlock) : blockSize;
+	this->blockSize = (this->blockSize + this->blockAlign - 1) / this->blockAlign * this->blockAlign;
+
+	pools.push_back(this);
+}
+
+FixedPool::~FixedPool()
+{
+	for (void* chunk : chunks)
+		::operator delete(chunk, std::align_val_t(blockAlign));
+
+	std::erase(pools, this);
+}
+
+void* FixedPool::Allocate()
+{
+	std::lock_guard<std::mutex> guard(lock);
+
+	if (!freeList)
+		AddChunk();
+
+	FreeBlock* block = freeList;
+	freeList = block->next;
+
+	allocations++;
+	peak = std::max(peak, allocations - frees);
+	return block;
+}
+
+void FixedPool::Free(void* block)
+{
+	if (!block) return;
+
+	std::lock_guard<std::mutex> guard(lock);
+
+	FreeBlock* freed = static_cast<FreeBlock*>(block);
+	freed->next = freeList;
+	freeList = freed;
+
+	frees++;
+}
+
+void FixedPool::AddChunk()
+{
+	unsigned char* chunk = static_cast<unsigned char*>(
+		::operator new(blockSize * blocksPerChunk, std::align_val_t(blockAlign)));
+	chunks.push_back(chunk);
+
+	// Thread the new blocks onto the free list, front to back
+	for (size_t i = blocksPerChunk; i > 0; i--) {
+		FreeBlock* block = reinterpret_cast<FreeBlock*>(chunk + (i - 1) * blockSize);
+		block->next = freeList;
+		freeList = block;
+	}
+}
+
+AllocatorStats FixedPool::GetStats()
+{
+	std::lock_guard<std::mutex> guard(lock);
+
+	AllocatorStats stats = {};
+	stats.name = name;
+	stats.blockSize = blockSize;
+	stats.bytesReserved = chunks.size() * blocksPerChunk * blockSize;
+	stats.bytesUsed = (allocations - frees) * blockSize;
+	stats.allocations = allocations;
+	stats.frees = frees;
+	stats.live = allocations - frees;
+	stats.peak = peak;
+	return stats;
+}
+
+const std::vector<FixedPool*>& FixedPool::All() { return pools; }
+
+///////////////////////////////////////////////////////////////////////////////
+// ------ ARENA ---------------------------------------------------------------
+///////////////////////////////////////////////////////////////////////////////
+
+Arena::Arena(const char* name, size_t blockSize) :
+	name(name),
+	blockSize(blockSize),
+	currentBlock(0),
+	offset(0),
+	bytesUsed(0),
+	allocations(0),
+	resets(0),
+	liveAllocations(0),
+	peak(0),
+	sharedCount(0)
+{
+	arenas.push_back(this);
+}
+
+Arena::~Arena()
+{
+	if (sharedCount != 0) {
+		printf("Arena '%s' destroyed with %zu MakeInArena objects still alive\n", name, (size_t)sharedCount);
+		assert(!"Arena destroyed while MakeInArena objects still point into it");
+	}
+
+	for (Block& block : blocks)
+		::operator delete(block.memory);
+
+	std::erase(arenas, this);
+}
+
+void* Arena::Allocate(size_t size, size_t align)
+{
+	// Try to fit into the current block
+	if (currentBlock < blocks.size()) {
+		Block& block = blocks[currentBlock];
+		size_t aligned = (reinterpret_cast<size_t>(block.memory) + offset + align - 1) & ~(align - 1);
+		size_t start = aligned - reinterpret_cast<size_t>(block.memory);
+		if (start + size <= block.size) {
+			offset = start + size;
+			bytesUsed += size;
+			allocations++;
+			liveAllocations++;
+			peak = std::max(peak, liveAllocations);
+			return block.memory + start;
+		}
+
+		currentBlock++;
+	}
+
+	// Reuse the next block from before the last Reset() if it's big
+	// enough, otherwise slot a new one in right here
+	size_t needed = size + align;
+	if (currentBlock >= blocks.size() || blocks[currentBlock].size < needed) {
+		Block block;
+		block.size = std::max(blockSize, needed);
+		block.memory = static_cast<unsigned char*>(::operator new(block.size));
+		blocks.insert(blocks.begin() + currentBlock, block);
+	}
+
+	offset = 0;
+	return Allocate(size, align);
+}
+
+void Arena::Reset()
+{
+	//rewinding under a live shared_ptr would hand its memory to the next allocation
+	if (sharedCount != 0) {
+		printf("Arena '%s' reset with %zu MakeInArena objects still alive\n", name, (size_t)sharedCount);
+		assert(!"Arena::Reset() while MakeInArena objects still point into it");
+	}
+
+	currentBlock = 0;
+	offset = 0;
+	bytesUsed = 0;
+	liveAllocations = 0;
+	resets++;
+}
+
+void Arena::RetainShared() { sharedCount++; }
+
+void Arena::ReleaseShared() { sharedCount--; }
+
+size_t Arena::GetSharedCount() { return sharedCount; }
+
+AllocatorStats Arena::GetStats()
+{
+	AllocatorStats stats = {};
+	stats.name = name;
+	stats.blockSize = 0;
+	for (Block& block : blocks)
+		stats.bytesReserved += block.size;
+	stats.bytesUsed = bytesUsed;
+	stats.allocations = allocations;
+	stats.frees = resets;
+	stats.live = liveAllocations;
+	stats.peak = peak;
+	return stats;
+}
+
+const std::vector<Arena*>& Arena::All() { return arenas; }
@@ -0,0 +1,226 @@
+#pragma once
+
+//C++
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <new>
+#include <typeinfo>
+#include <type_traits>
+#include <utility>
+
+// --------------------------------------------------------
+// Counters shared by every allocator, shown in the UI
+// --------------------------------------------------------
+struct AllocatorStats
+{
+	const char* name;
+	size_t blockSize;		// Size of one pooled block (0 for arenas)
+	size_t bytesReserved;	// Memory grabbed from the OS
+	size_t bytesUsed;		// Memory currently handed out
+	size_t allocations;		// Total allocations since creation
+	size_t frees;			// Total frees (or resets, for arenas)
+	size_t live;			// Allocations still outstanding
+	size_t peak;			// Highest "live" seen
+};
+
+// --------------------------------------------------------
+// Fixed-size block pool
+//  - Memory comes in chunks of blocksPerChunk blocks
+//  - Freed blocks go on an intrusive free list and are
+//    handed back out before a new chunk is made
+// --------------------------------------------------------
+class FixedPool
+{
+public:
+	FixedPool(const char* name, size_t blockSize, size_t blockAlign, size_t blocksPerChunk = 256);
+	~FixedPool();
+	FixedPool(const FixedPool&) = delete;
+	FixedPool& operator=(const FixedPool&) = delete;
+
+	void* Allocate();
+	void Free(void* block);
+
+	AllocatorStats GetStats();
+
+	// Every pool that currently exists
+	static const std::vector<FixedPool*>& All();
+
+private:
+	struct FreeBlock { FreeBlock* next; };
+
+	void AddChunk();
+
+	const char* name;
+	size_t blockSize;
+	size_t blockAlign;
+	size_t blocksPerChunk;
+
+	std::vector<void*> chunks;
+	FreeBlock* freeList;
+
+	size_t allocations;
+	size_t frees;
+	size_t peak;
+
+	std::mutex lock;
+
+	static std::vector<FixedPool*> pools;
+};
+
+// --------------------------------------------------------
+// Linear (bump) allocator for things that all die together
+//  - Individual frees do nothing
+//  - Reset() drops everything at once by rewinding the
+//    offset; the memory is kept for the next level
+//  - Objects from MakeInArena still run their destructors
+//    when their last shared_ptr goes, so they're counted,
+//    and Reset() with any still alive is an error
+// --------------------------------------------------------
+class Arena
+{
+public:
+	Arena(const char* name, size_t blockSize = 64 * 1024);
+	~Arena();
+	Arena(const Arena&) = delete;
+	Arena& operator=(const Arena&) = delete;
+
+	void* Allocate(size_t size, size_t align);
+	void Reset();
+
+	// Called by ArenaAllocator as shared_ptr allocations come and go
+	void RetainShared();
+	void ReleaseShared();
+	size_t GetSharedCount();
+
+	// Only for types that don't need their destructor run
+	template<typename T, typename... Args>
+	T* New(Args&&... args)
+	{
+		static_assert(std::is_trivially_destructible_v<T>, "Arena::New() never runs destructors");
+		return new (Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+	}
+
+	AllocatorStats GetStats();
+
+	// Every arena that currently exists
+	static const std::vector<Arena*>& All();
+
+private:
+	struct Block
+	{
+		unsigned char* memory;
+		size_t size;
+	};
+
+	const char* name;
+	size_t blockSize;
+
+	std::vector<Block> blocks;
+	size_t currentBlock;
+	size_t offset;
+
+	size_t bytesUsed;
+	size_t allocations;
+	size_t resets;
+	size_t liveAllocations;
+	size_t peak;
+
+	// MakeInArena objects not yet destroyed (released from any thread)
+	std::atomic<size_t> sharedCount;
+
+	static std::vector<Arena*> arenas;
+};
+
+// --------------------------------------------------------
+// One pool per (tag, size, alignment), created on first use
+// --------------------------------------------------------
+template<typename Tag, size_t Size, size_t Align>
+FixedPool& PoolFor()
+{
+	static FixedPool pool(typeid(Tag).name(), Size, Align);
+	return pool;
+}
+
+// --------------------------------------------------------
+// STL allocator backed by a FixedPool
+//  - Tag keeps the pool named after the type being created,
+//    even when allocate_shared rebinds to its control block
+// --------------------------------------------------------
+template<typename T, typename Tag = T>
+struct PoolAllocator
+{
+	typedef T value_type;
+
+	template<typename U>
+	struct rebind { typedef PoolAllocator<U, Tag> other; };
+
+	PoolAllocator() = default;
+	template<typename U>
+	PoolAllocator(const PoolAllocator<U, Tag>&) {}
+
+	T* allocate(size_t n)
+	{
+		// Pools only hand out single objects
+		if (n != 1) return static_cast<T*>(::operator new(n * sizeof(T)));
+		return static_cast<T*>(PoolFor<Tag, sizeof(T), alignof(T)>().Allocate());
+	}
+
+	void deallocate(T* p, size_t n)
+	{
+		if (n != 1) { ::operator delete(p); return; }
+		PoolFor<Tag, sizeof(T), alignof(T)>().Free(p);
+	}
+
+	template<typename U>
+	bool operator==(const PoolAllocator<U, Tag>&) const { return true; }
+	template<typename U>
+	bool operator!=(const PoolAllocator<U, Tag>&) const { return false; }
+};
+
+// --------------------------------------------------------
+// STL allocator backed by an Arena - deallocate gives no
+// memory back (that happens when the arena is Reset()), it
+// only tells the arena the allocation is dead
+// --------------------------------------------------------
+template<typename T>
+struct ArenaAllocator
+{
+	typedef T value_type;
+
+	Arena* arena;
+
+	ArenaAllocator(Arena* arena) : arena(arena) {}
+	template<typename U>
+	ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) {}
+
+	T* allocate(size_t n)
+	{
+		T* memory = static_cast<T*>(arena->Allocate(n * sizeof(T), alignof(T)));
+		arena->RetainShared();
+		return memory;
+	}
+
+	void deallocate(T*, size_t) { arena->ReleaseShared(); }
+
+	template<typename U>
+	bool operator==(const ArenaAllocator<U>& other) const { return arena == other.arena; }
+	template<typename U>
+	bool operator!=(const ArenaAllocator<U>& other) const { return arena != other.arena; }
+};
+
+// shared_ptr whose object and control block come from T's pool
+template<typename T, typename... Args>
+std::shared_ptr<T> MakePooled(Args&&... args)
+{
+	return std::allocate_shared<T>(PoolAllocator<T>(), std::forward<Args>(args)...);
+}
+
+// shared_ptr whose object and control block live in an arena
+//  - Every one must be gone before the arena is Reset()
+template<typename T, typename... Args>
+std::shared_ptr<T> MakeInArena(Arena& arena, Args&&... args)
+{
+	return std::allocate_shared<T>(ArenaAllocator<T>(&arena), std::forward<Args>(args)...);
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+//C++
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+// --------------------------------------------------------
+// A run of consecutive shader slots, bound from count
+// entries of a flat table starting at first
+// --------------------------------------------------------
+struct BindingRange
+{
+	unsigned int startSlot;
+	unsigned int first;
+	unsigned int count;
+};
+
+// --------------------------------------------------------
+// Sorts (slot, resource) pairs by slot into a flat table
+// and splits it wherever the slots stop being consecutive
+// --------------------------------------------------------
+template<typename T>
+void BuildBindingRanges(std::vector<std::pair<unsigned int, T*>>& bindings, std::vector<T*>& table, std::vector<BindingRange>& ranges)
+{
+	std::sort(bindings.begin(), bindings.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+	table.clear();
+	ranges.clear();
+	for (unsigned int i = 0; i < bindings.size(); i++) {
+		if (ranges.empty() || bindings[i].first != ranges.back().startSlot + ranges.back().count)
+			ranges.push_back({ bindings[i].first, i, 0 });
+
+		table.push_back(bindings[i].second);
+		ranges.back().count++;
+	}
+}
+
+// --------------------------------------------------------
+// The same from resources keyed by name (values with a
+// Get(), like ComPtr).  slotOf(name) returns the register
+// the shader declares it at, or -1 - names the shader
+// doesn't declare are left out, so binding never has to
+// look anything up by name.
+// --------------------------------------------------------
+template<typename T, typename Map, typename SlotFunc>
+void BuildBindingTable(const Map& resources, SlotFunc slotOf, std::vector<T*>& table, std::vector<BindingRange>& ranges)
+{
+	std::vector<std::pair<unsigned int, T*>> bindings;
+	for (const auto& [name, resource] : resources) {
+		int slot = slotOf(name);
+		if (slot >= 0) bindings.push_back({ (unsigned int)slot, resource.Get() });
+	}
+	BuildBindingRanges(bindings, table, ranges);
+}
@@ -0,0 +1,252 @@
+#include "Bounds.h"
+
+#include <cfloat>
+#include <cmath>
+#include <algorithm>
+
+using namespace DirectX;
+
+AABB EmptyAABB()
+{
+	AABB box;
+	box.min = XMFLOAT3(FLT_MAX, FLT_MAX, FLT_MAX);
+	box.max = XMFLOAT3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+	return box;
+}
+
+AABB AABBUnion(const AABB& a, const AABB& b)
+{
+	AABB box;
+	box.min = XMFLOAT3(std::min(a.min.x, b.min.x), std::min(a.min.y, b.min.y), std::min(a.min.z, b.min.z));
+	box.max = XMFLOAT3(std::max(a.max.x, b.max.x), std::max(a.max.y, b.max.y), std::max(a.max.z, b.max.z));
+	return box;
+}
+
+AABB AABBExpand(const AABB& box, float margin)
+{
+	AABB result;
+	result.min = XMFLOAT3(box.min.x - margin, box.min.y - margin, box.min.z - margin);
+	result.max = XMFLOAT3(box.max.x + margin, box.max.y + margin, box.max.z + margin);
+	return result;
+}
+
+// --------------------------------------------------------
+// Transforms a local box by a world matrix and returns the
+// box around the result (Arvo's method - transform the
+// center, then project the extents onto each world axis)
+// --------------------------------------------------------
+AABB AABBTransform(const AABB& local, const DirectX::XMFLOAT4X4& world)
+{
+	float c[3] = { (local.min.x + local.max.x) * 0.5f, (local.min.y + local.max.y) * 0.5f, (local.min.z + local.max.z) * 0.5f };
+	float e[3] = { (local.max.x - local.min.x) * 0.5f, (local.max.y - local.min.y) * 0.5f, (local.max.z - local.min.z) * 0.5f };
+
+	float newC[3];
+	float newE[3];
+	for (int j = 0; j < 3; j++) {
+		newC[j] = world.m[3][j];
+		newE[j] = 0.0f;
+		for (int i = 0; i < 3; i++) {
+			newC[j] += c[i] * world.m[i][j];
+			newE[j] += e[i] * fabsf(world.m[i][j]);
+		}
+	}
+
+	AABB box;
+	box.min = XMFLOAT3(newC[0] - newE[0], newC[1] - newE[1], newC[2] - newE[2]);
+	box.max = XMFLOAT3(newC[0] + newE[0], newC[1] + newE[1], newC[2] + newE[2]);
+	return box;
+}
+
+void AABBGrow(AABB& box, const DirectX::XMFLOAT3& point)
+{
+	box.min = XMFLOAT3(std::min(box.min.x, point.x), std::min(box.min.y, point.y), std::min(box.min.z, point.z));
+	box.max = XMFLOAT3(std::max(box.max.x, point.x), std::max(box.max.y, point.y), std::max(box.max.z, point.z));
+}
+
+bool AABBContains(const AABB& outer, const AABB& inner)
+{
+	return
+		outer.min.x <= inner.min.x && outer.min.y <= inner.min.y && outer.min.z <= inner.min.z &&
+		outer.max.x >= inner.max.x && outer.max.y >= inner.max.y && outer.max.z >= inner.max.z;
+}
+
+bool AABBOverlaps(const AABB& a, const AABB& b)
+{
+	return
+		a.min.x <= b.max.x && a.max.x >= b.min.x &&
+		a.min.y <= b.max.y && a.max.y >= b.min.y &&
+		a.min.z <= b.max.z && a.max.z >= b.min.z;
+}
+
+float AABBSurfaceArea(const AABB& box)
+{
+	float dx = box.max.x - box.min.x;
+	float dy = box.max.y - box.min.y;
+	float dz = box.max.z - box.min.z;
+	return 2.0f * (dx * dy + dy * dz + dz * dx);
+}
+
+DirectX::XMFLOAT3 AABBCenter(const AABB& box)
+{
+	return XMFLOAT3((box.min.x + box.max.x) * 0.5f, (box.min.y + box.max.y) * 0.5f, (box.min.z + box.max.z) * 0.5f);
+}
+
+DirectX::XMFLOAT3 AABBExtents(const AABB& box)
+{
+	return XMFLOAT3((box.max.x - box.min.x) * 0.5f, (box.max.y - box.min.y) * 0.5f, (box.max.z - box.min.z) * 0.5f);
+}
+
+float AABBScreenRadius(const AABB& box, const DirectX::XMFLOAT3& eye, float pixelsPerUnit, bool perspective)
+{
+	XMFLOAT3 center = AABBCenter(box);
+	XMFLOAT3 extents = AABBExtents(box);
+	float radius = sqrtf(extents.x * extents.x + extents.y * extents.y + extents.z * extents.z);
+
+	if (!perspective)
+		return radius * pixelsPerUnit;
+
+	float dx = center.x - eye.x;
+	float dy = center.y - eye.y;
+	float dz = center.z - eye.z;
+	float distance = sqrtf(dx * dx + dy * dy + dz * dz);
+	if (distance <= radius)
+		return FLT_MAX;
+
+	return radius * pixelsPerUnit / distance;
+}
+
+// --------------------------------------------------------
+// Slab test - clips the ray against each pair of axis planes
+// --------------------------------------------------------
+bool RayIntersectsAABB(const Ray& ray, const AABB& box, float maxT, float* tHit)
+{
+	const float o[3] = { ray.origin.x, ray.origin.y, ray.origin.z };
+	const float d[3] = { ray.direction.x, ray.direction.y, ray.direction.z };
+	const float bmin[3] = { box.min.x, box.min.y, box.min.z };
+	const float bmax[3] = { box.max.x, box.max.y, box.max.z };
+
+	float tMin = 0.0f;
+	float tMax = maxT;
+	for (int i = 0; i < 3; i++) {
+		if (fabsf(d[i]) < 1e-8f) {
+			//parallel to this slab - either always inside it or never
+			if (o[i] < bmin[i] || o[i] > bmax[i])
+				return false;
+			continue;
+		}
+
+		float inv = 1.0f / d[i];
+		float t0 = (bmin[i] - o[i]) * inv;
+		float t1 = (bmax[i] - o[i]) * inv;
+		if (t0 > t1) std::swap(t0, t1);
+
+		tMin = std::max(tMin, t0);
+		tMax = std::min(tMax, t1);
+		if (tMin > tMax)
+			return false;
+	}
+
+	if (tHit) *tHit = tMin;
+	return true;
+}
+
+// --------------------------------------------------------
+// Moller-Trumbore, hitting either side of the triangle.
+// t is in units of the ray's direction, so an unnormalized
+// direction still gives comparable distances.
+// --------------------------------------------------------
+bool RayIntersectsTriangle(const Ray& ray, const DirectX::XMFLOAT3& v0, const DirectX::XMFLOAT3& v1, const DirectX::XMFLOAT3& v2, float maxT, float* tHit)
+{
+	XMFLOAT3 e1(v1.x - v0.x, v1.y - v0.y, v1.z - v0.z);
+	XMFLOAT3 e2(v2.x - v0.x, v2.y - v0.y, v2.z - v0.z);
+	const XMFLOAT3& d = ray.direction;
+
+	//p = d x e2
+	XMFLOAT3 p(d.y * e2.z - d.z * e2.y, d.z * e2.x - d.x * e2.z, d.x * e2.y - d.y * e2.x);
+	float det = e1.x * p.x + e1.y * p.y + e1.z * p.z;
+	if (fabsf(det) < 1e-12f)
+		return false;
+
+	float invDet = 1.0f / det;
+	XMFLOAT3 s(ray.origin.x - v0.x, ray.origin.y - v0.y, ray.origin.z - v0.z);
+	float u = (s.x * p.x + s.y * p.y + s.z * p.z) * invDet;
+	if (u < 0.0f || u > 1.0f)
+		return false;
+
+	//q = s x e1
+	XMFLOAT3 q(s.y * e1.z - s.z * e1.y, s.z * e1.x - s.x * e1.z, s.x * e1.y - s.y * e1.x);
+	float v = (d.x * q.x + d.y * q.y + d.z * q.z) * invDet;
+	if (v < 0.0f || u + v > 1.0f)
+		return false;
+
+	float t = (e2.x * q.x + e2.y * q.y + e2.z * q.z) * invDet;
+	if (t < 0.0f || t > maxT)
+		return false;
+
+	if (tHit) *tHit = t;
+	return true;
+}
+
+// --------------------------------------------------------
+// Pulls the six clip planes straight out of a combined
+// view * projection matrix (Gribb & Hartmann).  Works in
+// D3D's row-vector convention with clip z in [0, w].
+// --------------------------------------------------------
+Frustum FrustumFromMatrix(const DirectX::XMFLOAT4X4& m)
+{
+	Frustum frustum;
+	frustum.planes[0] = XMFLOAT4(m._14 + m._11, m._24 + m._21, m._34 + m._31, m._44 + m._41); // Left
+	frustum.planes[1] = XMFLOAT4(m._14 - m._11, m._24 - m._21, m._34 - m._31, m._44 - m._41); // Right
+	frustum.planes[2] = XMFLOAT4(m._14 + m._12, m._24 + m._22, m._34 + m._32, m._44 + m._42); // Bottom
+	frustum.planes[3] = XMFLOAT4(m._14 - m._12, m._24 - m._22, m._34 - m._32, m._44 - m._42); // Top
+	frustum.planes[4] = XMFLOAT4(m._13, m._23, m._33, m._43);                                 // Near
+	frustum.planes[5] = XMFLOAT4(m._14 - m._13, m._24 - m._23, m._34 - m._33, m._44 - m._43); // Far
+
+	//normalize so plane distances are real world-space distances
+	for (int i = 0; i < 6; i++) {
+		XMFLOAT4& p = frustum.planes[i];
+		float length = sqrtf(p.x * p.x + p.y * p.y + p.z * p.z);
+		if (length > 0.0f) {
+			p.x /= length;
+			p.y /= length;
+			p.z /= length;
+			p.w /= length;
+		}
+	}
+
+	return frustum;
+}
+
+Frustum FrustumInflate(const Frustum& frustum, float distance)
+{
+	Frustum inflated = frustum;
+	for (int i = 0; i < 6; i++)
+		inflated.planes[i].w += distance;
+	return inflated;
+}
+
+// --------------------------------------------------------
+// Tests the box's "positive" and "negative" corners against
+// each plane - if the most-inside corner is outside any plane
+// the box is out, if the least-inside corner is inside every
+// plane the box is fully in
+// --------------------------------------------------------
+CullResult FrustumTestAABB(const Frustum& frustum, const AABB& box)
+{
+	XMFLOAT3 c = AABBCenter(box);
+	XMFLOAT3 e = AABBExtents(box);
+
+	CullResult result = CullResult::Inside;
+	for (int i = 0; i < 6; i++) {
+		const XMFLOAT4& p = frustum.planes[i];
+		float distance = p.x * c.x + p.y * c.y + p.z * c.z + p.w;
+		float radius = fabsf(p.x) * e.x + fabsf(p.y) * e.y + fabsf(p.z) * e.z;
+
+		if (distance < -radius)
+			return CullResult::Outside;
+		if (distance < radius)
+			result = CullResult::Intersecting;
+	}
+
+	return result;
+}
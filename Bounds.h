@@ -0,0 +1,71 @@
+#pragma once
+
+//DirectX
+#include <DirectXMath.h>
+
+// --------------------------------------------------------
+// Axis-aligned bounding box
+// --------------------------------------------------------
+struct AABB
+{
+	DirectX::XMFLOAT3 min;
+	DirectX::XMFLOAT3 max;
+};
+
+// --------------------------------------------------------
+// Ray with an (ideally normalized) direction
+// --------------------------------------------------------
+struct Ray
+{
+	DirectX::XMFLOAT3 origin;
+	DirectX::XMFLOAT3 direction;
+};
+
+// --------------------------------------------------------
+// Six planes (left, right, bottom, top, near, far) stored
+// as (a, b, c, d) with normals pointing INTO the frustum,
+// so a point p is inside a plane when dot(n, p) + d >= 0
+// --------------------------------------------------------
+struct Frustum
+{
+	DirectX::XMFLOAT4 planes[6];
+};
+
+enum class CullResult
+{
+	Outside,
+	Intersecting,
+	Inside
+};
+
+//AABB helpers
+AABB EmptyAABB();
+AABB AABBUnion(const AABB& a, const AABB& b);
+AABB AABBExpand(const AABB& box, float margin);
+AABB AABBTransform(const AABB& local, const DirectX::XMFLOAT4X4& world);
+void AABBGrow(AABB& box, const DirectX::XMFLOAT3& point);
+bool AABBContains(const AABB& outer, const AABB& inner);
+bool AABBOverlaps(const AABB& a, const AABB& b);
+float AABBSurfaceArea(const AABB& box);
+DirectX::XMFLOAT3 AABBCenter(const AABB& box);
+DirectX::XMFLOAT3 AABBExtents(const AABB& box);
+
+// --------------------------------------------------------
+// Radius in pixels of the sphere around a box, as seen from
+// eye.  pixelsPerUnit comes from Camera::GetPixelsPerUnit:
+// perspective cameras divide it by the distance, while
+// orthographic ones draw a unit the same size anywhere.
+// An eye inside the sphere gets FLT_MAX.
+// --------------------------------------------------------
+float AABBScreenRadius(const AABB& box, const DirectX::XMFLOAT3& eye, float pixelsPerUnit, bool perspective);
+
+//Ray helpers - tHit is the distance along the ray to the entry point
+bool RayIntersectsAABB(const Ray& ray, const AABB& box, float maxT, float* tHit);
+bool RayIntersectsTriangle(const Ray& ray, const DirectX::XMFLOAT3& v0, const DirectX::XMFLOAT3& v1, const DirectX::XMFLOAT3& v2, float maxT, float* tHit);
+
+//Frustum helpers
+Frustum FrustumFromMatrix(const DirectX::XMFLOAT4X4& viewProjection);
+CullResult FrustumTestAABB(const Frustum& frustum, const AABB& box);
+
+//Pushes every (normalized) plane outward by distance
+Frustum FrustumInflate(const Frustum& frustum, float distance);
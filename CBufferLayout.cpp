@@ -0,0 +1,106 @@
+#include "CBufferLayout.h"
+
+//C++
+#include <sstream>
+
+static void AddError(std::string* error, const std::string& message)
+{
+	if (error) *error += message + "\n";
+}
+
+static const CBufferField* FindField(const CBufferLayout& layout, const std::string& name)
+{
+	for (const CBufferField& field : layout.fields) {
+		if (field.name == name)
+			return &field;
+	}
+	return nullptr;
+}
+
+bool ValidateCBufferLayout(const CBufferLayout& cpu, const CBufferLayout& reflected, std::string* error)
+{
+	bool valid = true;
+	std::string prefix = "cbuffer " + reflected.name + ": ";
+
+	//HLSL packing rules, checked on the C++ side alone
+	for (const CBufferField& field : cpu.fields) {
+		bool straddles = field.size < 16 ?
+			(field.offset % 16) + field.size > 16 :
+			field.offset % 16 != 0;
+
+		if (straddles) {
+			AddError(error, prefix + "'" + field.name + "' at offset " + std::to_string(field.offset) +
+				" (size " + std::to_string(field.size) + ") breaks 16-byte register packing");
+			valid = false;
+		}
+	}
+
+	unsigned int roundedSize = (cpu.size + 15) / 16 * 16;
+	if (roundedSize != reflected.size) {
+		AddError(error, prefix + "C++ size " + std::to_string(cpu.size) + " (" + std::to_string(roundedSize) +
+			" padded) doesn't match shader size " + std::to_string(reflected.size));
+		valid = false;
+	}
+
+	for (const CBufferField& var : reflected.fields) {
+		const CBufferField* field = FindField(cpu, var.name);
+		if (!field) {
+			AddError(error, prefix + "shader variable '" + var.name + "' has no C++ field");
+			valid = false;
+		}
+		else if (field->offset != var.offset || field->size != var.size) {
+			AddError(error, prefix + "'" + var.name + "' is at " + std::to_string(field->offset) + " (size " + std::to_string(field->size) +
+				") in C++ but " + std::to_string(var.offset) + " (size " + std::to_string(var.size) + ") in the shader");
+			valid = false;
+		}
+	}
+
+	for (const CBufferField& field : cpu.fields) {
+		if (!FindField(reflected, field.name)) {
+			AddError(error, prefix + "C++ field '" + field.name + "' isn't in the shader");
+			valid = false;
+		}
+	}
+
+	return valid;
+}
+
+std::string SerializeCBufferLayout(const CBufferLayout& layout)
+{
+	std::ostringstream out;
+	out << "cbuffer " << layout.name << " " << layout.size << "\n";
+	for (const CBufferField& field : layout.fields)
+		out << field.name << " " << field.offset << " " << field.size << "\n";
+	return out.str();
+}
+
+bool ParseCBufferLayout(const std::string& text, CBufferLayout* layout)
+{
+	std::istringstream in(text);
+	std::string line;
+	std::string keyword;
+	std::string extra;
+	CBufferLayout parsed;
+
+	if (!std::getline(in, line))
+		return false;
+
+	std::istringstream header(line);
+	if (!(header >> keyword >> parsed.name >> parsed.size) || keyword != "cbuffer" || header >> extra)
+		return false;
+
+	//one field per line, exactly three values each (blank lines are skipped)
+	while (std::getline(in, line)) {
+		if (line.find_first_not_of(" \t\r") == std::string::npos)
+			continue;
+
+		std::istringstream fieldLine(line);
+		CBufferField field;
+		if (!(fieldLine >> field.name >> field.offset >> field.size) || fieldLine >> extra)
+			return false;
+		parsed.fields.push_back(field);
+	}
+
+	*layout = parsed;
+	return true;
+}
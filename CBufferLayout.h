@@ -0,0 +1,55 @@
+#pragma once
+
+//C++
+#include <string>
+#include <vector>
+#include <cstddef>
+
+// --------------------------------------------------------
+// One variable in a constant buffer: where it starts and
+// how many bytes it covers
+// --------------------------------------------------------
+struct CBufferField
+{
+	std::string name;
+	unsigned int offset;
+	unsigned int size;
+};
+
+// --------------------------------------------------------
+// A constant buffer's layout - either described from a C++
+// struct (see CBUFFER_FIELD) or read back from shader
+// reflection (see ISimpleShader::GetBufferLayout)
+// --------------------------------------------------------
+struct CBufferLayout
+{
+	std::string name;
+	unsigned int size = 0;
+	std::vector<CBufferField> fields;
+};
+
+//Describes one member of a C++ struct that mirrors a cbuffer
+#define CBUFFER_FIELD(Struct, member) CBufferField{ #member, (unsigned int)offsetof(Struct, member), (unsigned int)sizeof(Struct::member) }
+
+// --------------------------------------------------------
+// Checks a C++ layout against a reflected one:
+//  - the C++ fields follow HLSL packing (nothing under 16
+//    bytes crosses a 16-byte register, anything bigger
+//    starts on one)
+//  - every reflected variable has a C++ field with the same
+//    name, offset and size, and vice versa
+//  - the struct rounds up to the reflected buffer size
+// Problems are appended to error (one per line) if given.
+// --------------------------------------------------------
+bool ValidateCBufferLayout(const CBufferLayout& cpu, const CBufferLayout& reflected, std::string* error);
+
+// --------------------------------------------------------
+// Plain-text form of a layout, so reflection data can be
+// dumped once and checked without a device:
+//
+//   cbuffer perObject 128
+//   world 0 64
+//   worldInvTranspose 64 64
+// --------------------------------------------------------
+std::string SerializeCBufferLayout(const CBufferLayout& layout);
+bool ParseCBufferLayout(const std::string& text, CBufferLayout* layout);
@@ -6,10 +6,14 @@ Camera::Camera(DirectX::XMFLOAT3 pos, float moveSpeed, float lookSpeed, float fo
     moveSpeed(moveSpeed),
     mouseLookSpeed(lookSpeed),
     fov(fov),
-    aspectRatio(aspectRatio)
+    aspectRatio(aspectRatio),
+    nearClipDistance(0.1f),
+    farClipDistance(1000.0f),
+    perspective(true),
+    orthographicHeight(10.0f)
 {
     //CHANGED: just added the provided position to the transform
-    transform = std::make_shared<Transform>(pos.x, pos.y, pos.z);
+    transform = MakePooled<Transform>(pos.x, pos.y, pos.z);
 
     UpdateViewMatrix();
     UpdateProjectionMatrix(aspectRatio);
@@ -68,17 +72,84 @@ void Camera::UpdateViewMatrix()
 
 void Camera::UpdateProjectionMatrix(float aspectRatio)
 {
-    //call the dxmath function to make a perspective projection
-    XMMATRIX proj = XMMatrixPerspectiveFovLH(
-        XM_PIDIV4, //FOV angle in radians
-        aspectRatio,
-        0.1f,
-        1000.0f);
+    this->aspectRatio = aspectRatio;
+
+    //call the dxmath function to make a perspective (or orthographic) projection
+    XMMATRIX proj = perspective ?
+        XMMatrixPerspectiveFovLH(
+            fov, //FOV angle in radians
+            aspectRatio,
+            nearClipDistance,
+            farClipDistance) :
+        XMMatrixOrthographicLH(
+            orthographicHeight * aspectRatio,
+            orthographicHeight,
+            nearClipDistance,
+            farClipDistance);
     XMStoreFloat4x4(&projectionMatrix, proj);
 }
 
+void Camera::SetPerspective(bool perspective)
+{
+    this->perspective = perspective;
+    UpdateProjectionMatrix(aspectRatio);
+}
+
+void Camera::SetOrthographicHeight(float height)
+{
+    if (height <= 0.0f)
+        return;
+
+    orthographicHeight = height;
+    UpdateProjectionMatrix(aspectRatio);
+}
+
 DirectX::XMFLOAT4X4 Camera::GetView() { return viewMatrix; }
 
 DirectX::XMFLOAT4X4 Camera::GetProjection() { return projectionMatrix; }
 
-std::shared_ptr<Transform> Camera::GetTransform() { return transform; }
+DirectX::XMFLOAT4X4 Camera::GetViewProjection()
+{
+    XMFLOAT4X4 viewProj;
+    XMStoreFloat4x4(&viewProj, XMMatrixMultiply(XMLoadFloat4x4(&viewMatrix), XMLoadFloat4x4(&projectionMatrix)));
+    return viewProj;
+}
+
+Frustum Camera::GetFrustum() { return FrustumFromMatrix(GetViewProjection()); }
+
+float Camera::GetFov() { return fov; }
+
+float Camera::GetNearClip() { return nearClipDistance; }
+
+float Camera::GetFarClip() { return farClipDistance; }
+
+bool Camera::IsPerspective() { return perspective; }
+
+float Camera::GetOrthographicHeight() { return orthographicHeight; }
+
+float Camera::GetPixelsPerUnit(float screenHeight)
+{
+    if (!perspective)
+        return screenHeight / orthographicHeight;
+
+    return (screenHeight * 0.5f) / tanf(fov * 0.5f);
+}
+
+Ray Camera::GetPickRay(float screenX, float screenY, float screenWidth, float screenHeight)
+{
+    //pixel -> NDC, then back through the inverse view * projection
+    float ndcX = (screenX + 0.5f) / screenWidth * 2.0f - 1.0f;
+    float ndcY = 1.0f - (screenY + 0.5f) / screenHeight * 2.0f;
+
+    XMFLOAT4X4 viewProj = GetViewProjection();
+    XMMATRIX invViewProj = XMMatrixInverse(nullptr, XMLoadFloat4x4(&viewProj));
+    XMVECTOR nearPoint = XMVector3TransformCoord(XMVectorSet(ndcX, ndcY, 0.0f, 1.0f), invViewProj);
+    XMVECTOR farPoint = XMVector3TransformCoord(XMVectorSet(ndcX, ndcY, 1.0f, 1.0f), invViewProj);
+
+    Ray ray;
+    XMStoreFloat3(&ray.origin, nearPoint);
+    XMStoreFloat3(&ray.direction, XMVector3Normalize(farPoint - nearPoint));
+    return ray;
+}
+
+const std::shared_ptr<Transform>& Camera::GetTransform() { return transform; }
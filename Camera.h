@@ -9,6 +9,8 @@
 //Program
 #include "Transform.h"
 #include "Input.h"
+#include "Allocators.h"
+#include "Bounds.h"
 
 class Camera
 {
@@ -21,10 +23,28 @@ public:
 	void UpdateViewMatrix();
 	void UpdateProjectionMatrix(float aspectRatio);
 
+	//Switches between a perspective and an orthographic projection
+	void SetPerspective(bool perspective);
+	void SetOrthographicHeight(float height);
+
 	//Getters
 	DirectX::XMFLOAT4X4 GetView();
 	DirectX::XMFLOAT4X4 GetProjection();
-	std::shared_ptr<Transform> GetTransform();
+	DirectX::XMFLOAT4X4 GetViewProjection();
+	Frustum GetFrustum();
+	float GetFov();
+	float GetNearClip();
+	float GetFarClip();
+	bool IsPerspective();
+	float GetOrthographicHeight();
+
+	//Pixels one world unit covers on a screen this tall - at distance 1
+	//for a perspective camera, at any distance for an orthographic one
+	float GetPixelsPerUnit(float screenHeight);
+
+	//World-space ray through a pixel (origin on the near plane, normalized direction)
+	Ray GetPickRay(float screenX, float screenY, float screenWidth, float screenHeight);
+	const std::shared_ptr<Transform>& GetTransform();
 
 private:
 	DirectX::XMFLOAT4X4 viewMatrix;
@@ -39,6 +59,7 @@ private:
 	float nearClipDistance;
 	float farClipDistance;
 	bool perspective;
+	float orthographicHeight;	// World units the view spans vertically when not perspective
 
 
 
@@ -0,0 +1,195 @@
+#include "CommandBuffer.h"
+
+//C++
+#include <cstring>
+#include <algorithm>
+#include <type_traits>
+
+// --------------------------------------------------------
+// Stream layout - payloads are copied in and out with
+// memcpy, so nothing in the stream needs to be aligned.
+// No command may have implicit padding: memcpy would copy
+// its uninitialised bytes into the stream, and two
+// recordings of the same commands would differ.
+// --------------------------------------------------------
+struct CommandHeader
+{
+	uint32_t type;
+	uint32_t size;		// Header and payload, padded to 8 bytes
+};
+
+struct BindMaterialCommand
+{
+	void* material;
+	uint32_t instanced;
+	uint32_t pad = 0;	// Fills out the pointer's alignment on 64-bit
+};
+
+struct SetConstantsCommand
+{
+	void* target;
+	uint32_t slot;
+	uint32_t size;		// Followed by this many bytes of constants
+};
+
+struct DrawCommand
+{
+	void* mesh;
+};
+
+struct DrawInstancedCommand
+{
+	void* mesh;
+	uint32_t firstInstance;
+	uint32_t instanceCount;
+};
+
+static_assert(std::has_unique_object_representations_v<CommandHeader> &&
+	std::has_unique_object_representations_v<BindMaterialCommand> &&
+	std::has_unique_object_representations_v<SetConstantsCommand> &&
+	std::has_unique_object_representations_v<DrawCommand> &&
+	std::has_unique_object_representations_v<DrawInstancedCommand>, "Command structs must have no padding");
+
+unsigned int DefaultRecordingThreadCount()
+{
+	return std::max(1u, std::min(4u, std::thread::hardware_concurrency()));
+}
+
+CommandBuffer::CommandBuffer() :
+	commandCount(0)
+{
+}
+
+//keeps the allocation, so a buffer reused every frame stops allocating after the first few
+void CommandBuffer::Clear()
+{
+	data.clear();
+	commandCount = 0;
+}
+
+uint8_t* CommandBuffer::Push(uint32_t type, size_t payloadSize)
+{
+	size_t size = (sizeof(CommandHeader) + payloadSize + 7) & ~(size_t)7;
+	size_t offset = data.size();
+	data.resize(offset + size);
+
+	CommandHeader header = { type, (uint32_t)size };
+	memcpy(&data[offset], &header, sizeof(header));
+	commandCount++;
+	return &data[offset + sizeof(CommandHeader)];
+}
+
+void CommandBuffer::BindMaterial(void* material, bool instanced)
+{
+	BindMaterialCommand command = { material, instanced ? 1u : 0u };
+	memcpy(Push(RENDER_COMMAND_BIND_MATERIAL, sizeof(command)), &command, sizeof(command));
+}
+
+void CommandBuffer::SetConstants(void* target, unsigned int slot, const void* constants, unsigned int size)
+{
+	SetConstantsCommand command = { target, slot, size };
+	uint8_t* payload = Push(RENDER_COMMAND_SET_CONSTANTS, sizeof(command) + size);
+	memcpy(payload, &command, sizeof(command));
+	memcpy(payload + sizeof(command), constants, size);
+}
+
+void CommandBuffer::Draw(void* mesh)
+{
+	DrawCommand command = { mesh };
+	memcpy(Push(RENDER_COMMAND_DRAW, sizeof(command)), &command, sizeof(command));
+}
+
+void CommandBuffer::DrawInstanced(void* mesh, unsigned int firstInstance, unsigned int instanceCount)
+{
+	DrawInstancedCommand command = { mesh, firstInstance, instanceCount };
+	memcpy(Push(RENDER_COMMAND_DRAW_INSTANCED, sizeof(command)), &command, sizeof(command));
+}
+
+bool CommandBuffer::Execute(CommandBackend& backend)
+{
+	size_t offset = 0;
+	while (offset < data.size()) {
+		CommandHeader header;
+		if (data.size() - offset < sizeof(header))
+			return false;
+		memcpy(&header, &data[offset], sizeof(header));
+		if (header.size < sizeof(header) || header.size > data.size() - offset)
+			return false;
+
+		const uint8_t* payload = &data[offset + sizeof(header)];
+		size_t payloadSize = header.size - sizeof(header);
+
+		switch (header.type) {
+		case RENDER_COMMAND_BIND_MATERIAL: {
+			BindMaterialCommand command;
+			if (payloadSize < sizeof(command)) return false;
+			memcpy(&command, payload, sizeof(command));
+			backend.BindMaterial(command.material, command.instanced != 0);
+			break;
+		}
+		case RENDER_COMMAND_SET_CONSTANTS: {
+			SetConstantsCommand command;
+			if (payloadSize < sizeof(command)) return false;
+			memcpy(&command, payload, sizeof(command));
+			if (payloadSize - sizeof(command) < command.size) return false;
+			backend.SetConstants(command.target, command.slot, payload + sizeof(command), command.size);
+			break;
+		}
+		case RENDER_COMMAND_DRAW: {
+			DrawCommand command;
+			if (payloadSize < sizeof(command)) return false;
+			memcpy(&command, payload, sizeof(command));
+			backend.Draw(command.mesh);
+			break;
+		}
+		case RENDER_COMMAND_DRAW_INSTANCED: {
+			DrawInstancedCommand command;
+			if (payloadSize < sizeof(command)) return false;
+			memcpy(&command, payload, sizeof(command));
+			backend.DrawInstanced(command.mesh, command.firstInstance, command.instanceCount);
+			break;
+		}
+		default:
+			return false;
+		}
+
+		offset += header.size;
+	}
+	return true;
+}
+
+unsigned int CommandBuffer::GetCommandCount() { return commandCount; }
+
+size_t CommandBuffer::GetSize() { return data.size(); }
+
+const uint8_t* CommandBuffer::GetData() { return data.data(); }
+
+
+void NullCommandBackend::BindMaterial(void*, bool) { commands++; }
+
+void NullCommandBackend::SetConstants(void*, unsigned int, const void*, unsigned int size)
+{
+	commands++;
+	constantBytes += size;
+}
+
+void NullCommandBackend::Draw(void*)
+{
+	commands++;
+	draws++;
+}
+
+void NullCommandBackend::DrawInstanced(void*, unsigned int, unsigned int)
+{
+	commands++;
+	draws++;
+}
+
+
+void RecordingCommandBackend::BindMaterial(void* material, bool instanced) { commands.BindMaterial(material, instanced); }
+
+void RecordingCommandBackend::SetConstants(void* target, unsigned int slot, const void* data, unsigned int size) { commands.SetConstants(target, slot, data, size); }
+
+void RecordingCommandBackend::Draw(void* mesh) { commands.Draw(mesh); }
+
+void RecordingCommandBackend::DrawInstanced(void* mesh, unsigned int firstInstance, unsigned int instanceCount) { commands.DrawInstanced(mesh, firstInstance, instanceCount); }
@@ -0,0 +1,155 @@
+#pragma once
+
+//C++
+#include <vector>
+#include <cstdint>
+
+//Program
+#include "ThreadPool.h"
+
+// --------------------------------------------------------
+// Command types in a CommandBuffer's stream
+// --------------------------------------------------------
+#define RENDER_COMMAND_BIND_MATERIAL 0
+#define RENDER_COMMAND_SET_CONSTANTS 1
+#define RENDER_COMMAND_DRAW 2
+#define RENDER_COMMAND_DRAW_INSTANCED 3
+
+// --------------------------------------------------------
+// Blocks of constants a set-constants command can carry
+// (its slot) - the backend decides where each one goes
+// --------------------------------------------------------
+#define RENDER_CONSTANTS_OBJECT 0	// VSPerObject
+#define RENDER_CONSTANTS_LIGHTS 1	// PSPerObject
+
+//below this many items recording on threads costs more than it saves
+#define MIN_ITEMS_FOR_RECORDING_THREADS 256
+
+//Hardware threads, capped at 4 - a sensible size (workers plus the caller) for RecordCommandsParallel's pool
+unsigned int DefaultRecordingThreadCount();
+
+// --------------------------------------------------------
+// Whatever a CommandBuffer is replayed into.  Materials,
+// meshes and constant targets are opaque pointers here;
+// only the backend knows what they point at.
+// --------------------------------------------------------
+class CommandBackend
+{
+public:
+	virtual ~CommandBackend() {}
+
+	virtual void BindMaterial(void* material, bool instanced) = 0;
+	virtual void SetConstants(void* target, unsigned int slot, const void* data, unsigned int size) = 0;
+	virtual void Draw(void* mesh) = 0;
+	virtual void DrawInstanced(void* mesh, unsigned int firstInstance, unsigned int instanceCount) = 0;
+};
+
+// --------------------------------------------------------
+// A compact binary stream of render commands.  Recording
+// only appends bytes, so a buffer can be filled on any
+// thread without touching the graphics API - the backend
+// sees the commands when the buffer is executed, in the
+// order they were recorded.
+//
+// Each command is an 8-byte header (type and total size)
+// followed by its payload, padded to 8 bytes.
+// --------------------------------------------------------
+class CommandBuffer
+{
+public:
+	CommandBuffer();
+
+	void Clear();
+
+	void BindMaterial(void* material, bool instanced);
+	void SetConstants(void* target, unsigned int slot, const void* data, unsigned int size);
+	void Draw(void* mesh);
+	void DrawInstanced(void* mesh, unsigned int firstInstance, unsigned int instanceCount);
+
+	//Replays every command into backend; false (after the good ones) if the stream is corrupt
+	bool Execute(CommandBackend& backend);
+
+	unsigned int GetCommandCount();
+	size_t GetSize();
+	const uint8_t* GetData();
+
+private:
+	//Appends a header and room for payloadSize bytes, returns the payload
+	uint8_t* Push(uint32_t type, size_t payloadSize);
+
+	std::vector<uint8_t> data;
+	unsigned int commandCount;
+};
+
+// --------------------------------------------------------
+// Backend that throws commands away, for timing recording
+// and replay on their own
+// --------------------------------------------------------
+class NullCommandBackend : public CommandBackend
+{
+public:
+	void BindMaterial(void* material, bool instanced);
+	void SetConstants(void* target, unsigned int slot, const void* data, unsigned int size);
+	void Draw(void* mesh);
+	void DrawInstanced(void* mesh, unsigned int firstInstance, unsigned int instanceCount);
+
+	unsigned int commands = 0;
+	unsigned int draws = 0;
+	unsigned int constantBytes = 0;
+};
+
+// --------------------------------------------------------
+// Backend that records whatever it's given into another
+// CommandBuffer, so a replay can be compared byte for byte
+// with a reference recording
+// --------------------------------------------------------
+class RecordingCommandBackend : public CommandBackend
+{
+public:
+	void BindMaterial(void* material, bool instanced);
+	void SetConstants(void* target, unsigned int slot, const void* data, unsigned int size);
+	void Draw(void* mesh);
+	void DrawInstanced(void* mesh, unsigned int firstInstance, unsigned int instanceCount);
+
+	CommandBuffer commands;
+};
+
+// --------------------------------------------------------
+// Splits count items into one contiguous slice per thread
+// of pool (its workers and the caller) and records each
+// slice as one of the pool's tasks:
+//
+//   record(commandBuffer, slice, begin, end)
+//
+// Executing buffers[0], buffers[1], ... afterwards replays
+// everything in item order.  Below
+// MIN_ITEMS_FOR_RECORDING_THREADS, or without a pool, it
+// all goes into buffers[0] on the calling thread.
+// Returns the number of buffers filled.
+// --------------------------------------------------------
+template<typename RecordFunction>
+unsigned int RecordCommandsParallel(std::vector<CommandBuffer>& buffers, unsigned int count, ThreadPool* pool, RecordFunction record)
+{
+	//(no std::min/max - this header ends up next to windows.h)
+	unsigned int threadCount = pool ? pool->GetWorkerCount() + 1 : 1;
+	unsigned int slices = threadCount < count ? threadCount : count;
+	if (slices == 0 || count < MIN_ITEMS_FOR_RECORDING_THREADS)
+		slices = 1;
+	if (buffers.size() < slices)
+		buffers.resize(slices);
+
+	for (unsigned int s = 0; s < slices; s++)
+		buffers[s].Clear();
+
+	if (slices == 1) {
+		record(buffers[0], 0u, 0u, count);
+		return 1;
+	}
+
+	pool->Run(slices, [&](unsigned int s) {
+		unsigned int begin = (unsigned int)((uint64_t)count * s / slices);
+		unsigned int end = (unsigned int)((uint64_t)count * (s + 1) / slices);
+		record(buffers[s], s, begin, end);
+	});
+	return slices;
+}
@@ -0,0 +1,183 @@
+#pragma once
+
+//C++
+#include <vector>
+#include <memory>
+
+// --------------------------------------------------------
+// Entities are just IDs - all of their data lives in
+// tightly packed component pools (one per component type)
+// --------------------------------------------------------
+typedef unsigned int EntityID;
+const EntityID INVALID_ENTITY = 0xFFFFFFFF;
+
+// --------------------------------------------------------
+// Type-erased base so the store can hold pools of any type
+// --------------------------------------------------------
+class IComponentPool
+{
+public:
+	virtual ~IComponentPool() {}
+	virtual void Remove(EntityID id) = 0;
+	virtual bool Has(EntityID id) = 0;
+};
+
+// --------------------------------------------------------
+// Sparse set of one component type
+//  - "dense" holds the components back to back for iteration
+//  - "sparse" maps an entity ID to its slot in "dense"
+// --------------------------------------------------------
+template<typename T>
+class ComponentPool : public IComponentPool
+{
+public:
+	T& Add(EntityID id, const T& component)
+	{
+		if (Has(id)) {
+			dense[sparse[id]] = component;
+			return dense[sparse[id]];
+		}
+
+		if (id >= sparse.size())
+			sparse.resize(id + 1, INVALID_ENTITY);
+
+		sparse[id] = (unsigned int)dense.size();
+		dense.push_back(component);
+		denseEntities.push_back(id);
+		return dense.back();
+	}
+
+	void Remove(EntityID id)
+	{
+		if (!Has(id)) return;
+
+		//swap the last component into the hole so the array stays packed
+		unsigned int slot = sparse[id];
+		unsigned int last = (unsigned int)dense.size() - 1;
+		if (slot != last) {
+			dense[slot] = dense[last];
+			denseEntities[slot] = denseEntities[last];
+			sparse[denseEntities[slot]] = slot;
+		}
+
+		dense.pop_back();
+		denseEntities.pop_back();
+		sparse[id] = INVALID_ENTITY;
+	}
+
+	bool Has(EntityID id)
+	{
+		return id < sparse.size() && sparse[id] != INVALID_ENTITY;
+	}
+
+	T* Get(EntityID id)
+	{
+		return Has(id) ? &dense[sparse[id]] : nullptr;
+	}
+
+	size_t Size() { return dense.size(); }
+	T* Data() { return dense.data(); }
+	EntityID* Entities() { return denseEntities.data(); }
+	std::vector<T>& GetComponents() { return dense; }
+
+private:
+	std::vector<T> dense;
+	std::vector<EntityID> denseEntities;
+	std::vector<unsigned int> sparse;
+};
+
+// --------------------------------------------------------
+// Owns the entity IDs and one pool per component type
+// --------------------------------------------------------
+class ComponentStore
+{
+public:
+	EntityID CreateEntity()
+	{
+		if (!freeIDs.empty()) {
+			EntityID id = freeIDs.back();
+			freeIDs.pop_back();
+			return id;
+		}
+		return nextID++;
+	}
+
+	void DestroyEntity(EntityID id)
+	{
+		for (auto& pool : pools) {
+			if (pool) pool->Remove(id);
+		}
+		freeIDs.push_back(id);
+	}
+
+	template<typename T>
+	T& Add(EntityID id, const T& component) { return Pool<T>().Add(id, component); }
+
+	template<typename T>
+	void Remove(EntityID id) { Pool<T>().Remove(id); }
+
+	template<typename T>
+	bool Has(EntityID id) { return Pool<T>().Has(id); }
+
+	template<typename T>
+	T* Get(EntityID id) { return Pool<T>().Get(id); }
+
+	template<typename T>
+	ComponentPool<T>& Pool()
+	{
+		unsigned int index = TypeIndex<T>();
+		if (index >= pools.size())
+			pools.resize(index + 1);
+		if (!pools[index])
+			pools[index] = std::make_unique<ComponentPool<T>>();
+
+		return *static_cast<ComponentPool<T>*>(pools[index].get());
+	}
+
+	// --------------------------------------------------------
+	// Calls func(id, a) for every entity with an A, walking A's
+	// packed array front to back
+	// --------------------------------------------------------
+	template<typename A, typename Func>
+	void Each(Func func)
+	{
+		ComponentPool<A>& pool = Pool<A>();
+		A* data = pool.Data();
+		EntityID* ids = pool.Entities();
+		for (size_t i = 0; i < pool.Size(); i++)
+			func(ids[i], data[i]);
+	}
+
+	// --------------------------------------------------------
+	// Calls func(id, a, b) for every entity with both an A and
+	// a B, walking A's packed array and looking up B
+	//  - Put the rarer component first
+	// --------------------------------------------------------
+	template<typename A, typename B, typename Func>
+	void Each(Func func)
+	{
+		ComponentPool<A>& poolA = Pool<A>();
+		ComponentPool<B>& poolB = Pool<B>();
+		A* data = poolA.Data();
+		EntityID* ids = poolA.Entities();
+		for (size_t i = 0; i < poolA.Size(); i++) {
+			B* b = poolB.Get(ids[i]);
+			if (b) func(ids[i], data[i], *b);
+		}
+	}
+
+private:
+	std::vector<std::unique_ptr<IComponentPool>> pools;
+	std::vector<EntityID> freeIDs;
+	EntityID nextID = 0;
+
+	//each component type gets a small, stable index into "pools"
+	inline static unsigned int nextTypeIndex = 0;
+
+	template<typename T>
+	static unsigned int TypeIndex()
+	{
+		static unsigned int index = nextTypeIndex++;
+		return index;
+	}
+};
@@ -0,0 +1,48 @@
+#pragma once
+
+//C++
+#include <vector>
+
+//Program
+#include "ComponentStore.h"
+#include "SlotMap.h"
+#include "Lights.h"
+#include "Bounds.h"
+#include "Transform.h"
+
+class Mesh;
+class Material;
+
+// --------------------------------------------------------
+// Plain-data components stored in a ComponentStore
+// --------------------------------------------------------
+
+// Lights are already plain data laid out for the shader
+typedef Light LightComponent;
+
+// --------------------------------------------------------
+// Something drawn with a mesh and material, and what the
+// culling stages keep about it.  Renderables are never
+// destroyed, so a slot in their pool is a stable index
+// (the BVH, culler, visibility cache and render packets
+// all refer to entities by it).  The transform, mesh and
+// material are handles into the game's slot maps.
+// --------------------------------------------------------
+struct RenderableComponent
+{
+	Handle<Transform> transform;
+	Handle<Mesh> mesh;
+	Handle<Material> material;
+
+	//world bounds, rebuilt from the mesh bounds when the transform version moves on
+	AABB worldBounds = {};
+	unsigned int boundsVersion = 0;
+	bool boundsValid = false;
+
+	int bvhProxy = -1;				// Leaf in the scene BVH
+	bool occluder = false;			// Drawn into the occlusion buffer and never culled by it
+	bool important = false;			// Never dropped for being too small on screen
+	unsigned int stateVersion = 0;	// Bumped whenever the material or a culling flag changes
+
+	std::vector<int> cells;			// Portal cells it overlaps (none is always visible)
+};
@@ -0,0 +1,144 @@
+#include "ConstantBufferRing.h"
+
+//C++
+#include <cstring>
+#include <thread>
+
+ConstantBufferRing::ConstantBufferRing(unsigned int size, unsigned int framesInFlight) :
+	size(size),
+	framesInFlight(framesInFlight),
+	frame(0),
+	retiredFrames(0),
+	supported(false),
+	discardNext(true),
+	mapped(nullptr),
+	allocator(size, 256)
+{
+}
+
+bool ConstantBufferRing::Initialize(Microsoft::WRL::ComPtr<ID3D11Device> device, Microsoft::WRL::ComPtr<ID3D11DeviceContext> context)
+{
+	this->context = context;
+
+	//both offset binding and NO_OVERWRITE on constant buffers are optional on 11.1 drivers
+	D3D11_FEATURE_DATA_D3D11_OPTIONS options = {};
+	if (FAILED(device->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options))) ||
+		!options.ConstantBufferOffsetting ||
+		!options.MapNoOverwriteOnDynamicConstantBuffer) {
+		supported = false;
+		return false;
+	}
+
+	D3D11_BUFFER_DESC desc = {};
+	desc.Usage = D3D11_USAGE_DYNAMIC;
+	desc.ByteWidth = size;
+	desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+
+	supported = SUCCEEDED(device->CreateBuffer(&desc, 0, buffer.GetAddressOf()));
+
+	D3D11_QUERY_DESC queryDesc = {};
+	queryDesc.Query = D3D11_QUERY_EVENT;
+	frameQueries.resize(framesInFlight);
+	for (unsigned int i = 0; supported && i < framesInFlight; i++)
+		supported = SUCCEEDED(device->CreateQuery(&queryDesc, frameQueries[i].ReleaseAndGetAddressOf()));
+
+	allocator.Reset(size);
+	retiredFrames = frame;
+	discardNext = true;
+	return supported;
+}
+
+bool ConstantBufferRing::IsSupported() { return supported; }
+
+// --------------------------------------------------------
+// Retires every frame the GPU has finished, oldest first.
+// Only the frame framesInFlight back is waited for, since
+// its query is about to be reused - the rest are polled.
+// --------------------------------------------------------
+void ConstantBufferRing::BeginFrame()
+{
+	if (!supported)
+		return;
+
+	while (retiredFrames < frame) {
+		ID3D11Query* query = frameQueries[retiredFrames % framesInFlight].Get();
+		bool wait = frame - retiredFrames >= framesInFlight;
+
+		HRESULT hr;
+		while ((hr = context->GetData(query, nullptr, 0, wait ? 0 : D3D11_ASYNC_GETDATA_DONOTFLUSH)) == S_FALSE && wait)
+			std::this_thread::yield();
+		if (hr != S_OK)
+			break;
+
+		allocator.RetireFrames(retiredFrames);
+		retiredFrames++;
+	}
+}
+
+void ConstantBufferRing::EndFrame()
+{
+	if (!supported)
+		return;
+
+	EndWrites();
+	allocator.EndFrame(frame);
+	context->End(frameQueries[frame % framesInFlight].Get());
+	frame++;
+}
+
+bool ConstantBufferRing::BeginWrites()
+{
+	if (!supported)
+		return false;
+	if (mapped)
+		return true;
+
+	//only the very first map discards - a wrap lands on space the fences have already freed,
+	//and renaming the buffer then would lose slices bound earlier in the frame
+	D3D11_MAP mapType = discardNext ? D3D11_MAP_WRITE_DISCARD : D3D11_MAP_WRITE_NO_OVERWRITE;
+
+	D3D11_MAPPED_SUBRESOURCE mappedBuffer = {};
+	if (FAILED(context->Map(buffer.Get(), 0, mapType, 0, &mappedBuffer)))
+		return false;
+	discardNext = false;
+	mapped = (unsigned char*)mappedBuffer.pData;
+	return true;
+}
+
+void ConstantBufferRing::EndWrites()
+{
+	if (!mapped)
+		return;
+	context->Unmap(buffer.Get(), 0);
+	mapped = nullptr;
+}
+
+bool ConstantBufferRing::Upload(const void* data, unsigned int dataSize, ConstantBufferSlice* slice)
+{
+	if (!supported)
+		return false;
+
+	unsigned int offset;
+	bool wrapped;
+	if (!allocator.Allocate(dataSize, &offset, &wrapped))
+		return false;
+
+	bool mapHere = !mapped;
+	if (mapHere && !BeginWrites())
+		return false;
+	memcpy(mapped + offset, data, dataSize);
+	if (mapHere)
+		EndWrites();
+
+	//counts must be a multiple of 16 constants, which the 256-byte alignment already covers
+	unsigned int alignment = allocator.GetAlignment();
+	slice->buffer = buffer.Get();
+	slice->firstConstant = offset / 16;
+	slice->numConstants = (dataSize + alignment - 1) / alignment * alignment / 16;
+	return true;
+}
+
+unsigned int ConstantBufferRing::GetUsed() { return allocator.GetUsed(); }
+
+unsigned int ConstantBufferRing::GetSize() { return size; }
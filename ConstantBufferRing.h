@@ -0,0 +1,79 @@
+#pragma once
+
+//C++
+#include <cstdint>
+#include <vector>
+
+//DirectX
+#include <d3d11_1.h>
+#include <wrl/client.h>
+
+//Program
+#include "RingAllocator.h"
+
+// --------------------------------------------------------
+// Where an upload landed, in the units
+// VS/PSSetConstantBuffers1 take (16-byte constants)
+// --------------------------------------------------------
+struct ConstantBufferSlice
+{
+	ID3D11Buffer* buffer;
+	unsigned int firstConstant;
+	unsigned int numConstants;
+};
+
+// --------------------------------------------------------
+// One big dynamic constant buffer that small per-draw
+// uploads are carved out of, instead of UpdateSubresource
+// on a buffer of their own.  Slices are 256-byte aligned
+// (the offset granularity D3D11.1 requires) and written
+// with MAP_NO_OVERWRITE; MAP_DISCARD is only used for the
+// very first map.  Wrapping needs no discard, since the
+// allocator never hands out a region a frame still holds.
+//
+// Each frame ends with an event query, which stands in for
+// a fence: a frame's slices are retired once its query has
+// signalled, and BeginFrame() waits on the query from
+// framesInFlight frames back before reusing it.
+//
+// Uploads between BeginWrites() and EndWrites() share one
+// map; nothing may be drawn with the ring until EndWrites().
+// --------------------------------------------------------
+class ConstantBufferRing
+{
+public:
+	ConstantBufferRing(unsigned int size = 1 << 20, unsigned int framesInFlight = 3);
+
+	//Returns false if the device can't bind constant buffers by offset
+	bool Initialize(Microsoft::WRL::ComPtr<ID3D11Device> device, Microsoft::WRL::ComPtr<ID3D11DeviceContext> context);
+	bool IsSupported();
+
+	//Called once at the start and end of every frame
+	void BeginFrame();
+	void EndFrame();
+
+	//Maps the buffer for a run of uploads; false if it can't be mapped
+	bool BeginWrites();
+	void EndWrites();
+
+	//Copies data into a new slice (mapping just for it outside BeginWrites); false if the ring is full (the caller should upload the old way)
+	bool Upload(const void* data, unsigned int dataSize, ConstantBufferSlice* slice);
+
+	unsigned int GetUsed();
+	unsigned int GetSize();
+
+private:
+	unsigned int size;
+	unsigned int framesInFlight;
+	uint64_t frame;
+	uint64_t retiredFrames;		// Frames before this one are retired
+	bool supported;
+	bool discardNext;
+	unsigned char* mapped;		// Between BeginWrites() and EndWrites(), else null
+
+	RingAllocator allocator;
+
+	Microsoft::WRL::ComPtr<ID3D11Buffer> buffer;
+	std::vector<Microsoft::WRL::ComPtr<ID3D11Query>> frameQueries;	// Frame n ends queries[n % framesInFlight]
+	Microsoft::WRL::ComPtr<ID3D11DeviceContext> context;
+};
@@ -0,0 +1,60 @@
+#include "CpuFeatures.h"
+
+#if defined(_MSC_VER) && CPU_X86
+#include <intrin.h>
+#elif CPU_X86
+#include <cpuid.h>
+#endif
+
+#if CPU_X86
+static void Cpuid(int leaf, int registers[4])
+{
+#if defined(_MSC_VER)
+	__cpuid(registers, leaf);
+#else
+	unsigned int a, b, c, d;
+	__cpuid(leaf, a, b, c, d);
+	registers[0] = (int)a; registers[1] = (int)b; registers[2] = (int)c; registers[3] = (int)d;
+#endif
+}
+
+//XCR0 - which register states the OS saves on a context switch
+static unsigned long long ReadXCR0()
+{
+#if defined(_MSC_VER)
+	return _xgetbv(0);
+#else
+	unsigned int low, high;
+	__asm__ volatile("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+	return ((unsigned long long)high << 32) | low;
+#endif
+}
+
+static bool DetectAVX()
+{
+	int registers[4];
+	Cpuid(0, registers);
+	if (registers[0] < 1)
+		return false;
+
+	//leaf 1 ECX: bit 27 OSXSAVE, bit 28 AVX
+	Cpuid(1, registers);
+	bool osxsave = (registers[2] & (1 << 27)) != 0;
+	bool avx = (registers[2] & (1 << 28)) != 0;
+	if (!osxsave || !avx)
+		return false;
+
+	//XMM (bit 1) and YMM (bit 2) state both enabled
+	return (ReadXCR0() & 6) == 6;
+}
+#endif
+
+bool CpuHasAVX()
+{
+#if CPU_X86
+	static const bool hasAVX = DetectAVX();
+	return hasAVX;
+#else
+	return false;
+#endif
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+// --------------------------------------------------------
+// Instruction sets the running CPU (and OS) support, so
+// SIMD kernels can be picked at runtime.  The project is
+// built for the baseline instruction set; kernels that need
+// more live in their own files compiled with it (see the
+// *AVX.cpp files) and must only be called after checking.
+// --------------------------------------------------------
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define CPU_X86 1
+#else
+#define CPU_X86 0
+#endif
+
+//AVX instructions and OS support for saving the YMM registers
+bool CpuHasAVX();
@@ -0,0 +1,98 @@
+#include "D3D11CommandBackend.h"
+
+//C++
+#include <cstring>
+#include <cstdio>
+#include <cassert>
+
+//Program
+#include "Material.h"
+#include "Mesh.h"
+#include "ShaderConstants.h"
+
+D3D11CommandBackend::D3D11CommandBackend(ID3D11Buffer* instanceBuffer, unsigned int instanceStride, ConstantBufferRing* ring) :
+	instanceBuffer(instanceBuffer),
+	instanceStride(instanceStride),
+	ring(ring),
+	writing(false),
+	nextSlice(0)
+{
+}
+
+bool D3D11CommandBackend::Execute(CommandBuffer& commands)
+{
+	slices.clear();
+	nextSlice = 0;
+
+	//if the ring can't be mapped no slices are filled, and every draw uploads the old way
+	if (ring && ring->BeginWrites()) {
+		writing = true;
+		commands.Execute(*this);
+		writing = false;
+		ring->EndWrites();
+	}
+	return commands.Execute(*this);
+}
+
+const ConstantBufferSlice* D3D11CommandBackend::NextSlice()
+{
+	if (nextSlice >= slices.size())
+		return nullptr;
+	const ConstantBufferSlice* slice = &slices[nextSlice++];
+	return slice->buffer ? slice : nullptr;
+}
+
+void D3D11CommandBackend::BindMaterial(void* material, bool instanced)
+{
+	if (writing) return;
+	((Material*)material)->BindMaterial(instanced);
+}
+
+void D3D11CommandBackend::SetConstants(void* target, unsigned int slot, const void* data, unsigned int size)
+{
+	Material* material = (Material*)target;
+
+	//copied out, the stream makes no promises about alignment
+	//(a slice the ring had no room for is left empty, and that draw uploads the old way)
+	if (slot == RENDER_CONSTANTS_OBJECT && size == sizeof(VSPerObject)) {
+		VSPerObject object;
+		memcpy(&object, data, sizeof(object));
+		if (writing) {
+			slices.push_back({});
+			material->WriteObject(object, ring, &slices.back());
+		}
+		else if (const ConstantBufferSlice* slice = NextSlice())
+			material->BindObject(*slice);
+		else
+			material->PrepareObject(object);
+	}
+	else if (slot == RENDER_CONSTANTS_LIGHTS && size == sizeof(PSPerObject)) {
+		PSPerObject lights;
+		memcpy(&lights, data, sizeof(lights));
+		if (writing) {
+			slices.push_back({});
+			material->WriteObjectLights(lights, ring, &slices.back());
+		}
+		else if (const ConstantBufferSlice* slice = NextSlice())
+			material->BindObjectLights(*slice);
+		else
+			material->PrepareObjectLights(lights);
+	}
+	else if (!writing) {
+		//recorded against a different layout - dropping it would draw with stale constants
+		printf("SetConstants: unknown slot %u or wrong size %u\n", slot, size);
+		assert(!"Set-constants command this backend can't apply (see console)");
+	}
+}
+
+void D3D11CommandBackend::Draw(void* mesh)
+{
+	if (writing) return;
+	((Mesh*)mesh)->Draw();
+}
+
+void D3D11CommandBackend::DrawInstanced(void* mesh, unsigned int firstInstance, unsigned int instanceCount)
+{
+	if (writing) return;
+	((Mesh*)mesh)->DrawInstanced(instanceBuffer, instanceStride, firstInstance, instanceCount);
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+//C++
+#include <vector>
+
+//DirectX
+#include <d3d11.h>
+
+//Program
+#include "CommandBuffer.h"
+#include "ConstantBufferRing.h"
+
+// --------------------------------------------------------
+// Replays command buffers on the immediate context:
+// materials are Material*, meshes are Mesh*, and the
+// targets of set-constants commands are Material*
+// (RENDER_CONSTANTS_OBJECT and RENDER_CONSTANTS_LIGHTS).
+// Instanced draws read from one shared instance buffer.
+//
+// With a ring, Execute() replays a buffer twice: first only
+// its constants, all written under one map of the ring,
+// then everything, binding the slices the first pass
+// filled.  (Nothing can be drawn while the ring is mapped.)
+// --------------------------------------------------------
+class D3D11CommandBackend : public CommandBackend
+{
+public:
+	D3D11CommandBackend(ID3D11Buffer* instanceBuffer, unsigned int instanceStride, ConstantBufferRing* ring);
+
+	//Replays commands through this backend; false if the stream is corrupt
+	bool Execute(CommandBuffer& commands);
+
+	void BindMaterial(void* material, bool instanced);
+	void SetConstants(void* target, unsigned int slot, const void* data, unsigned int size);
+	void Draw(void* mesh);
+	void DrawInstanced(void* mesh, unsigned int firstInstance, unsigned int instanceCount);
+
+private:
+	ID3D11Buffer* instanceBuffer;
+	unsigned int instanceStride;
+	ConstantBufferRing* ring;	// Null to upload per-draw constants the old way
+
+	//Next slice the replay pass binds, or null if the first pass couldn't fill one
+	const ConstantBufferSlice* NextSlice();
+
+	bool writing;	// First pass: only constants, into the mapped ring
+	std::vector<ConstantBufferSlice> slices;
+	size_t nextSlice;
+};
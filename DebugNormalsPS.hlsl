@@ -1,4 +1,5 @@
-cbuffer psConstantBuffer : register(b0)
+// Same register as the lit shader, so materials can switch between them
+cbuffer perMaterial : register(b1)
 {
     float4 colorTint;
 }
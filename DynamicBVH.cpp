@@ -0,0 +1,540 @@
+#include "DynamicBVH.h"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+
+using namespace DirectX;
+
+DynamicBVH::DynamicBVH(float margin) :
+	root(-1),
+	freeList(-1),
+	proxyCount(0),
+	margin(margin),
+	costAtBuild(0.0f),
+	reinsertsSinceCheck(0),
+	rebuildRatio(1.5f),
+	stats{}
+{
+}
+
+// --------------------------------------------------------
+// Adds a leaf for the given box and returns its proxy ID
+// --------------------------------------------------------
+int DynamicBVH::Insert(const AABB& box, int userData)
+{
+	int leaf = AllocateNode();
+	nodes[leaf].box = AABBExpand(box, margin);
+	nodes[leaf].tight = box;
+	nodes[leaf].userData = userData;
+	nodes[leaf].height = 0;
+
+	InsertLeaf(leaf);
+	proxyCount++;
+	return leaf;
+}
+
+void DynamicBVH::Remove(int proxy)
+{
+	RemoveLeaf(proxy);
+	FreeNode(proxy);
+	proxyCount--;
+}
+
+// --------------------------------------------------------
+// Updates a leaf after its object moved
+//
+// Returns true if the tree changed, false if the new box
+// still fits inside the leaf's fat box
+// --------------------------------------------------------
+bool DynamicBVH::Refit(int proxy, const AABB& box)
+{
+	nodes[proxy].tight = box;
+	if (AABBContains(nodes[proxy].box, box))
+		return false;
+
+	//out of its margin - rather than growing the leaf (which
+	//only ever gets bigger) put it back in with a fresh one
+	RemoveLeaf(proxy);
+	nodes[proxy].box = AABBExpand(box, margin);
+	InsertLeaf(proxy);
+
+	reinsertsSinceCheck++;
+	stats.reinserts++;
+	return true;
+}
+
+// --------------------------------------------------------
+// Throws away every internal node and rebuilds top-down,
+// splitting at the median centroid along the longest axis.
+// Leaves (and therefore proxy IDs) are kept, with their fat
+// boxes rebuilt around where their objects are now.
+// --------------------------------------------------------
+void DynamicBVH::Rebuild()
+{
+	std::vector<int> leaves;
+	leaves.reserve(proxyCount);
+
+	for (int i = 0; i < (int)nodes.size(); i++) {
+		if (nodes[i].height < 0)
+			continue;
+
+		if (nodes[i].IsLeaf()) {
+			nodes[i].box = AABBExpand(nodes[i].tight, margin);
+			leaves.push_back(i);
+		}
+		else {
+			FreeNode(i);
+		}
+	}
+
+	root = leaves.empty() ? -1 : BuildTopDown(leaves, 0, (int)leaves.size());
+	if (root != -1)
+		nodes[root].parent = -1;
+
+	costAtBuild = ComputeCost();
+	reinsertsSinceCheck = 0;
+	stats.rebuilds++;
+}
+
+// --------------------------------------------------------
+// Every so often (after enough reinserts) compares the tree's
+// surface area cost against its cost right after the last
+// build, and rebuilds if it has degraded too far
+// --------------------------------------------------------
+bool DynamicBVH::RebuildIfNeeded()
+{
+	unsigned int checkInterval = std::max(64u, (unsigned int)proxyCount / 8);
+	if (reinsertsSinceCheck < checkInterval)
+		return false;
+
+	reinsertsSinceCheck = 0;
+	if (costAtBuild > 0.0f && ComputeCost() <= costAtBuild * rebuildRatio)
+		return false;
+
+	Rebuild();
+	return true;
+}
+
+void DynamicBVH::QueryFrustum(const Frustum& frustum, std::vector<int>& out)
+{
+	if (root == -1) return;
+
+	std::vector<int> stack;
+	stack.push_back(root);
+	while (!stack.empty()) {
+		int index = stack.back();
+		stack.pop_back();
+
+		CullResult result = FrustumTestAABB(frustum, nodes[index].box);
+		if (result == CullResult::Outside)
+			continue;
+
+		//whole subtree is visible - no need to test any further
+		if (result == CullResult::Inside) {
+			CollectLeaves(index, out);
+			continue;
+		}
+
+		if (nodes[index].IsLeaf()) {
+			out.push_back(nodes[index].userData);
+		}
+		else {
+			stack.push_back(nodes[index].left);
+			stack.push_back(nodes[index].right);
+		}
+	}
+}
+
+void DynamicBVH::QueryFrustums(const Frustum* frustums, int viewCount, std::vector<int>* out)
+{
+	if (root == -1 || viewCount <= 0) return;
+	if (viewCount > MAX_BVH_VIEWS) viewCount = MAX_BVH_VIEWS;
+
+	//nothing to share, and the plain walk has no masks to carry
+	if (viewCount == 1) {
+		QueryFrustum(frustums[0], out[0]);
+		return;
+	}
+
+	struct Entry
+	{
+		int index;
+		unsigned int testing;	// Views that still need to test this subtree
+		unsigned int inside;	// Views that already contain it
+	};
+
+	unsigned int allViews = viewCount == 32 ? 0xFFFFFFFF : (1u << viewCount) - 1;
+
+	//same fixed stack as QueryOverlap(), and only the views still in play are visited
+	Entry stack[BVH_STACK_SIZE];
+	int count = 0;
+	stack[count++] = { root, allViews, 0 };
+	while (count > 0) {
+		Entry entry = stack[--count];
+
+		const Node& node = nodes[entry.index];
+		for (unsigned int views = entry.testing; views != 0; views &= views - 1) {
+			int v = std::countr_zero(views);
+			CullResult result = FrustumTestAABB(frustums[v], node.box);
+			if (result != CullResult::Intersecting)
+				entry.testing &= ~(1u << v);
+			if (result == CullResult::Inside)
+				entry.inside |= 1u << v;
+		}
+
+		if ((entry.testing | entry.inside) == 0)
+			continue;
+
+		//every remaining view contains the whole subtree - walk it once and share the leaves
+		if (entry.testing == 0 && !node.IsLeaf()) {
+			frustumLeaves.clear();
+			CollectLeaves(entry.index, frustumLeaves);
+			for (unsigned int views = entry.inside; views != 0; views &= views - 1) {
+				std::vector<int>& result = out[std::countr_zero(views)];
+				result.insert(result.end(), frustumLeaves.begin(), frustumLeaves.end());
+			}
+			continue;
+		}
+
+		if (node.IsLeaf()) {
+			for (unsigned int views = entry.testing | entry.inside; views != 0; views &= views - 1)
+				out[std::countr_zero(views)].push_back(node.userData);
+		}
+		else {
+			assert(count + 2 <= BVH_STACK_SIZE);
+			stack[count++] = { node.left, entry.testing, entry.inside };
+			stack[count++] = { node.right, entry.testing, entry.inside };
+		}
+	}
+}
+
+void DynamicBVH::QueryOverlap(const AABB& box, std::vector<int>& out)
+{
+	if (root == -1) return;
+
+	//called per moved entity (portal cells), where allocating a stack cost more than the walk
+	int stack[BVH_STACK_SIZE];
+	int count = 0;
+	stack[count++] = root;
+	while (count > 0) {
+		int index = stack[--count];
+
+		if (!AABBOverlaps(nodes[index].box, box))
+			continue;
+
+		if (nodes[index].IsLeaf()) {
+			out.push_back(nodes[index].userData);
+		}
+		else {
+			assert(count + 2 <= BVH_STACK_SIZE);
+			stack[count++] = nodes[index].left;
+			stack[count++] = nodes[index].right;
+		}
+	}
+}
+
+int DynamicBVH::GetUserData(int proxy) { return nodes[proxy].userData; }
+
+const AABB& DynamicBVH::GetFatAABB(int proxy) { return nodes[proxy].box; }
+
+int DynamicBVH::GetProxyCount() { return proxyCount; }
+
+int DynamicBVH::GetHeight() { return root == -1 ? 0 : nodes[root].height; }
+
+// --------------------------------------------------------
+// Sum of internal node surface areas - proportional to the
+// expected cost of a random query
+// --------------------------------------------------------
+float DynamicBVH::ComputeCost()
+{
+	float cost = 0.0f;
+	for (const Node& node : nodes) {
+		if (node.height > 0)
+			cost += AABBSurfaceArea(node.box);
+	}
+	return cost;
+}
+
+BVHStats DynamicBVH::GetStats() { return stats; }
+
+///////////////////////////////////////////////////////////////////////////////
+// ------ INTERNALS -----------------------------------------------------------
+///////////////////////////////////////////////////////////////////////////////
+
+int DynamicBVH::AllocateNode()
+{
+	int index;
+	if (freeList != -1) {
+		index = freeList;
+		freeList = nodes[index].parent;
+	}
+	else {
+		index = (int)nodes.size();
+		nodes.emplace_back();
+	}
+
+	nodes[index].parent = -1;
+	nodes[index].left = -1;
+	nodes[index].right = -1;
+	nodes[index].height = 0;
+	nodes[index].userData = -1;
+	return index;
+}
+
+void DynamicBVH::FreeNode(int index)
+{
+	//free nodes reuse "parent" as the free list link
+	nodes[index].parent = freeList;
+	nodes[index].height = -1;
+	freeList = index;
+}
+
+// --------------------------------------------------------
+// Descends toward the cheapest sibling (branch and bound on
+// surface area), pairs the leaf with it under a new parent
+// and walks back up balancing and refitting
+// --------------------------------------------------------
+void DynamicBVH::InsertLeaf(int leaf)
+{
+	if (root == -1) {
+		root = leaf;
+		nodes[root].parent = -1;
+		return;
+	}
+
+	AABB leafBox = nodes[leaf].box;
+	int index = root;
+	while (!nodes[index].IsLeaf()) {
+		int left = nodes[index].left;
+		int right = nodes[index].right;
+
+		float area = AABBSurfaceArea(nodes[index].box);
+		float combinedArea = AABBSurfaceArea(AABBUnion(nodes[index].box, leafBox));
+
+		//cost of making a new parent for this node and the leaf
+		float cost = 2.0f * combinedArea;
+
+		//minimum cost of pushing the leaf further down
+		float inheritance = 2.0f * (combinedArea - area);
+
+		float costLeft = AABBSurfaceArea(AABBUnion(leafBox, nodes[left].box)) + inheritance;
+		if (!nodes[left].IsLeaf())
+			costLeft -= AABBSurfaceArea(nodes[left].box);
+
+		float costRight = AABBSurfaceArea(AABBUnion(leafBox, nodes[right].box)) + inheritance;
+		if (!nodes[right].IsLeaf())
+			costRight -= AABBSurfaceArea(nodes[right].box);
+
+		if (cost < costLeft && cost < costRight)
+			break;
+
+		index = costLeft < costRight ? left : right;
+	}
+
+	int sibling = index;
+	int oldParent = nodes[sibling].parent;
+	int newParent = AllocateNode();
+	nodes[newParent].parent = oldParent;
+	nodes[newParent].box = AABBUnion(leafBox, nodes[sibling].box);
+	nodes[newParent].height = nodes[sibling].height + 1;
+	nodes[newParent].left = sibling;
+	nodes[newParent].right = leaf;
+	nodes[sibling].parent = newParent;
+	nodes[leaf].parent = newParent;
+
+	if (oldParent != -1) {
+		if (nodes[oldParent].left == sibling) nodes[oldParent].left = newParent;
+		else nodes[oldParent].right = newParent;
+	}
+	else {
+		root = newParent;
+	}
+
+	//fix heights and boxes on the way back up
+	index = nodes[leaf].parent;
+	while (index != -1) {
+		index = Balance(index);
+
+		int left = nodes[index].left;
+		int right = nodes[index].right;
+		nodes[index].height = 1 + std::max(nodes[left].height, nodes[right].height);
+		nodes[index].box = AABBUnion(nodes[left].box, nodes[right].box);
+
+		index = nodes[index].parent;
+	}
+}
+
+void DynamicBVH::RemoveLeaf(int leaf)
+{
+	if (leaf == root) {
+		root = -1;
+		return;
+	}
+
+	int parent = nodes[leaf].parent;
+	int grandParent = nodes[parent].parent;
+	int sibling = nodes[parent].left == leaf ? nodes[parent].right : nodes[parent].left;
+
+	if (grandParent != -1) {
+		//splice the sibling into the parent's place
+		if (nodes[grandParent].left == parent) nodes[grandParent].left = sibling;
+		else nodes[grandParent].right = sibling;
+		nodes[sibling].parent = grandParent;
+		FreeNode(parent);
+
+		int index = grandParent;
+		while (index != -1) {
+			index = Balance(index);
+
+			int left = nodes[index].left;
+			int right = nodes[index].right;
+			nodes[index].box = AABBUnion(nodes[left].box, nodes[right].box);
+			nodes[index].height = 1 + std::max(nodes[left].height, nodes[right].height);
+
+			index = nodes[index].parent;
+		}
+	}
+	else {
+		root = sibling;
+		nodes[sibling].parent = -1;
+		FreeNode(parent);
+	}
+
+	nodes[leaf].parent = -1;
+}
+
+// --------------------------------------------------------
+// If one child of A is more than one level taller than the
+// other, rotates that child up into A's place.  Returns the
+// index of the node now sitting where A was.
+// --------------------------------------------------------
+int DynamicBVH::Balance(int iA)
+{
+	if (nodes[iA].IsLeaf() || nodes[iA].height < 2)
+		return iA;
+
+	int iB = nodes[iA].left;
+	int iC = nodes[iA].right;
+	int balance = nodes[iC].height - nodes[iB].height;
+
+	//rotate C up
+	if (balance > 1) {
+		int iF = nodes[iC].left;
+		int iG = nodes[iC].right;
+
+		nodes[iC].left = iA;
+		nodes[iC].parent = nodes[iA].parent;
+		nodes[iA].parent = iC;
+
+		if (nodes[iC].parent != -1) {
+			if (nodes[nodes[iC].parent].left == iA) nodes[nodes[iC].parent].left = iC;
+			else nodes[nodes[iC].parent].right = iC;
+		}
+		else {
+			root = iC;
+		}
+
+		//keep the taller of F/G under C, hand the other to A
+		int keep = nodes[iF].height > nodes[iG].height ? iF : iG;
+		int give = keep == iF ? iG : iF;
+
+		nodes[iC].right = keep;
+		nodes[iA].right = give;
+		nodes[give].parent = iA;
+
+		nodes[iA].box = AABBUnion(nodes[iB].box, nodes[give].box);
+		nodes[iC].box = AABBUnion(nodes[iA].box, nodes[keep].box);
+		nodes[iA].height = 1 + std::max(nodes[iB].height, nodes[give].height);
+		nodes[iC].height = 1 + std::max(nodes[iA].height, nodes[keep].height);
+
+		stats.rotations++;
+		return iC;
+	}
+
+	//rotate B up
+	if (balance < -1) {
+		int iD = nodes[iB].left;
+		int iE = nodes[iB].right;
+
+		nodes[iB].left = iA;
+		nodes[iB].parent = nodes[iA].parent;
+		nodes[iA].parent = iB;
+
+		if (nodes[iB].parent != -1) {
+			if (nodes[nodes[iB].parent].left == iA) nodes[nodes[iB].parent].left = iB;
+			else nodes[nodes[iB].parent].right = iB;
+		}
+		else {
+			root = iB;
+		}
+
+		int keep = nodes[iD].height > nodes[iE].height ? iD : iE;
+		int give = keep == iD ? iE : iD;
+
+		nodes[iB].right = keep;
+		nodes[iA].left = give;
+		nodes[give].parent = iA;
+
+		nodes[iA].box = AABBUnion(nodes[iC].box, nodes[give].box);
+		nodes[iB].box = AABBUnion(nodes[iA].box, nodes[keep].box);
+		nodes[iA].height = 1 + std::max(nodes[iC].height, nodes[give].height);
+		nodes[iB].height = 1 + std::max(nodes[iA].height, nodes[keep].height);
+
+		stats.rotations++;
+		return iB;
+	}
+
+	return iA;
+}
+
+int DynamicBVH::BuildTopDown(std::vector<int>& leaves, int first, int count)
+{
+	if (count == 1)
+		return leaves[first];
+
+	//split along the longest axis of the centroids
+	AABB centroids = EmptyAABB();
+	for (int i = first; i < first + count; i++)
+		AABBGrow(centroids, AABBCenter(nodes[leaves[i]].box));
+
+	XMFLOAT3 size = AABBExtents(centroids);
+	int axis = 0;
+	if (size.y > size.x) axis = 1;
+	if (size.z > (axis == 0 ? size.x : size.y)) axis = 2;
+
+	auto key = [&](int leaf) {
+		XMFLOAT3 c = AABBCenter(nodes[leaf].box);
+		return axis == 0 ? c.x : (axis == 1 ? c.y : c.z);
+	};
+
+	int half = count / 2;
+	std::nth_element(
+		leaves.begin() + first,
+		leaves.begin() + first + half,
+		leaves.begin() + first + count,
+		[&](int a, int b) { return key(a) < key(b); });
+
+	int left = BuildTopDown(leaves, first, half);
+	int right = BuildTopDown(leaves, first + half, count - half);
+
+	int index = AllocateNode();
+	nodes[index].left = left;
+	nodes[index].right = right;
+	nodes[index].box = AABBUnion(nodes[left].box, nodes[right].box);
+	nodes[index].height = 1 + std::max(nodes[left].height, nodes[right].height);
+	nodes[left].parent = index;
+	nodes[right].parent = index;
+	return index;
+}
+
+void DynamicBVH::CollectLeaves(int index, std::vector<int>& out)
+{
+	if (nodes[index].IsLeaf()) {
+		out.push_back(nodes[index].userData);
+		return;
+	}
+
+	CollectLeaves(nodes[index].left, out);
+	CollectLeaves(nodes[index].right, out);
+}
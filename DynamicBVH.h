@@ -0,0 +1,156 @@
+#pragma once
+
+//C++
+#include <cassert>
+#include <vector>
+
+//Program
+#include "Bounds.h"
+
+//Views per QueryFrustums() call (one bit each)
+#define MAX_BVH_VIEWS 32
+
+//Fixed traversal stack for the queries and Raycast() - the tree is kept
+//height-balanced, so a walk never holds more than its height + 1 nodes
+#define BVH_STACK_SIZE 64
+
+// --------------------------------------------------------
+// Counters for the UI / profiling
+// --------------------------------------------------------
+struct BVHStats
+{
+	unsigned int reinserts;		// Leaves that left their fat box and were reinserted
+	unsigned int rotations;		// Balancing rotations
+	unsigned int rebuilds;		// Full top-down rebuilds
+};
+
+// --------------------------------------------------------
+// Dynamic bounding volume hierarchy over world-space AABBs
+//
+//  - Leaves store a "fat" box (the real box plus a margin) so
+//    small movements don't touch the tree at all
+//  - Insertion picks a sibling with a surface area heuristic
+//    and keeps the tree height-balanced with rotations
+//  - Refit() removes a leaf whose box has left its fat box
+//    and reinserts it with a fresh margin around the new box
+//  - RebuildIfNeeded() rebuilds top-down (re-fattening every
+//    leaf around its latest box) once reinsertions have made
+//    the tree noticeably worse than when it was built
+//
+// Proxy IDs returned by Insert() stay valid until Remove(),
+// including across rebuilds.
+// --------------------------------------------------------
+class DynamicBVH
+{
+public:
+	DynamicBVH(float margin = 0.1f);
+
+	int Insert(const AABB& box, int userData);
+	void Remove(int proxy);
+	bool Refit(int proxy, const AABB& box);
+
+	void Rebuild();
+	bool RebuildIfNeeded();
+
+	//Queries - userData of every hit leaf is appended to "out"
+	void QueryFrustum(const Frustum& frustum, std::vector<int>& out);
+	void QueryOverlap(const AABB& box, std::vector<int>& out);
+
+	// --------------------------------------------------------
+	// Culls against several frusta (up to MAX_BVH_VIEWS) in one
+	// traversal.  Each node carries a mask of views still
+	// testing it; a view drops out of a subtree once the node
+	// is fully outside or fully inside it.  out[v] gets the
+	// userData visible to view v.
+	// --------------------------------------------------------
+	void QueryFrustums(const Frustum* frustums, int viewCount, std::vector<int>* out);
+
+	// --------------------------------------------------------
+	// Walks leaves whose fat box the ray enters before maxT,
+	// nearest child first.  callback(userData, tEntry) returns
+	// the new maxT (return the exact hit distance to clip the
+	// rest of the search, or the old maxT to keep going).
+	// --------------------------------------------------------
+	template<typename Func>
+	void Raycast(const Ray& ray, float maxT, Func callback)
+	{
+		if (root == -1) return;
+
+		//per picked mesh as well as per scene, so no allocation here either
+		int stack[BVH_STACK_SIZE];
+		int count = 0;
+		stack[count++] = root;
+		while (count > 0) {
+			int index = stack[--count];
+
+			float tEntry;
+			if (!RayIntersectsAABB(ray, nodes[index].box, maxT, &tEntry))
+				continue;
+
+			if (nodes[index].IsLeaf()) {
+				maxT = callback(nodes[index].userData, tEntry);
+				continue;
+			}
+
+			//push the farther child first so the nearer one is popped next
+			int left = nodes[index].left;
+			int right = nodes[index].right;
+			float tLeft, tRight;
+			bool hitLeft = RayIntersectsAABB(ray, nodes[left].box, maxT, &tLeft);
+			bool hitRight = RayIntersectsAABB(ray, nodes[right].box, maxT, &tRight);
+			assert(count + 2 <= BVH_STACK_SIZE);
+			if (hitLeft && hitRight) {
+				if (tLeft < tRight) { stack[count++] = right; stack[count++] = left; }
+				else { stack[count++] = left; stack[count++] = right; }
+			}
+			else if (hitLeft) stack[count++] = left;
+			else if (hitRight) stack[count++] = right;
+		}
+	}
+
+	//Getters
+	int GetUserData(int proxy);
+	const AABB& GetFatAABB(int proxy);
+	int GetProxyCount();
+	int GetHeight();
+	float ComputeCost();
+	BVHStats GetStats();
+
+private:
+	struct Node
+	{
+		AABB box;		// Fat box for leaves
+		AABB tight;		// Leaves only: the box last passed to Insert()/Refit()
+		int parent;
+		int left;
+		int right;
+		int height;		// 0 for leaves, -1 for free nodes
+		int userData;	// -1 for internal nodes
+
+		bool IsLeaf() const { return left == -1; }
+	};
+
+	int AllocateNode();
+	void FreeNode(int index);
+
+	void InsertLeaf(int leaf);
+	void RemoveLeaf(int leaf);
+	int Balance(int index);
+	int BuildTopDown(std::vector<int>& leaves, int first, int count);
+	void CollectLeaves(int index, std::vector<int>& out);
+
+	std::vector<Node> nodes;
+	std::vector<int> frustumLeaves;	// QueryFrustums() scratch for subtrees shared by several views
+	int root;
+	int freeList;
+	int proxyCount;
+
+	float margin;
+
+	//rebuild heuristics
+	float costAtBuild;
+	unsigned int reinsertsSinceCheck;
+	float rebuildRatio;
+
+	BVHStats stats;
+};
@@ -0,0 +1,64 @@
+#include "FixedTimestep.h"
+
+FixedTimestep::FixedTimestep(double stepSeconds, int maxStepsPerFrame) :
+	step(stepSeconds),
+	accumulator(0.0),
+	simulationTime(0.0),
+	maxStepsPerFrame(maxStepsPerFrame),
+	droppedSteps(0)
+{
+}
+
+int FixedTimestep::Advance(double frameDeltaSeconds)
+{
+	if (frameDeltaSeconds < 0.0)
+		frameDeltaSeconds = 0.0;
+
+	accumulator += frameDeltaSeconds;
+
+	int steps = 0;
+	while (accumulator >= step && steps < maxStepsPerFrame) {
+		accumulator -= step;
+		simulationTime += step;
+		steps++;
+	}
+
+	//catch-up limit: rather than spiral trying to simulate a long hitch,
+	//drop whatever whole steps are still owed and keep the remainder
+	if (accumulator >= step) {
+		unsigned int owed = (unsigned int)(accumulator / step);
+		droppedSteps += owed;
+		accumulator -= owed * step;
+	}
+
+	return steps;
+}
+
+float FixedTimestep::GetAlpha() { return (float)(accumulator / step); }
+
+float FixedTimestep::GetStep() { return (float)step; }
+
+double FixedTimestep::GetSimulationTime() { return simulationTime; }
+
+int FixedTimestep::GetMaxStepsPerFrame() { return maxStepsPerFrame; }
+
+unsigned int FixedTimestep::GetDroppedSteps() { return droppedSteps; }
+
+void FixedTimestep::SetStep(double stepSeconds)
+{
+	if (stepSeconds > 0.0)
+		step = stepSeconds;
+}
+
+void FixedTimestep::SetMaxStepsPerFrame(int maxSteps)
+{
+	if (maxSteps > 0)
+		maxStepsPerFrame = maxSteps;
+}
+
+void FixedTimestep::Reset()
+{
+	accumulator = 0.0;
+	simulationTime = 0.0;
+	droppedSteps = 0;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+// --------------------------------------------------------
+// Accumulates variable frame time and hands it back out in
+// fixed-size simulation steps.  Has no dependency on the
+// OS clock, so it can be driven by any source of deltas.
+// --------------------------------------------------------
+class FixedTimestep
+{
+public:
+	FixedTimestep(double stepSeconds = 1.0 / 60.0, int maxStepsPerFrame = 5);
+
+	//Feeds in one frame's worth of time and returns how many fixed steps should run
+	int Advance(double frameDeltaSeconds);
+
+	//How far (0-1) the render time sits between the previous and current simulation step
+	float GetAlpha();
+
+	float GetStep();
+	double GetSimulationTime();
+	int GetMaxStepsPerFrame();
+	unsigned int GetDroppedSteps();
+
+	void SetStep(double stepSeconds);
+	void SetMaxStepsPerFrame(int maxSteps);
+	void Reset();
+
+private:
+	double step;
+	double accumulator;
+	double simulationTime;
+	int maxStepsPerFrame;
+
+	//steps thrown away because a frame fell too far behind
+	unsigned int droppedSteps;
+};
@@ -0,0 +1,97 @@
+#include "FrustumCuller.h"
+
+//std
+#include <cmath>
+
+//Program
+#include "CpuFeatures.h"
+
+using namespace DirectX;
+
+FrustumCuller::FrustumCuller() :
+	count(0)
+{
+}
+
+// --------------------------------------------------------
+// Sizes the arrays to hold count boxes.  Padding lanes get
+// an inverted (negative) extent so they can never pass.
+// --------------------------------------------------------
+void FrustumCuller::Resize(unsigned int count)
+{
+	this->count = count;
+	size_t padded = ((size_t)count + 7) & ~(size_t)7;
+
+	centerX.resize(padded, 0.0f);
+	centerY.resize(padded, 0.0f);
+	centerZ.resize(padded, 0.0f);
+	extentX.resize(padded, -INFINITY);
+	extentY.resize(padded, -INFINITY);
+	extentZ.resize(padded, -INFINITY);
+
+	for (size_t i = count; i < padded; i++) {
+		centerX[i] = centerY[i] = centerZ[i] = 0.0f;
+		extentX[i] = extentY[i] = extentZ[i] = -INFINITY;
+	}
+}
+
+void FrustumCuller::SetBox(unsigned int index, const AABB& box)
+{
+	centerX[index] = (box.min.x + box.max.x) * 0.5f;
+	centerY[index] = (box.min.y + box.max.y) * 0.5f;
+	centerZ[index] = (box.min.z + box.max.z) * 0.5f;
+	extentX[index] = (box.max.x - box.min.x) * 0.5f;
+	extentY[index] = (box.max.y - box.min.y) * 0.5f;
+	extentZ[index] = (box.max.z - box.min.z) * 0.5f;
+}
+
+unsigned int FrustumCuller::GetCount() { return count; }
+
+bool FrustumCuller::HasSIMD() { return CpuHasAVX(); }
+
+void FrustumCuller::Cull(const Frustum& frustum, std::vector<unsigned int>& visible)
+{
+	if (HasSIMD())
+		CullSIMD(frustum, visible);
+	else
+		CullScalar(frustum, visible);
+}
+
+// --------------------------------------------------------
+// Center/extent form of the plane test: a box is outside a
+// plane when dot(n, c) + d < -(e . |n|)
+// --------------------------------------------------------
+void FrustumCuller::CullScalar(const Frustum& frustum, std::vector<unsigned int>& visible)
+{
+	for (unsigned int i = 0; i < count; i++) {
+		bool inside = true;
+		for (int p = 0; p < 6 && inside; p++) {
+			const XMFLOAT4& plane = frustum.planes[p];
+			float distance = plane.x * centerX[i] + plane.y * centerY[i] + plane.z * centerZ[i] + plane.w;
+			float radius = fabsf(plane.x) * extentX[i] + fabsf(plane.y) * extentY[i] + fabsf(plane.z) * extentZ[i];
+			inside = distance + radius >= 0.0f;
+		}
+
+		if (inside)
+			visible.push_back(i);
+	}
+}
+
+// --------------------------------------------------------
+// 8 boxes per iteration on CPUs with AVX (scalar otherwise)
+// --------------------------------------------------------
+void FrustumCuller::CullSIMD(const Frustum& frustum, std::vector<unsigned int>& visible)
+{
+#if CPU_X86
+	if (HasSIMD()) {
+		const float* soa[6] = { centerX.data(), centerY.data(), centerZ.data(), extentX.data(), extentY.data(), extentZ.data() };
+		size_t start = visible.size();
+		visible.resize(start + count);
+		unsigned int written = CullAVX(frustum, soa, centerX.size(), visible.data() + start);
+		visible.resize(start + written);
+		return;
+	}
+#endif
+
+	CullScalar(frustum, visible);
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+//std
+#include <vector>
+#include <cstddef>
+
+//Bounds
+#include "Bounds.h"
+
+// --------------------------------------------------------
+// Flat frustum culler over a fixed list of boxes.  Centers
+// and extents are kept in structure-of-arrays form so the
+// AVX path can test 8 boxes against all 6 planes at once;
+// CPUs without AVX fall back to the scalar loop (checked
+// at runtime - see CpuFeatures.h).
+// --------------------------------------------------------
+class FrustumCuller
+{
+public:
+	FrustumCuller();
+
+	//Box storage (index is whatever the caller wants back from Cull)
+	void Resize(unsigned int count);
+	void SetBox(unsigned int index, const AABB& box);
+	unsigned int GetCount();
+
+	//Appends the index of every box not fully outside the frustum
+	void Cull(const Frustum& frustum, std::vector<unsigned int>& visible);
+
+	//Both paths are exposed so they can be compared against each other
+	void CullScalar(const Frustum& frustum, std::vector<unsigned int>& visible);
+	void CullSIMD(const Frustum& frustum, std::vector<unsigned int>& visible);
+	static bool HasSIMD();
+
+private:
+	unsigned int count;
+
+	//padded up to a multiple of 8 so the AVX loop never reads past the end
+	std::vector<float> centerX, centerY, centerZ;
+	std::vector<float> extentX, extentY, extentZ;
+
+	// --------------------------------------------------------
+	// The AVX kernel, in FrustumCullerAVX.cpp (the only file
+	// built with AVX enabled).  soa is centerX/Y/Z then
+	// extentX/Y/Z, padded boxes long; writes surviving indices
+	// to out and returns how many.
+	// --------------------------------------------------------
+	static unsigned int CullAVX(const Frustum& frustum, const float* const soa[6], size_t padded, unsigned int* out);
+};
@@ -0,0 +1,74 @@
+#include "FrustumCuller.h"
+
+//Program
+#include "CpuFeatures.h"
+
+// --------------------------------------------------------
+// Built with AVX enabled (/arch:AVX on this file only), so
+// nothing here may run before CpuHasAVX() says it can.
+// Sticks to intrinsics and raw pointers - an inline
+// function from a shared header compiled here could be the
+// copy the linker keeps for the whole program.
+// --------------------------------------------------------
+#if CPU_X86
+
+//C++
+#include <cmath>
+#include <immintrin.h>
+
+using namespace DirectX;
+
+// --------------------------------------------------------
+// 8 boxes per iteration, all 6 planes, then the surviving
+// lanes are written out in order from the movemask bits
+// --------------------------------------------------------
+unsigned int FrustumCuller::CullAVX(const Frustum& frustum, const float* const soa[6], size_t padded, unsigned int* out)
+{
+	//broadcast each plane (and its absolute normal) once up front
+	__m256 nx[6], ny[6], nz[6], nd[6], ax[6], ay[6], az[6];
+	for (int p = 0; p < 6; p++) {
+		const XMFLOAT4& plane = frustum.planes[p];
+		nx[p] = _mm256_set1_ps(plane.x);
+		ny[p] = _mm256_set1_ps(plane.y);
+		nz[p] = _mm256_set1_ps(plane.z);
+		nd[p] = _mm256_set1_ps(plane.w);
+		ax[p] = _mm256_set1_ps(fabsf(plane.x));
+		ay[p] = _mm256_set1_ps(fabsf(plane.y));
+		az[p] = _mm256_set1_ps(fabsf(plane.z));
+	}
+
+	const __m256 zero = _mm256_setzero_ps();
+	unsigned int written = 0;
+
+	for (size_t i = 0; i < padded; i += 8) {
+		__m256 cx = _mm256_loadu_ps(soa[0] + i);
+		__m256 cy = _mm256_loadu_ps(soa[1] + i);
+		__m256 cz = _mm256_loadu_ps(soa[2] + i);
+		__m256 ex = _mm256_loadu_ps(soa[3] + i);
+		__m256 ey = _mm256_loadu_ps(soa[4] + i);
+		__m256 ez = _mm256_loadu_ps(soa[5] + i);
+
+		__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+		for (int p = 0; p < 6; p++) {
+			//same order of operations as CullScalar, so both agree on boxes touching a plane
+			__m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(nx[p], cx), _mm256_mul_ps(ny[p], cy)),
+				_mm256_mul_ps(nz[p], cz)), nd[p]);
+			__m256 radius = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ax[p], ex), _mm256_mul_ps(ay[p], ey)),
+				_mm256_mul_ps(az[p], ez));
+			inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(distance, radius), zero, _CMP_GE_OQ));
+		}
+
+		//padding lanes have -inf extents, so they always fail the compare
+		unsigned int mask = (unsigned int)_mm256_movemask_ps(inside);
+		while (mask) {
+			unsigned int lane = 0;
+			while (!(mask & (1u << lane))) lane++;
+			out[written++] = (unsigned int)i + lane;
+			mask &= mask - 1;
+		}
+	}
+
+	return written;
+}
+
+#endif
@@ -4,6 +4,12 @@
 #pragma comment(lib, "d3dcompiler.lib")
 #include <d3dcompiler.h>
 
+//C++
+#include <cfloat>
+#include <cassert>
+#include <cstdio>
+#include <fstream>
+
 //ImGui
 #include "ImGui/imgui.h"
 #include "ImGui/imgui_impl_dx11.h"
@@ -13,6 +19,9 @@
 #define FIXPATH(x) FixPath(x).c_str()
 #define UISTEP 0.05f
 
+//1 to write the reflected layout of every buffer ShaderConstants.h mirrors to Tests/ShaderLayouts at startup
+#define DUMP_SHADER_LAYOUTS 0
+
 // For the DirectX Math library
 using namespace DirectX;
 
@@ -35,19 +44,24 @@ void Game::Initialize()
 	//CAMERA
 
 	for (unsigned int i = 0; i < 2; i++) {
-		cameras.push_back(std::make_shared<Camera>(
-			XMFLOAT3(0, 0, -15), 4.0f, 0.005f, XM_PIDIV4, Window::AspectRatio()));
-	}
+		Handle<Camera> camera = cameras.Emplace(
+			XMFLOAT3(0, 0, -15), 4.0f, 0.005f, XM_PIDIV4, Window::AspectRatio());
 
-	currentCamera = cameras[0];
+		if (i == 0)
+			currentCamera = camera;
+	}
 
 	//Generates light sources (directional, point, spot) and sets the ambient color
 	CreateLighting();
 
 	//Creates meshes, materials, and entities
 	CreateGeometry();
+	ValidateShaderConstants();
 
-	Graphics::Context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	StateCache::For(Graphics::Context.Get()).IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
+	//without offset binding, per-draw constants just use each shader's own buffers
+	constantRing.Initialize(Graphics::Device, Graphics::Context);
 }
 
 
@@ -106,26 +120,28 @@ void Game::CreateGeometry()
 
 	//CREATE MESHES
 
-	meshes.push_back(std::make_shared<Mesh>("Cube", FIXPATH("../../Assets/Models/cube.obj")));
-	meshes.push_back(std::make_shared<Mesh>("Cylinder", FIXPATH("../../Assets/Models/cylinder.obj")));
-	meshes.push_back(std::make_shared<Mesh>("Helix", FIXPATH("../../Assets/Models/helix.obj")));
-	meshes.push_back(std::make_shared<Mesh>("Sphere", FIXPATH("../../Assets/Models/sphere.obj")));
-	meshes.push_back(std::make_shared<Mesh>("Torus", FIXPATH("../../Assets/Models/torus.obj")));
-	meshes.push_back(std::make_shared<Mesh>("Quad_Double", FIXPATH("../../Assets/Models/quad_double_sided.obj")));
-	meshes.push_back(std::make_shared<Mesh>("Quad", FIXPATH("../../Assets/Models/quad.obj")));
+	Handle<Mesh> cube = meshes.Emplace("Cube", FIXPATH("../../Assets/Models/cube.obj"));
+	Handle<Mesh> cylinder = meshes.Emplace("Cylinder", FIXPATH("../../Assets/Models/cylinder.obj"));
+	Handle<Mesh> helix = meshes.Emplace("Helix", FIXPATH("../../Assets/Models/helix.obj"));
+	Handle<Mesh> sphere = meshes.Emplace("Sphere", FIXPATH("../../Assets/Models/sphere.obj"));
+	Handle<Mesh> torus = meshes.Emplace("Torus", FIXPATH("../../Assets/Models/torus.obj"));
+	Handle<Mesh> quadDouble = meshes.Emplace("Quad_Double", FIXPATH("../../Assets/Models/quad_double_sided.obj"));
+	Handle<Mesh> quad = meshes.Emplace("Quad", FIXPATH("../../Assets/Models/quad.obj"));
 
 	//CREATE SHADERS
 
-	vss.push_back(std::make_shared<SimpleVertexShader>(Graphics::Device, Graphics::Context, FIXPATH(L"VertexShader.cso")));
-	vss.push_back(std::make_shared<SimpleVertexShader>(Graphics::Device, Graphics::Context, FIXPATH(L"VertexShader_Sky.cso")));
+	vsNames = { "VertexShader", "VertexShader_Sky", "VertexShader_Instanced" };
+	for (const std::string& name : vsNames)
+		vss.push_back(std::make_shared<SimpleVertexShader>(Graphics::Device, Graphics::Context, FIXPATH(NarrowToWide(name + ".cso"))));
 
-	pss.push_back(std::make_shared<SimplePixelShader>(Graphics::Device, Graphics::Context, FIXPATH(L"PixelShader.cso")));
-	pss.push_back(std::make_shared<SimplePixelShader>(Graphics::Device, Graphics::Context, FIXPATH(L"PixelShader_Sky.cso")));
+	psNames = { "PixelShader", "PixelShader_Sky" };
+	for (const std::string& name : psNames)
+		pss.push_back(std::make_shared<SimplePixelShader>(Graphics::Device, Graphics::Context, FIXPATH(NarrowToWide(name + ".cso"))));
 
 	//CREATE SKYBOX
 	#define MAKESRV(srv, texFile) DirectX::CreateWICTextureFromFile(Graphics::Device.Get(), Graphics::Context.Get(), texFile, 0, srv.GetAddressOf());
 	
-	sky = std::make_shared<Sky>(samplerState, meshes[0], vss[1], pss[1]);
+	sky = std::make_shared<Sky>(samplerState, meshes.Get(cube), vss[1], pss[1]);
 
 	//create SRV
 	sky->CreateCubemap(
@@ -161,41 +177,180 @@ void Game::CreateGeometry()
 
 	//CREATE MATERIALS
 
-	materials.push_back(std::make_shared<Material>("Denim Normal", XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f), vss[0], pss[0], 0.8f));
-	materials[0]->AddTextureSRV("SurfaceTexture", denimBCSRV);
-	materials[0]->AddTextureSRV("NormalMap", denimNSRV);
-	materials[0]->AddSampler("BasicSampler", samplerState);
+	Handle<Material> denimNormal = materials.Emplace("Denim Normal", XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f), vss[0], pss[0], 0.8f);
+	materials.Get(denimNormal)->AddTextureSRV("SurfaceTexture", denimBCSRV);
+	materials.Get(denimNormal)->AddTextureSRV("NormalMap", denimNSRV);
+	materials.Get(denimNormal)->AddSampler("BasicSampler", samplerState);
+
+	Handle<Material> denimBrown = materials.Emplace("Denim Brown", XMFLOAT4(0.8f, 0.5f, 0.0f, 1.0f), vss[0], pss[0], 0.4f);
+	materials.Get(denimBrown)->AddTextureSRV("SurfaceTexture", denimBCSRV);
+	materials.Get(denimBrown)->AddTextureSRV("NormalMap", denimNSRV);
+	materials.Get(denimBrown)->AddSampler("BasicSampler", samplerState);
 
-	materials.push_back(std::make_shared<Material>("Denim Brown", XMFLOAT4(0.8f, 0.5f, 0.0f, 1.0f), vss[0], pss[0], 0.4f));
-	materials[1]->AddTextureSRV("SurfaceTexture", denimBCSRV);
-	materials[1]->AddTextureSRV("NormalMap", denimNSRV);
-	materials[1]->AddSampler("BasicSampler", samplerState);
+	Handle<Material> bricks = materials.Emplace("Bricks Normal", XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f), vss[0], pss[0], 1.0f);
+	materials.Get(bricks)->AddTextureSRV("SurfaceTexture", brickBCSRV);
+	materials.Get(bricks)->AddTextureSRV("NormalMap", brickNSRV);
+	materials.Get(bricks)->AddSampler("BasicSampler", samplerState);
 
-	materials.push_back(std::make_shared<Material>("Bricks Normal", XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f), vss[0], pss[0], 1.0f));
-	materials[2]->AddTextureSRV("SurfaceTexture", brickBCSRV);
-	materials[2]->AddTextureSRV("NormalMap", brickNSRV);
-	materials[2]->AddSampler("BasicSampler", samplerState);
+	Handle<Material> cushion = materials.Emplace("Cushion", XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f), vss[0], pss[0], 0.2f, XMFLOAT2{1.5f, 1.5f});
+	materials.Get(cushion)->AddTextureSRV("SurfaceTexture", cushionBCSRV);
+	materials.Get(cushion)->AddTextureSRV("NormalMap", cushionNSRV);
+	materials.Get(cushion)->AddSampler("BasicSampler", samplerState);
 
-	materials.push_back(std::make_shared<Material>("Cushion", XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f), vss[0], pss[0], 0.2f, XMFLOAT2{1.5f, 1.5f}));
-	materials[3]->AddTextureSRV("SurfaceTexture", cushionBCSRV);
-	materials[3]->AddTextureSRV("NormalMap", cushionNSRV);
-	materials[3]->AddSampler("BasicSampler", samplerState);
+	//every material above uses the regular vertex shader, so all of them can instance
+	materials.Each([&](Handle<Material>, Material& material) { material.SetInstancedVertexShader(vss[2]); });
 
 	//CREATE ENTITIES
 
-	entities.push_back(std::make_shared<Entity>(meshes[0], materials[0], std::make_shared<Transform>(-7.5f, +2.0f, 0.0f)));
-	entities.push_back(std::make_shared<Entity>(meshes[1], materials[1], std::make_shared<Transform>(-4.5f, +2.0f, 0.0f)));
-	entities.push_back(std::make_shared<Entity>(meshes[2], materials[0], std::make_shared<Transform>(-1.5f, +2.0f, 0.0f)));
-	entities.push_back(std::make_shared<Entity>(meshes[3], materials[1], std::make_shared<Transform>(+1.5f, +2.0f, 0.0f)));
-	entities.push_back(std::make_shared<Entity>(meshes[4], materials[0], std::make_shared<Transform>(+4.5f, +2.0f, 0.0f)));
-	entities.push_back(std::make_shared<Entity>(meshes[5], materials[1], std::make_shared<Transform>(+7.5f, +2.0f, 0.0f)));
-
-	entities.push_back(std::make_shared<Entity>(meshes[0], materials[2], std::make_shared<Transform>(-7.5f, -2.0f, 0.0f)));
-	entities.push_back(std::make_shared<Entity>(meshes[1], materials[3], std::make_shared<Transform>(-4.5f, -2.0f, 0.0f)));
-	entities.push_back(std::make_shared<Entity>(meshes[2], materials[2], std::make_shared<Transform>(-1.5f, -2.0f, 0.0f)));
-	entities.push_back(std::make_shared<Entity>(meshes[3], materials[3], std::make_shared<Transform>(+1.5f, -2.0f, 0.0f)));
-	entities.push_back(std::make_shared<Entity>(meshes[6], materials[2], std::make_shared<Transform>(+4.5f, -2.0f, 0.0f)));
-	entities.push_back(std::make_shared<Entity>(meshes[5], materials[3], std::make_shared<Transform>(+7.5f, -2.0f, 0.0f)));
+	CreateEntity(cube, denimNormal, XMFLOAT3(-7.5f, +2.0f, 0.0f));
+	CreateEntity(cylinder, denimBrown, XMFLOAT3(-4.5f, +2.0f, 0.0f));
+	CreateEntity(helix, denimNormal, XMFLOAT3(-1.5f, +2.0f, 0.0f));
+	CreateEntity(sphere, denimBrown, XMFLOAT3(+1.5f, +2.0f, 0.0f));
+	CreateEntity(torus, denimNormal, XMFLOAT3(+4.5f, +2.0f, 0.0f));
+	CreateEntity(quadDouble, denimBrown, XMFLOAT3(+7.5f, +2.0f, 0.0f));
+
+	CreateEntity(cube, bricks, XMFLOAT3(-7.5f, -2.0f, 0.0f));
+	CreateEntity(cylinder, cushion, XMFLOAT3(-4.5f, -2.0f, 0.0f));
+	CreateEntity(helix, bricks, XMFLOAT3(-1.5f, -2.0f, 0.0f));
+	CreateEntity(sphere, cushion, XMFLOAT3(+1.5f, -2.0f, 0.0f));
+	CreateEntity(quad, bricks, XMFLOAT3(+4.5f, -2.0f, 0.0f));
+	CreateEntity(quadDouble, cushion, XMFLOAT3(+7.5f, -2.0f, 0.0f));
+
+	std::vector<RenderableComponent>& renderables = scene.Pool<RenderableComponent>().GetComponents();
+
+	//the cubes are solid, so they make good occluders
+	renderables[0].occluder = true;
+	renderables[6].occluder = true;
+
+	//CREATE PORTAL CELLS
+
+	//the two halves of the scene, open to each other across x = 0
+	int left = portalSystem.AddCell({ XMFLOAT3(-12.0f, -10.0f, -20.0f), XMFLOAT3(0.0f, 10.0f, 20.0f) });
+	int right = portalSystem.AddCell({ XMFLOAT3(0.0f, -10.0f, -20.0f), XMFLOAT3(12.0f, 10.0f, 20.0f) });
+	portalSystem.AddPortal(left, right, {
+		XMFLOAT3(0.0f, -10.0f, -20.0f), XMFLOAT3(0.0f, 10.0f, -20.0f),
+		XMFLOAT3(0.0f, 10.0f, 20.0f), XMFLOAT3(0.0f, -10.0f, 20.0f) });
+
+	//ADD ENTITIES TO THE BVH AND THEIR PORTAL CELLS
+
+	for (unsigned int i = 0; i < renderables.size(); i++) {
+		RenderableComponent& entity = renderables[i];
+		UpdateWorldBounds(entity);
+		entity.bvhProxy = sceneBVH.Insert(entity.worldBounds, i);
+		portalSystem.FindCells(entity.worldBounds, entity.cells);
+	}
+}
+
+// --------------------------------------------------------
+// Writes what reflection reports for one buffer to
+// Tests/ShaderLayouts/<shader>.<buffer>.txt, the files
+// CBufferLayoutTests checks ShaderConstants.h against
+// (see DUMP_SHADER_LAYOUTS)
+// --------------------------------------------------------
+static void DumpShaderLayout(ISimpleShader* shader, const std::string& shaderName, const std::string& bufferName)
+{
+	CBufferLayout reflected;
+	if (!shader->GetBufferLayout(bufferName, &reflected))
+		return;
+
+	//binary, so the files keep their LF line endings
+	std::string path = FixPath("../../Tests/ShaderLayouts/" + shaderName + "." + bufferName + ".txt");
+	std::ofstream out(path, std::ios::binary);
+	out << SerializeCBufferLayout(reflected);
+	printf("%s %s\n", out ? "Wrote" : "Couldn't write", path.c_str());
+}
+
+// --------------------------------------------------------
+// Checks one buffer of a loaded shader against the struct
+// meant to fill it.  Shaders without the buffer are fine;
+// a shader with it laid out differently is a bug, so it's
+// reported on the console (with the reflected layout, to
+// refresh Tests/ShaderLayouts from) and stops debug builds
+// here.  Returns the buffer's index, or -1 if it can't be
+// set as a struct.
+// --------------------------------------------------------
+static int CheckShaderBuffer(ISimpleShader* shader, const std::string& shaderName, const CBufferLayout& layout)
+{
+	int index = shader->GetBufferIndex(layout.name);
+	if (index < 0)
+		return -1;
+
+#if DUMP_SHADER_LAYOUTS
+	DumpShaderLayout(shader, shaderName, layout.name);
+#endif
+
+	std::string error;
+	if (!shader->ValidateBufferLayout(layout, &error)) {
+		CBufferLayout reflected;
+		shader->GetBufferLayout(layout.name, &reflected);
+		printf("%s doesn't match ShaderConstants.h:\n%sReflected:\n%s", shaderName.c_str(), error.c_str(), SerializeCBufferLayout(reflected).c_str());
+		assert(!"Constant buffer layout mismatch (see console)");
+		return -1;
+	}
+	return index;
+}
+
+void Game::ValidateShaderConstants()
+{
+	vsFrameBuffers.clear();
+	for (unsigned int i = 0; i < vss.size(); i++) {
+		vsFrameBuffers.push_back(CheckShaderBuffer(vss[i].get(), vsNames[i], VSPerFrame::Layout()));
+		CheckShaderBuffer(vss[i].get(), vsNames[i], VSPerObject::Layout());
+	}
+
+	psFrameBuffers.clear();
+	for (unsigned int i = 0; i < pss.size(); i++) {
+		psFrameBuffers.push_back(CheckShaderBuffer(pss[i].get(), psNames[i], PSPerFrame::Layout()));
+		CheckShaderBuffer(pss[i].get(), psNames[i], PSPerMaterial::Layout());
+		CheckShaderBuffer(pss[i].get(), psNames[i], PSPerObject::Layout());
+	}
+}
+
+// --------------------------------------------------------
+// Refits the BVH leaves, culler boxes and portal cells of
+// any entity whose transform changed, and rebuilds the BVH
+// if that has degraded the tree
+// --------------------------------------------------------
+void Game::UpdateSceneBounds()
+{
+	std::vector<RenderableComponent>& renderables = scene.Pool<RenderableComponent>().GetComponents();
+
+	bool resized = frustumCuller.GetCount() != renderables.size();
+	if (resized)
+		frustumCuller.Resize((unsigned int)renderables.size());
+
+	for (unsigned int i = 0; i < renderables.size(); i++) {
+		RenderableComponent& entity = renderables[i];
+		if (UpdateWorldBounds(entity)) {
+			sceneBVH.Refit(entity.bvhProxy, entity.worldBounds);
+			frustumCuller.SetBox(i, entity.worldBounds);
+
+			//FindCells clears and refills, so moving between cells stops allocating quickly
+			portalSystem.FindCells(entity.worldBounds, entity.cells);
+		}
+		else if (resized) {
+			frustumCuller.SetBox(i, entity.worldBounds);
+		}
+	}
+
+	sceneBVH.RebuildIfNeeded();
+}
+
+// --------------------------------------------------------
+// Rebuilds an entity's world bounds if its transform has
+// changed since they were last built.  Returns true if
+// they changed.
+// --------------------------------------------------------
+bool Game::UpdateWorldBounds(RenderableComponent& entity)
+{
+	Transform* transform = transforms.Get(entity.transform);
+	if (entity.boundsValid && entity.boundsVersion == transform->GetVersion())
+		return false;
+
+	entity.worldBounds = AABBTransform(meshes.Get(entity.mesh)->GetLocalBounds(), transform->GetWorldMatrix());
+	entity.boundsVersion = transform->GetVersion();
+	entity.boundsValid = true;
+	return true;
 }
 
 // --------------------------------------------------------
@@ -204,8 +359,8 @@ void Game::CreateGeometry()
 // --------------------------------------------------------
 void Game::OnResize()
 {
-	if (currentCamera)
-		currentCamera->UpdateProjectionMatrix(Window::AspectRatio());
+	if (Camera* camera = cameras.Get(currentCamera))
+		camera->UpdateProjectionMatrix(Window::AspectRatio());
 }
 
 // --------------------------------------------------------
@@ -217,20 +372,45 @@ void Game::Update(float deltaTime, float totalTime)
 {
 	//ui
 	UIInfo(deltaTime);
-	UIUpdate(deltaTime, currentCamera, cameras, meshes, entities, materials, lights);
+	UIUpdate(deltaTime, currentCamera, cameras, meshes, transforms, scene.Pool<RenderableComponent>().GetComponents(), materials, scene.Pool<LightComponent>().GetComponents(), renderStats, renderSettings, selectedEntity, transformEdits);
 
 	// Example input checking: Quit if the escape key is pressed
 	if (Input::KeyDown(VK_ESCAPE))
 		Window::Quit();
 
-	currentCamera->Update(deltaTime);
+	//right click selects whatever is under the mouse (unless it's over the UI)
+	if (Input::MouseRightPress() && !ImGui::GetIO().WantCaptureMouse) {
+		UpdateSceneBounds();
+
+		Ray ray = cameras.Get(currentCamera)->GetPickRay((float)Input::GetMouseX(), (float)Input::GetMouseY(), (float)Window::Width(), (float)Window::Height());
+		float distance;
+		selectedEntity = PickEntity(ray, &distance);
+	}
+
+	cameras.Get(currentCamera)->Update(deltaTime);
+}
+
+// --------------------------------------------------------
+// Runs at a fixed rate, independent of the frame rate
+//  - Simulation (physics, gameplay movement) goes here
+//  - Draw() blends between the last two steps
+// --------------------------------------------------------
+void Game::FixedUpdate(float stepTime, float simulationTime)
+{
+	//snapshot where everything was before this step
+	scene.Each<RenderableComponent>([&](EntityID, RenderableComponent& entity) {
+		transforms.Get(entity.transform)->SavePrevious();
+	});
+
+	//entity movement - the UI only queues it, so it happens here at the fixed rate
+	ApplyTransformEdits(transformEdits);
 }
 
 
 // --------------------------------------------------------
 // Clear the screen, redraw everything, present to the user
 // --------------------------------------------------------
-void Game::Draw(float deltaTime, float totalTime)
+void Game::Draw(float deltaTime, float totalTime, float alpha)
 {
 	// Frame START
 	// - These things should happen ONCE PER FRAME
@@ -240,21 +420,83 @@ void Game::Draw(float deltaTime, float totalTime)
 		//const float color[4] = { 0.4f, 0.6f, 0.75f, 0.0f };
 		Graphics::Context->ClearRenderTargetView(Graphics::BackBufferRTV.Get(), backgroundColor);
 		Graphics::Context->ClearDepthStencilView(Graphics::DepthBufferDSV.Get(), D3D11_CLEAR_DEPTH, 1.0f, 0);
+
+		StateCache::For(Graphics::Context.Get()).ResetCounters();
 	}
 
-	for (unsigned int i = 0; i < entities.size(); i++) { 
-		entities[i]->GetMaterial()->GetPixelShader()->SetFloat3("ambient", ambientColor);
-		entities[i]->GetMaterial()->GetPixelShader()->SetInt("lightCount", (int)lights.size());
-		entities[i]->GetMaterial()->GetPixelShader()->SetData("lights", &lights[0], sizeof(Light) * (int)lights.size());
-		entities[i]->Draw(currentCamera);
+	Camera* camera = cameras.Get(currentCamera);
+
+	UpdateSceneBounds();
+	CullEntities(camera);
+	if (renderSettings.debugViewCulling)
+		CullViews();
+	else
+		renderStats.entitiesVisiblePerView.clear();
+
+	constantRing.BeginFrame();
+	ConstantBufferRing* ring = renderSettings.constantRing && constantRing.IsSupported() ? &constantRing : nullptr;
+
+	ISimpleShader::UploadedBytes = 0;
+	ISimpleShader::UploadsIssued = 0;
+	ISimpleShader::UploadsSkipped = 0;
+	UpdateLightGrid();
+	UploadFrameConstants(camera);
+	renderStats.lightsUploaded = 0;
+
+	BuildRenderQueue(camera);
+	BuildInstanceBatches(alpha);
+	renderStats.drawCalls = 0;
+	renderStats.shaderChanges = 0;
+	renderStats.materialChanges = 0;
+	renderStats.meshChanges = 0;
+	renderStats.instancedBatches = 0;
+	renderStats.instancesDrawn = 0;
+
+	//slices of the sorted batches are recorded on worker threads, then replayed here in order
+	ThreadPool* pool = renderSettings.parallelRecording ? &recordingPool : nullptr;
+	if (drawRecorders.size() < recordingPool.GetWorkerCount() + 1)
+		drawRecorders.resize(recordingPool.GetWorkerCount() + 1);
+
+	unsigned int slices = RecordCommandsParallel(drawCommands, (unsigned int)instanceBatcher.GetBatches().size(), pool,
+		[&](CommandBuffer& commands, unsigned int slice, unsigned int begin, unsigned int end) {
+			RecordBatches(begin, end, alpha, commands, drawRecorders[slice]);
+		});
+
+	D3D11CommandBackend backend(instanceBuffer.Get(), sizeof(InstanceData), ring);
+	renderStats.commandBuffers = slices;
+	renderStats.commandBytes = 0;
+	for (unsigned int s = 0; s < slices; s++) {
+		backend.Execute(drawCommands[s]);
+		renderStats.commandBytes += (unsigned int)drawCommands[s].GetSize();
+
+		const RenderStats& stats = drawRecorders[s].stats;
+		renderStats.drawCalls += stats.drawCalls;
+		renderStats.shaderChanges += stats.shaderChanges;
+		renderStats.materialChanges += stats.materialChanges;
+		renderStats.meshChanges += stats.meshChanges;
+		renderStats.instancedBatches += stats.instancedBatches;
+		renderStats.instancesDrawn += stats.instancesDrawn;
+		renderStats.lightsUploaded += stats.lightsUploaded;
 	}
 
-	sky->Draw(currentCamera);
+	sky->Draw(camera);
+	renderStats.constantBytesUploaded = ISimpleShader::UploadedBytes;
+	renderStats.constantUploadsIssued = ISimpleShader::UploadsIssued;
+	renderStats.constantUploadsSkipped = ISimpleShader::UploadsSkipped;
+
+	constantRing.EndFrame();
+	renderStats.constantRingUsed = constantRing.GetUsed();
+
+	renderStats.stateCallsIssued = StateCache::For(Graphics::Context.Get()).GetIssuedCount();
+	renderStats.stateCallsFiltered = StateCache::For(Graphics::Context.Get()).GetFilteredCount();
 	 
 	//prepares ImGUI buffers and uses them to draw on screen
 	{
 		ImGui::Render(); // Turns this frames UI into renderable triangles
 		ImGui_ImplDX11_RenderDrawData(ImGui::GetDrawData()); // Draws it to the screen
+
+		//ImGui binds its own shaders, buffers and textures
+		StateCache::For(Graphics::Context.Get()).Invalidate();
 	}
 
 	// Frame END
@@ -272,11 +514,592 @@ void Game::Draw(float deltaTime, float totalTime)
 			1,
 			Graphics::BackBufferRTV.GetAddressOf(),
 			Graphics::DepthBufferDSV.Get());
+
+		// Everything downstream has seen this frame's transform changes
+		Transform::ClearChangedThisFrame();
 	}
 }
 
+// --------------------------------------------------------
+// Builds visibleEntities for this frame.  Entities whose
+// cached result is stale go through the frustum, portal,
+// contribution and occlusion stages (each one narrows
+// visibleEntities in place); everyone else reuses the
+// visibility cache.  With caching on, the frustum and
+// portal stages use a frustum grown by the cache's slack,
+// so a stored result still holds for any view the cache
+// accepts.
+// --------------------------------------------------------
+void Game::CullEntities(Camera* camera)
+{
+	std::vector<RenderableComponent>& renderables = scene.Pool<RenderableComponent>().GetComponents();
+
+	//a cached walk costs about what the batched frustum pass does, so caching only
+	//pays when it also skips the later stages (and the slack draws a few more entities)
+	bool portals = renderSettings.portalCulling && portalSystem.GetCellCount() > 0;
+	bool caching = renderSettings.visibilityCaching && (portals || renderSettings.contributionCulling || renderSettings.occlusionCulling);
+
+	Frustum frustum = camera->GetFrustum();
+	if (caching)
+		frustum = FrustumInflate(frustum, visibilityCache.GetFrustumSlack(camera->GetFarClip()));
+
+	bool full = visibilityCache.BeginFrame(camera->GetView(), camera->GetProjection(), (unsigned int)renderables.size());
+
+	//new culling settings can change anyone's result
+	if (!caching || !renderSettings.SameCulling(cachedSettings))
+		full = true;
+	cachedSettings = renderSettings;
+
+	//one walk: cached answers are collected as they are, and only stale entities
+	//go through the stages (they start out hidden), unless a changed flag or a
+	//moving occluder turns up - those can change anyone's result
+	unsigned int tested = 0;
+	visibleEntities.clear();
+	cachedVisible.clear();
+	for (unsigned int i = 0; i < renderables.size() && !full; i++) {
+		RenderableComponent& renderable = renderables[i];
+		unsigned int version = transforms.Get(renderable.transform)->GetVersion();
+		if (!visibilityCache.IsStale(i, version, renderable.stateVersion)) {
+			if (visibilityCache.IsVisible(i))
+				cachedVisible.push_back(i);
+			continue;
+		}
+
+		if (visibilityCache.IsStateStale(i, renderable.stateVersion) || (renderSettings.occlusionCulling && renderable.occluder)) {
+			full = true;
+			break;
+		}
+
+		//a handful of entities isn't worth the batched pass
+		visibilityCache.Store(i, version, renderable.stateVersion, false);
+		tested++;
+		if (FrustumTestAABB(frustum, renderable.worldBounds) != CullResult::Outside)
+			visibleEntities.push_back(i);
+	}
+
+	//everyone is retested (whatever the walk got through is thrown away)
+	if (full) {
+		visibilityCache.Invalidate();
+		visibleEntities.clear();
+		cachedVisible.clear();
+		for (unsigned int i = 0; i < renderables.size(); i++)
+			visibilityCache.Store(i, transforms.Get(renderables[i].transform)->GetVersion(), renderables[i].stateVersion, false);
+		tested = (unsigned int)renderables.size();
+		frustumCuller.Cull(frustum, visibleEntities);
+	}
+
+	renderStats.entitiesTotal = (unsigned int)renderables.size();
+	renderStats.entitiesRetested = tested;
+	renderStats.entitiesFrustumCulled = tested - (unsigned int)visibleEntities.size();
+	renderStats.entitiesPortalCulled = 0;
+	renderStats.entitiesContributionCulled = 0;
+	renderStats.entitiesOcclusionCulled = 0;
+	renderStats.occluderTriangles = 0;
+
+	//nothing to retest means no occluders to rasterize either
+	if (portals && !visibleEntities.empty())
+		PortalCullEntities(camera, frustum);
+	if (renderSettings.contributionCulling && !visibleEntities.empty())
+		ContributionCullEntities(camera);
+	if (renderSettings.occlusionCulling && !visibleEntities.empty())
+		OcclusionCullEntities(camera, frustum);
+
+	for (unsigned int i : visibleEntities)
+		visibilityCache.Store(i, transforms.Get(renderables[i].transform)->GetVersion(), renderables[i].stateVersion, true);
+
+	//untouched entities keep their cached answer
+	visibleEntities.insert(visibleEntities.end(), cachedVisible.begin(), cachedVisible.end());
+
+	//results from the exact frustum don't hold for the views the cache accepts
+	visibilityCache.EndFrame();
+	if (!caching)
+		visibilityCache.Invalidate();
+	renderStats.entitiesVisible = (unsigned int)visibleEntities.size();
+	renderStats.entitiesEntered = (unsigned int)visibilityCache.GetEntered().size();
+	renderStats.entitiesExited = (unsigned int)visibilityCache.GetExited().size();
+}
+
+// --------------------------------------------------------
+// Debug pass: gathers every camera's frustum and culls them
+// all against the BVH at once, for the per-camera counts in
+// the UI.  Only the current camera is drawn, so nothing
+// else reads viewVisibleEntities yet - the BVH answers with
+// fat leaf boxes, so each hit gets an exact box test before
+// it's counted.
+// --------------------------------------------------------
+void Game::CullViews()
+{
+	std::vector<RenderableComponent>& renderables = scene.Pool<RenderableComponent>().GetComponents();
+
+	std::vector<Frustum> frustums;
+	std::vector<unsigned int> slots;
+	cameras.Each([&](Handle<Camera> handle, Camera& camera) {
+		if (frustums.size() < MAX_BVH_VIEWS) {
+			frustums.push_back(camera.GetFrustum());
+			slots.push_back(handle.index);
+		}
+	});
+
+	std::vector<std::vector<int>> results(frustums.size());
+	sceneBVH.QueryFrustums(frustums.data(), (int)frustums.size(), results.data());
+
+	viewVisibleEntities.clear();
+	renderStats.entitiesVisiblePerView.clear();
+	for (size_t v = 0; v < slots.size(); v++) {
+		//fat leaves let near misses through
+		std::vector<int>& hits = results[v];
+		unsigned int kept = 0;
+		for (int i : hits) {
+			if (FrustumTestAABB(frustums[v], renderables[i].worldBounds) != CullResult::Outside)
+				hits[kept++] = i;
+		}
+		hits.resize(kept);
+
+		if (viewVisibleEntities.size() <= slots[v]) {
+			viewVisibleEntities.resize(slots[v] + 1);
+			renderStats.entitiesVisiblePerView.resize(slots[v] + 1, 0);
+		}
+
+		renderStats.entitiesVisiblePerView[slots[v]] = (unsigned int)results[v].size();
+		viewVisibleEntities[slots[v]].swap(results[v]);
+	}
+}
+
+// --------------------------------------------------------
+// Walks the portal graph from the camera's cell and keeps
+// entities overlapping any cell it reached (or in no cell
+// at all)
+// --------------------------------------------------------
+void Game::PortalCullEntities(Camera* camera, const Frustum& frustum)
+{
+	std::vector<RenderableComponent>& renderables = scene.Pool<RenderableComponent>().GetComponents();
+
+	portalSystem.ComputeVisibleCells(camera->GetTransform()->GetPosition(), frustum);
+
+	unsigned int kept = 0;
+	for (unsigned int i : visibleEntities) {
+		const std::vector<int>& cells = renderables[i].cells;
+		if (cells.empty() || portalSystem.IsAnyCellVisible(cells))
+			visibleEntities[kept++] = i;
+	}
+
+	renderStats.entitiesPortalCulled = (unsigned int)visibleEntities.size() - kept;
+	visibleEntities.resize(kept);
+}
+
+// --------------------------------------------------------
+// Estimates each entity's on-screen size from a sphere
+// around its world bounds and drops anything under the
+// threshold:
+//   perspective   pixels = radius / (distance * tan(fov / 2)) * (height / 2)
+//   orthographic  pixels = radius * height / view height
+// --------------------------------------------------------
+void Game::ContributionCullEntities(Camera* camera)
+{
+	std::vector<RenderableComponent>& renderables = scene.Pool<RenderableComponent>().GetComponents();
+	XMFLOAT3 cameraPos = camera->GetTransform()->GetPosition();
+
+	//everything except the sphere is the same for every entity
+	float pixelsPerUnit = camera->GetPixelsPerUnit((float)Window::Height());
+	bool perspective = camera->IsPerspective();
+	float threshold = renderSettings.contributionThreshold;
+
+	unsigned int kept = 0;
+	for (unsigned int i : visibleEntities) {
+		//cameras inside the sphere always keep it (the radius comes back as FLT_MAX)
+		if (!renderables[i].important && AABBScreenRadius(renderables[i].worldBounds, cameraPos, pixelsPerUnit, perspective) < threshold)
+			continue;
+
+		visibleEntities[kept++] = i;
+	}
+
+	renderStats.entitiesContributionCulled = (unsigned int)visibleEntities.size() - kept;
+	visibleEntities.resize(kept);
+}
+
+// --------------------------------------------------------
+// Rasterizes the visible occluders into the CPU depth
+// buffer, then keeps only the entities whose bounds are
+// in front of it somewhere
+// --------------------------------------------------------
+void Game::OcclusionCullEntities(Camera* camera, const Frustum& frustum)
+{
+	std::vector<RenderableComponent>& renderables = scene.Pool<RenderableComponent>().GetComponents();
+
+	//occluders come from the whole scene, since cached entities aren't in visibleEntities
+	occlusionBuffer.Begin(camera->GetViewProjection());
+	for (unsigned int i = 0; i < renderables.size(); i++) {
+		if (renderables[i].occluder && FrustumTestAABB(frustum, renderables[i].worldBounds) != CullResult::Outside) {
+			Mesh* mesh = meshes.Get(renderables[i].mesh);
+			//same (latest step) transform the occludee bounds below come from
+			occlusionBuffer.AddOccluder(mesh->GetVertices(), mesh->GetIndices(), transforms.Get(renderables[i].transform)->GetWorldMatrix());
+		}
+	}
+	occlusionBuffer.Rasterize();
+
+	unsigned int kept = 0;
+	for (unsigned int i : visibleEntities) {
+		if (renderables[i].occluder || occlusionBuffer.IsVisible(renderables[i].worldBounds))
+			visibleEntities[kept++] = i;
+	}
+
+	renderStats.entitiesOcclusionCulled = (unsigned int)visibleEntities.size() - kept;
+	renderStats.occluderTriangles = occlusionBuffer.GetTriangleCount();
+	visibleEntities.resize(kept);
+}
+
+// --------------------------------------------------------
+// One packet per visible entity.  Depth is the distance to
+// the camera over the far clip, so within a shader/material/
+// mesh group things draw front to back.
+// --------------------------------------------------------
+void Game::BuildRenderQueue(Camera* camera)
+{
+	std::vector<RenderableComponent>& renderables = scene.Pool<RenderableComponent>().GetComponents();
+	XMFLOAT3 cameraPos = camera->GetTransform()->GetPosition();
+	float invFar = 1.0f / camera->GetFarClip();
+
+	renderQueue.Clear();
+	for (unsigned int i : visibleEntities) {
+		Material* material = materials.Get(renderables[i].material);
+		XMFLOAT3 center = AABBCenter(renderables[i].worldBounds);
+		float dx = center.x - cameraPos.x;
+		float dy = center.y - cameraPos.y;
+		float dz = center.z - cameraPos.z;
+
+		unsigned int shader = renderQueue.GetShaderID(material->GetVertexShader().get(), material->GetPixelShader().get());
+		uint64_t key = RenderQueue::MakeKey(RENDER_PASS_OPAQUE, shader, material->GetID(), meshes.Get(renderables[i].mesh)->GetID(),
+			sqrtf(dx * dx + dy * dy + dz * dz) * invFar);
+
+		renderQueue.Add(key, i);
+	}
+
+	renderQueue.Sort();
+}
+
+// --------------------------------------------------------
+// Broad phase walks the scene BVH nearest-first; each
+// candidate's mesh triangles are then tested in object
+// space through the mesh's own BVH (see TriangleBVH.h)
+// --------------------------------------------------------
+int Game::PickEntity(const Ray& ray, float* distance)
+{
+	std::vector<RenderableComponent>& renderables = scene.Pool<RenderableComponent>().GetComponents();
+
+	return RaycastNearest(sceneBVH, ray, distance, [&](int entity) {
+		RenderableComponent& renderable = renderables[entity];
+		return RayTarget{ &renderable.worldBounds, transforms.Get(renderable.transform), meshes.Get(renderable.mesh)->GetTriangleBVH() };
+	});
+}
+
+// --------------------------------------------------------
+// Runs of packets with the same pass, shader, material and
+// mesh become instanced batches when the material has an
+// instanced vertex shader.  A draw has one light list, so
+// with light culling a run is split by the set of lights
+// that reach each entity.  Matrices are packed in batch
+// order and written to a dynamic vertex buffer that grows
+// (doubling) whenever a frame needs more room.
+// --------------------------------------------------------
+static_assert(MAX_SCENE_LIGHTS <= 32, "Instanced batches keep their lights as one bit per per-frame slot");
+
+void Game::BuildInstanceBatches(float alpha)
+{
+	std::vector<RenderableComponent>& renderables = scene.Pool<RenderableComponent>().GetComponents();
+	const std::vector<RenderPacket>& packets = renderQueue.GetPackets();
+	instanceBatcher.Build(packets, RENDER_KEY_STATE_MASK,
+		[&](unsigned int a, unsigned int b) {
+			//key IDs are truncated, so check the real material and mesh handles
+			return renderables[a].material == renderables[b].material && renderables[a].mesh == renderables[b].mesh;
+		},
+		[&](unsigned int entity) {
+			return renderSettings.instancing && materials.Get(renderables[entity].material)->SupportsInstancing();
+		},
+		[&](unsigned int entity) {
+			if (!renderSettings.lightCulling)
+				return (uint32_t)0;
+
+			//one bit per per-frame buffer slot
+			GatherLights(renderables[entity].worldBounds, instanceNearbyLights, instanceLights);
+			uint32_t mask = 0;
+			for (int slot : instanceLights)
+				mask |= 1u << slot;
+			return mask;
+		});
+
+	instanceBatcher.Pack([&](unsigned int entity, InstanceData& data) {
+		Transform* transform = transforms.Get(renderables[entity].transform);
+		data.world = transform->GetInterpolatedWorldMatrix(alpha);
+		data.worldInvTranspose = transform->GetInterpolatedWorldInverseTransposeMatrix(alpha);
+	});
+
+	unsigned int count = instanceBatcher.GetInstanceCount();
+	if (count == 0)
+		return;
+
+	if (count > instanceBufferCapacity) {
+		instanceBufferCapacity = instanceBufferCapacity == 0 ? 64 : instanceBufferCapacity;
+		while (instanceBufferCapacity < count)
+			instanceBufferCapacity *= 2;
+
+		D3D11_BUFFER_DESC desc = {};
+		desc.Usage = D3D11_USAGE_DYNAMIC;
+		desc.ByteWidth = sizeof(InstanceData) * instanceBufferCapacity;
+		desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+		desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+
+		instanceBuffer.Reset();
+		Graphics::Device->CreateBuffer(&desc, 0, instanceBuffer.GetAddressOf());
+	}
+
+	D3D11_MAPPED_SUBRESOURCE mapped = {};
+	Graphics::Context->Map(instanceBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped);
+	memcpy(mapped.pData, &instanceBatcher.GetInstances()[0], sizeof(InstanceData) * count);
+	Graphics::Context->Unmap(instanceBuffer.Get(), 0);
+}
+
 //LIGHTING HELPERS
 
+// --------------------------------------------------------
+// Fills and uploads the perFrame buffer of every shader
+// that has one: camera matrices for vertex shaders, camera
+// position, ambient and the light pool for pixel shaders.
+// Past MAX_SCENE_LIGHTS lights, the ones whose range comes
+// nearest the camera go in.  Draws then only send slots in
+// that light array.
+// --------------------------------------------------------
+void Game::UploadFrameConstants(Camera* camera)
+{
+	std::vector<LightComponent>& lights = scene.Pool<LightComponent>().GetComponents();
+	XMFLOAT3 cameraPos = camera->GetTransform()->GetPosition();
+	SelectFrameLights(lights, cameraPos, MAX_SCENE_LIGHTS, frameLights);
+	unsigned int lightCount = (unsigned int)frameLights.size();
+
+	static bool warnedLightCount = false;
+	if (lights.size() > MAX_SCENE_LIGHTS && !warnedLightCount) {
+		printf("%u lights in the scene but only %d fit in the per-frame buffer - the nearest are used\n", (unsigned int)lights.size(), MAX_SCENE_LIGHTS);
+		warnedLightCount = true;
+	}
+
+	frameLightSlots.assign(lights.size(), -1);
+	for (unsigned int s = 0; s < lightCount; s++)
+		frameLightSlots[frameLights[s]] = (int)s;
+
+	VSPerFrame vsFrame = {};
+	vsFrame.view = camera->GetView();
+	vsFrame.proj = camera->GetProjection();
+
+	//lights past lightCount are left zeroed (the shader never reads them)
+	PSPerFrame psFrame = {};
+	psFrame.cameraPosition = cameraPos;
+	psFrame.ambient = ambientColor;
+	for (unsigned int s = 0; s < lightCount; s++)
+		psFrame.lights[s] = lights[frameLights[s]];
+
+	for (unsigned int i = 0; i < vss.size(); i++) {
+		SimpleVertexShader* vs = vss[i].get();
+		if (vsFrameBuffers[i] >= 0) {
+			vs->SetBufferData(vsFrameBuffers[i], &vsFrame, sizeof(vsFrame));
+			vs->CopyBufferData(vsFrameBuffers[i]);
+		}
+		else if (vs->GetBufferInfo("perFrame")) {
+			vs->SetMatrix4x4("view", vsFrame.view);
+			vs->SetMatrix4x4("proj", vsFrame.proj);
+			vs->CopyBufferData("perFrame");
+		}
+	}
+
+	for (unsigned int i = 0; i < pss.size(); i++) {
+		SimplePixelShader* ps = pss[i].get();
+		if (psFrameBuffers[i] >= 0) {
+			ps->SetBufferData(psFrameBuffers[i], &psFrame, sizeof(psFrame));
+			ps->CopyBufferData(psFrameBuffers[i]);
+		}
+		else if (ps->GetBufferInfo("perFrame")) {
+			ps->SetFloat3("cameraPosition", psFrame.cameraPosition);
+			ps->SetFloat3("ambient", psFrame.ambient);
+			if (lightCount > 0)
+				ps->SetData("lights", psFrame.lights, sizeof(Light) * lightCount);
+			ps->CopyBufferData("perFrame");
+		}
+	}
+}
+
+// --------------------------------------------------------
+// Records batches [begin, end) of the sorted list.  Runs
+// on a worker thread, so it only reads shared state - the
+// one exception is each entity's own transform and bounds,
+// which no other slice touches.  State changes are judged
+// against the batch before begin, since the slices are
+// replayed back to back on one context.
+// --------------------------------------------------------
+void Game::RecordBatches(unsigned int begin, unsigned int end, float alpha, CommandBuffer& commands, DrawRecorder& recorder)
+{
+	std::vector<RenderableComponent>& renderables = scene.Pool<RenderableComponent>().GetComponents();
+	const std::vector<RenderPacket>& packets = renderQueue.GetPackets();
+	const std::vector<DrawBatch>& batches = instanceBatcher.GetBatches();
+
+	RenderStats& stats = recorder.stats;
+	stats.drawCalls = 0;
+	stats.shaderChanges = 0;
+	stats.materialChanges = 0;
+	stats.meshChanges = 0;
+	stats.instancedBatches = 0;
+	stats.instancesDrawn = 0;
+	stats.lightsUploaded = 0;
+
+	//without light culling, every light in the per-frame buffer applies (up to MAX_LIGHTS)
+	int sceneLightCount = (int)frameLights.size();
+
+	Material* lastMaterial = nullptr;
+	Mesh* lastMesh = nullptr;
+	SimplePixelShader* lastShader = nullptr;
+	bool lastInstanced = false;
+	if (begin > 0) {
+		const RenderableComponent& previous = renderables[packets[batches[begin - 1].firstPacket].entity];
+		lastMaterial = materials.Get(previous.material);
+		lastMesh = meshes.Get(previous.mesh);
+		lastShader = lastMaterial->GetPixelShader().get();
+		lastInstanced = batches[begin - 1].instanced;
+	}
+
+	for (unsigned int b = begin; b < end; b++) {
+		const DrawBatch& batch = batches[b];
+
+		//everything in a batch shares its first entity's material and mesh
+		const RenderableComponent& first = renderables[packets[batch.firstPacket].entity];
+		Material* material = materials.Get(first.material);
+		Mesh* mesh = meshes.Get(first.mesh);
+		SimplePixelShader* ps = material->GetPixelShader().get();
+
+		unsigned int drawCount = batch.instanced ? 1 : batch.packetCount;
+		stats.drawCalls += drawCount;
+		if (ps != lastShader) stats.shaderChanges++;
+		if (material != lastMaterial) stats.materialChanges++;
+		if (mesh != lastMesh) stats.meshChanges++;
+		//per-material data only goes up when the material (or vertex shader) changes
+		if (material != lastMaterial || batch.instanced != lastInstanced)
+			commands.BindMaterial(material, batch.instanced);
+
+		lastShader = ps;
+		lastMaterial = material;
+		lastMesh = mesh;
+		lastInstanced = batch.instanced;
+
+		for (unsigned int p = 0; p < drawCount; p++) {
+			const RenderableComponent& entity = renderables[packets[batch.firstPacket + p].entity];
+
+			//the lights themselves went up with the frame, each draw just picks some
+			std::vector<int>& entityLights = recorder.entityLights;
+			if (renderSettings.lightCulling && batch.instanced) {
+				//every instance was gathered the same lights when the batch was built
+				entityLights.clear();
+				for (int slot = 0; slot < MAX_SCENE_LIGHTS; slot++) {
+					if (batch.group & (1u << slot))
+						entityLights.push_back(slot);
+				}
+			}
+			else if (renderSettings.lightCulling) {
+				GatherLights(entity.worldBounds, recorder.nearbyLights, entityLights);
+			}
+			else {
+				entityLights.clear();
+				for (int l = 0; l < sceneLightCount && l < MAX_LIGHTS; l++)
+					entityLights.push_back(l);
+			}
+
+			PSPerObject objectLights = {};
+			objectLights.lightCount = (int)entityLights.size();
+			for (unsigned int l = 0; l < entityLights.size(); l++)
+				objectLights.lightIndices[l] = entityLights[l];
+			commands.SetConstants(material, RENDER_CONSTANTS_LIGHTS, &objectLights, sizeof(objectLights));
+			stats.lightsUploaded += (unsigned int)entityLights.size();
+
+			if (batch.instanced) {
+				commands.DrawInstanced(mesh, batch.firstInstance, batch.packetCount);
+				stats.instancedBatches++;
+				stats.instancesDrawn += batch.packetCount;
+			}
+			else {
+				//alpha blends between the last two simulation steps
+				Transform* transform = transforms.Get(entity.transform);
+				VSPerObject object;
+				object.world = transform->GetInterpolatedWorldMatrix(alpha);
+				object.worldInvTranspose = transform->GetInterpolatedWorldInverseTransposeMatrix(alpha);
+				commands.SetConstants(material, RENDER_CONSTANTS_OBJECT, &object, sizeof(object));
+				commands.Draw(mesh);
+			}
+		}
+	}
+}
+
+// --------------------------------------------------------
+// Lights are never removed from the pool, so a pool index
+// identifies the same light every frame.  Moving a light
+// (e.g. from the UI) is just a Move() in the grid.
+// --------------------------------------------------------
+void Game::UpdateLightGrid()
+{
+	std::vector<LightComponent>& lights = scene.Pool<LightComponent>().GetComponents();
+
+	directionalLights.clear();
+	maxLightRange = 0.0f;
+	for (unsigned int i = 0; i < lights.size(); i++) {
+		if (i == lightProxies.size())
+			lightProxies.push_back(-1);
+
+		if (lights[i].type == LIGHT_TYPE_DIRECTIONAL) {
+			if (lightProxies[i] != -1) {
+				lightGrid.Remove(lightProxies[i]);
+				lightProxies[i] = -1;
+			}
+			directionalLights.push_back(i);
+			continue;
+		}
+
+		if (lightProxies[i] == -1)
+			lightProxies[i] = lightGrid.Insert(lights[i].position, i);
+		else
+			lightGrid.Move(lightProxies[i], lights[i].position);
+
+		if (lights[i].range > maxLightRange)
+			maxLightRange = lights[i].range;
+	}
+}
+
+// --------------------------------------------------------
+// Directional lights always apply; point and spot lights
+// only if their range sphere touches the entity's bounding
+// sphere (attenuation is zero past the range).  Only lights
+// in this frame's buffer count, and past MAX_LIGHTS the
+// brightest on the sphere win.
+// --------------------------------------------------------
+void Game::GatherLights(const AABB& bounds, std::vector<int>& nearbyLights, std::vector<int>& entityLights)
+{
+	std::vector<LightComponent>& lights = scene.Pool<LightComponent>().GetComponents();
+
+	XMFLOAT3 center = AABBCenter(bounds);
+	XMFLOAT3 extents = AABBExtents(bounds);
+	float radius = sqrtf(extents.x * extents.x + extents.y * extents.y + extents.z * extents.z);
+
+	nearbyLights.clear();
+	lightGrid.QueryRadius(center, radius + maxLightRange, nearbyLights);
+
+	entityLights.clear();
+	for (unsigned int i : directionalLights) {
+		if (frameLightSlots[i] >= 0)
+			entityLights.push_back(i);
+	}
+	for (int i : nearbyLights) {
+		if (frameLightSlots[i] >= 0)
+			entityLights.push_back(i);
+	}
+
+	SelectDrawLights(lights.data(), entityLights, center, radius, MAX_LIGHTS);
+	for (int& light : entityLights)
+		light = frameLightSlots[light];
+}
+
 void Game::CreateDirectional(float intensity, DirectX::XMFLOAT3 color, DirectX::XMFLOAT3 direction)
 {
 	CreateLight(0, intensity, color, direction, 0.0f, DirectX::XMFLOAT3(), 0.0f, 0.0f);
@@ -301,5 +1124,21 @@ void Game::CreateLight(int type, float intensity, DirectX::XMFLOAT3 color, Direc
 	light.spotInnerAngle = spotInnerAngle;
 	light.spotOuterAngle = spotOuterAngle;
 
-	lights.push_back(light);
+	EntityID id = scene.CreateEntity();
+	scene.Add<LightComponent>(id, light);
+}
+
+// --------------------------------------------------------
+// Gives a new entity its own transform at position and
+// draws it with mesh and material
+// --------------------------------------------------------
+void Game::CreateEntity(Handle<Mesh> mesh, Handle<Material> material, DirectX::XMFLOAT3 position)
+{
+	RenderableComponent renderable;
+	renderable.transform = transforms.Emplace(position.x, position.y, position.z);
+	renderable.mesh = mesh;
+	renderable.material = material;
+
+	EntityID id = scene.CreateEntity();
+	scene.Add<RenderableComponent>(id, renderable);
 }
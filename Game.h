@@ -11,7 +11,6 @@
 #include "Material.h"
 #include "Mesh.h"
 #include "Transform.h"
-#include "Entity.h"
 #include "Graphics.h"
 #include "Vertex.h"
 #include "Input.h"
@@ -20,6 +19,23 @@
 #include "Lights.h"
 #include "Sky.h"
 #include "UI.h"
+#include "ComponentStore.h"
+#include "Components.h"
+#include "SlotMap.h"
+#include "Allocators.h"
+#include "DynamicBVH.h"
+#include "RenderStats.h"
+#include "FrustumCuller.h"
+#include "OcclusionBuffer.h"
+#include "PortalSystem.h"
+#include "VisibilityCache.h"
+#include "SpatialHash.h"
+#include "LightSelection.h"
+#include "RenderQueue.h"
+#include "InstanceBatcher.h"
+#include "ShaderConstants.h"
+#include "CommandBuffer.h"
+#include "D3D11CommandBackend.h"
 
 //DirectX
 #include <d3d11.h>
@@ -41,7 +57,8 @@ public:
 	// Primary functions
 	void Initialize();
 	void Update(float deltaTime, float totalTime);
-	void Draw(float deltaTime, float totalTime);
+	void FixedUpdate(float stepTime, float simulationTime);
+	void Draw(float deltaTime, float totalTime, float alpha);
 	void OnResize();
 
 	//Getters
@@ -54,6 +71,61 @@ private:
 	void CreateLighting();
 	void CreateGeometry();
 
+	//Checks every loaded shader's perFrame/perObject/perMaterial buffers
+	//against ShaderConstants.h (asserts in debug builds on a mismatch)
+	void ValidateShaderConstants();
+
+	//Keeps the BVH and the culler in step with entities that moved
+	void UpdateSceneBounds();
+	bool UpdateWorldBounds(RenderableComponent& entity);
+
+	//Fills visibleEntities with the entities the camera can see
+	void CullEntities(Camera* camera);
+
+	//Culls the scene for every camera in one BVH traversal
+	void CullViews();
+
+	//Index of the nearest entity under the ray (-1 for none)
+	int PickEntity(const Ray& ray, float* distance);
+
+	//Builds and sorts one packet per visible entity
+	void BuildRenderQueue(Camera* camera);
+
+	//Keeps the light grid in step with the light pool
+	void UpdateLightGrid();
+
+	//Groups the sorted packets into batches and uploads instance matrices
+	void BuildInstanceBatches(float alpha);
+
+	//Uploads camera, ambient and lights to every shader's perFrame buffer
+	void UploadFrameConstants(Camera* camera);
+
+	//Fills entityLights with the per-frame buffer slots of the (up to MAX_LIGHTS)
+	//brightest lights that reach a box (nearbyLights is scratch - each thread passes its own)
+	void GatherLights(const AABB& bounds, std::vector<int>& nearbyLights, std::vector<int>& entityLights);
+
+	// --------------------------------------------------------
+	// What one draw recording thread keeps to itself
+	// --------------------------------------------------------
+	struct DrawRecorder
+	{
+		std::vector<int> nearbyLights;
+		std::vector<int> entityLights;
+		RenderStats stats;		// Only the draw counters are filled in
+	};
+
+	//Records a slice of the instance batches as commands (thread safe across disjoint slices)
+	void RecordBatches(unsigned int begin, unsigned int end, float alpha, CommandBuffer& commands, DrawRecorder& recorder);
+
+	//Drops visible entities in cells that can't be seen through any portal
+	void PortalCullEntities(Camera* camera, const Frustum& frustum);
+
+	//Drops visible entities too small on screen to matter
+	void ContributionCullEntities(Camera* camera);
+
+	//Drops visible entities hidden behind occluders
+	void OcclusionCullEntities(Camera* camera, const Frustum& frustum);
+
 	//Directional Light
 	void CreateDirectional(float intensity, DirectX::XMFLOAT3 color, DirectX::XMFLOAT3 direction);
 
@@ -65,16 +137,75 @@ private:
 
 	//ALL Lights
 	void CreateLight(int type, float intensity, DirectX::XMFLOAT3 color, DirectX::XMFLOAT3 direction, float range, DirectX::XMFLOAT3 position, float spotInnerAngle, float spotOuterAngle);
+
+	//Entity drawn with a mesh and material
+	void CreateEntity(Handle<Mesh> mesh, Handle<Material> material, DirectX::XMFLOAT3 position);
 	
 	//Camera
-	std::shared_ptr<Camera> currentCamera;
-	std::vector<std::shared_ptr<Camera>> cameras;
-
-	//Meshes
-	std::vector<std::shared_ptr<Mesh>> meshes;
-
-	//Entities
-	std::vector<std::shared_ptr<Entity>> entities;
+	Handle<Camera> currentCamera;
+	SlotMap<Camera> cameras;
+
+	//Scene objects - entities refer to these by handle, and a handle
+	//to something removed is caught (asserts) instead of aliasing
+	SlotMap<Mesh> meshes;
+	SlotMap<Material> materials;
+	SlotMap<Transform> transforms;
+
+	//Spatial structure over entity world bounds (user data = entity index)
+	DynamicBVH sceneBVH;
+
+	//SoA copy of entity world bounds (index = entity index)
+	FrustumCuller frustumCuller;
+
+	//Indices into entities that survived culling this frame
+	std::vector<unsigned int> visibleEntities;
+	std::vector<unsigned int> cachedVisible;	// Visible entities whose cached result still holds
+	OcclusionBuffer occlusionBuffer;
+	PortalSystem portalSystem;
+	VisibilityCache visibilityCache;
+	RenderSettings cachedSettings;	// Settings the cached visibility was computed with
+
+	//Point and spot lights by position (user data = index in the light pool)
+	SpatialHash lightGrid;
+	std::vector<int> lightProxies;			// Per light pool index, -1 for directional lights
+	std::vector<unsigned int> directionalLights;
+	float maxLightRange = 0.0f;
+
+	//Light pool indices in the per-frame buffer this frame, and each pool light's slot there (-1 if it didn't fit)
+	std::vector<int> frameLights;
+	std::vector<int> frameLightSlots;
+
+	//Sorted draws for this frame
+	RenderQueue renderQueue;
+	InstanceBatcher instanceBatcher;
+	std::vector<int> instanceNearbyLights;	// Scratch for splitting instanced runs by their lights
+	std::vector<int> instanceLights;
+	Microsoft::WRL::ComPtr<ID3D11Buffer> instanceBuffer;
+	unsigned int instanceBufferCapacity = 0;	// In instances
+
+	//Per-draw constants are sliced out of this (when supported)
+	ConstantBufferRing constantRing;
+
+	//One command buffer and recorder per recording thread
+	std::vector<CommandBuffer> drawCommands;
+	std::vector<DrawRecorder> drawRecorders;
+	ThreadPool recordingPool{ DefaultRecordingThreadCount() - 1 };
+
+	//Per shader in vss/pss, the index of a perFrame buffer that matches
+	//VSPerFrame/PSPerFrame (-1 to set it variable by variable instead)
+	std::vector<int> vsFrameBuffers;
+	std::vector<int> psFrameBuffers;
+
+	//Entity picked with the right mouse button (-1 for none)
+	int selectedEntity = -1;
+
+	//Transform changes from the UI, applied on the next FixedUpdate()
+	std::vector<TransformEdit> transformEdits;
+
+	//Per camera slot visible entity lists from CullViews() (debug only)
+	std::vector<std::vector<int>> viewVisibleEntities;
+	RenderStats renderStats;
+	RenderSettings renderSettings;
 
 	// Note the usage of ComPtr below
 	//  - This is a smart pointer for objects that abide by the
@@ -86,14 +217,17 @@ private:
 	Microsoft::WRL::ComPtr<ID3D11Buffer> indexBuffer;
 	Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState;
 
-
-	std::vector<std::shared_ptr<Material>> materials;
 	std::vector<std::shared_ptr<SimpleVertexShader>> vss;
 	std::vector<std::shared_ptr<SimplePixelShader>> pss;
+	std::vector<std::string> vsNames;	// .cso names without the extension, for messages and layout dumps
+	std::vector<std::string> psNames;
 
 	//lighting
 	DirectX::XMFLOAT3 ambientColor;
-	std::vector<Light> lights;
+
+	//packed component storage - lights are LightComponents and drawn entities
+	//RenderableComponents (an entity index elsewhere is a slot in that pool)
+	ComponentStore scene;
 
 	std::shared_ptr<Sky> sky;
 
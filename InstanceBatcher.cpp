@@ -0,0 +1,19 @@
+#include "InstanceBatcher.h"
+
+InstanceBatcher::InstanceBatcher(unsigned int minInstances) :
+	minInstances(minInstances),
+	instanceCount(0)
+{
+}
+
+const std::vector<DrawBatch>& InstanceBatcher::GetBatches() { return batches; }
+
+const std::vector<InstanceData>& InstanceBatcher::GetInstances() { return instances; }
+
+const std::vector<unsigned int>& InstanceBatcher::GetInstanceEntities() { return instanceEntities; }
+
+unsigned int InstanceBatcher::GetInstanceCount() { return instanceCount; }
+
+unsigned int InstanceBatcher::GetMinInstances() { return minInstances; }
+
+void InstanceBatcher::SetMinInstances(unsigned int minInstances) { this->minInstances = minInstances; }
@@ -0,0 +1,152 @@
+#pragma once
+
+//C++
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+//DirectX
+#include <DirectXMath.h>
+
+//Program
+#include "RenderQueue.h"
+
+// --------------------------------------------------------
+// Per-instance vertex data for VertexShader_Instanced
+// --------------------------------------------------------
+struct InstanceData
+{
+	DirectX::XMFLOAT4X4 world;
+	DirectX::XMFLOAT4X4 worldInvTranspose;
+};
+
+// --------------------------------------------------------
+// A run of sorted packets drawn together.  Instanced batches
+// read their matrices from instances[firstInstance...] (and
+// their entities from GetInstanceEntities() - firstPacket is
+// just where their run starts); the rest are drawn one
+// packet at a time.
+// --------------------------------------------------------
+struct DrawBatch
+{
+	unsigned int firstPacket;
+	unsigned int packetCount;
+	unsigned int firstInstance;
+	bool instanced;
+	uint32_t group;		// What split() gave every entity in an instanced batch (0 otherwise)
+};
+
+// --------------------------------------------------------
+// Splits a sorted packet list into batches.  Packets whose
+// keys match under groupMask (the same pass, shader,
+// material and mesh) are neighbours after sorting, so each
+// run of at least minInstances becomes one instanced draw.
+// No D3D here - the caller uploads GetInstances().
+//
+// Keys only hold the low bits of each ID, so two different
+// meshes or materials can share a key; sameState(a, b)
+// compares the real state of two entities and ends a run
+// where it differs.
+//
+// An instanced draw can only send one set of per-draw
+// constants, so split(entity) divides a run into one batch
+// per distinct value (e.g. the lights that reach it), each
+// keeping its entities' sorted order.
+// --------------------------------------------------------
+class InstanceBatcher
+{
+public:
+	InstanceBatcher(unsigned int minInstances = 2);
+
+	// --------------------------------------------------------
+	// sameState(first, entity) is asked for each packet that
+	// matches the run's key; canInstance(entity) once per run,
+	// with the run's first entity - everything in a run shares
+	// its material and mesh.
+	// --------------------------------------------------------
+	template<typename SameFunc, typename Func, typename SplitFunc>
+	void Build(const std::vector<RenderPacket>& packets, uint64_t groupMask, SameFunc sameState, Func canInstance, SplitFunc split)
+	{
+		batches.clear();
+		instanceEntities.clear();
+		instanceCount = 0;
+
+		unsigned int count = (unsigned int)packets.size();
+		unsigned int first = 0;
+		while (first < count) {
+			//find the end of this run of matching state
+			uint64_t group = packets[first].key & groupMask;
+			unsigned int end = first + 1;
+			while (end < count && (packets[end].key & groupMask) == group && sameState(packets[first].entity, packets[end].entity))
+				end++;
+
+			unsigned int runLength = end - first;
+			if (runLength >= minInstances && canInstance(packets[first].entity)) {
+				//stable, so each group stays in draw order
+				grouped.clear();
+				for (unsigned int p = first; p < end; p++)
+					grouped.push_back({ split(packets[p].entity), packets[p].entity });
+				std::stable_sort(grouped.begin(), grouped.end(), [](const GroupedEntity& a, const GroupedEntity& b) { return a.group < b.group; });
+
+				for (unsigned int g = 0; g < runLength; ) {
+					unsigned int groupEnd = g + 1;
+					while (groupEnd < runLength && grouped[groupEnd].group == grouped[g].group)
+						groupEnd++;
+
+					batches.push_back({ first, groupEnd - g, instanceCount, true, grouped[g].group });
+					for (unsigned int i = g; i < groupEnd; i++)
+						instanceEntities.push_back(grouped[i].entity);
+					instanceCount += groupEnd - g;
+					g = groupEnd;
+				}
+			}
+			else {
+				batches.push_back({ first, runLength, 0, false, 0 });
+			}
+
+			first = end;
+		}
+	}
+
+	//Every run drawn with as few instanced batches as possible
+	template<typename SameFunc, typename Func>
+	void Build(const std::vector<RenderPacket>& packets, uint64_t groupMask, SameFunc sameState, Func canInstance)
+	{
+		Build(packets, groupMask, sameState, canInstance, [](unsigned int) { return (uint32_t)0; });
+	}
+
+	// --------------------------------------------------------
+	// Fills the instance array for every instanced batch.
+	// fill(entity, InstanceData&) writes one entity's matrices.
+	// --------------------------------------------------------
+	template<typename Func>
+	void Pack(Func fill)
+	{
+		instances.resize(instanceCount);
+		for (unsigned int i = 0; i < instanceCount; i++)
+			fill(instanceEntities[i], instances[i]);
+	}
+
+	const std::vector<DrawBatch>& GetBatches();
+	const std::vector<InstanceData>& GetInstances();
+	const std::vector<unsigned int>& GetInstanceEntities();
+	unsigned int GetInstanceCount();
+	unsigned int GetMinInstances();
+	void SetMinInstances(unsigned int minInstances);
+
+private:
+	unsigned int minInstances;
+	unsigned int instanceCount;
+
+	std::vector<DrawBatch> batches;
+	std::vector<InstanceData> instances;
+	std::vector<unsigned int> instanceEntities;	// Entity of each instance, batch by batch
+
+	//Build() scratch for one run
+	struct GroupedEntity
+	{
+		uint32_t group;
+		unsigned int entity;
+	};
+	std::vector<GroupedEntity> grouped;
+};
@@ -0,0 +1,81 @@
+#include "LightSelection.h"
+
+//C++
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <utility>
+
+using namespace DirectX;
+
+static float Distance(const XMFLOAT3& a, const XMFLOAT3& b)
+{
+	float dx = a.x - b.x, dy = a.y - b.y, dz = a.z - b.z;
+	return sqrtf(dx * dx + dy * dy + dz * dz);
+}
+
+// --------------------------------------------------------
+// Matches Attenuation() in ShaderIncludes.hlsli, measured
+// to the sphere instead of a pixel - spot cones are ignored,
+// so a spot counts as bright as a point light of its range
+// --------------------------------------------------------
+float LightContribution(const Light& light, const DirectX::XMFLOAT3& center, float radius)
+{
+	if (light.type == LIGHT_TYPE_DIRECTIONAL)
+		return light.intensity;
+
+	float distance = Distance(light.position, center) - radius;
+	if (distance <= 0.0f)
+		return light.intensity;
+	if (distance >= light.range)
+		return 0.0f;
+
+	float attenuation = 1.0f - distance * distance / (light.range * light.range);
+	return light.intensity * attenuation * attenuation;
+}
+
+void SelectFrameLights(const std::vector<Light>& lights, const DirectX::XMFLOAT3& eye, unsigned int maxLights, std::vector<int>& selected)
+{
+	selected.clear();
+	if (lights.size() <= maxLights) {
+		for (int i = 0; i < (int)lights.size(); i++)
+			selected.push_back(i);
+		return;
+	}
+
+	//distance from the eye to each light's range (0 inside it, and for directional lights)
+	std::vector<std::pair<float, int>> ranked(lights.size());
+	for (int i = 0; i < (int)lights.size(); i++) {
+		float gap = lights[i].type == LIGHT_TYPE_DIRECTIONAL ? -1.0f : std::max(0.0f, Distance(lights[i].position, eye) - lights[i].range);
+		ranked[i] = { gap, i };
+	}
+
+	std::partial_sort(ranked.begin(), ranked.begin() + maxLights, ranked.end());
+	for (unsigned int i = 0; i < maxLights; i++)
+		selected.push_back(ranked[i].second);
+}
+
+void SelectDrawLights(const Light* lights, std::vector<int>& candidates, const DirectX::XMFLOAT3& center, float radius, unsigned int maxLights)
+{
+	//candidates come from the per-frame buffer, so they fit on the stack
+	assert(candidates.size() <= MAX_SCENE_LIGHTS);
+
+	//contribution is worked out once per candidate and kept alongside it for the sort
+	std::pair<float, int> ranked[MAX_SCENE_LIGHTS];
+	unsigned int count = 0;
+	for (int i : candidates) {
+		float contribution = LightContribution(lights[i], center, radius);
+		if (contribution > 0.0f && count < MAX_SCENE_LIGHTS)
+			ranked[count++] = { contribution, i };
+	}
+
+	if (count > maxLights) {
+		std::partial_sort(ranked, ranked + maxLights, ranked + count,
+			[](const std::pair<float, int>& a, const std::pair<float, int>& b) { return a.first > b.first; });
+		count = maxLights;
+	}
+
+	candidates.clear();
+	for (unsigned int i = 0; i < count; i++)
+		candidates.push_back(ranked[i].second);
+}
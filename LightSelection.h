@@ -0,0 +1,29 @@
+#pragma once
+
+//C++
+#include <vector>
+
+//DirectX
+#include <DirectXMath.h>
+
+//Program
+#include "Lights.h"
+
+// --------------------------------------------------------
+// Picks which lights go where when there are more than fit:
+//  - The per-frame buffer holds MAX_SCENE_LIGHTS, chosen
+//    by how close each light's range comes to the camera
+//  - A draw indexes up to MAX_LIGHTS of those, chosen by
+//    how bright each one is on the draw's bounding sphere
+// When everything fits, both keep the original order.
+// --------------------------------------------------------
+
+//Brightness of a light at the nearest point of a sphere, using the shader's falloff (0 if out of range)
+float LightContribution(const Light& light, const DirectX::XMFLOAT3& center, float radius);
+
+//Fills selected with up to maxLights indices into lights - directional lights first, then the rest nearest first
+void SelectFrameLights(const std::vector<Light>& lights, const DirectX::XMFLOAT3& eye, unsigned int maxLights, std::vector<int>& selected);
+
+//Drops candidates that can't reach the sphere and, past maxLights, keeps the brightest
+//(at most MAX_SCENE_LIGHTS candidates - the lights in the per-frame buffer)
+void SelectDrawLights(const Light* lights, std::vector<int>& candidates, const DirectX::XMFLOAT3& center, float radius, unsigned int maxLights);
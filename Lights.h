@@ -9,6 +9,14 @@
 #define LIGHT_TYPE_POINT 1
 #define LIGHT_TYPE_SPOT 2
 
+//must match MAX_LIGHTS and MAX_SCENE_LIGHTS in ShaderIncludes.hlsli
+//(lights per draw, and lights in the per-frame buffer)
+#define MAX_LIGHTS 10
+#define MAX_SCENE_LIGHTS 32
+
+//per-draw light indices are packed four to an int4
+#define LIGHT_INDEX_VECTORS ((MAX_LIGHTS + 3) / 4)
+
 struct Light {
 	int type; // Which kind of light? 0, 1 or 2 (see above)
 	DirectX::XMFLOAT3 direction; // Directional and Spot lights need a direction
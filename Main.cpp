@@ -6,6 +6,7 @@
 #include "Graphics.h"
 #include "Game.h"
 #include "Input.h"
+#include "FixedTimestep.h"
 
 // Annonymous namespace to hold variables
 // only accessible in this file
@@ -102,6 +103,9 @@ int WINAPI WinMain(
 	currentTime = startTime;
 	previousTime = startTime;
 
+	// Simulation runs at a fixed 60hz, catching up at most 5 steps per frame
+	FixedTimestep fixedStep(1.0 / 60.0, 5);
+
 	// Windows message loop (and our game loop)
 	MSG msg = {};
 	while (msg.message != WM_QUIT)
@@ -128,9 +132,16 @@ int WINAPI WinMain(
 			// Input updating
 			Input::Update();
 
-			// Update and draw
+			// Per-frame update (input, UI, camera)
 			game->Update(deltaTime, totalTime);
-			game->Draw(deltaTime, totalTime);
+
+			// Fixed-rate simulation steps owed for this frame
+			int steps = fixedStep.Advance(deltaTime);
+			for (int i = 0; i < steps; i++)
+				game->FixedUpdate(fixedStep.GetStep(), (float)fixedStep.GetSimulationTime());
+
+			// Draw, blending between the last two simulation steps
+			game->Draw(deltaTime, totalTime, fixedStep.GetAlpha());
 
 			// Notify Input system about end of frame
 			Input::EndOfFrame();
@@ -2,56 +2,196 @@
 
 using namespace DirectX;
 
+unsigned int Material::nextID = 0;
+
+//names of the per-draw variables, hashed at compile time
+static constexpr SimpleShaderName worldName("world");
+static constexpr SimpleShaderName worldInvTransposeName("worldInvTranspose");
+static constexpr SimpleShaderName colorTintName("colorTint");
+static constexpr SimpleShaderName uvScaleName("uvScale");
+static constexpr SimpleShaderName uvOffsetName("uvOffset");
+static constexpr SimpleShaderName roughnessName("roughness");
+static constexpr SimpleShaderName lightCountName("lightCount");
+static constexpr SimpleShaderName lightIndicesName("lightIndices");
+
+//index of a buffer if it can be set from a ShaderConstants.h struct, else -1
+static int FindTypedBuffer(ISimpleShader* shader, const CBufferLayout& layout)
+{
+	if (!shader->ValidateBufferLayout(layout, nullptr))
+		return -1;
+	return shader->GetBufferIndex(layout.name);
+}
+
 Material::Material(const char* name, DirectX::XMFLOAT4 colorTint, std::shared_ptr<SimpleVertexShader> vs, std::shared_ptr<SimplePixelShader> ps, float roughness, DirectX::XMFLOAT2 uvScale, DirectX::XMFLOAT2 uvOffset) :
 	name(name),
+	id(nextID++),
 	colorTint(colorTint),
 	vertexShader(vs),
-	pixelShader(ps), 
+	pixelShader(ps),
+	instancedVertexShader(nullptr),
 	uvScale(uvScale),
 	uvOffset(uvOffset),
 	roughness(roughness)
 {
+	ResolveHandles();
 }
 
 Material::~Material()
 {
 }
 
+void Material::ResolveHandles()
+{
+	worldHandle = vertexShader->GetVariableHandle(worldName);
+	worldInvTransposeHandle = vertexShader->GetVariableHandle(worldInvTransposeName);
+
+	colorTintHandle = pixelShader->GetVariableHandle(colorTintName);
+	uvScaleHandle = pixelShader->GetVariableHandle(uvScaleName);
+	uvOffsetHandle = pixelShader->GetVariableHandle(uvOffsetName);
+	roughnessHandle = pixelShader->GetVariableHandle(roughnessName);
+	lightCountHandle = pixelShader->GetVariableHandle(lightCountName);
+	lightIndicesHandle = pixelShader->GetVariableHandle(lightIndicesName);
+
+	vsObjectBuffer = FindTypedBuffer(vertexShader.get(), VSPerObject::Layout());
+	psMaterialBuffer = FindTypedBuffer(pixelShader.get(), PSPerMaterial::Layout());
+	psObjectBuffer = FindTypedBuffer(pixelShader.get(), PSPerObject::Layout());
+
+	vsObjectIndex = vsObjectBuffer >= 0 ? vsObjectBuffer : vertexShader->GetBufferIndex("perObject");
+	psObjectIndex = psObjectBuffer >= 0 ? psObjectBuffer : pixelShader->GetBufferIndex("perObject");
+}
+
+// --------------------------------------------------------
+// Slot tables for pixelShader (see BuildBindingTable() in
+// BindingTable.h)
+// --------------------------------------------------------
+void Material::BuildBindingTable()
+{
+	::BuildBindingTable(textureSRVs, [&](const std::string& name) {
+		const SimpleSRV* info = pixelShader->GetShaderResourceViewInfo(name);
+		return info ? (int)info->BindIndex : -1;
+	}, srvTable, srvRanges);
+
+	::BuildBindingTable(samplers, [&](const std::string& name) {
+		const SimpleSampler* info = pixelShader->GetSamplerInfo(name);
+		return info ? (int)info->BindIndex : -1;
+	}, samplerTable, samplerRanges);
+}
+
 void Material::AddTextureSRV(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv)
 {
 	textureSRVs.insert({ name, srv });
+	BuildBindingTable();
 }
 
 void Material::AddSampler(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> sampler)
 {
 	samplers.insert({ name, sampler });
+	BuildBindingTable();
 }
 
-void Material::PrepareMaterial(std::shared_ptr<Transform> transform, std::shared_ptr<Camera> camera)
+void Material::BindMaterial(bool instanced)
 {
 	// Turn on these shaders
-	vertexShader->SetShader();
+	if (instanced)
+		instancedVertexShader->SetShader();
+	else
+		vertexShader->SetShader();
 	pixelShader->SetShader();
 
-	// Send data to the vertex shader
-	vertexShader->SetMatrix4x4("world", transform->GetWorldMatrix());
-	vertexShader->SetMatrix4x4("worldInvTranspose", transform->GetWorldInverseTransposeMatrix());
-	vertexShader->SetMatrix4x4("view", camera->GetView());
-	vertexShader->SetMatrix4x4("proj", camera->GetProjection());
-	vertexShader->CopyAllBufferData();
-
 	// Send data to the pixel shader
-	pixelShader->SetFloat4("colorTint", colorTint);
-	pixelShader->SetFloat2("uvScale", uvScale);
-	pixelShader->SetFloat2("uvOffset", uvOffset);
-	pixelShader->SetFloat("roughness", roughness);
-
-	pixelShader->SetFloat3("cameraPosition", camera->GetTransform()->GetPosition());
+	if (psMaterialBuffer >= 0) {
+		PSPerMaterial data = {};
+		data.colorTint = colorTint;
+		data.uvScale = uvScale;
+		data.uvOffset = uvOffset;
+		data.roughness = roughness;
+		pixelShader->SetBufferData(psMaterialBuffer, &data, sizeof(data));
+		pixelShader->CopyBufferData(psMaterialBuffer);
+	}
+	else {
+		pixelShader->SetFloat4(colorTintHandle, colorTint);
+		pixelShader->SetFloat2(uvScaleHandle, uvScale);
+		pixelShader->SetFloat2(uvOffsetHandle, uvOffset);
+		pixelShader->SetFloat(roughnessHandle, roughness);
+		pixelShader->CopyBufferData("perMaterial");
+	}
 	
-	for (auto& t : textureSRVs) { pixelShader->SetShaderResourceView(t.first.c_str(), t.second); }
-	for (auto& s : samplers) { pixelShader->SetSamplerState(s.first.c_str(), s.second); }
+	StateCache& cache = pixelShader->GetStateCache();
+	for (const BindingRange& r : srvRanges) { cache.PSSetShaderResources(r.startSlot, r.count, &srvTable[r.first]); }
+	for (const BindingRange& r : samplerRanges) { cache.PSSetSamplers(r.startSlot, r.count, &samplerTable[r.first]); }
+}
+
+// --------------------------------------------------------
+// Uploads one draw's matrices, worked out by the caller
+// (e.g. a command buffer recorded on another thread)
+// --------------------------------------------------------
+void Material::PrepareObject(const VSPerObject& object, ConstantBufferRing* ring)
+{
+	SetObjectData(object);
+	if (vsObjectIndex >= 0)
+		vertexShader->CopyBufferData(vsObjectIndex, ring);
+}
+
+// --------------------------------------------------------
+// Per-draw light list for the pixel shader (indices into
+// the lights already uploaded with the frame)
+// --------------------------------------------------------
+void Material::PrepareObjectLights(const PSPerObject& lights, ConstantBufferRing* ring)
+{
+	SetObjectLightsData(lights);
+	if (psObjectIndex >= 0)
+		pixelShader->CopyBufferData(psObjectIndex, ring);
+}
+
+bool Material::WriteObject(const VSPerObject& object, ConstantBufferRing* ring, ConstantBufferSlice* slice)
+{
+	SetObjectData(object);
+	return vsObjectIndex >= 0 && vertexShader->UploadBufferData(vsObjectIndex, ring, slice);
+}
+
+bool Material::WriteObjectLights(const PSPerObject& lights, ConstantBufferRing* ring, ConstantBufferSlice* slice)
+{
+	SetObjectLightsData(lights);
+	return psObjectIndex >= 0 && pixelShader->UploadBufferData(psObjectIndex, ring, slice);
+}
+
+void Material::BindObject(const ConstantBufferSlice& slice)
+{
+	if (vsObjectIndex >= 0)
+		vertexShader->BindBufferData(vsObjectIndex, slice);
+}
 
-	pixelShader->CopyAllBufferData();
+void Material::BindObjectLights(const ConstantBufferSlice& slice)
+{
+	if (psObjectIndex >= 0)
+		pixelShader->BindBufferData(psObjectIndex, slice);
+}
+
+void Material::SetObjectData(const VSPerObject& object)
+{
+	if (vsObjectBuffer >= 0) {
+		vertexShader->SetBufferData(vsObjectBuffer, &object, sizeof(object));
+	}
+	else {
+		vertexShader->SetMatrix4x4(worldHandle, object.world);
+		vertexShader->SetMatrix4x4(worldInvTransposeHandle, object.worldInvTranspose);
+	}
+}
+
+void Material::SetObjectLightsData(const PSPerObject& lights)
+{
+	if (psObjectBuffer >= 0) {
+		pixelShader->SetBufferData(psObjectBuffer, &lights, sizeof(lights));
+	}
+	else {
+		pixelShader->SetInt(lightCountHandle, lights.lightCount);
+		pixelShader->SetData(lightIndicesHandle, lights.lightIndices, sizeof(lights.lightIndices));
+	}
+}
+
+bool Material::SupportsInstancing()
+{
+	return instancedVertexShader != nullptr && instancedVertexShader->GetPerInstanceCompatible();
 }
 
 DirectX::XMFLOAT4 Material::GetColorTint()
@@ -59,12 +199,12 @@ DirectX::XMFLOAT4 Material::GetColorTint()
 	return colorTint;
 }
 
-std::shared_ptr<SimpleVertexShader> Material::GetVertexShader()
+const std::shared_ptr<SimpleVertexShader>& Material::GetVertexShader()
 {
 	return vertexShader;
 }
 
-std::shared_ptr<SimplePixelShader> Material::GetPixelShader()
+const std::shared_ptr<SimplePixelShader>& Material::GetPixelShader()
 {
 	return pixelShader;
 }
@@ -102,11 +242,14 @@ void Material::SetColorTint3(DirectX::XMFLOAT3 cT)
 void Material::SetVertexShader(std::shared_ptr<SimpleVertexShader> vS)
 {
 	vertexShader = vS;
+	ResolveHandles();
 }
 
 void Material::SetPixelShader(std::shared_ptr<SimplePixelShader> pS)
 {
 	pixelShader = pS;
+	ResolveHandles();
+	BuildBindingTable();
 }
 
 void Material::SetUvScale(DirectX::XMFLOAT2 uvs)
@@ -124,7 +267,12 @@ void Material::SetRoughness(float rgh)
 	roughness = rgh;
 }
 
-std::unordered_map<std::string, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>>& Material::GetTextureSRVMap()
+void Material::SetInstancedVertexShader(std::shared_ptr<SimpleVertexShader> vS)
+{
+	instancedVertexShader = vS;
+}
+
+const std::unordered_map<std::string, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>>& Material::GetTextureSRVMap()
 {
 	return textureSRVs;
 }
@@ -3,13 +3,14 @@
 //C++
 #include <memory>
 #include <unordered_map>
+#include <vector>
 
 //Program
 #include "SimpleShader.h"
 #include "Graphics.h"
 #include "PathHelpers.h"
-#include "Transform.h"
-#include "Camera.h"
+#include "ShaderConstants.h"
+#include "BindingTable.h"
 
 //DirectX
 #include <DirectXMath.h>
@@ -31,15 +32,37 @@ public:
 	void AddTextureSRV(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv);
 	void AddSampler(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState);
 
-	void PrepareMaterial(std::shared_ptr<Transform> transform, std::shared_ptr<Camera> camera);
+	// --------------------------------------------------------
+	// Drawing is split up - per-frame buffers are
+	// uploaded by the caller, BindMaterial() runs when the
+	// material changes and PrepareObject() runs for every draw.
+	// Instanced binding reads the matrices from a vertex buffer
+	// instead (see Mesh::DrawInstanced), so needs no object.
+	// With a ring, object data goes into a slice of it.
+	// --------------------------------------------------------
+	void BindMaterial(bool instanced = false);
+	void PrepareObject(const VSPerObject& object, ConstantBufferRing* ring = nullptr);
+	void PrepareObjectLights(const PSPerObject& lights, ConstantBufferRing* ring = nullptr);
+	bool SupportsInstancing();
+
+	// --------------------------------------------------------
+	// The ring path in two steps (see D3D11CommandBackend):
+	// Write*() fills a slice while the ring is mapped and
+	// returns false if it's full, Bind*() binds it later.
+	// --------------------------------------------------------
+	bool WriteObject(const VSPerObject& object, ConstantBufferRing* ring, ConstantBufferSlice* slice);
+	bool WriteObjectLights(const PSPerObject& lights, ConstantBufferRing* ring, ConstantBufferSlice* slice);
+	void BindObject(const ConstantBufferSlice& slice);
+	void BindObjectLights(const ConstantBufferSlice& slice);
 
 	DirectX::XMFLOAT4 GetColorTint();
-	std::shared_ptr<SimpleVertexShader> GetVertexShader();
-	std::shared_ptr<SimplePixelShader> GetPixelShader();
+	const std::shared_ptr<SimpleVertexShader>& GetVertexShader();
+	const std::shared_ptr<SimplePixelShader>& GetPixelShader();
 	DirectX::XMFLOAT2 GetUvScale();
 	DirectX::XMFLOAT2 GetUvOffset();
 	float GetRoughness();
 	const char* GetName();
+	unsigned int GetID();
 
 	void SetColorTint(DirectX::XMFLOAT4 cT);
 	void SetColorTint3(DirectX::XMFLOAT3 cT);
@@ -48,15 +71,52 @@ public:
 	void SetUvScale(DirectX::XMFLOAT2 uvs);
 	void SetUvOffset(DirectX::XMFLOAT2 uvo);
 	void SetRoughness(float rgh);
+	void SetInstancedVertexShader(std::shared_ptr<SimpleVertexShader> vS);
 	
-	std::unordered_map<std::string, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>>& GetTextureSRVMap();
+	const std::unordered_map<std::string, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>>& GetTextureSRVMap();
 
 private:
+	//Looks up the per-draw variables and buffers once per shader (see SimpleShaderHandle)
+	void ResolveHandles();
+
+	//Puts one draw's data in the shaders' local copies of their per-object buffers
+	void SetObjectData(const VSPerObject& object);
+	void SetObjectLightsData(const PSPerObject& lights);
+
+	//Flattens the texture and sampler maps into slot order for pixelShader
+	void BuildBindingTable();
+
 	const char* name;
+	unsigned int id;		// Small unique number, used in render queue sort keys
+
+	static unsigned int nextID;
 
 	DirectX::XMFLOAT4 colorTint;
 	std::shared_ptr<SimpleVertexShader> vertexShader;
 	std::shared_ptr<SimplePixelShader> pixelShader;
+	std::shared_ptr<SimpleVertexShader> instancedVertexShader;	// Optional, null if this material can't instance
+
+	//handles into vertexShader
+	SimpleShaderHandle worldHandle;
+	SimpleShaderHandle worldInvTransposeHandle;
+
+	//handles into pixelShader
+	SimpleShaderHandle colorTintHandle;
+	SimpleShaderHandle uvScaleHandle;
+	SimpleShaderHandle uvOffsetHandle;
+	SimpleShaderHandle roughnessHandle;
+	SimpleShaderHandle lightCountHandle;
+	SimpleShaderHandle lightIndicesHandle;
+
+	//buffers that match ShaderConstants.h and can be set as one struct
+	//(-1 for shaders that declare them differently - set by handle instead)
+	int vsObjectBuffer;
+	int psMaterialBuffer;
+	int psObjectBuffer;
+
+	//the per-object buffers either way (-1 if a shader has none)
+	int vsObjectIndex;
+	int psObjectIndex;
 
 	DirectX::XMFLOAT2 uvScale;
 	DirectX::XMFLOAT2 uvOffset;
@@ -64,5 +124,11 @@ private:
 
 	std::unordered_map<std::string, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>> textureSRVs;
 	std::unordered_map<std::string, Microsoft::WRL::ComPtr<ID3D11SamplerState>> samplers;
+
+	//what BindMaterial() actually binds - raw pointers, kept alive by the maps above
+	std::vector<ID3D11ShaderResourceView*> srvTable;
+	std::vector<BindingRange> srvRanges;
+	std::vector<ID3D11SamplerState*> samplerTable;
+	std::vector<BindingRange> samplerRanges;
 };
 
@@ -3,16 +3,23 @@
 // For the DirectX Math library
 using namespace DirectX;
 
+unsigned int Mesh::nextID = 0;
+
 Mesh::Mesh(const char* name, std::vector<Vertex> vertices, std::vector<UINT> indices) :
 	verts(vertices),
 	indices(indices),
-	name(name)
+	name(name),
+	id(nextID++),
+	stateCache(&StateCache::For(Graphics::Context.Get()))
 { 
+	CalculateBounds();
 	CreateBuffers();
 }
 
 Mesh::Mesh(const char* name, const char* objFile) : 
-	name(name)
+	name(name),
+	id(nextID++),
+	stateCache(&StateCache::For(Graphics::Context.Get()))
 {
 	// Author: Chris Cascioli
 // Purpose: Basic .OBJ 3D model loading, supporting positions, uvs and normals
@@ -266,6 +273,7 @@ Mesh::Mesh(const char* name, const char* objFile) :
 	//calculate vertex tangents
 	CalculateTangents();
 
+	CalculateBounds();
 	CreateBuffers();
 }
 
@@ -397,6 +405,23 @@ void Mesh::CalculateTangents()
 	}
 }
 
+// --------------------------------------------------------
+// Finds the object-space box around every vertex - done once
+// at load so culling only has to transform 8 corners' worth.
+// The triangle BVH picking walks is built here too.
+// --------------------------------------------------------
+void Mesh::CalculateBounds()
+{
+	localBounds = EmptyAABB();
+	for (unsigned int i = 0; i < verts.size(); i++)
+		AABBGrow(localBounds, verts[i].Position);
+
+	if (verts.empty())
+		localBounds = AABB{ XMFLOAT3(0, 0, 0), XMFLOAT3(0, 0, 0) };
+
+	triangles.Build(verts, indices);
+}
+
 Mesh::~Mesh() { }
 
 unsigned int Mesh::GetIndexCount() {
@@ -412,16 +437,62 @@ const char* Mesh::GetName()
 	return name;
 }
 
+unsigned int Mesh::GetID()
+{
+	return id;
+}
+
+AABB Mesh::GetLocalBounds()
+{
+	return localBounds;
+}
+
+const std::vector<Vertex>& Mesh::GetVertices()
+{
+	return verts;
+}
+
+const std::vector<UINT>& Mesh::GetIndices()
+{
+	return indices;
+}
+
+TriangleBVH* Mesh::GetTriangleBVH()
+{
+	return &triangles;
+}
+
 void Mesh::Draw() {
 	//create buffers for primitve / input assembly
 	UINT stride = sizeof(Vertex);
 	UINT offset = 0;
-	Graphics::Context->IASetVertexBuffers(0, 1, comptr_vertexBuffer.GetAddressOf(), &stride, &offset);
-	Graphics::Context->IASetIndexBuffer(comptr_indexBuffer.Get(), DXGI_FORMAT_R32_UINT, 0);
+	StateCache& cache = *stateCache;
+	cache.IASetVertexBuffers(0, 1, comptr_vertexBuffer.GetAddressOf(), &stride, &offset);
+	cache.IASetIndexBuffer(comptr_indexBuffer.Get(), DXGI_FORMAT_R32_UINT, 0);
 
 	//tell direct3d what to draw
 	Graphics::Context->DrawIndexed(
 		static_cast<unsigned int>(indices.size()),     // The number of indices to use (we could draw a subset if we wanted)
 		0,     // Offset to the first index we want to use
 		0);    // Offset to add to each index when looking up vertices
+}
+
+// --------------------------------------------------------
+// Same as Draw(), plus a second vertex buffer (slot 1) of
+// per-instance data starting at firstInstance
+// --------------------------------------------------------
+void Mesh::DrawInstanced(ID3D11Buffer* instanceBuffer, unsigned int instanceStride, unsigned int firstInstance, unsigned int instanceCount) {
+	ID3D11Buffer* buffers[2] = { comptr_vertexBuffer.Get(), instanceBuffer };
+	UINT strides[2] = { sizeof(Vertex), instanceStride };
+	UINT offsets[2] = { 0, 0 };
+	StateCache& cache = *stateCache;
+	cache.IASetVertexBuffers(0, 2, buffers, strides, offsets);
+	cache.IASetIndexBuffer(comptr_indexBuffer.Get(), DXGI_FORMAT_R32_UINT, 0);
+
+	Graphics::Context->DrawIndexedInstanced(
+		static_cast<unsigned int>(indices.size()),
+		instanceCount,
+		0,
+		0,
+		firstInstance);
 }
\ No newline at end of file
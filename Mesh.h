@@ -11,6 +11,9 @@
 //Program
 #include "Vertex.h"
 #include "Graphics.h"
+#include "Bounds.h"
+#include "StateCache.h"
+#include "TriangleBVH.h"
 
 //DirectX
 #include <DirectXMath.h>
@@ -23,6 +26,7 @@ public:
 
 	void CreateBuffers();
 	void CalculateTangents();
+	void CalculateBounds();
 
 	~Mesh();
 
@@ -32,14 +36,31 @@ public:
 	unsigned int GetIndexCount();
 	unsigned int GetVertexCount();
 	const char* GetName();
+	unsigned int GetID();
+	AABB GetLocalBounds();
+
+	//CPU copies of the geometry (used by the occlusion rasterizer)
+	const std::vector<Vertex>& GetVertices();
+	const std::vector<UINT>& GetIndices();
+
+	//Picking only walks the triangles whose boxes a ray passes through
+	TriangleBVH* GetTriangleBVH();
 
 	void Draw();
+	void DrawInstanced(ID3D11Buffer* instanceBuffer, unsigned int instanceStride, unsigned int firstInstance, unsigned int instanceCount);
 
 private:
 	Microsoft::WRL::ComPtr<ID3D11Buffer> comptr_vertexBuffer;
 	Microsoft::WRL::ComPtr<ID3D11Buffer> comptr_indexBuffer;
 
 	const char* name;
+	unsigned int id;		// Small unique number, used in render queue sort keys
+	StateCache* stateCache;	// Graphics::Context's cache, looked up once
+
+	static unsigned int nextID;
+
+	AABB localBounds;	// Object-space box around every vertex
+	TriangleBVH triangles;
 
 	std::vector<DirectX::XMFLOAT3> positions;	// Positions from the file
 	std::vector<DirectX::XMFLOAT3> normals;		// Normals from the file
@@ -0,0 +1,360 @@
+#include "OcclusionBuffer.h"
+
+//C++
+#include <algorithm>
+#include <cmath>
+
+//Program
+#include "CpuFeatures.h"
+
+using namespace DirectX;
+
+//tile size in pixels - the width is a multiple of 8 so the AVX loop stays inside a tile
+#define TILE_WIDTH 32
+#define TILE_HEIGHT 16
+
+//below this many triangles threads cost more than they save
+#define MIN_TRIANGLES_FOR_THREADS 256
+
+// --------------------------------------------------------
+// Row-vector transform helpers (p * m), kept local so the
+// buffer doesn't rely on the SIMD DirectXMath path
+// --------------------------------------------------------
+static XMFLOAT4 TransformPoint(const XMFLOAT3& p, const XMFLOAT4X4& m)
+{
+	return XMFLOAT4(
+		p.x * m._11 + p.y * m._21 + p.z * m._31 + m._41,
+		p.x * m._12 + p.y * m._22 + p.z * m._32 + m._42,
+		p.x * m._13 + p.y * m._23 + p.z * m._33 + m._43,
+		p.x * m._14 + p.y * m._24 + p.z * m._34 + m._44);
+}
+
+static XMFLOAT4X4 Multiply(const XMFLOAT4X4& a, const XMFLOAT4X4& b)
+{
+	XMFLOAT4X4 result;
+	for (int r = 0; r < 4; r++) {
+		for (int c = 0; c < 4; c++) {
+			result.m[r][c] = a.m[r][0] * b.m[0][c] + a.m[r][1] * b.m[1][c] + a.m[r][2] * b.m[2][c] + a.m[r][3] * b.m[3][c];
+		}
+	}
+	return result;
+}
+
+OcclusionBuffer::OcclusionBuffer(unsigned int width, unsigned int height, unsigned int threadCount) :
+	width(0),
+	height(0),
+	tilesX(0),
+	tilesY(0),
+	threadCount(threadCount),
+	simd(CpuHasAVX())
+{
+	if (this->threadCount == 0)
+		this->threadCount = std::max(1u, std::min(4u, std::thread::hardware_concurrency()));
+	workers.SetWorkerCount(this->threadCount - 1);
+
+	Resize(width, height);
+}
+
+// --------------------------------------------------------
+// Rounds the size up to whole tiles and reallocates the
+// depth pyramid
+// --------------------------------------------------------
+void OcclusionBuffer::Resize(unsigned int width, unsigned int height)
+{
+	tilesX = std::max(1u, (width + TILE_WIDTH - 1) / TILE_WIDTH);
+	tilesY = std::max(1u, (height + TILE_HEIGHT - 1) / TILE_HEIGHT);
+	this->width = tilesX * TILE_WIDTH;
+	this->height = tilesY * TILE_HEIGHT;
+
+	bins.assign(tilesX * tilesY, std::vector<unsigned int>());
+
+	levels.clear();
+	unsigned int w = this->width;
+	unsigned int h = this->height;
+	while (true) {
+		levels.push_back({ w, h, std::vector<float>(w * h, 1.0f) });
+		if (w == 1 && h == 1)
+			break;
+		w = std::max(1u, (w + 1) / 2);
+		h = std::max(1u, (h + 1) / 2);
+	}
+}
+
+void OcclusionBuffer::Begin(const DirectX::XMFLOAT4X4& viewProjection)
+{
+	this->viewProjection = viewProjection;
+
+	triangles.clear();
+	for (std::vector<unsigned int>& bin : bins)
+		bin.clear();
+}
+
+// --------------------------------------------------------
+// Projects an occluder's triangles and bins them by the
+// tiles their screen rectangle touches.  Triangles that
+// cross the near plane are dropped, which only ever makes
+// the buffer less aggressive.
+// --------------------------------------------------------
+void OcclusionBuffer::AddOccluder(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, const DirectX::XMFLOAT4X4& world)
+{
+	XMFLOAT4X4 worldViewProjection = Multiply(world, viewProjection);
+
+	for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+		ScreenTriangle tri;
+		bool clipped = false;
+
+		for (int v = 0; v < 3; v++) {
+			XMFLOAT4 clip = TransformPoint(vertices[indices[i + v]].Position, worldViewProjection);
+			if (clip.z < 0.0f || clip.w <= 1e-5f) {
+				clipped = true;
+				break;
+			}
+
+			float invW = 1.0f / clip.w;
+			tri.x[v] = (clip.x * invW * 0.5f + 0.5f) * width;
+			tri.y[v] = (0.5f - clip.y * invW * 0.5f) * height;
+			tri.z[v] = clip.z * invW;
+		}
+		if (clipped)
+			continue;
+
+		//pixel centers covered lie inside the rounded rectangle
+		tri.minX = std::max(0, (int)floorf(std::min({ tri.x[0], tri.x[1], tri.x[2] })));
+		tri.minY = std::max(0, (int)floorf(std::min({ tri.y[0], tri.y[1], tri.y[2] })));
+		tri.maxX = std::min((int)width - 1, (int)ceilf(std::max({ tri.x[0], tri.x[1], tri.x[2] })));
+		tri.maxY = std::min((int)height - 1, (int)ceilf(std::max({ tri.y[0], tri.y[1], tri.y[2] })));
+		if (tri.minX > tri.maxX || tri.minY > tri.maxY)
+			continue;
+
+		unsigned int index = (unsigned int)triangles.size();
+		triangles.push_back(tri);
+
+		for (int ty = tri.minY / TILE_HEIGHT; ty <= tri.maxY / TILE_HEIGHT; ty++) {
+			for (int tx = tri.minX / TILE_WIDTH; tx <= tri.maxX / TILE_WIDTH; tx++) {
+				bins[ty * tilesX + tx].push_back(index);
+			}
+		}
+	}
+}
+
+// --------------------------------------------------------
+// Clears the depth buffer, rasterizes every tile (spread
+// across threads when there's enough work) and builds the
+// HiZ pyramid
+// --------------------------------------------------------
+void OcclusionBuffer::Rasterize()
+{
+	std::fill(levels[0].depth.begin(), levels[0].depth.end(), 1.0f);
+
+	unsigned int tileCount = tilesX * tilesY;
+	if (triangles.size() < MIN_TRIANGLES_FOR_THREADS || threadCount <= 1) {
+		for (unsigned int tile = 0; tile < tileCount; tile++)
+			RasterizeTile(tile);
+	}
+	else {
+		//tiles own disjoint pixels, so the pool's threads just pull the next tile index
+		workers.Run(tileCount, [&](unsigned int tile) { RasterizeTile(tile); });
+	}
+
+	BuildHiZ();
+}
+
+void OcclusionBuffer::RasterizeTile(unsigned int tile)
+{
+	int tileMinX = (tile % tilesX) * TILE_WIDTH;
+	int tileMinY = (tile / tilesX) * TILE_HEIGHT;
+
+	for (unsigned int index : bins[tile])
+		RasterizeTriangle(triangles[index], tileMinX, tileMinY, tileMinX + TILE_WIDTH - 1, tileMinY + TILE_HEIGHT - 1);
+}
+
+// --------------------------------------------------------
+// Half-space rasterizer.  Each edge and the depth are set up
+// as planes over screen space (A * x + B * y + C) and then
+// evaluated at pixel centers, 8 at a time on CPUs with AVX.
+// --------------------------------------------------------
+void OcclusionBuffer::RasterizeTriangle(const ScreenTriangle& tri, int tileMinX, int tileMinY, int tileMaxX, int tileMaxY)
+{
+	float x0 = tri.x[0], y0 = tri.y[0];
+	float x1 = tri.x[1], y1 = tri.y[1];
+	float x2 = tri.x[2], y2 = tri.y[2];
+
+	//occluders are drawn regardless of winding, so flip to a positive area
+	float area = (x1 - x0) * (y2 - y0) - (y1 - y0) * (x2 - x0);
+	if (fabsf(area) < 1e-8f)
+		return;
+
+	float z0 = tri.z[0], z1 = tri.z[1], z2 = tri.z[2];
+	if (area < 0.0f) {
+		std::swap(x1, x2);
+		std::swap(y1, y2);
+		std::swap(z1, z2);
+		area = -area;
+	}
+
+	//edge opposite each vertex: E(p) = A * x + B * y + C
+	TrianglePlanes planes;
+	float* a = planes.a;
+	float* b = planes.b;
+	float* c = planes.c;
+	a[0] = y1 - y2; b[0] = x2 - x1; c[0] = -(a[0] * x1 + b[0] * y1);
+	a[1] = y2 - y0; b[1] = x0 - x2; c[1] = -(a[1] * x2 + b[1] * y2);
+	a[2] = y0 - y1; b[2] = x1 - x0; c[2] = -(a[2] * x0 + b[2] * y0);
+
+	//depth plane from the barycentric weights
+	float invArea = 1.0f / area;
+	planes.za = (a[0] * z0 + a[1] * z1 + a[2] * z2) * invArea;
+	planes.zb = (b[0] * z0 + b[1] * z1 + b[2] * z2) * invArea;
+	planes.zc = (c[0] * z0 + c[1] * z1 + c[2] * z2) * invArea;
+
+	int minX = std::max(tri.minX, tileMinX);
+	int minY = std::max(tri.minY, tileMinY);
+	int maxX = std::min(tri.maxX, tileMaxX);
+	int maxY = std::min(tri.maxY, tileMaxY);
+	if (minX > maxX || minY > maxY)
+		return;
+
+	float* depth = levels[0].depth.data();
+
+#if CPU_X86
+	//tiles start on a multiple of 8, so aligning down never leaves the tile
+	if (simd) {
+		RasterizeRectAVX(planes, depth, width, minX & ~7, minY, maxX, maxY);
+		return;
+	}
+#endif
+
+	RasterizeRectScalar(planes, depth, width, minX, minY, maxX, maxY);
+}
+
+void OcclusionBuffer::RasterizeRectScalar(const TrianglePlanes& planes, float* depth, unsigned int width, int minX, int minY, int maxX, int maxY)
+{
+	const float* a = planes.a;
+	const float* b = planes.b;
+	const float* c = planes.c;
+
+	for (int y = minY; y <= maxY; y++) {
+		float py = y + 0.5f;
+		float* row = depth + y * width;
+
+		//the y terms are summed once per row, exactly as the AVX version does,
+		//so both produce bit-identical coverage and depth
+		float row0 = b[0] * py + c[0];
+		float row1 = b[1] * py + c[1];
+		float row2 = b[2] * py + c[2];
+		float rowZ = planes.zb * py + planes.zc;
+
+		for (int x = minX; x <= maxX; x++) {
+			float px = x + 0.5f;
+			if (a[0] * px + row0 < 0.0f || a[1] * px + row1 < 0.0f || a[2] * px + row2 < 0.0f)
+				continue;
+
+			float z = planes.za * px + rowZ;
+			if (z < row[x])
+				row[x] = z;
+		}
+	}
+}
+
+// --------------------------------------------------------
+// Each level keeps the FARTHEST depth of the 2x2 texels
+// below it, so "box nearer than the texel" stays conservative
+// --------------------------------------------------------
+void OcclusionBuffer::BuildHiZ()
+{
+	for (size_t l = 1; l < levels.size(); l++) {
+		const HiZLevel& src = levels[l - 1];
+		HiZLevel& dst = levels[l];
+
+		for (unsigned int y = 0; y < dst.height; y++) {
+			unsigned int sy0 = std::min(y * 2, src.height - 1);
+			unsigned int sy1 = std::min(y * 2 + 1, src.height - 1);
+
+			for (unsigned int x = 0; x < dst.width; x++) {
+				unsigned int sx0 = std::min(x * 2, src.width - 1);
+				unsigned int sx1 = std::min(x * 2 + 1, src.width - 1);
+
+				dst.depth[y * dst.width + x] = std::max(
+					std::max(src.depth[sy0 * src.width + sx0], src.depth[sy0 * src.width + sx1]),
+					std::max(src.depth[sy1 * src.width + sx0], src.depth[sy1 * src.width + sx1]));
+			}
+		}
+	}
+}
+
+// --------------------------------------------------------
+// Projects the box's corners, picks the pyramid level where
+// its screen rectangle spans only a few texels, and reports
+// visible if the box's nearest depth is in front of any of
+// them.  Boxes crossing the near plane are always visible.
+// --------------------------------------------------------
+bool OcclusionBuffer::IsVisible(const AABB& worldBox)
+{
+	float minX = INFINITY, minY = INFINITY, maxX = -INFINITY, maxY = -INFINITY;
+	float minZ = INFINITY;
+
+	for (int i = 0; i < 8; i++) {
+		XMFLOAT3 corner(
+			(i & 1) ? worldBox.max.x : worldBox.min.x,
+			(i & 2) ? worldBox.max.y : worldBox.min.y,
+			(i & 4) ? worldBox.max.z : worldBox.min.z);
+
+		XMFLOAT4 clip = TransformPoint(corner, viewProjection);
+		if (clip.z < 0.0f || clip.w <= 1e-5f)
+			return true;
+
+		float invW = 1.0f / clip.w;
+		float sx = (clip.x * invW * 0.5f + 0.5f) * width;
+		float sy = (0.5f - clip.y * invW * 0.5f) * height;
+		minX = std::min(minX, sx);
+		maxX = std::max(maxX, sx);
+		minY = std::min(minY, sy);
+		maxY = std::max(maxY, sy);
+		minZ = std::min(minZ, clip.z * invW);
+	}
+
+	int x0 = std::max(0, (int)floorf(minX));
+	int y0 = std::max(0, (int)floorf(minY));
+	int x1 = std::min((int)width - 1, (int)floorf(maxX));
+	int y1 = std::min((int)height - 1, (int)floorf(maxY));
+	if (x0 > x1 || y0 > y1)
+		return false;
+
+	//coarsest level where the rectangle is at most ~4 texels across
+	unsigned int level = 0;
+	int size = std::max(x1 - x0, y1 - y0) + 1;
+	while (size > 4 && level + 1 < levels.size()) {
+		size = (size + 1) / 2;
+		level++;
+	}
+
+	const HiZLevel& hiZ = levels[level];
+	for (int y = y0 >> level; y <= (y1 >> level); y++) {
+		for (int x = x0 >> level; x <= (x1 >> level); x++) {
+			if (minZ <= hiZ.depth[y * hiZ.width + x])
+				return true;
+		}
+	}
+
+	return false;
+}
+
+unsigned int OcclusionBuffer::GetWidth() { return width; }
+
+unsigned int OcclusionBuffer::GetHeight() { return height; }
+
+unsigned int OcclusionBuffer::GetThreadCount() { return threadCount; }
+
+unsigned int OcclusionBuffer::GetTriangleCount() { return (unsigned int)triangles.size(); }
+
+bool OcclusionBuffer::GetSIMD() { return simd; }
+
+const std::vector<float>& OcclusionBuffer::GetDepth() { return levels[0].depth; }
+
+void OcclusionBuffer::SetThreadCount(unsigned int threadCount)
+{
+	this->threadCount = std::max(1u, threadCount);
+	workers.SetWorkerCount(this->threadCount - 1);
+}
+
+void OcclusionBuffer::SetSIMD(bool enabled) { simd = enabled && CpuHasAVX(); }
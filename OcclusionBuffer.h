@@ -0,0 +1,93 @@
+#pragma once
+
+//C++
+#include <vector>
+
+//DirectX
+#include <DirectXMath.h>
+
+//Program
+#include "Vertex.h"
+#include "Bounds.h"
+#include "ThreadPool.h"
+
+// --------------------------------------------------------
+// Low resolution CPU depth buffer for occlusion culling.
+//  - Occluder triangles are transformed to screen space,
+//    binned into tiles and rasterized on worker threads
+//    (kept alive between frames)
+//  - A max-depth pyramid (HiZ) is built on top so a box
+//    can be tested against a handful of texels
+// Everything here is plain C++ so it runs without D3D.
+// --------------------------------------------------------
+class OcclusionBuffer
+{
+public:
+	OcclusionBuffer(unsigned int width = 256, unsigned int height = 128, unsigned int threadCount = 0);
+
+	void Resize(unsigned int width, unsigned int height);
+
+	//Per frame: Begin, AddOccluder for each occluder, Rasterize, then IsVisible
+	void Begin(const DirectX::XMFLOAT4X4& viewProjection);
+	void AddOccluder(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, const DirectX::XMFLOAT4X4& world);
+	void Rasterize();
+	bool IsVisible(const AABB& worldBox);
+
+	//Getters
+	unsigned int GetWidth();
+	unsigned int GetHeight();
+	unsigned int GetThreadCount();
+	unsigned int GetTriangleCount();
+	bool GetSIMD();
+	const std::vector<float>& GetDepth();
+
+	//Setters
+	void SetThreadCount(unsigned int threadCount);
+	void SetSIMD(bool enabled);		// Ignored (stays off) on CPUs without AVX
+
+private:
+	struct ScreenTriangle
+	{
+		float x[3], y[3], z[3];
+		int minX, minY, maxX, maxY;
+	};
+
+	struct HiZLevel
+	{
+		unsigned int width;
+		unsigned int height;
+		std::vector<float> depth;
+	};
+
+	//A triangle's three edge functions and its depth as planes over screen space (A * x + B * y + C)
+	struct TrianglePlanes
+	{
+		float a[3], b[3], c[3];
+		float za, zb, zc;
+	};
+
+	void RasterizeTile(unsigned int tile);
+	void RasterizeTriangle(const ScreenTriangle& tri, int tileMinX, int tileMinY, int tileMaxX, int tileMaxY);
+	void BuildHiZ();
+
+	//Fills the covered pixels of a rectangle (minX a multiple of 8 for the AVX
+	//version, which lives in OcclusionBufferAVX.cpp - only call if CpuHasAVX())
+	static void RasterizeRectScalar(const TrianglePlanes& planes, float* depth, unsigned int width, int minX, int minY, int maxX, int maxY);
+	static void RasterizeRectAVX(const TrianglePlanes& planes, float* depth, unsigned int width, int minX, int minY, int maxX, int maxY);
+
+	unsigned int width;
+	unsigned int height;
+	unsigned int tilesX;
+	unsigned int tilesY;
+	unsigned int threadCount;
+	bool simd;
+
+	//threadCount - 1 workers; Rasterize() is the last thread
+	ThreadPool workers;
+
+	DirectX::XMFLOAT4X4 viewProjection;
+
+	std::vector<ScreenTriangle> triangles;
+	std::vector<std::vector<unsigned int>> bins;	// Triangle indices per tile
+	std::vector<HiZLevel> levels;					// Level 0 is the full depth buffer
+};
@@ -0,0 +1,52 @@
+#include "OcclusionBuffer.h"
+
+//Program
+#include "CpuFeatures.h"
+
+// --------------------------------------------------------
+// Built with AVX enabled (/arch:AVX on this file only), so
+// nothing here may run before CpuHasAVX() says it can.
+// Sticks to intrinsics and raw pointers - an inline
+// function from a shared header compiled here could be the
+// copy the linker keeps for the whole program.
+// --------------------------------------------------------
+#if CPU_X86
+
+//C++
+#include <immintrin.h>
+
+// --------------------------------------------------------
+// 8 pixels per iteration along each row.  minX is a
+// multiple of 8 and rows are whole tiles wide, so the
+// loads and stores never leave the tile.
+// --------------------------------------------------------
+void OcclusionBuffer::RasterizeRectAVX(const TrianglePlanes& planes, float* depth, unsigned int width, int minX, int minY, int maxX, int maxY)
+{
+	const float* a = planes.a;
+	const float* b = planes.b;
+	const float* c = planes.c;
+	const __m256 laneOffsets = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+	const __m256 zero = _mm256_setzero_ps();
+
+	for (int y = minY; y <= maxY; y++) {
+		float py = y + 0.5f;
+		float* row = depth + y * width;
+
+		for (int x = minX; x <= maxX; x += 8) {
+			__m256 px = _mm256_add_ps(_mm256_set1_ps((float)x), laneOffsets);
+			__m256 e0 = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(a[0]), px), _mm256_set1_ps(b[0] * py + c[0]));
+			__m256 e1 = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(a[1]), px), _mm256_set1_ps(b[1] * py + c[1]));
+			__m256 e2 = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(a[2]), px), _mm256_set1_ps(b[2] * py + c[2]));
+			__m256 inside = _mm256_and_ps(_mm256_cmp_ps(e0, zero, _CMP_GE_OQ),
+				_mm256_and_ps(_mm256_cmp_ps(e1, zero, _CMP_GE_OQ), _mm256_cmp_ps(e2, zero, _CMP_GE_OQ)));
+			if (_mm256_movemask_ps(inside) == 0)
+				continue;
+
+			__m256 z = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(planes.za), px), _mm256_set1_ps(planes.zb * py + planes.zc));
+			__m256 old = _mm256_loadu_ps(row + x);
+			_mm256_storeu_ps(row + x, _mm256_blendv_ps(old, _mm256_min_ps(old, z), inside));
+		}
+	}
+}
+
+#endif
@@ -1,17 +1,27 @@
 #include "ShaderIncludes.hlsli"
 
-cbuffer psConstantBuffer : register(b0)
+// Uploaded once per frame - every light in the scene
+cbuffer perFrame : register(b0)
+{
+    float3 cameraPosition;
+    float3 ambient;
+    Light lights[MAX_SCENE_LIGHTS];
+}
+
+// Uploaded when the material changes
+cbuffer perMaterial : register(b1)
 {
     float4 colorTint;
     float2 uvScale;
     float2 uvOffset;
-    float3 cameraPosition;
     float roughness;
-    
-    float3 ambient;
-    Light lights[MAX_LIGHTS];
+}
+
+// Uploaded for every draw - which of the scene's lights reach this object
+cbuffer perObject : register(b2)
+{
     int lightCount;
-    
+    int4 lightIndices[LIGHT_INDEX_VECTORS];
 }
 
 Texture2D SurfaceTexture : register(t0); // "t" registers for textures
@@ -56,7 +66,7 @@ float4 main(VertexToPixel input) : SV_TARGET
     
     for (int i = 0; i < lightCount; i++)
     {
-        totalLight += CreateLight(lights[i], input.normal, input.worldPosition, cameraPosition, roughness, surfaceColor);
+        totalLight += CreateLight(lights[lightIndices[i / 4][i % 4]], input.normal, input.worldPosition, cameraPosition, roughness, surfaceColor);
     }
     
     return pow(float4(totalLight, 1), 1.0f / 2.2f);
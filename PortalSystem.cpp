@@ -0,0 +1,245 @@
+#include "PortalSystem.h"
+
+//C++
+#include <cmath>
+#include <algorithm>
+
+using namespace DirectX;
+
+// --------------------------------------------------------
+// Small vector helpers on the storage types
+// --------------------------------------------------------
+static XMFLOAT3 Sub(const XMFLOAT3& a, const XMFLOAT3& b) { return XMFLOAT3(a.x - b.x, a.y - b.y, a.z - b.z); }
+
+static XMFLOAT3 Cross(const XMFLOAT3& a, const XMFLOAT3& b)
+{
+	return XMFLOAT3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+}
+
+static float PlaneDistance(const XMFLOAT4& plane, const XMFLOAT3& p) { return plane.x * p.x + plane.y * p.y + plane.z * p.z + plane.w; }
+
+// --------------------------------------------------------
+// Plane through three points (normalized), or a zero plane
+// if they're degenerate
+// --------------------------------------------------------
+static XMFLOAT4 PlaneFromPoints(const XMFLOAT3& a, const XMFLOAT3& b, const XMFLOAT3& c)
+{
+	XMFLOAT3 n = Cross(Sub(b, a), Sub(c, a));
+	float length = sqrtf(n.x * n.x + n.y * n.y + n.z * n.z);
+	if (length < 1e-8f)
+		return XMFLOAT4(0, 0, 0, 0);
+
+	n = XMFLOAT3(n.x / length, n.y / length, n.z / length);
+	return XMFLOAT4(n.x, n.y, n.z, -(n.x * a.x + n.y * a.y + n.z * a.z));
+}
+
+// --------------------------------------------------------
+// Sutherland-Hodgman against one plane, keeping the side
+// where the plane distance is >= 0
+// --------------------------------------------------------
+static void ClipPolygon(const std::vector<XMFLOAT3>& in, const XMFLOAT4& plane, std::vector<XMFLOAT3>& out)
+{
+	out.clear();
+	size_t count = in.size();
+	for (size_t i = 0; i < count; i++) {
+		const XMFLOAT3& a = in[i];
+		const XMFLOAT3& b = in[(i + 1) % count];
+		float da = PlaneDistance(plane, a);
+		float db = PlaneDistance(plane, b);
+
+		if (da >= 0.0f)
+			out.push_back(a);
+
+		if ((da >= 0.0f) != (db >= 0.0f)) {
+			float t = da / (da - db);
+			out.push_back(XMFLOAT3(a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, a.z + (b.z - a.z) * t));
+		}
+	}
+}
+
+PortalSystem::PortalSystem(int maxDepth) :
+	maxDepth(maxDepth),
+	cellTree(0.0f),
+	frame(0),
+	portalsTraversed(0)
+{
+}
+
+int PortalSystem::AddCell(const AABB& bounds)
+{
+	int index = (int)cells.size();
+	cells.push_back({ bounds, {} });
+	visibleFrame.push_back(0);
+	cellTree.Insert(bounds, index);
+	return index;
+}
+
+// --------------------------------------------------------
+// Points should form a convex polygon (either winding)
+// --------------------------------------------------------
+int PortalSystem::AddPortal(int cellA, int cellB, const std::vector<DirectX::XMFLOAT3>& points)
+{
+	Portal portal;
+	portal.points = points;
+	portal.plane = points.size() >= 3 ? PlaneFromPoints(points[0], points[1], points[2]) : XMFLOAT4(0, 0, 0, 0);
+	portal.cells[0] = cellA;
+	portal.cells[1] = cellB;
+	portal.onStack = false;
+
+	int index = (int)portals.size();
+	portals.push_back(portal);
+	cells[cellA].portals.push_back(index);
+	cells[cellB].portals.push_back(index);
+	return index;
+}
+
+void PortalSystem::Clear()
+{
+	cells.clear();
+	portals.clear();
+	visibleCells.clear();
+	visibleFrame.clear();
+	cellTree = DynamicBVH(0.0f);
+	frame = 0;
+}
+
+// --------------------------------------------------------
+// Where cells touch, the point is on both - the lowest
+// index wins, so the answer doesn't depend on tree order
+// --------------------------------------------------------
+int PortalSystem::FindCell(const DirectX::XMFLOAT3& point)
+{
+	cellHits.clear();
+	cellTree.QueryOverlap({ point, point }, cellHits);
+
+	int found = -1;
+	for (int cell : cellHits) {
+		if (found == -1 || cell < found)
+			found = cell;
+	}
+	return found;
+}
+
+void PortalSystem::FindCells(const AABB& bounds, std::vector<int>& out)
+{
+	//with no margin the leaves are the cell bounds themselves, so every hit is a real overlap
+	out.clear();
+	cellTree.QueryOverlap(bounds, out);
+	std::sort(out.begin(), out.end());
+}
+
+void PortalSystem::ComputeVisibleCells(const DirectX::XMFLOAT3& eye, const Frustum& frustum)
+{
+	frame++;
+	visibleCells.clear();
+	portalsTraversed = 0;
+
+	int start = FindCell(eye);
+	if (start < 0) {
+		//outside the interior - fall back to plain frustum tests on the cells
+		for (size_t i = 0; i < cells.size(); i++) {
+			if (FrustumTestAABB(frustum, cells[i].bounds) != CullResult::Outside)
+				MarkVisible((int)i);
+		}
+		return;
+	}
+
+	std::vector<XMFLOAT4> planes(frustum.planes, frustum.planes + 6);
+	Traverse(start, eye, planes, 0);
+}
+
+// --------------------------------------------------------
+// Marks the cell, then for each portal: clip it by the
+// current planes, and if anything is left, build a new
+// frustum from the eye through the clipped edges (keeping
+// the far plane) and continue into the neighbour
+// --------------------------------------------------------
+void PortalSystem::Traverse(int cell, const DirectX::XMFLOAT3& eye, const std::vector<DirectX::XMFLOAT4>& planes, int depth)
+{
+	MarkVisible(cell);
+	if (depth >= maxDepth)
+		return;
+
+	std::vector<XMFLOAT3> clipped, scratch;
+	for (int p : cells[cell].portals) {
+		Portal& portal = portals[p];
+		if (portal.onStack)
+			continue;
+
+		//clip the portal polygon by every plane we're looking through
+		clipped = portal.points;
+		for (const XMFLOAT4& plane : planes) {
+			ClipPolygon(clipped, plane, scratch);
+			clipped.swap(scratch);
+			if (clipped.size() < 3)
+				break;
+		}
+		if (clipped.size() < 3)
+			continue;
+
+		portalsTraversed++;
+		int next = portal.cells[0] == cell ? portal.cells[1] : portal.cells[0];
+
+		std::vector<XMFLOAT4> narrowed;
+		if (fabsf(PlaneDistance(portal.plane, eye)) < 1e-3f) {
+			//standing in the doorway - the edge planes would be degenerate
+			narrowed = planes;
+		}
+		else {
+			XMFLOAT3 centroid(0, 0, 0);
+			for (const XMFLOAT3& v : clipped) {
+				centroid.x += v.x;
+				centroid.y += v.y;
+				centroid.z += v.z;
+			}
+			float inv = 1.0f / clipped.size();
+			centroid = XMFLOAT3(centroid.x * inv, centroid.y * inv, centroid.z * inv);
+
+			for (size_t i = 0; i < clipped.size(); i++) {
+				XMFLOAT4 edgePlane = PlaneFromPoints(eye, clipped[i], clipped[(i + 1) % clipped.size()]);
+				if (edgePlane.x == 0.0f && edgePlane.y == 0.0f && edgePlane.z == 0.0f)
+					continue;
+
+				//face the planes inward, towards the middle of the opening
+				if (PlaneDistance(edgePlane, centroid) < 0.0f)
+					edgePlane = XMFLOAT4(-edgePlane.x, -edgePlane.y, -edgePlane.z, -edgePlane.w);
+				narrowed.push_back(edgePlane);
+			}
+
+			//the far plane is the last of the camera's planes
+			narrowed.push_back(planes.back());
+		}
+
+		portal.onStack = true;
+		Traverse(next, eye, narrowed, depth + 1);
+		portal.onStack = false;
+	}
+}
+
+void PortalSystem::MarkVisible(int cell)
+{
+	if (visibleFrame[cell] == frame)
+		return;
+
+	visibleFrame[cell] = frame;
+	visibleCells.push_back(cell);
+}
+
+bool PortalSystem::IsCellVisible(int cell) { return cell >= 0 && cell < (int)cells.size() && visibleFrame[cell] == frame; }
+
+bool PortalSystem::IsAnyCellVisible(const std::vector<int>& cells)
+{
+	for (int cell : cells) {
+		if (IsCellVisible(cell))
+			return true;
+	}
+	return false;
+}
+
+const std::vector<int>& PortalSystem::GetVisibleCells() { return visibleCells; }
+
+unsigned int PortalSystem::GetCellCount() { return (unsigned int)cells.size(); }
+
+unsigned int PortalSystem::GetPortalCount() { return (unsigned int)portals.size(); }
+
+unsigned int PortalSystem::GetPortalsTraversed() { return portalsTraversed; }
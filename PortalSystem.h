@@ -0,0 +1,79 @@
+#pragma once
+
+//C++
+#include <vector>
+
+//DirectX
+#include <DirectXMath.h>
+
+//Program
+#include "Bounds.h"
+#include "DynamicBVH.h"
+
+// --------------------------------------------------------
+// Cell and portal visibility for indoor scenes.
+//  - A cell is a room, described by its bounds
+//  - A portal is a convex polygon joining two cells
+// Starting from the camera's cell, the view frustum is
+// narrowed through every portal it can see and the cells
+// behind are marked visible.  Pure CPU math, no D3D.
+// Cell lookups go through a BVH over the cell bounds, so
+// they stay cheap as the number of rooms grows.
+// --------------------------------------------------------
+class PortalSystem
+{
+public:
+	PortalSystem(int maxDepth = 16);
+
+	//Building
+	int AddCell(const AABB& bounds);
+	int AddPortal(int cellA, int cellB, const std::vector<DirectX::XMFLOAT3>& points);
+	void Clear();
+
+	//Cell containing a point, or -1 if it isn't inside any
+	int FindCell(const DirectX::XMFLOAT3& point);
+
+	//Every cell the box overlaps, in cell order (replaces the contents of out)
+	void FindCells(const AABB& bounds, std::vector<int>& out);
+
+	//Fills the visible set - if the eye is outside every cell, any cell in the frustum counts
+	void ComputeVisibleCells(const DirectX::XMFLOAT3& eye, const Frustum& frustum);
+	bool IsCellVisible(int cell);
+	bool IsAnyCellVisible(const std::vector<int>& cells);
+	const std::vector<int>& GetVisibleCells();
+
+	//Getters
+	unsigned int GetCellCount();
+	unsigned int GetPortalCount();
+	unsigned int GetPortalsTraversed();
+
+private:
+	struct Cell
+	{
+		AABB bounds;
+		std::vector<int> portals;
+	};
+
+	struct Portal
+	{
+		std::vector<DirectX::XMFLOAT3> points;
+		DirectX::XMFLOAT4 plane;
+		int cells[2];
+		bool onStack;	// Stops the traversal from walking back through itself
+	};
+
+	void Traverse(int cell, const DirectX::XMFLOAT3& eye, const std::vector<DirectX::XMFLOAT4>& planes, int depth);
+	void MarkVisible(int cell);
+
+	int maxDepth;
+	std::vector<Cell> cells;
+	std::vector<Portal> portals;
+
+	DynamicBVH cellTree;		// Exact cell bounds (no margin), user data = cell index
+	std::vector<int> cellHits;	// FindCell() query scratch
+
+	std::vector<int> visibleCells;
+	std::vector<unsigned int> visibleFrame;		// Stamp per cell, compared with frame
+	unsigned int frame;
+	unsigned int portalsTraversed;
+};
@@ -0,0 +1,135 @@
+#include "RenderQueue.h"
+
+//C++
+#include <algorithm>
+#include <array>
+
+//below this many packets threads cost more than they save
+#define MIN_PACKETS_FOR_THREADS 65536
+
+RenderQueue::RenderQueue(unsigned int threadCount) :
+	threadCount(threadCount)
+{
+	if (this->threadCount == 0)
+		this->threadCount = std::max(1u, std::min(8u, std::thread::hardware_concurrency()));
+	workers.SetWorkerCount(this->threadCount - 1);
+}
+
+// --------------------------------------------------------
+// Packs the fields into a key - each field is clamped to
+// its width, and depth is expected in [0, 1]
+// --------------------------------------------------------
+uint64_t RenderQueue::MakeKey(unsigned int pass, unsigned int shader, unsigned int material, unsigned int mesh, float depth)
+{
+	depth = std::min(std::max(depth, 0.0f), 1.0f);
+	uint64_t quantized = (uint64_t)(depth * 65535.0f);
+
+	return ((uint64_t)(pass & 0xF) << 60) |
+		((uint64_t)(shader & 0xFFF) << 48) |
+		((uint64_t)(material & 0xFFFF) << 32) |
+		((uint64_t)(mesh & 0xFFFF) << 16) |
+		quantized;
+}
+
+// --------------------------------------------------------
+// Keyed on the exact pair, so two pairs never share an ID
+// (the key only has room for 4096 of them; past that they
+// wrap and just sort less well)
+// --------------------------------------------------------
+unsigned int RenderQueue::GetShaderID(const void* vertexShader, const void* pixelShader)
+{
+	std::pair<const void*, const void*> pair(vertexShader, pixelShader);
+
+	auto it = shaderIDs.find(pair);
+	if (it != shaderIDs.end())
+		return it->second;
+
+	unsigned int id = (unsigned int)shaderIDs.size();
+	shaderIDs.insert({ pair, id });
+	return id;
+}
+
+void RenderQueue::Clear() { packets.clear(); }
+
+void RenderQueue::Add(uint64_t key, unsigned int entity) { packets.push_back({ key, entity }); }
+
+void RenderQueue::Sort() { RadixSort(packets, scratch, &workers); }
+
+const std::vector<RenderPacket>& RenderQueue::GetPackets() { return packets; }
+
+unsigned int RenderQueue::GetThreadCount() { return threadCount; }
+
+void RenderQueue::SetThreadCount(unsigned int threadCount)
+{
+	this->threadCount = std::max(1u, threadCount);
+	workers.SetWorkerCount(this->threadCount - 1);
+}
+
+// --------------------------------------------------------
+// 8 passes of 8 bits, least significant first.  Each of
+// the pool's threads owns a contiguous slice: every pass
+// histograms the slices in one Run(), turns the histograms
+// into per-slice scatter offsets, then scatters the slices
+// in a second Run().  Slices scatter in order, so every
+// pass stays stable.  Passes where every key has the same
+// byte are skipped.
+// --------------------------------------------------------
+void RenderQueue::RadixSort(std::vector<RenderPacket>& packets, std::vector<RenderPacket>& scratch, ThreadPool* pool)
+{
+	size_t count = packets.size();
+	if (count < 2)
+		return;
+
+	scratch.resize(count);
+	unsigned int sliceCount = 1;
+	if (pool && count >= MIN_PACKETS_FOR_THREADS)
+		sliceCount = pool->GetWorkerCount() + 1;
+
+	auto run = [&](const std::function<void(unsigned int)>& task) {
+		if (sliceCount == 1)
+			task(0);
+		else
+			pool->Run(sliceCount, task);
+	};
+
+	std::vector<std::array<size_t, 256>> offsets(sliceCount);
+	RenderPacket* src = packets.data();
+	RenderPacket* dst = scratch.data();
+
+	for (int shift = 0; shift < 64; shift += 8) {
+		run([&](unsigned int slice) {
+			std::array<size_t, 256>& histogram = offsets[slice];
+			histogram.fill(0);
+			for (size_t i = count * slice / sliceCount; i < count * (slice + 1) / sliceCount; i++)
+				histogram[(src[i].key >> shift) & 0xFF]++;
+		});
+
+		//each slice's digits go after every earlier digit, and after earlier slices' of its own
+		bool skip = false;
+		size_t running = 0;
+		for (int digit = 0; digit < 256; digit++) {
+			size_t total = 0;
+			for (unsigned int slice = 0; slice < sliceCount; slice++) {
+				size_t sliceTotal = offsets[slice][digit];
+				offsets[slice][digit] = running + total;
+				total += sliceTotal;
+			}
+
+			if (total == count)
+				skip = true;
+			running += total;
+		}
+		if (skip)
+			continue;
+
+		run([&](unsigned int slice) {
+			std::array<size_t, 256>& offset = offsets[slice];
+			for (size_t i = count * slice / sliceCount; i < count * (slice + 1) / sliceCount; i++)
+				dst[offset[(src[i].key >> shift) & 0xFF]++] = src[i];
+		});
+		std::swap(src, dst);
+	}
+
+	if (src != packets.data())
+		packets.swap(scratch);
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+//C++
+#include <vector>
+#include <cstdint>
+#include <map>
+
+//Program
+#include "ThreadPool.h"
+
+// --------------------------------------------------------
+// One draw, reduced to a sort key and the entity to draw
+// --------------------------------------------------------
+struct RenderPacket
+{
+	uint64_t key;
+	unsigned int entity;
+};
+
+// --------------------------------------------------------
+// Passes are the most significant part of the key, so all
+// of one pass draws before the next
+// --------------------------------------------------------
+#define RENDER_PASS_OPAQUE 0
+#define RENDER_PASS_TRANSPARENT 1
+
+//every part of a key except depth - packets equal under this share all draw state
+#define RENDER_KEY_STATE_MASK 0xFFFFFFFFFFFF0000ull
+
+// --------------------------------------------------------
+// Per-frame list of packets sorted by a 64-bit key:
+//
+//   63..60  pass
+//   59..48  shader    (vertex + pixel shader pair)
+//   47..32  material
+//   31..16  mesh
+//   15..0   depth     (quantized, front to back)
+//
+// so sorting groups draws by the most expensive state first.
+// Keys are sorted with an LSD radix sort that splits each
+// pass across the queue's thread pool once the queue is big
+// enough.
+// --------------------------------------------------------
+class RenderQueue
+{
+public:
+	RenderQueue(unsigned int threadCount = 0);
+
+	static uint64_t MakeKey(unsigned int pass, unsigned int shader, unsigned int material, unsigned int mesh, float depth);
+
+	//Small stable IDs for shader pairs, handed out on first use (one per exact pair)
+	unsigned int GetShaderID(const void* vertexShader, const void* pixelShader);
+
+	void Clear();
+	void Add(uint64_t key, unsigned int entity);
+	void Sort();
+
+	const std::vector<RenderPacket>& GetPackets();
+	unsigned int GetThreadCount();
+	void SetThreadCount(unsigned int threadCount);
+
+	//Exposed on its own so it can be run on any packet list (no pool sorts on this thread)
+	static void RadixSort(std::vector<RenderPacket>& packets, std::vector<RenderPacket>& scratch, ThreadPool* pool = nullptr);
+
+private:
+	std::vector<RenderPacket> packets;
+	std::vector<RenderPacket> scratch;
+	unsigned int threadCount;
+
+	//threadCount - 1 workers; Sort() is the last thread
+	ThreadPool workers;
+
+	std::map<std::pair<const void*, const void*>, unsigned int> shaderIDs;
+};
@@ -0,0 +1,97 @@
+#pragma once
+
+//C++
+#include <vector>
+
+// --------------------------------------------------------
+// Per-frame rendering counters, filled in by Game::Draw()
+// and shown in the UI's "General" panel
+// --------------------------------------------------------
+struct RenderStats
+{
+	unsigned int entitiesTotal = 0;
+	unsigned int entitiesVisible = 0;
+	unsigned int entitiesFrustumCulled = 0;
+	unsigned int entitiesPortalCulled = 0;
+	unsigned int entitiesContributionCulled = 0;
+	unsigned int entitiesOcclusionCulled = 0;
+	unsigned int occluderTriangles = 0;
+
+	//visibility cache
+	unsigned int entitiesRetested = 0;
+	unsigned int entitiesEntered = 0;
+	unsigned int entitiesExited = 0;
+
+	//render queue, counted while walking the sorted packets
+	unsigned int drawCalls = 0;
+	unsigned int shaderChanges = 0;
+	unsigned int materialChanges = 0;
+	unsigned int meshChanges = 0;
+
+	//instanced draws and the entities they covered
+	unsigned int instancedBatches = 0;
+	unsigned int instancesDrawn = 0;
+
+	//pipeline state calls that reached the context vs. ones the state cache dropped
+	unsigned int stateCallsIssued = 0;
+	unsigned int stateCallsFiltered = 0;
+
+	//light indices sent to the pixel shader, summed over draws
+	unsigned int lightsUploaded = 0;
+
+	//constant buffer bytes sent with UpdateSubresource, and buffer copies
+	//issued vs. skipped because their data hadn't changed
+	unsigned int constantBytesUploaded = 0;
+	unsigned int constantUploadsIssued = 0;
+	unsigned int constantUploadsSkipped = 0;
+
+	//bytes of the per-draw constant ring not yet retired
+	unsigned int constantRingUsed = 0;
+
+	//draw command buffers recorded (one per thread) and their total size
+	unsigned int commandBuffers = 0;
+	unsigned int commandBytes = 0;
+
+	//debug multi-view pass, indexed by camera slot
+	std::vector<unsigned int> entitiesVisiblePerView;
+};
+
+// --------------------------------------------------------
+// Renderer toggles the UI is allowed to change
+// --------------------------------------------------------
+struct RenderSettings
+{
+	bool occlusionCulling = true;
+	bool portalCulling = true;
+
+	//entities whose bounding sphere covers less than this many pixels (radius) are skipped
+	bool contributionCulling = true;
+	float contributionThreshold = 1.0f;
+
+	//reuse last frame's results for entities that haven't moved
+	bool visibilityCaching = true;
+
+	//only send each entity the lights whose range reaches it
+	bool lightCulling = true;
+
+	//debug: cull every camera's view each frame to show how many entities each one sees
+	bool debugViewCulling = false;
+
+	//draw entities sharing a mesh and material with one instanced call
+	bool instancing = true;
+
+	//put per-draw constants in slices of one mapped buffer (if the device supports it)
+	bool constantRing = true;
+
+	//record draw commands on worker threads (they're always replayed on this one)
+	bool parallelRecording = true;
+
+	//true if both would cull every entity the same way (what cached visibility depends on)
+	bool SameCulling(const RenderSettings& other) const
+	{
+		return occlusionCulling == other.occlusionCulling &&
+			portalCulling == other.portalCulling &&
+			contributionCulling == other.contributionCulling &&
+			contributionThreshold == other.contributionThreshold;
+	}
+};
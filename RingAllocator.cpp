@@ -0,0 +1,80 @@
+#include "RingAllocator.h"
+
+RingAllocator::RingAllocator(unsigned int capacity, unsigned int alignment) :
+	capacity(capacity),
+	alignment(alignment),
+	head(0),
+	tail(0),
+	allocated(0),
+	retired(0)
+{
+}
+
+void RingAllocator::Reset(unsigned int capacity)
+{
+	this->capacity = capacity;
+	head = 0;
+	tail = 0;
+	allocated = 0;
+	retired = 0;
+	fences.clear();
+}
+
+bool RingAllocator::Allocate(unsigned int size, unsigned int* offset, bool* wrapped)
+{
+	unsigned int aligned = (size + alignment - 1) / alignment * alignment;
+	unsigned int used = GetUsed();
+	*wrapped = false;
+
+	if (aligned == 0 || aligned > capacity - used)
+		return false;
+
+	//free space is [head, tail) when the head is behind the tail,
+	//otherwise [head, capacity) followed by [0, tail)
+	if (head < tail || (head == tail && used > 0)) {
+		if (tail - head < aligned)
+			return false;
+
+		*offset = head;
+	}
+	else if (capacity - head >= aligned) {
+		*offset = head;
+	}
+	else {
+		//the end is too short - skip it (it counts as used until retired) and start over at 0
+		if (tail < aligned)
+			return false;
+
+		allocated += capacity - head;
+		*offset = 0;
+		*wrapped = true;
+	}
+
+	head = *offset + aligned;
+	if (head == capacity)
+		head = 0;
+	allocated += aligned;
+	return true;
+}
+
+void RingAllocator::EndFrame(uint64_t frame)
+{
+	fences.push_back({ frame, head, allocated });
+}
+
+void RingAllocator::RetireFrames(uint64_t completedFrame)
+{
+	while (!fences.empty() && fences.front().frame <= completedFrame) {
+		tail = fences.front().head;
+		retired = fences.front().allocated;
+		fences.pop_front();
+	}
+}
+
+unsigned int RingAllocator::GetCapacity() { return capacity; }
+
+unsigned int RingAllocator::GetAlignment() { return alignment; }
+
+unsigned int RingAllocator::GetUsed() { return (unsigned int)(allocated - retired); }
+
+unsigned int RingAllocator::GetFenceCount() { return (unsigned int)fences.size(); }
@@ -0,0 +1,65 @@
+#pragma once
+
+//C++
+#include <deque>
+#include <cstdint>
+
+// --------------------------------------------------------
+// Offset-only ring allocator (no memory of its own), used
+// to hand out slices of a GPU buffer.  Allocations are
+// aligned and move a head forward, wrapping to 0 when the
+// end doesn't have room.  EndFrame() fences everything
+// allocated so far; once the GPU is done with that frame,
+// RetireFrames() releases it and the tail catches up.
+// Nothing is ever handed out over a region the GPU might
+// still be reading.
+// --------------------------------------------------------
+class RingAllocator
+{
+public:
+	RingAllocator(unsigned int capacity = 0, unsigned int alignment = 256);
+
+	//Empties the ring (and drops all fences) at a new size
+	void Reset(unsigned int capacity);
+
+	// --------------------------------------------------------
+	// Finds room for size bytes.  wrapped is set when the slice
+	// starts back at offset 0.  Returns false if the ring is
+	// full of data from frames that haven't been retired.
+	// --------------------------------------------------------
+	bool Allocate(unsigned int size, unsigned int* offset, bool* wrapped);
+
+	//Fences this frame's allocations with its number
+	void EndFrame(uint64_t frame);
+
+	//Frees every frame up to and including completedFrame
+	void RetireFrames(uint64_t completedFrame);
+
+	unsigned int GetCapacity();
+	unsigned int GetAlignment();
+	unsigned int GetUsed();			// Bytes allocated and not yet retired (including skipped ends)
+	unsigned int GetFenceCount();
+
+private:
+	// --------------------------------------------------------
+	// Where the head was, and how much had been allocated in
+	// total, at the end of a frame
+	// --------------------------------------------------------
+	struct Fence
+	{
+		uint64_t frame;
+		unsigned int head;
+		uint64_t allocated;
+	};
+
+	unsigned int capacity;
+	unsigned int alignment;
+	unsigned int head;
+	unsigned int tail;
+
+	//running totals, so used = allocated - retired even when head == tail
+	uint64_t allocated;
+	uint64_t retired;
+
+	std::deque<Fence> fences;
+};
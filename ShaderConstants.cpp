@@ -0,0 +1,49 @@
+#include "ShaderConstants.h"
+
+const CBufferLayout& VSPerFrame::Layout()
+{
+	static const CBufferLayout layout = { "perFrame", sizeof(VSPerFrame), {
+		CBUFFER_FIELD(VSPerFrame, view),
+		CBUFFER_FIELD(VSPerFrame, proj),
+	} };
+	return layout;
+}
+
+const CBufferLayout& VSPerObject::Layout()
+{
+	static const CBufferLayout layout = { "perObject", sizeof(VSPerObject), {
+		CBUFFER_FIELD(VSPerObject, world),
+		CBUFFER_FIELD(VSPerObject, worldInvTranspose),
+	} };
+	return layout;
+}
+
+const CBufferLayout& PSPerFrame::Layout()
+{
+	static const CBufferLayout layout = { "perFrame", sizeof(PSPerFrame), {
+		CBUFFER_FIELD(PSPerFrame, cameraPosition),
+		CBUFFER_FIELD(PSPerFrame, ambient),
+		CBUFFER_FIELD(PSPerFrame, lights),
+	} };
+	return layout;
+}
+
+const CBufferLayout& PSPerMaterial::Layout()
+{
+	static const CBufferLayout layout = { "perMaterial", sizeof(PSPerMaterial), {
+		CBUFFER_FIELD(PSPerMaterial, colorTint),
+		CBUFFER_FIELD(PSPerMaterial, uvScale),
+		CBUFFER_FIELD(PSPerMaterial, uvOffset),
+		CBUFFER_FIELD(PSPerMaterial, roughness),
+	} };
+	return layout;
+}
+
+const CBufferLayout& PSPerObject::Layout()
+{
+	static const CBufferLayout layout = { "perObject", sizeof(PSPerObject), {
+		CBUFFER_FIELD(PSPerObject, lightCount),
+		CBUFFER_FIELD(PSPerObject, lightIndices),
+	} };
+	return layout;
+}
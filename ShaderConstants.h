@@ -0,0 +1,76 @@
+#pragma once
+
+//DirectX
+#include <DirectXMath.h>
+
+//Program
+#include "Lights.h"
+#include "CBufferLayout.h"
+
+// --------------------------------------------------------
+// C++ mirrors of the constant buffers in VertexShader.hlsl
+// and PixelShader.hlsl, so each buffer can be filled as a
+// struct and set with one ISimpleShader::SetBufferData().
+//
+// Padding HLSL inserts to keep members inside 16-byte
+// registers is spelled out here as pad members.  Layout()
+// lists the real members only, for checking against the
+// compiled shader with ISimpleShader::ValidateBufferLayout()
+// - keep both in step with the .hlsl files.
+// --------------------------------------------------------
+
+//cbuffer perFrame : register(b0) (vertex)
+struct VSPerFrame
+{
+	DirectX::XMFLOAT4X4 view;
+	DirectX::XMFLOAT4X4 proj;
+
+	static const CBufferLayout& Layout();
+};
+
+//cbuffer perObject : register(b1) (vertex)
+struct VSPerObject
+{
+	DirectX::XMFLOAT4X4 world;
+	DirectX::XMFLOAT4X4 worldInvTranspose;
+
+	static const CBufferLayout& Layout();
+};
+
+//cbuffer perFrame : register(b0) (pixel)
+struct PSPerFrame
+{
+	DirectX::XMFLOAT3 cameraPosition;
+	float pad0;
+	DirectX::XMFLOAT3 ambient;
+	float pad1;
+	Light lights[MAX_SCENE_LIGHTS];
+
+	static const CBufferLayout& Layout();
+};
+
+//cbuffer perMaterial : register(b1) (pixel)
+struct PSPerMaterial
+{
+	DirectX::XMFLOAT4 colorTint;
+	DirectX::XMFLOAT2 uvScale;
+	DirectX::XMFLOAT2 uvOffset;
+	float roughness;
+
+	static const CBufferLayout& Layout();
+};
+
+//cbuffer perObject : register(b2) (pixel)
+struct PSPerObject
+{
+	int lightCount;
+	int pad[3];
+	int lightIndices[LIGHT_INDEX_VECTORS * 4];	// int4 lightIndices[LIGHT_INDEX_VECTORS]
+
+	static const CBufferLayout& Layout();
+};
+
+//the parts of the packing that don't depend on the shader compiler
+static_assert(sizeof(Light) % 16 == 0, "Light must fill whole registers to be an HLSL array element");
+static_assert(offsetof(PSPerFrame, lights) % 16 == 0, "Arrays start on a register boundary");
+static_assert(offsetof(PSPerObject, lightIndices) % 16 == 0, "Arrays start on a register boundary");
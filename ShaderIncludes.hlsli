@@ -8,6 +8,8 @@
 #define MAX_SPECULAR_EXPONENT 256.0f
 
 #define MAX_LIGHTS 10
+#define MAX_SCENE_LIGHTS 32
+#define LIGHT_INDEX_VECTORS ((MAX_LIGHTS + 3) / 4)
 
 // Struct representing a single vertex worth of data
 // - This should match the vertex definition in our C++ code
@@ -0,0 +1,37 @@
+#include "ShaderVariableTable.h"
+
+void ShaderVariableTable::Clear()
+{
+	byName.clear();
+	byHash.clear();
+	hashCollision = false;
+}
+
+void ShaderVariableTable::Add(const std::string& name, const SimpleShaderVariable& var)
+{
+	auto added = byName.insert(NameTable::value_type(name, var));
+	if (!added.second)
+		return;
+
+	if (!byHash.insert({ SimpleShaderHash(name.c_str()), &*added.first }).second)
+		hashCollision = true;
+}
+
+SimpleShaderVariable* ShaderVariableTable::Find(const std::string& name)
+{
+	auto result = byName.find(name);
+	return result == byName.end() ? nullptr : &result->second;
+}
+
+SimpleShaderVariable* ShaderVariableTable::Find(const SimpleShaderName& name)
+{
+	if (hashCollision)
+		return Find(std::string(name.Text));
+
+	auto result = byHash.find(name.Hash);
+	if (result == byHash.end() || result->second->first != name.Text)
+		return nullptr;
+	return &result->second->second;
+}
+
+const std::unordered_map<std::string, SimpleShaderVariable>& ShaderVariableTable::GetVariables() { return byName; }
@@ -0,0 +1,76 @@
+#pragma once
+
+//C++
+#include <unordered_map>
+#include <string>
+#include <cstdint>
+
+// --------------------------------------------------------
+// Used by simple shaders to store information about
+// specific variables in constant buffers
+// --------------------------------------------------------
+struct SimpleShaderVariable
+{
+	unsigned int ByteOffset;
+	unsigned int Size;
+	unsigned int ConstantBufferIndex;
+};
+
+// --------------------------------------------------------
+// 32-bit FNV-1a hash of a variable name, usable at
+// compile time
+// --------------------------------------------------------
+constexpr uint32_t SimpleShaderHash(const char* text)
+{
+	uint32_t hash = 2166136261u;
+	while (*text)
+	{
+		hash ^= (unsigned char)*text++;
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+// --------------------------------------------------------
+// A variable name with its hash worked out up front, so
+// looking it up never builds or hashes a std::string:
+//
+//   static constexpr SimpleShaderName worldName("world");
+//   SimpleShaderHandle world = vs->GetVariableHandle(worldName);
+// --------------------------------------------------------
+struct SimpleShaderName
+{
+	const char* Text;
+	uint32_t Hash;
+
+	constexpr explicit SimpleShaderName(const char* text) : Text(text), Hash(SimpleShaderHash(text)) {}
+};
+
+// --------------------------------------------------------
+// A shader's variables, found by name or by precomputed
+// hash.  A hash hit still compares the name, so a name the
+// shader doesn't have can't land on another variable that
+// happens to share its hash.  If two of the shader's own
+// names collide, hashed lookups fall back to the name.
+// --------------------------------------------------------
+class ShaderVariableTable
+{
+public:
+	void Clear();
+
+	//Names are unique within a shader; a repeat is ignored
+	void Add(const std::string& name, const SimpleShaderVariable& var);
+
+	//Null if the shader has no variable of that name
+	SimpleShaderVariable* Find(const std::string& name);
+	SimpleShaderVariable* Find(const SimpleShaderName& name);
+
+	const std::unordered_map<std::string, SimpleShaderVariable>& GetVariables();
+
+private:
+	typedef std::unordered_map<std::string, SimpleShaderVariable> NameTable;
+
+	NameTable byName;
+	std::unordered_map<uint32_t, NameTable::value_type*> byHash; // Into byName, whose entries never move
+	bool hashCollision = false;
+};
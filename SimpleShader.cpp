@@ -1,8 +1,13 @@
 #include "SimpleShader.h"
 
+#include <algorithm>
+
 // Default error reporting state
 bool ISimpleShader::ReportErrors = false;
 bool ISimpleShader::ReportWarnings = false;
+unsigned int ISimpleShader::UploadedBytes = 0;
+unsigned int ISimpleShader::UploadsIssued = 0;
+unsigned int ISimpleShader::UploadsSkipped = 0;
 
 // To enable error reporting, use either or both 
 // of the following lines somewhere in your program, 
@@ -24,6 +29,7 @@ ISimpleShader::ISimpleShader(Microsoft::WRL::ComPtr<ID3D11Device> device, Micros
 	// Save the device
 	this->device = device;
 	this->deviceContext = context;
+	this->stateCache = &StateCache::For(context.Get());
 
 	// Set up fields
 	this->constantBufferCount = 0;
@@ -64,7 +70,7 @@ void ISimpleShader::CleanUp()
 		delete samplerStates[i];
 
 	// Clean up tables
-	varTable.clear();
+	varTable.Clear();
 	cbTable.clear();
 	samplerTable.clear();
 	textureTable.clear();
@@ -224,7 +230,7 @@ bool ISimpleShader::LoadShaderFile(LPCWSTR shaderFile)
 			std::string varName(varDesc.Name);
 
 			// Add this variable to the table and the constant buffer
-			varTable.insert(std::pair<std::string, SimpleShaderVariable>(varName, varStruct));
+			varTable.Add(varName, varStruct);
 			constantBuffers[b].Variables.push_back(varStruct);
 		}
 	}
@@ -243,16 +249,10 @@ bool ISimpleShader::LoadShaderFile(LPCWSTR shaderFile)
 SimpleShaderVariable* ISimpleShader::FindVariable(std::string name, int size)
 {
 	// Look for the key
-	std::unordered_map<std::string, SimpleShaderVariable>::iterator result =
-		varTable.find(name);
-
-	// Did we find the key?
-	if (result == varTable.end())
+	SimpleShaderVariable* var = varTable.Find(name);
+	if (var == 0)
 		return 0;
 
-	// Grab the result from the iterator
-	SimpleShaderVariable* var = &(result->second);
-
 	// Is the data size correct ?
 	if (size > 0 && var->Size != size)
 		return 0;
@@ -349,9 +349,7 @@ void ISimpleShader::CopyAllBufferData()
 	for (unsigned int i = 0; i < constantBufferCount; i++)
 	{
 		// Copy the entire local data buffer
-		deviceContext->UpdateSubresource(
-			constantBuffers[i].ConstantBuffer.Get(), 0, 0,
-			constantBuffers[i].LocalDataBuffer, 0, 0);
+		UploadBuffer(&constantBuffers[i]);
 	}
 }
 
@@ -380,9 +378,7 @@ void ISimpleShader::CopyBufferData(unsigned int index)
 	if (!cb) return;
 
 	// Copy the data and get out
-	deviceContext->UpdateSubresource(
-		cb->ConstantBuffer.Get(), 0, 0, 
-		cb->LocalDataBuffer, 0, 0);
+	UploadBuffer(cb);
 }
 
 // --------------------------------------------------------
@@ -402,11 +398,206 @@ void ISimpleShader::CopyBufferData(std::string bufferName)
 	if (!cb) return;
 
 	// Copy the data and get out
+	UploadBuffer(cb);
+}
+
+// --------------------------------------------------------
+// Copies local data into a fresh slice of a shared ring
+// buffer and binds that slice in place of the shader's own
+// buffer.  Meant for data that changes every draw, so the
+// dirty flag isn't consulted.  If the ring is full (or
+// the stage/device can't bind by offset) this falls back
+// to a normal copy into the shader's own buffer.
+//
+// bufferName - Specifies the name of the buffer to copy.
+// ring - The shared ring to allocate from
+// --------------------------------------------------------
+void ISimpleShader::CopyBufferData(std::string bufferName, ConstantBufferRing* ring)
+{
+	// Check for the buffer
+	SimpleConstantBuffer* cb = this->FindConstantBuffer(bufferName);
+	if (!cb) return;
+
+	CopyBufferData((unsigned int)(cb - constantBuffers), ring);
+}
+
+// --------------------------------------------------------
+// Same, by index (see GetBufferIndex())
+// --------------------------------------------------------
+void ISimpleShader::CopyBufferData(unsigned int index, ConstantBufferRing* ring)
+{
+	// Ensure the shader is valid
+	if (!shaderValid) return;
+
+	// Validate the index
+	if (index >= this->constantBufferCount)
+		return;
+
+	SimpleConstantBuffer* cb = &this->constantBuffers[index];
+
+	ConstantBufferSlice slice;
+	if (ring && UploadBufferData(index, ring, &slice) && BindBufferData(index, slice))
+		return;
+
+	// The slot may still hold a ring slice from an earlier draw
+	BindConstantBuffer(cb->BindIndex, cb->ConstantBuffer.Get());
+	UploadBuffer(cb);
+}
+
+// --------------------------------------------------------
+// Copies local data into a fresh slice of a ring without
+// binding it (see BindBufferData())
+//
+// index - The buffer's index (see GetBufferIndex())
+// ring - The shared ring to allocate from
+// slice - Where the data landed
+//
+// Returns false if the index is wrong or the ring is full
+// --------------------------------------------------------
+bool ISimpleShader::UploadBufferData(unsigned int index, ConstantBufferRing* ring, ConstantBufferSlice* slice)
+{
+	if (!shaderValid || index >= this->constantBufferCount)
+		return false;
+
+	SimpleConstantBuffer* cb = &this->constantBuffers[index];
+	if (!ring->Upload(cb->LocalDataBuffer, cb->Size, slice))
+		return false;
+
+	UploadedBytes += cb->Size;
+	UploadsIssued++;
+	return true;
+}
+
+// --------------------------------------------------------
+// Binds a slice filled by UploadBufferData() in place of
+// the buffer's own
+// --------------------------------------------------------
+bool ISimpleShader::BindBufferData(unsigned int index, const ConstantBufferSlice& slice)
+{
+	if (!shaderValid || index >= this->constantBufferCount)
+		return false;
+
+	return BindConstantBufferRange(this->constantBuffers[index].BindIndex, slice);
+}
+
+// --------------------------------------------------------
+// Copies a buffer's local data to the GPU, unless nothing
+// has been changed by SetData() since the last copy
+// --------------------------------------------------------
+void ISimpleShader::UploadBuffer(SimpleConstantBuffer* cb)
+{
+	if (!cb->Upload.NeedsUpload())
+	{
+		UploadsSkipped++;
+		return;
+	}
+
 	deviceContext->UpdateSubresource(
-		cb->ConstantBuffer.Get(), 0, 0, 
+		cb->ConstantBuffer.Get(), 0, 0,
 		cb->LocalDataBuffer, 0, 0);
+	cb->Upload.MarkUploaded();
+
+	UploadedBytes += cb->Size;
+	UploadsIssued++;
+}
+
+
+// --------------------------------------------------------
+// Resolves a variable name to a handle (invalid if the
+// variable isn't in this shader)
+// --------------------------------------------------------
+SimpleShaderHandle ISimpleShader::GetVariableHandle(std::string name)
+{
+	SimpleShaderHandle handle;
+	SimpleShaderVariable* var = FindVariable(name, -1);
+	if (var)
+	{
+		handle.ConstantBufferIndex = var->ConstantBufferIndex;
+		handle.ByteOffset = var->ByteOffset;
+		handle.Size = var->Size;
+	}
+	return handle;
 }
 
+// --------------------------------------------------------
+// Same, using the precomputed hash of the name
+// --------------------------------------------------------
+SimpleShaderHandle ISimpleShader::GetVariableHandle(const SimpleShaderName& name)
+{
+	SimpleShaderHandle handle;
+	SimpleShaderVariable* var = varTable.Find(name);
+	if (var)
+	{
+		handle.ConstantBufferIndex = var->ConstantBufferIndex;
+		handle.ByteOffset = var->ByteOffset;
+		handle.Size = var->Size;
+	}
+	return handle;
+}
+
+// --------------------------------------------------------
+// Sets a variable through a handle with arbitrary data of
+// the specified size
+//
+// handle - A handle from this shader's GetVariableHandle()
+// data - The data to set in the buffer
+// size - The size of the data (this must be less than or equal to the variable's size)
+//
+// Returns true if data is copied, false if the handle is invalid or too small
+// --------------------------------------------------------
+bool ISimpleShader::SetData(const SimpleShaderHandle& handle, const void* data, unsigned int size)
+{
+	if (!handle.IsValid() || size > handle.Size || handle.ConstantBufferIndex >= constantBufferCount)
+		return false;
+
+	// Set the data in the local data buffer, marking the
+	// buffer for upload only if the bytes actually change
+	SimpleConstantBuffer* cb = &constantBuffers[handle.ConstantBufferIndex];
+	cb->Upload.Write(cb->LocalDataBuffer + handle.ByteOffset, data, size);
+
+	return true;
+}
+
+// --------------------------------------------------------
+// Replaces a constant buffer's entire local data with one
+// copy, for C++ structs that mirror the buffer.  The struct
+// may be short of the buffer by the padding HLSL adds to
+// round it up to 16 bytes, but no more - so a struct from
+// the wrong buffer is caught here, and a struct whose
+// members are laid out wrong is caught by
+// ValidateBufferLayout() at load time.
+//
+// index - The buffer's index (see GetBufferIndex())
+// data - The struct to copy
+// size - sizeof the struct
+//
+// Returns true if data is copied, false if the index or size is wrong
+// --------------------------------------------------------
+bool ISimpleShader::SetBufferData(unsigned int index, const void* data, unsigned int size)
+{
+	if (index >= constantBufferCount)
+		return false;
+
+	SimpleConstantBuffer* cb = &constantBuffers[index];
+	if (size > cb->Size || (size + 15) / 16 * 16 != cb->Size)
+		return false;
+
+	cb->Upload.Write(cb->LocalDataBuffer, data, size);
+
+	return true;
+}
+
+bool ISimpleShader::SetInt(const SimpleShaderHandle& handle, int data) { return SetData(handle, &data, sizeof(int)); }
+
+bool ISimpleShader::SetFloat(const SimpleShaderHandle& handle, float data) { return SetData(handle, &data, sizeof(float)); }
+
+bool ISimpleShader::SetFloat2(const SimpleShaderHandle& handle, const DirectX::XMFLOAT2 data) { return SetData(handle, &data, sizeof(float) * 2); }
+
+bool ISimpleShader::SetFloat3(const SimpleShaderHandle& handle, const DirectX::XMFLOAT3 data) { return SetData(handle, &data, sizeof(float) * 3); }
+
+bool ISimpleShader::SetFloat4(const SimpleShaderHandle& handle, const DirectX::XMFLOAT4 data) { return SetData(handle, &data, sizeof(float) * 4); }
+
+bool ISimpleShader::SetMatrix4x4(const SimpleShaderHandle& handle, const DirectX::XMFLOAT4X4 data) { return SetData(handle, &data, sizeof(float) * 16); }
 
 // --------------------------------------------------------
 // Sets a variable by name with arbitrary data of the specified size
@@ -420,8 +611,8 @@ void ISimpleShader::CopyBufferData(std::string bufferName)
 bool ISimpleShader::SetData(std::string name, const void* data, unsigned int size)
 {
 	// Look for the variable and verify
-	SimpleShaderVariable* var = FindVariable(name, -1);
-	if (var == 0)
+	SimpleShaderHandle handle = GetVariableHandle(name);
+	if (!handle.IsValid())
 	{
 		if (ReportWarnings)
 		{
@@ -434,7 +625,7 @@ bool ISimpleShader::SetData(std::string name, const void* data, unsigned int siz
 
 	// Ensure we're not trying to copy more data than the variable can hold
 	// Note: We can copy less data, in the case of a subset of an array
-	if (size > var->Size)
+	if (size > handle.Size)
 	{
 		if (ReportWarnings)
 		{
@@ -445,14 +636,8 @@ bool ISimpleShader::SetData(std::string name, const void* data, unsigned int siz
 		return false;
 	}
 
-	// Set the data in the local data buffer
-	memcpy(
-		constantBuffers[var->ConstantBufferIndex].LocalDataBuffer + var->ByteOffset,
-		data,
-		size);
-
-	// Success
-	return true;
+	// Hand off to the handle version
+	return SetData(handle, data, size);
 }
 
 // --------------------------------------------------------
@@ -680,6 +865,66 @@ const SimpleConstantBuffer * ISimpleShader::GetBufferInfo(unsigned int index)
 	return &constantBuffers[index];
 }
 
+// --------------------------------------------------------
+// Gets the index of a constant buffer by name, or -1 if
+// it doesn't exist
+// --------------------------------------------------------
+int ISimpleShader::GetBufferIndex(std::string name)
+{
+	SimpleConstantBuffer* cb = FindConstantBuffer(name);
+	if (!cb) return -1;
+
+	return (int)(cb - constantBuffers);
+}
+
+// --------------------------------------------------------
+// Builds a constant buffer's layout from reflection:
+// its size and every variable in it, sorted by offset
+//
+// Returns false if the buffer doesn't exist
+// --------------------------------------------------------
+bool ISimpleShader::GetBufferLayout(std::string name, CBufferLayout* layout)
+{
+	SimpleConstantBuffer* cb = FindConstantBuffer(name);
+	if (!cb) return false;
+
+	unsigned int index = (unsigned int)(cb - constantBuffers);
+
+	layout->name = cb->Name;
+	layout->size = cb->Size;
+	layout->fields.clear();
+	for (auto& var : varTable.GetVariables())
+	{
+		if (var.second.ConstantBufferIndex == index)
+			layout->fields.push_back({ var.first, var.second.ByteOffset, var.second.Size });
+	}
+
+	std::sort(layout->fields.begin(), layout->fields.end(),
+		[](const CBufferField& a, const CBufferField& b) { return a.offset < b.offset; });
+	return true;
+}
+
+// --------------------------------------------------------
+// Checks a C++ struct's layout (see CBUFFER_FIELD) against
+// the constant buffer of the same name in this shader
+//
+// cpu - The struct's layout; its name picks the buffer
+// error - Optional, receives a description of each mismatch
+//
+// Returns true if the struct can be copied over the buffer
+// --------------------------------------------------------
+bool ISimpleShader::ValidateBufferLayout(const CBufferLayout& cpu, std::string* error)
+{
+	CBufferLayout reflected;
+	if (!GetBufferLayout(cpu.name, &reflected))
+	{
+		if (error) *error += "cbuffer " + cpu.name + ": not in this shader\n";
+		return false;
+	}
+
+	return ValidateCBufferLayout(cpu, reflected, error);
+}
+
 
 
 
@@ -869,8 +1114,9 @@ void SimpleVertexShader::SetShaderAndCBs()
 	if (!shaderValid) return;
 
 	// Set the shader and input layout
-	deviceContext->IASetInputLayout(inputLayout.Get());
-	deviceContext->VSSetShader(shader.Get(), 0, 0);
+	StateCache& cache = *stateCache;
+	cache.IASetInputLayout(inputLayout.Get());
+	cache.VSSetShader(shader.Get());
 
 	// Set the constant buffers
 	for (unsigned int i = 0; i < constantBufferCount; i++)
@@ -880,13 +1126,28 @@ void SimpleVertexShader::SetShaderAndCBs()
 			continue;
 
 		// This is a real constant buffer, so set it
-		deviceContext->VSSetConstantBuffers(
+		cache.VSSetConstantBuffer(
 			constantBuffers[i].BindIndex,
-			1,
-			constantBuffers[i].ConstantBuffer.GetAddressOf());
+			constantBuffers[i].ConstantBuffer.Get());
 	}
 }
 
+// --------------------------------------------------------
+// Binds constant buffers to the vertex stage (through
+// the state cache)
+// --------------------------------------------------------
+bool SimpleVertexShader::BindConstantBuffer(unsigned int slot, ID3D11Buffer* buffer)
+{
+	stateCache->VSSetConstantBuffer(slot, buffer);
+	return true;
+}
+
+bool SimpleVertexShader::BindConstantBufferRange(unsigned int slot, const ConstantBufferSlice& slice)
+{
+	stateCache->VSSetConstantBufferRange(slot, slice.buffer, slice.firstConstant, slice.numConstants);
+	return true;
+}
+
 // --------------------------------------------------------
 // Sets a shader resource view in the vertex shader stage
 //
@@ -911,7 +1172,7 @@ bool SimpleVertexShader::SetShaderResourceView(std::string name, Microsoft::WRL:
 	}
 
 	// Set the shader resource view
-	deviceContext->VSSetShaderResources(srvInfo->BindIndex, 1, srv.GetAddressOf());
+	stateCache->VSSetShaderResource(srvInfo->BindIndex, srv.Get());
 
 	// Success
 	return true;
@@ -941,7 +1202,7 @@ bool SimpleVertexShader::SetSamplerState(std::string name, Microsoft::WRL::ComPt
 	}
 
 	// Set the shader resource view
-	deviceContext->VSSetSamplers(sampInfo->BindIndex, 1, samplerState.GetAddressOf());
+	stateCache->VSSetSampler(sampInfo->BindIndex, samplerState.Get());
 
 	// Success
 	return true;
@@ -1012,7 +1273,8 @@ void SimplePixelShader::SetShaderAndCBs()
 	if (!shaderValid) return;
 	
 	// Set the shader
-	deviceContext->PSSetShader(shader.Get(), 0, 0);
+	StateCache& cache = *stateCache;
+	cache.PSSetShader(shader.Get());
 
 	// Set the constant buffers
 	for (unsigned int i = 0; i < constantBufferCount; i++)
@@ -1022,13 +1284,28 @@ void SimplePixelShader::SetShaderAndCBs()
 			continue;
 
 		// This is a real constant buffer, so set it
-		deviceContext->PSSetConstantBuffers(
+		cache.PSSetConstantBuffer(
 			constantBuffers[i].BindIndex,
-			1,
-			constantBuffers[i].ConstantBuffer.GetAddressOf());
+			constantBuffers[i].ConstantBuffer.Get());
 	}
 }
 
+// --------------------------------------------------------
+// Binds constant buffers to the pixel stage (through
+// the state cache)
+// --------------------------------------------------------
+bool SimplePixelShader::BindConstantBuffer(unsigned int slot, ID3D11Buffer* buffer)
+{
+	stateCache->PSSetConstantBuffer(slot, buffer);
+	return true;
+}
+
+bool SimplePixelShader::BindConstantBufferRange(unsigned int slot, const ConstantBufferSlice& slice)
+{
+	stateCache->PSSetConstantBufferRange(slot, slice.buffer, slice.firstConstant, slice.numConstants);
+	return true;
+}
+
 // --------------------------------------------------------
 // Sets a shader resource view in the pixel shader stage
 //
@@ -1053,7 +1330,7 @@ bool SimplePixelShader::SetShaderResourceView(std::string name, Microsoft::WRL::
 	}
 
 	// Set the shader resource view
-	deviceContext->PSSetShaderResources(srvInfo->BindIndex, 1, srv.GetAddressOf());
+	stateCache->PSSetShaderResource(srvInfo->BindIndex, srv.Get());
 
 	// Success
 	return true;
@@ -1083,7 +1360,7 @@ bool SimplePixelShader::SetSamplerState(std::string name, Microsoft::WRL::ComPtr
 	}
 
 	// Set the shader resource view
-	deviceContext->PSSetSamplers(sampInfo->BindIndex, 1, samplerState.GetAddressOf());
+	stateCache->PSSetSampler(sampInfo->BindIndex, samplerState.Get());
 
 	// Success
 	return true;
@@ -10,18 +10,14 @@
 #include <unordered_map>
 #include <vector>
 #include <string>
+#include <cstdint>
 
+#include "StateCache.h"
+#include "ConstantBufferRing.h"
+#include "CBufferLayout.h"
+#include "UploadTracker.h"
+#include "ShaderVariableTable.h"
 
-// --------------------------------------------------------
-// Used by simple shaders to store information about
-// specific variables in constant buffers
-// --------------------------------------------------------
-struct SimpleShaderVariable
-{
-	unsigned int ByteOffset;
-	unsigned int Size;
-	unsigned int ConstantBufferIndex;
-};
 
 // --------------------------------------------------------
 // Contains information about a specific
@@ -37,6 +33,23 @@ struct SimpleConstantBuffer
 	Microsoft::WRL::ComPtr<ID3D11Buffer> ConstantBuffer = 0;
 	unsigned char* LocalDataBuffer = 0;
 	std::vector<SimpleShaderVariable> Variables;
+	UploadTracker Upload; // Whether local data differs from what was last uploaded
+};
+
+// --------------------------------------------------------
+// A shader variable resolved once by name: which constant
+// buffer it's in and where.  Setting data through a handle
+// skips the name lookup entirely.  A handle only means
+// something to the shader that made it; Size 0 means the
+// variable doesn't exist.
+// --------------------------------------------------------
+struct SimpleShaderHandle
+{
+	unsigned int ConstantBufferIndex = 0;
+	unsigned int ByteOffset = 0;
+	unsigned int Size = 0;
+
+	bool IsValid() const { return Size > 0; }
 };
 
 // --------------------------------------------------------
@@ -74,8 +87,33 @@ public:
 	void CopyAllBufferData();
 	void CopyBufferData(unsigned int index);
 	void CopyBufferData(std::string bufferName);
+	void CopyBufferData(unsigned int index, ConstantBufferRing* ring);
+	void CopyBufferData(std::string bufferName, ConstantBufferRing* ring);
 
-	// Sets arbitrary shader data
+	// The ring version in two steps, so many slices can be
+	// written under one map before any of them are bound
+	bool UploadBufferData(unsigned int index, ConstantBufferRing* ring, ConstantBufferSlice* slice);
+	bool BindBufferData(unsigned int index, const ConstantBufferSlice& slice);
+
+	// Sets a whole constant buffer at once from a struct that
+	// mirrors it (see ValidateBufferLayout)
+	bool SetBufferData(unsigned int index, const void* data, unsigned int size);
+
+	// Resolving variable names to handles (once, not per draw)
+	SimpleShaderHandle GetVariableHandle(std::string name);
+	SimpleShaderHandle GetVariableHandle(const SimpleShaderName& name);
+
+	// Sets shader data through a handle from this shader
+	bool SetData(const SimpleShaderHandle& handle, const void* data, unsigned int size);
+
+	bool SetInt(const SimpleShaderHandle& handle, int data);
+	bool SetFloat(const SimpleShaderHandle& handle, float data);
+	bool SetFloat2(const SimpleShaderHandle& handle, const DirectX::XMFLOAT2 data);
+	bool SetFloat3(const SimpleShaderHandle& handle, const DirectX::XMFLOAT3 data);
+	bool SetFloat4(const SimpleShaderHandle& handle, const DirectX::XMFLOAT4 data);
+	bool SetMatrix4x4(const SimpleShaderHandle& handle, const DirectX::XMFLOAT4X4 data);
+
+	// Sets arbitrary shader data by name (looks the name up every call)
 	bool SetData(std::string name, const void* data, unsigned int size);
 
 	bool SetInt(std::string name, int data);
@@ -114,20 +152,33 @@ public:
 	unsigned int GetBufferSize(unsigned int index);
 	const SimpleConstantBuffer* GetBufferInfo(std::string name);
 	const SimpleConstantBuffer* GetBufferInfo(unsigned int index);
+	int GetBufferIndex(std::string name);
+
+	// Comparing constant buffers against C++ structs
+	bool GetBufferLayout(std::string name, CBufferLayout* layout);
+	bool ValidateBufferLayout(const CBufferLayout& cpu, std::string* error);
 	
 	// Misc getters
 	Microsoft::WRL::ComPtr<ID3DBlob> GetShaderBlob() { return shaderBlob; }
+	StateCache& GetStateCache() { return *stateCache; }
 
 	// Error reporting
 	static bool ReportErrors;
 	static bool ReportWarnings;
 
+	// Constant buffer bytes sent to the GPU, and buffer copies
+	// issued vs. skipped because nothing changed (reset by the caller)
+	static unsigned int UploadedBytes;
+	static unsigned int UploadsIssued;
+	static unsigned int UploadsSkipped;
+
 protected:
 	
 	bool shaderValid;
 	Microsoft::WRL::ComPtr<ID3DBlob> shaderBlob;
 	Microsoft::WRL::ComPtr<ID3D11Device> device;
 	Microsoft::WRL::ComPtr<ID3D11DeviceContext> deviceContext;
+	StateCache* stateCache;	// deviceContext's cache, looked up once
 
 	// Resource counts
 	unsigned int constantBufferCount;
@@ -137,7 +188,7 @@ protected:
 	std::vector<SimpleSRV*>		shaderResourceViews;
 	std::vector<SimpleSampler*>	samplerStates;
 	std::unordered_map<std::string, SimpleConstantBuffer*> cbTable;
-	std::unordered_map<std::string, SimpleShaderVariable> varTable;
+	ShaderVariableTable varTable;
 	std::unordered_map<std::string, SimpleSRV*> textureTable;
 	std::unordered_map<std::string, SimpleSampler*> samplerTable;
 
@@ -150,6 +201,14 @@ protected:
 
 	virtual void CleanUp();
 
+	// Uploads a buffer's local data if it's dirty
+	void UploadBuffer(SimpleConstantBuffer* cb);
+
+	// Binds a whole buffer, or a range of one, to a register of this
+	// shader's stage (stages without range support return false)
+	virtual bool BindConstantBuffer(unsigned int slot, ID3D11Buffer* buffer) { return false; }
+	virtual bool BindConstantBufferRange(unsigned int slot, const ConstantBufferSlice& slice) { return false; }
+
 	// Helpers for finding data by name
 	SimpleShaderVariable* FindVariable(std::string name, int size);
 	SimpleConstantBuffer* FindConstantBuffer(std::string name);
@@ -182,6 +241,9 @@ public:
 	bool SetSamplerState(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState);
 
 protected:
+	bool BindConstantBuffer(unsigned int slot, ID3D11Buffer* buffer);
+	bool BindConstantBufferRange(unsigned int slot, const ConstantBufferSlice& slice);
+
 	bool perInstanceCompatible;
 	 Microsoft::WRL::ComPtr<ID3D11InputLayout> inputLayout;
 	 Microsoft::WRL::ComPtr<ID3D11VertexShader> shader;
@@ -205,6 +267,9 @@ public:
 	bool SetSamplerState(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState);
 
 protected:
+	bool BindConstantBuffer(unsigned int slot, ID3D11Buffer* buffer);
+	bool BindConstantBufferRange(unsigned int slot, const ConstantBufferSlice& slice);
+
 	Microsoft::WRL::ComPtr<ID3D11PixelShader> shader;
 	bool CreateShader(Microsoft::WRL::ComPtr<ID3DBlob> shaderBlob);
 	void SetShaderAndCBs();
@@ -2,7 +2,7 @@
 
 using namespace DirectX;
 
-Sky::Sky(Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState, std::shared_ptr<Mesh> mesh, std::shared_ptr<SimpleVertexShader> vertexShader, std::shared_ptr<SimplePixelShader> pixelShader) :
+Sky::Sky(Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState, Mesh* mesh, std::shared_ptr<SimpleVertexShader> vertexShader, std::shared_ptr<SimplePixelShader> pixelShader) :
 	samplerState(samplerState),
 	mesh(mesh),
 	vertexShader(vertexShader),
@@ -118,7 +118,7 @@ void Sky::CreateCubemap(const wchar_t* right,
 	Graphics::Device->CreateShaderResourceView(cubeMapTexture.Get(), &srvDesc, shaderResourceView.GetAddressOf());
 }
 
-void Sky::Draw(std::shared_ptr<Camera> camera)
+void Sky::Draw(Camera* camera)
 {
 	Graphics::Context->RSSetState(rasterizer.Get());
 	Graphics::Context->OMSetDepthStencilState(depthBuffer.Get(), 0);
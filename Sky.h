@@ -17,7 +17,7 @@
 class Sky
 {
 public:
-	Sky(Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState, std::shared_ptr<Mesh> mesh, std::shared_ptr<SimpleVertexShader> vertexShader, std::shared_ptr<SimplePixelShader> pixelShader);
+	Sky(Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState, Mesh* mesh, std::shared_ptr<SimpleVertexShader> vertexShader, std::shared_ptr<SimplePixelShader> pixelShader);
 
 	void CreateCubemap(const wchar_t* right,
 		const wchar_t* left,
@@ -27,7 +27,7 @@ public:
 		const wchar_t* back);
 
 	//Draw
-	void Draw(std::shared_ptr<Camera> camera);
+	void Draw(Camera* camera);
 
 
 private:
@@ -36,7 +36,7 @@ private:
 	Microsoft::WRL::ComPtr<ID3D11DepthStencilState> depthBuffer;
 	Microsoft::WRL::ComPtr<ID3D11RasterizerState> rasterizer;
 
-	std::shared_ptr<Mesh> mesh;
+	Mesh* mesh;		// Owned by the game's mesh slot map
 	std::shared_ptr<SimplePixelShader> pixelShader;
 	std::shared_ptr<SimpleVertexShader> vertexShader;
 
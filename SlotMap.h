@@ -0,0 +1,126 @@
+#pragma once
+
+//C++
+#include <vector>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <cassert>
+
+// --------------------------------------------------------
+// A typed reference into a SlotMap
+//  - index picks the slot
+//  - generation must match the slot's current generation,
+//    so a handle to something that was removed (and maybe
+//    replaced) is detected instead of silently aliasing
+// --------------------------------------------------------
+template<typename T>
+struct Handle
+{
+	unsigned int index = 0xFFFFFFFF;
+	unsigned int generation = 0;
+
+	bool IsNull() const { return index == 0xFFFFFFFF; }
+	bool operator==(const Handle& other) const { return index == other.index && generation == other.generation; }
+	bool operator!=(const Handle& other) const { return !(*this == other); }
+};
+
+// --------------------------------------------------------
+// Owns objects in an array of slots and hands out Handles
+// to them.  Removed slots are recycled through a free
+// list, bumping their generation each time.
+//  - Slots come in fixed-size chunks, so objects never
+//    move once emplaced: a pointer from Get() stays good
+//    until the object is removed, and types that can't be
+//    copied or moved (like Transform) can be stored
+//  - Within a chunk, slots are back to back in the order
+//    they were first used
+// --------------------------------------------------------
+#define SLOT_MAP_CHUNK_SIZE 64
+
+template<typename T>
+class SlotMap
+{
+public:
+	template<typename... Args>
+	Handle<T> Emplace(Args&&... args)
+	{
+		unsigned int index;
+		if (!freeSlots.empty()) {
+			index = freeSlots.back();
+			freeSlots.pop_back();
+		}
+		else {
+			index = slotCount++;
+			if (index / SLOT_MAP_CHUNK_SIZE == chunks.size())
+				chunks.push_back(std::make_unique<Slot[]>(SLOT_MAP_CHUNK_SIZE));
+		}
+
+		Slot& slot = At(index);
+		slot.value.emplace(std::forward<Args>(args)...);
+		liveCount++;
+
+		return Handle<T>{ index, slot.generation };
+	}
+
+	void Remove(Handle<T> handle)
+	{
+		if (!Contains(handle)) {
+			assert(!"SlotMap::Remove() - stale or invalid handle");
+			return;
+		}
+
+		Slot& slot = At(handle.index);
+		slot.value.reset();
+		slot.generation++; //every outstanding handle to this slot is now stale
+		freeSlots.push_back(handle.index);
+		liveCount--;
+	}
+
+	bool Contains(Handle<T> handle) const
+	{
+		if (handle.index >= slotCount)
+			return false;
+
+		const Slot& slot = At(handle.index);
+		return slot.generation == handle.generation && slot.value.has_value();
+	}
+
+	// Returns null for a stale handle (and asserts in debug builds)
+	T* Get(Handle<T> handle)
+	{
+		if (!Contains(handle)) {
+			assert(handle.IsNull() && "SlotMap::Get() - stale handle");
+			return nullptr;
+		}
+		return &*At(handle.index).value;
+	}
+
+	// Calls func(handle, object) for every live object
+	template<typename Func>
+	void Each(Func func)
+	{
+		for (unsigned int i = 0; i < slotCount; i++) {
+			Slot& slot = At(i);
+			if (slot.value.has_value())
+				func(Handle<T>{ i, slot.generation }, *slot.value);
+		}
+	}
+
+	size_t Size() const { return liveCount; }
+
+private:
+	struct Slot
+	{
+		std::optional<T> value;
+		unsigned int generation = 0;
+	};
+
+	Slot& At(unsigned int index) { return chunks[index / SLOT_MAP_CHUNK_SIZE][index % SLOT_MAP_CHUNK_SIZE]; }
+	const Slot& At(unsigned int index) const { return chunks[index / SLOT_MAP_CHUNK_SIZE][index % SLOT_MAP_CHUNK_SIZE]; }
+
+	std::vector<std::unique_ptr<Slot[]>> chunks;
+	unsigned int slotCount = 0;		// Slots ever used (live or on the free list)
+	std::vector<unsigned int> freeSlots;
+	size_t liveCount = 0;
+};
@@ -0,0 +1,232 @@
+#include "SpatialHash.h"
+
+//C++
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+
+using namespace DirectX;
+
+//21 bits per axis, biased so negative cells pack too
+#define CELL_BITS 21
+#define CELL_BIAS (1 << (CELL_BITS - 1))
+#define CELL_MASK ((1ull << CELL_BITS) - 1)
+
+//roughly how many points can be distance-tested in the time of one cell lookup
+#define CELL_LOOKUP_COST 8
+
+SpatialHash::SpatialHash(float cellSize) :
+	cellSize(4.0f),
+	inverseCellSize(0.25f),
+	freeList(-1),
+	count(0)
+{
+	SetCellSize(cellSize);
+}
+
+// --------------------------------------------------------
+// Cell sizes whose inverse is a usable finite scale (zero,
+// negative, NaN, infinite and denormal sizes aren't)
+// --------------------------------------------------------
+static bool IsUsableCellSize(float cellSize)
+{
+	return cellSize > 0.0f && std::isfinite(cellSize) && std::isfinite(1.0f / cellSize);
+}
+
+// --------------------------------------------------------
+// Cell coordinate along one axis, clamped to what a key can
+// hold.  Clamping in float first keeps huge or infinite
+// values out of the int conversion (undefined behaviour);
+// NaN lands in cell 0.  Far-away points share the edge
+// cells, which queries clamp the same way, so they're still
+// found.
+// --------------------------------------------------------
+static int CellCoord(float scaled)
+{
+	float cell = floorf(scaled);
+	if (!(cell >= (float)-CELL_BIAS))
+		return cell < 0.0f ? -CELL_BIAS : 0;
+	if (cell > (float)(CELL_BIAS - 1))
+		return CELL_BIAS - 1;
+	return (int)cell;
+}
+
+uint64_t SpatialHash::CellKey(int x, int y, int z)
+{
+	return ((uint64_t)((x + CELL_BIAS) & CELL_MASK)) |
+		((uint64_t)((y + CELL_BIAS) & CELL_MASK) << CELL_BITS) |
+		((uint64_t)((z + CELL_BIAS) & CELL_MASK) << (CELL_BITS * 2));
+}
+
+uint64_t SpatialHash::CellKeyFor(const DirectX::XMFLOAT3& position)
+{
+	return CellKey(
+		CellCoord(position.x * inverseCellSize),
+		CellCoord(position.y * inverseCellSize),
+		CellCoord(position.z * inverseCellSize));
+}
+
+void SpatialHash::AddToCell(int proxy)
+{
+	Item& item = items[proxy];
+	item.cell = CellKeyFor(item.position);
+
+	std::vector<int>& list = cells[item.cell];
+	item.slot = (unsigned int)list.size();
+	list.push_back(proxy);
+}
+
+// --------------------------------------------------------
+// Swap-and-pop out of the cell, fixing up whoever moved
+// into the hole; empty cells are dropped from the map
+// --------------------------------------------------------
+void SpatialHash::RemoveFromCell(int proxy)
+{
+	Item& item = items[proxy];
+	auto it = cells.find(item.cell);
+	std::vector<int>& list = it->second;
+
+	int last = list.back();
+	list[item.slot] = last;
+	items[last].slot = item.slot;
+	list.pop_back();
+
+	if (list.empty())
+		cells.erase(it);
+}
+
+int SpatialHash::Insert(const DirectX::XMFLOAT3& position, int userData)
+{
+	int proxy;
+	if (freeList != -1) {
+		proxy = freeList;
+		freeList = (int)items[proxy].slot;
+	}
+	else {
+		proxy = (int)items.size();
+		items.push_back({});
+	}
+
+	items[proxy].position = position;
+	items[proxy].userData = userData;
+	items[proxy].alive = true;
+	AddToCell(proxy);
+
+	count++;
+	return proxy;
+}
+
+void SpatialHash::Move(int proxy, const DirectX::XMFLOAT3& position)
+{
+	Item& item = items[proxy];
+	item.position = position;
+
+	//most moves stay in the same cell
+	if (CellKeyFor(position) == item.cell)
+		return;
+
+	RemoveFromCell(proxy);
+	AddToCell(proxy);
+}
+
+void SpatialHash::Remove(int proxy)
+{
+	RemoveFromCell(proxy);
+
+	items[proxy].alive = false;
+	items[proxy].slot = (unsigned int)freeList;
+	freeList = proxy;
+	count--;
+}
+
+void SpatialHash::Clear()
+{
+	items.clear();
+	cells.clear();
+	freeList = -1;
+	count = 0;
+}
+
+// --------------------------------------------------------
+// Walks the (clamped) range of cells the sphere's box
+// touches, or every stored cell if that's fewer - which is
+// also what an infinite radius ends up doing.  Negative or
+// NaN radii find nothing.
+// --------------------------------------------------------
+void SpatialHash::QueryRadius(const DirectX::XMFLOAT3& center, float radius, std::vector<int>& out)
+{
+	if (!(radius >= 0.0f))
+		return;
+
+	int minX = CellCoord((center.x - radius) * inverseCellSize);
+	int minY = CellCoord((center.y - radius) * inverseCellSize);
+	int minZ = CellCoord((center.z - radius) * inverseCellSize);
+	int maxX = CellCoord((center.x + radius) * inverseCellSize);
+	int maxY = CellCoord((center.y + radius) * inverseCellSize);
+	int maxZ = CellCoord((center.z + radius) * inverseCellSize);
+	float radiusSq = radius * radius;
+
+	//a big radius costs more in cell lookups than testing every point, so scan the items instead
+	//(each span is at most 2^21 cells, so the product fits in an unsigned 64-bit value)
+	uint64_t touched = (uint64_t)(maxX - minX + 1) * (uint64_t)(maxY - minY + 1) * (uint64_t)(maxZ - minZ + 1);
+	if (touched > (uint64_t)items.size() / CELL_LOOKUP_COST) {
+		for (const Item& item : items) {
+			float dx = item.position.x - center.x, dy = item.position.y - center.y, dz = item.position.z - center.z;
+			if (item.alive && dx * dx + dy * dy + dz * dz <= radiusSq)
+				out.push_back(item.userData);
+		}
+		return;
+	}
+
+	for (int z = minZ; z <= maxZ; z++) {
+		for (int y = minY; y <= maxY; y++) {
+			for (int x = minX; x <= maxX; x++) {
+				auto it = cells.find(CellKey(x, y, z));
+				if (it == cells.end())
+					continue;
+
+				for (int proxy : it->second) {
+					const XMFLOAT3& p = items[proxy].position;
+					float dx = p.x - center.x, dy = p.y - center.y, dz = p.z - center.z;
+					if (dx * dx + dy * dy + dz * dz <= radiusSq)
+						out.push_back(items[proxy].userData);
+				}
+			}
+		}
+	}
+}
+
+void SpatialHash::QueryRadii(const DirectX::XMFLOAT3* centers, const float* radii, int count, std::vector<int>* out)
+{
+	for (int i = 0; i < count; i++) {
+		out[i].clear();
+		QueryRadius(centers[i], radii[i], out[i]);
+	}
+}
+
+float SpatialHash::GetCellSize() { return cellSize; }
+
+int SpatialHash::GetCount() { return count; }
+
+int SpatialHash::GetCellCount() { return (int)cells.size(); }
+
+DirectX::XMFLOAT3 SpatialHash::GetPosition(int proxy) { return items[proxy].position; }
+
+void SpatialHash::SetCellSize(float cellSize)
+{
+	//checked before the divide - a bad size would turn every cell coordinate into garbage
+	if (!IsUsableCellSize(cellSize)) {
+		printf("SpatialHash: cell size %g must be positive and finite, keeping %g\n", cellSize, this->cellSize);
+		assert(!"Bad SpatialHash cell size (see console)");
+		return;
+	}
+
+	this->cellSize = cellSize;
+	inverseCellSize = 1.0f / cellSize;
+
+	cells.clear();
+	for (int i = 0; i < (int)items.size(); i++) {
+		if (items[i].alive)
+			AddToCell(i);
+	}
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+//C++
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+//DirectX
+#include <DirectXMath.h>
+
+// --------------------------------------------------------
+// Uniform grid of points, hashed by cell so the world has
+// no fixed extent.  Built for lots of small moving things:
+//  - Insert/Move/Remove are O(1) (a move inside the same
+//    cell only updates the stored position)
+//  - Radius queries visit only the cells the sphere touches
+// Cell size should be around the typical query radius.
+// --------------------------------------------------------
+class SpatialHash
+{
+public:
+	SpatialHash(float cellSize = 4.0f);
+
+	int Insert(const DirectX::XMFLOAT3& position, int userData);
+	void Move(int proxy, const DirectX::XMFLOAT3& position);
+	void Remove(int proxy);
+	void Clear();
+
+	//userData of every point within radius of center is appended to "out"
+	void QueryRadius(const DirectX::XMFLOAT3& center, float radius, std::vector<int>& out);
+
+	//One query per center/radius pair; out[i] is cleared and filled for query i
+	void QueryRadii(const DirectX::XMFLOAT3* centers, const float* radii, int count, std::vector<int>* out);
+
+	//Getters
+	float GetCellSize();
+	int GetCount();
+	int GetCellCount();
+	DirectX::XMFLOAT3 GetPosition(int proxy);
+
+	//Setters (changing the cell size rehashes every point; it must be positive and finite)
+	void SetCellSize(float cellSize);
+
+private:
+	struct Item
+	{
+		DirectX::XMFLOAT3 position;
+		int userData;
+		uint64_t cell;
+		unsigned int slot;	// Index inside the cell's list, or the next free item
+		bool alive;
+	};
+
+	uint64_t CellKey(int x, int y, int z);
+	uint64_t CellKeyFor(const DirectX::XMFLOAT3& position);
+	void AddToCell(int proxy);
+	void RemoveFromCell(int proxy);
+
+	float cellSize;
+	float inverseCellSize;
+
+	std::vector<Item> items;
+	int freeList;
+	int count;
+
+	std::unordered_map<uint64_t, std::vector<int>> cells;
+};
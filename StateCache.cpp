@@ -0,0 +1,232 @@
+#include "StateCache.h"
+
+//C++
+#include <cstring>
+
+std::unordered_map<ID3D11DeviceContext*, StateCache> StateCache::caches;
+
+StateCache::StateCache(ID3D11DeviceContext* context) :
+	context(context),
+	issued(0),
+	filtered(0)
+{
+	Invalidate();
+}
+
+StateCache& StateCache::For(ID3D11DeviceContext* context)
+{
+	auto it = caches.find(context);
+	if (it == caches.end())
+		it = caches.emplace(context, StateCache(context)).first;
+	return it->second;
+}
+
+// --------------------------------------------------------
+// Fills every tracked value with all-ones bytes.  That is
+// never a real pointer, topology or format, so nothing
+// (not even null) compares equal until it's set again.
+// --------------------------------------------------------
+void StateCache::Invalidate()
+{
+	memset(&inputLayout, 0xFF, sizeof(inputLayout));
+	memset(&topology, 0xFF, sizeof(topology));
+	memset(vertexBuffers, 0xFF, sizeof(vertexBuffers));
+	memset(vertexStrides, 0xFF, sizeof(vertexStrides));
+	memset(vertexOffsets, 0xFF, sizeof(vertexOffsets));
+	memset(&indexBuffer, 0xFF, sizeof(indexBuffer));
+	memset(&indexFormat, 0xFF, sizeof(indexFormat));
+	memset(&indexOffset, 0xFF, sizeof(indexOffset));
+	memset(&vs, 0xFF, sizeof(vs));
+	memset(&ps, 0xFF, sizeof(ps));
+}
+
+template<typename T>
+bool StateCache::Update(T& cached, T value)
+{
+	if (cached == value) {
+		filtered++;
+		return false;
+	}
+
+	cached = value;
+	issued++;
+	return true;
+}
+
+template<typename T>
+bool StateCache::UpdateRange(T* cached, unsigned int count, T const* values)
+{
+	if (memcmp(cached, values, sizeof(T) * count) == 0) {
+		filtered++;
+		return false;
+	}
+
+	memcpy(cached, values, sizeof(T) * count);
+	issued++;
+	return true;
+}
+
+bool StateCache::UpdateConstantBuffer(StageState& stage, unsigned int slot, ID3D11Buffer* buffer, unsigned int first, unsigned int count)
+{
+	if (stage.constantBuffers[slot] == buffer && stage.constantFirst[slot] == first && stage.constantCount[slot] == count) {
+		filtered++;
+		return false;
+	}
+
+	stage.constantBuffers[slot] = buffer;
+	stage.constantFirst[slot] = first;
+	stage.constantCount[slot] = count;
+	issued++;
+	return true;
+}
+
+ID3D11DeviceContext1* StateCache::GetContext1()
+{
+	if (!context1)
+		context->QueryInterface(IID_PPV_ARGS(context1.GetAddressOf()));
+	return context1.Get();
+}
+
+//INPUT ASSEMBLER
+
+void StateCache::IASetInputLayout(ID3D11InputLayout* layout)
+{
+	if (Update(inputLayout, layout))
+		context->IASetInputLayout(layout);
+}
+
+void StateCache::IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology)
+{
+	if (Update(this->topology, topology))
+		context->IASetPrimitiveTopology(topology);
+}
+
+// --------------------------------------------------------
+// Issued as one call if any slot in the range differs.
+// Slots past STATE_CACHE_MAX_VERTEX_BUFFERS aren't tracked
+// and always go through.
+// --------------------------------------------------------
+void StateCache::IASetVertexBuffers(unsigned int startSlot, unsigned int count, ID3D11Buffer* const* buffers, const UINT* strides, const UINT* offsets)
+{
+	bool changed = startSlot + count > STATE_CACHE_MAX_VERTEX_BUFFERS;
+	for (unsigned int i = 0; i < count && !changed; i++) {
+		unsigned int slot = startSlot + i;
+		changed = vertexBuffers[slot] != buffers[i] || vertexStrides[slot] != strides[i] || vertexOffsets[slot] != offsets[i];
+	}
+
+	if (!changed) {
+		filtered++;
+		return;
+	}
+
+	for (unsigned int i = 0; i < count && startSlot + i < STATE_CACHE_MAX_VERTEX_BUFFERS; i++) {
+		vertexBuffers[startSlot + i] = buffers[i];
+		vertexStrides[startSlot + i] = strides[i];
+		vertexOffsets[startSlot + i] = offsets[i];
+	}
+
+	issued++;
+	context->IASetVertexBuffers(startSlot, count, buffers, strides, offsets);
+}
+
+void StateCache::IASetIndexBuffer(ID3D11Buffer* buffer, DXGI_FORMAT format, unsigned int offset)
+{
+	if (indexBuffer == buffer && indexFormat == format && indexOffset == offset) {
+		filtered++;
+		return;
+	}
+
+	indexBuffer = buffer;
+	indexFormat = format;
+	indexOffset = offset;
+	issued++;
+	context->IASetIndexBuffer(buffer, format, offset);
+}
+
+//VERTEX STAGE
+
+void StateCache::VSSetShader(ID3D11VertexShader* shader)
+{
+	if (Update(vs.shader, static_cast<ID3D11DeviceChild*>(shader)))
+		context->VSSetShader(shader, 0, 0);
+}
+
+void StateCache::VSSetConstantBuffer(unsigned int slot, ID3D11Buffer* buffer)
+{
+	if (UpdateConstantBuffer(vs, slot, buffer, 0, 0))
+		context->VSSetConstantBuffers(slot, 1, &buffer);
+}
+
+void StateCache::VSSetConstantBufferRange(unsigned int slot, ID3D11Buffer* buffer, unsigned int firstConstant, unsigned int numConstants)
+{
+	if (UpdateConstantBuffer(vs, slot, buffer, firstConstant, numConstants))
+		GetContext1()->VSSetConstantBuffers1(slot, 1, &buffer, &firstConstant, &numConstants);
+}
+
+void StateCache::VSSetShaderResource(unsigned int slot, ID3D11ShaderResourceView* srv)
+{
+	if (Update(vs.srvs[slot], srv))
+		context->VSSetShaderResources(slot, 1, &srv);
+}
+
+void StateCache::VSSetSampler(unsigned int slot, ID3D11SamplerState* sampler)
+{
+	if (Update(vs.samplers[slot], sampler))
+		context->VSSetSamplers(slot, 1, &sampler);
+}
+
+//PIXEL STAGE
+
+void StateCache::PSSetShader(ID3D11PixelShader* shader)
+{
+	if (Update(ps.shader, static_cast<ID3D11DeviceChild*>(shader)))
+		context->PSSetShader(shader, 0, 0);
+}
+
+void StateCache::PSSetConstantBuffer(unsigned int slot, ID3D11Buffer* buffer)
+{
+	if (UpdateConstantBuffer(ps, slot, buffer, 0, 0))
+		context->PSSetConstantBuffers(slot, 1, &buffer);
+}
+
+void StateCache::PSSetConstantBufferRange(unsigned int slot, ID3D11Buffer* buffer, unsigned int firstConstant, unsigned int numConstants)
+{
+	if (UpdateConstantBuffer(ps, slot, buffer, firstConstant, numConstants))
+		GetContext1()->PSSetConstantBuffers1(slot, 1, &buffer, &firstConstant, &numConstants);
+}
+
+void StateCache::PSSetShaderResource(unsigned int slot, ID3D11ShaderResourceView* srv)
+{
+	if (Update(ps.srvs[slot], srv))
+		context->PSSetShaderResources(slot, 1, &srv);
+}
+
+void StateCache::PSSetSampler(unsigned int slot, ID3D11SamplerState* sampler)
+{
+	if (Update(ps.samplers[slot], sampler))
+		context->PSSetSamplers(slot, 1, &sampler);
+}
+
+void StateCache::PSSetShaderResources(unsigned int startSlot, unsigned int count, ID3D11ShaderResourceView* const* srvs)
+{
+	if (UpdateRange(&ps.srvs[startSlot], count, srvs))
+		context->PSSetShaderResources(startSlot, count, srvs);
+}
+
+void StateCache::PSSetSamplers(unsigned int startSlot, unsigned int count, ID3D11SamplerState* const* samplers)
+{
+	if (UpdateRange(&ps.samplers[startSlot], count, samplers))
+		context->PSSetSamplers(startSlot, count, samplers);
+}
+
+//COUNTERS
+
+unsigned int StateCache::GetIssuedCount() { return issued; }
+
+unsigned int StateCache::GetFilteredCount() { return filtered; }
+
+void StateCache::ResetCounters()
+{
+	issued = 0;
+	filtered = 0;
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+//C++
+#include <unordered_map>
+
+//DirectX
+#include <d3d11_1.h>
+#include <wrl/client.h>
+
+#define STATE_CACHE_MAX_VERTEX_BUFFERS 4
+
+// --------------------------------------------------------
+// Remembers what is bound on one device context and drops
+// calls that would bind the same thing again.  Only the
+// vertex and pixel stages and the input assembler are
+// tracked - everything else goes straight to the context.
+//
+// Pointers are compared, not reference counted: anything
+// the cache thinks is bound is also held by the context,
+// so its address can't be reused while it's in here.
+// Anything that binds state behind the cache's back (e.g.
+// ImGui) has to be followed by Invalidate().
+// --------------------------------------------------------
+class StateCache
+{
+public:
+	StateCache(ID3D11DeviceContext* context);
+
+	//One cache per context, created on first use - the reference
+	//never moves, so per-draw callers look it up once and keep it
+	static StateCache& For(ID3D11DeviceContext* context);
+
+	//Forget everything, the next call of each kind is always issued
+	void Invalidate();
+
+	//Input assembler
+	void IASetInputLayout(ID3D11InputLayout* layout);
+	void IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology);
+	void IASetVertexBuffers(unsigned int startSlot, unsigned int count, ID3D11Buffer* const* buffers, const UINT* strides, const UINT* offsets);
+	void IASetIndexBuffer(ID3D11Buffer* buffer, DXGI_FORMAT format, unsigned int offset);
+
+	//Vertex stage
+	void VSSetShader(ID3D11VertexShader* shader);
+	void VSSetConstantBuffer(unsigned int slot, ID3D11Buffer* buffer);
+	void VSSetConstantBufferRange(unsigned int slot, ID3D11Buffer* buffer, unsigned int firstConstant, unsigned int numConstants);
+	void VSSetShaderResource(unsigned int slot, ID3D11ShaderResourceView* srv);
+	void VSSetSampler(unsigned int slot, ID3D11SamplerState* sampler);
+
+	//Pixel stage
+	void PSSetShader(ID3D11PixelShader* shader);
+	void PSSetConstantBuffer(unsigned int slot, ID3D11Buffer* buffer);
+	void PSSetConstantBufferRange(unsigned int slot, ID3D11Buffer* buffer, unsigned int firstConstant, unsigned int numConstants);
+	void PSSetShaderResource(unsigned int slot, ID3D11ShaderResourceView* srv);
+	void PSSetSampler(unsigned int slot, ID3D11SamplerState* sampler);
+
+	//Contiguous slots in one call (issued whole if any slot differs)
+	void PSSetShaderResources(unsigned int startSlot, unsigned int count, ID3D11ShaderResourceView* const* srvs);
+	void PSSetSamplers(unsigned int startSlot, unsigned int count, ID3D11SamplerState* const* samplers);
+
+	//Counts since the last ResetCounters()
+	unsigned int GetIssuedCount();
+	unsigned int GetFilteredCount();
+	void ResetCounters();
+
+private:
+	// --------------------------------------------------------
+	// Bound resources for one shader stage
+	// --------------------------------------------------------
+	struct StageState
+	{
+		ID3D11DeviceChild* shader;
+		ID3D11Buffer* constantBuffers[D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT];
+		unsigned int constantFirst[D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT];	// 0 and 0 for a whole buffer
+		unsigned int constantCount[D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT];
+		ID3D11ShaderResourceView* srvs[D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT];
+		ID3D11SamplerState* samplers[D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT];
+	};
+
+	//Returns true (and counts an issued call) if cached != value
+	template<typename T>
+	bool Update(T& cached, T value);
+
+	//Same, for a run of slots - true if any of them changed
+	template<typename T>
+	bool UpdateRange(T* cached, unsigned int count, T const* values);
+
+	//Same, for a constant buffer slot bound by offset
+	bool UpdateConstantBuffer(StageState& stage, unsigned int slot, ID3D11Buffer* buffer, unsigned int first, unsigned int count);
+
+	//Offset binding needs the 11.1 interface, fetched on first use
+	ID3D11DeviceContext1* GetContext1();
+
+	ID3D11DeviceContext* context;
+	Microsoft::WRL::ComPtr<ID3D11DeviceContext1> context1;
+
+	ID3D11InputLayout* inputLayout;
+	D3D11_PRIMITIVE_TOPOLOGY topology;
+	ID3D11Buffer* vertexBuffers[STATE_CACHE_MAX_VERTEX_BUFFERS];
+	UINT vertexStrides[STATE_CACHE_MAX_VERTEX_BUFFERS];
+	UINT vertexOffsets[STATE_CACHE_MAX_VERTEX_BUFFERS];
+	ID3D11Buffer* indexBuffer;
+	DXGI_FORMAT indexFormat;
+	unsigned int indexOffset;
+
+	StageState vs;
+	StageState ps;
+
+	unsigned int issued;
+	unsigned int filtered;
+
+	static std::unordered_map<ID3D11DeviceContext*, StateCache> caches;
+};
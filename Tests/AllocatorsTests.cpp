@@ -0,0 +1,55 @@
+#include "Test.h"
+
+#include "Allocators.h"
+
+//C++
+#include <string>
+
+namespace
+{
+	//not trivially destructible, like Material
+	struct Named
+	{
+		std::string name;
+		explicit Named(const char* name) : name(name) {}
+	};
+}
+
+TEST(FixedPoolReusesFreedBlocks)
+{
+	FixedPool pool("Test", 32, 8, 4);
+	void* a = pool.Allocate();
+	void* b = pool.Allocate();
+	pool.Free(a);
+	CHECK(pool.Allocate() == a);
+
+	AllocatorStats stats = pool.GetStats();
+	CHECK(stats.live == 2);
+	CHECK(stats.allocations == 3);
+	CHECK(stats.frees == 1);
+	pool.Free(b);
+}
+
+TEST(ArenaCountsSharedObjects)
+{
+	Arena arena("Test", 1024);
+	{
+		std::shared_ptr<Named> a = MakeInArena<Named>(arena, "a");
+		std::shared_ptr<Named> b = MakeInArena<Named>(arena, "a much longer name that has to allocate");
+		std::weak_ptr<Named> weak = a;
+		CHECK(arena.GetSharedCount() == 2);
+
+		//the block stays allocated while a weak_ptr holds the control block
+		a.reset();
+		CHECK(arena.GetSharedCount() == 2);
+		weak.reset();
+		CHECK(arena.GetSharedCount() == 1);
+	}
+	CHECK(arena.GetSharedCount() == 0);
+
+	//trivially destructible data isn't tracked, and Reset() is fine with it
+	arena.New<int>(5);
+	arena.Reset();
+	CHECK(arena.GetStats().live == 0);
+	CHECK(arena.GetStats().bytesUsed == 0);
+}
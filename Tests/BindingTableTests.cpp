@@ -0,0 +1,96 @@
+#include "Test.h"
+
+#include "BindingTable.h"
+
+//C++
+#include <map>
+#include <string>
+
+namespace
+{
+	struct Resource
+	{
+		int id;
+	};
+
+	//stands in for ComPtr
+	struct Ref
+	{
+		Resource* resource;
+		Resource* Get() const { return resource; }
+	};
+
+	Resource resources[8] = { { 0 }, { 1 }, { 2 }, { 3 }, { 4 }, { 5 }, { 6 }, { 7 } };
+}
+
+TEST(BindingRangesSplitAtGaps)
+{
+	//slots 0 1 2, 5, 7 8 - three ranges
+	std::vector<std::pair<unsigned int, Resource*>> bindings = {
+		{ 0, &resources[0] }, { 1, &resources[1] }, { 2, &resources[2] },
+		{ 5, &resources[5] }, { 7, &resources[6] }, { 8, &resources[7] } };
+	std::vector<Resource*> table;
+	std::vector<BindingRange> ranges;
+	BuildBindingRanges(bindings, table, ranges);
+
+	CHECK(table.size() == 6);
+	CHECK(ranges.size() == 3);
+	CHECK(ranges[0].startSlot == 0 && ranges[0].first == 0 && ranges[0].count == 3);
+	CHECK(ranges[1].startSlot == 5 && ranges[1].first == 3 && ranges[1].count == 1);
+	CHECK(ranges[2].startSlot == 7 && ranges[2].first == 4 && ranges[2].count == 2);
+	CHECK(table[3] == &resources[5] && table[5] == &resources[7]);
+
+	//nothing bound, nothing left over from the last build
+	bindings.clear();
+	BuildBindingRanges(bindings, table, ranges);
+	CHECK(table.empty() && ranges.empty());
+}
+
+TEST(BindingRangesSortUnsortedSlots)
+{
+	std::vector<std::pair<unsigned int, Resource*>> bindings = {
+		{ 3, &resources[3] }, { 0, &resources[0] }, { 4, &resources[4] }, { 1, &resources[1] } };
+	std::vector<Resource*> table;
+	std::vector<BindingRange> ranges;
+	BuildBindingRanges(bindings, table, ranges);
+
+	CHECK(ranges.size() == 2);
+	CHECK(ranges[0].startSlot == 0 && ranges[0].count == 2);
+	CHECK(ranges[1].startSlot == 3 && ranges[1].count == 2);
+
+	//every table entry is the resource for its slot
+	for (const BindingRange& r : ranges) {
+		for (unsigned int i = 0; i < r.count; i++)
+			CHECK(table[r.first + i]->id == (int)(r.startSlot + i));
+	}
+}
+
+// --------------------------------------------------------
+// Names come in whatever order the map keeps them; ones
+// the shader doesn't declare are dropped
+// --------------------------------------------------------
+TEST(BindingTableSkipsUndeclaredNames)
+{
+	std::map<std::string, Ref> textures = {
+		{ "albedo", { &resources[0] } },
+		{ "normals", { &resources[1] } },
+		{ "detail", { &resources[2] } },
+		{ "roughness", { &resources[3] } } };
+	std::map<std::string, int> registers = { { "roughness", 2 }, { "albedo", 0 }, { "normals", 1 }, { "unused", 5 } };
+
+	std::vector<Resource*> table;
+	std::vector<BindingRange> ranges;
+	BuildBindingTable(textures, [&](const std::string& name) {
+		auto it = registers.find(name);
+		return it == registers.end() ? -1 : it->second;
+	}, table, ranges);
+
+	CHECK(table.size() == 3);
+	CHECK(ranges.size() == 1);
+	CHECK(ranges[0].startSlot == 0 && ranges[0].count == 3);
+	CHECK(table[0] == &resources[0] && table[1] == &resources[1] && table[2] == &resources[3]);
+
+	//a shader that declares none of them binds nothing
+	BuildBindingTable(textures, [](const std::string&) { return -1; }, table, ranges);
+	CHECK(table.empty() && ranges.empty());
+}
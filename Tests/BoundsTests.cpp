@@ -0,0 +1,81 @@
+#include "Test.h"
+
+#include "Bounds.h"
+
+//C++
+#include <cfloat>
+#include <cmath>
+#include <random>
+
+using namespace DirectX;
+
+namespace
+{
+	AABB Cube(XMFLOAT3 center, float halfSize)
+	{
+		AABB box;
+		box.min = XMFLOAT3(center.x - halfSize, center.y - halfSize, center.z - halfSize);
+		box.max = XMFLOAT3(center.x + halfSize, center.y + halfSize, center.z + halfSize);
+		return box;
+	}
+
+	bool Near(float a, float b) { return fabsf(a - b) <= 1e-4f * fabsf(b); }
+}
+
+TEST(ScreenRadiusPerspectiveFallsOffWithDistance)
+{
+	AABB box = Cube(XMFLOAT3(0, 0, 10), 1.0f);
+	float radius = sqrtf(3.0f);
+
+	CHECK(Near(AABBScreenRadius(box, XMFLOAT3(0, 0, 0), 500.0f, true), radius * 500.0f / 10.0f));
+	CHECK(Near(AABBScreenRadius(box, XMFLOAT3(0, 0, -10), 500.0f, true), radius * 500.0f / 20.0f));
+
+	//inside the sphere it's always kept
+	CHECK(AABBScreenRadius(box, XMFLOAT3(0, 0, 9), 500.0f, true) == FLT_MAX);
+}
+
+TEST(ScreenRadiusOrthographicIgnoresDistance)
+{
+	AABB box = Cube(XMFLOAT3(0, 0, 10), 1.0f);
+	float expected = sqrtf(3.0f) * 72.0f;
+
+	CHECK(Near(AABBScreenRadius(box, XMFLOAT3(0, 0, 0), 72.0f, false), expected));
+	CHECK(Near(AABBScreenRadius(box, XMFLOAT3(0, 0, -1000), 72.0f, false), expected));
+	CHECK(Near(AABBScreenRadius(box, XMFLOAT3(0, 0, 10), 72.0f, false), expected));
+}
+
+// --------------------------------------------------------
+// Contribution pass over 100k boxes, as ContributionCullEntities
+// runs it for each projection
+// --------------------------------------------------------
+BENCHMARK(ContributionCullBenchmark)
+{
+	const unsigned int count = 100000;
+	std::mt19937 random(7);
+	std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+	std::uniform_real_distribution<float> size(0.05f, 2.0f);
+
+	std::vector<AABB> boxes(count);
+	for (AABB& box : boxes)
+		box = Cube(XMFLOAT3(position(random), position(random), position(random)), size(random));
+
+	XMFLOAT3 eye(0, 0, 0);
+	const float threshold = 4.0f;
+	const float perspectivePPU = 360.0f / tanf(XM_PIDIV4 * 0.5f);	// 720p, 45 degrees
+	const float orthographicPPU = 720.0f / 100.0f;					// 100 units tall
+
+	for (int mode = 0; mode < 2; mode++) {
+		bool perspective = mode == 0;
+		float pixelsPerUnit = perspective ? perspectivePPU : orthographicPPU;
+
+		unsigned int kept = 0;
+		double seconds = TimePerCall([&]() {
+			kept = 0;
+			for (const AABB& box : boxes)
+				kept += AABBScreenRadius(box, eye, pixelsPerUnit, perspective) >= threshold;
+		});
+
+		printf("  %-12s %6.2f ns/box, %u of %u kept\n", perspective ? "perspective" : "orthographic",
+			seconds * 1e9 / count, kept, count);
+	}
+}
@@ -0,0 +1,136 @@
+#include "Test.h"
+
+#include "CBufferLayout.h"
+#include "ShaderConstants.h"
+
+//C++
+#include <fstream>
+#include <sstream>
+
+// --------------------------------------------------------
+// ShaderLayouts/ holds what reflection reports for each
+// buffer of the shaders Game loads, in
+// SerializeCBufferLayout() form.  Game rewrites the files
+// at startup when built with DUMP_SHADER_LAYOUTS set to 1,
+// and a mismatch it prints includes the new text too.
+// --------------------------------------------------------
+namespace
+{
+	bool LoadLayout(const char* file, CBufferLayout* layout)
+	{
+		std::ifstream in(std::string(SHADER_LAYOUT_DIR) + "/" + file);
+		std::stringstream text;
+		text << in.rdbuf();
+		return in && ParseCBufferLayout(text.str(), layout);
+	}
+
+	bool Matches(const char* file, const CBufferLayout& cpu)
+	{
+		CBufferLayout reflected;
+		if (!LoadLayout(file, &reflected))
+			return false;
+
+		std::string error;
+		bool valid = ValidateCBufferLayout(cpu, reflected, &error);
+		if (!valid)
+			printf("%s", error.c_str());
+		return valid && error.empty();
+	}
+
+	//a well-formed pair to break one way at a time
+	CBufferLayout Reflected()
+	{
+		return { "perMaterial", 48, { { "colorTint", 0, 16 }, { "uvScale", 16, 8 }, { "uvOffset", 24, 8 }, { "roughness", 32, 4 } } };
+	}
+
+	CBufferLayout Cpu()
+	{
+		CBufferLayout layout = Reflected();
+		layout.size = 36;
+		return layout;
+	}
+
+	bool Fails(const CBufferLayout& cpu, const CBufferLayout& reflected, const char* expected)
+	{
+		std::string error;
+		return !ValidateCBufferLayout(cpu, reflected, &error) && error.find(expected) != std::string::npos;
+	}
+}
+
+TEST(CBufferLayoutsMatchShaders)
+{
+	CHECK(Matches("VertexShader.perFrame.txt", VSPerFrame::Layout()));
+	CHECK(Matches("VertexShader.perObject.txt", VSPerObject::Layout()));
+	CHECK(Matches("VertexShader_Instanced.perFrame.txt", VSPerFrame::Layout()));
+	CHECK(Matches("PixelShader.perFrame.txt", PSPerFrame::Layout()));
+	CHECK(Matches("PixelShader.perMaterial.txt", PSPerMaterial::Layout()));
+	CHECK(Matches("PixelShader.perObject.txt", PSPerObject::Layout()));
+}
+
+TEST(CBufferLayoutAcceptsGoodLayout)
+{
+	std::string error;
+	CHECK(ValidateCBufferLayout(Cpu(), Reflected(), &error));
+	CHECK(error.empty());
+}
+
+TEST(CBufferLayoutCatchesWrongOffset)
+{
+	CBufferLayout cpu = Cpu();
+	cpu.fields[3].offset = 36;
+	CHECK(Fails(cpu, Reflected(), "'roughness' is at 36"));
+}
+
+TEST(CBufferLayoutCatchesStraddlingField)
+{
+	//a float3 at 8 runs into the next register; HLSL would have moved it to 16
+	CBufferLayout cpu = { "perFrame", 32, { { "cameraPosition", 8, 12 } } };
+	CBufferLayout reflected = { "perFrame", 32, { { "cameraPosition", 8, 12 } } };
+	CHECK(Fails(cpu, reflected, "breaks 16-byte register packing"));
+
+	//anything over a register must start on one
+	cpu.fields[0] = { "view", 4, 64 };
+	reflected.fields[0] = cpu.fields[0];
+	CHECK(Fails(cpu, reflected, "breaks 16-byte register packing"));
+}
+
+TEST(CBufferLayoutCatchesSizeMismatch)
+{
+	//one register short of the shader's buffer, even with every field right
+	CBufferLayout cpu = Cpu();
+	CBufferLayout reflected = Reflected();
+	reflected.size = 64;
+	CHECK(Fails(cpu, reflected, "doesn't match shader size 64"));
+
+	//a field that doesn't cover the shader's variable
+	cpu = Cpu();
+	cpu.fields[0].size = 12;
+	CHECK(Fails(cpu, Reflected(), "'colorTint' is at 0 (size 12)"));
+}
+
+TEST(CBufferLayoutCatchesMissingFields)
+{
+	CBufferLayout cpu = Cpu();
+	cpu.fields.pop_back();
+	CHECK(Fails(cpu, Reflected(), "shader variable 'roughness' has no C++ field"));
+
+	CBufferLayout reflected = Reflected();
+	reflected.fields.pop_back();
+	CHECK(Fails(Cpu(), reflected, "C++ field 'roughness' isn't in the shader"));
+}
+
+TEST(CBufferLayoutSerializesRoundTrip)
+{
+	CBufferLayout parsed;
+	CHECK(ParseCBufferLayout(SerializeCBufferLayout(PSPerFrame::Layout()), &parsed));
+	CHECK(parsed.name == "perFrame" && parsed.size == sizeof(PSPerFrame));
+	CHECK(parsed.fields.size() == 3);
+	CHECK(parsed.fields[2].name == "lights" && parsed.fields[2].offset == 32 && parsed.fields[2].size == sizeof(Light) * MAX_SCENE_LIGHTS);
+
+	CBufferLayout unchanged = Reflected();
+	CHECK(!ParseCBufferLayout("", &unchanged));
+	CHECK(!ParseCBufferLayout("buffer perFrame 32\n", &unchanged));
+	CHECK(!ParseCBufferLayout("cbuffer perFrame 32\nview 0\n", &unchanged));
+	CHECK(!ParseCBufferLayout("cbuffer perFrame 32\nview 0 64 extra\n", &unchanged));
+	CHECK(unchanged.name == "perMaterial" && unchanged.fields.size() == 4);
+}
@@ -0,0 +1,76 @@
+#include "Test.h"
+
+#include "CommandBuffer.h"
+
+//C++
+#include <cstring>
+
+namespace
+{
+	//stand-ins for materials and meshes - backends here never dereference them
+	void* Fake(unsigned int id) { return (void*)(uintptr_t)(0x1000 + id * 16); }
+
+	//what a frame of draws looks like: material changes every few items, constants every item
+	void RecordItems(CommandBuffer& commands, unsigned int begin, unsigned int end)
+	{
+		for (unsigned int i = begin; i < end; i++) {
+			if (i % 7 == 0)
+				commands.BindMaterial(Fake(i / 7), i % 2 == 0);
+
+			float constants[5] = { (float)i, i * 0.5f, i * 0.25f, -(float)i, 1.0f };
+			commands.SetConstants(Fake(i / 7), i % 2, constants, sizeof(constants) - (i % 3) * 4);
+
+			if (i % 5 == 0)
+				commands.DrawInstanced(Fake(i), i, 1 + i % 4);
+			else
+				commands.Draw(Fake(i));
+		}
+	}
+
+	bool SameBytes(CommandBuffer& a, CommandBuffer& b)
+	{
+		return a.GetSize() == b.GetSize() && a.GetCommandCount() == b.GetCommandCount() &&
+			memcmp(a.GetData(), b.GetData(), a.GetSize()) == 0;
+	}
+}
+
+TEST(CommandBufferParallelReplayMatchesSerial)
+{
+	const unsigned int count = 5000;
+	CommandBuffer serial;
+	RecordItems(serial, 0, count);
+
+	ThreadPool pool(3);
+	std::vector<CommandBuffer> buffers;
+
+	//twice, so the second frame reuses cleared buffers
+	for (int frame = 0; frame < 2; frame++) {
+		unsigned int slices = RecordCommandsParallel(buffers, count, &pool,
+			[&](CommandBuffer& commands, unsigned int, unsigned int begin, unsigned int end) {
+				RecordItems(commands, begin, end);
+			});
+		CHECK(slices == 4);
+
+		RecordingCommandBackend replay;
+		for (unsigned int s = 0; s < slices; s++)
+			CHECK(buffers[s].Execute(replay));
+		CHECK(SameBytes(replay.commands, serial));
+	}
+}
+
+TEST(CommandBufferSmallOrWithoutPoolRecordsInline)
+{
+	ThreadPool pool(3);
+	std::vector<CommandBuffer> buffers;
+	auto record = [&](CommandBuffer& commands, unsigned int slice, unsigned int begin, unsigned int end) {
+		CHECK(slice == 0);
+		RecordItems(commands, begin, end);
+	};
+
+	CHECK(RecordCommandsParallel(buffers, MIN_ITEMS_FOR_RECORDING_THREADS - 1, &pool, record) == 1);
+	CHECK(RecordCommandsParallel(buffers, 1000, nullptr, record) == 1);
+
+	CommandBuffer serial;
+	RecordItems(serial, 0, 1000);
+	CHECK(SameBytes(buffers[0], serial));
+}
@@ -0,0 +1,161 @@
+#include "Test.h"
+
+#include "ComponentStore.h"
+#include "Components.h"
+#include "Allocators.h"
+
+//C++
+#include <algorithm>
+#include <memory>
+#include <random>
+
+//DirectX
+#include <DirectXMath.h>
+
+using namespace DirectX;
+
+namespace
+{
+	//stands in for a component about the size of a Light (64 bytes)
+	struct Body
+	{
+		XMFLOAT3 position;
+		XMFLOAT3 velocity;
+		float data[10];
+	};
+
+	struct Tag
+	{
+		int value;
+	};
+}
+
+TEST(ComponentPoolStaysPackedAfterRemove)
+{
+	ComponentStore store;
+	EntityID a = store.CreateEntity();
+	EntityID b = store.CreateEntity();
+	EntityID c = store.CreateEntity();
+	store.Add<Tag>(a, { 1 });
+	store.Add<Tag>(b, { 2 });
+	store.Add<Tag>(c, { 3 });
+
+	store.Remove<Tag>(a);
+	CHECK(!store.Has<Tag>(a));
+	CHECK(store.Pool<Tag>().Size() == 2);
+	CHECK(store.Get<Tag>(b)->value == 2);
+	CHECK(store.Get<Tag>(c)->value == 3);
+
+	//re-adding overwrites instead of duplicating
+	store.Add<Tag>(c, { 4 });
+	CHECK(store.Pool<Tag>().Size() == 2);
+	CHECK(store.Get<Tag>(c)->value == 4);
+
+	//destroyed IDs are handed out again, without their old components
+	store.DestroyEntity(b);
+	CHECK(store.CreateEntity() == b);
+	CHECK(!store.Has<Tag>(b));
+}
+
+TEST(ComponentStoreEachJoinsPools)
+{
+	ComponentStore store;
+	for (int i = 0; i < 10; i++) {
+		EntityID id = store.CreateEntity();
+		store.Add<Tag>(id, { i });
+		if (i % 3 == 0)
+			store.Add<Body>(id, Body{ XMFLOAT3((float)i, 0, 0), XMFLOAT3(0, 0, 0), {} });
+	}
+
+	int visited = 0;
+	store.Each<Body, Tag>([&](EntityID id, Body& body, Tag& tag) {
+		CHECK(body.position.x == (float)tag.value);
+		CHECK(store.Get<Tag>(id) == &tag);
+		visited++;
+	});
+	CHECK(visited == 4);
+}
+
+// --------------------------------------------------------
+// 100k entities: the per-frame scan UpdateSceneBounds and
+// CullEntities make on a frame where nothing moved (transform
+// version against bounds version, then the bounds), over
+// RenderableComponents in the store (transforms in a slot
+// map) vs the layout they replaced - a
+// vector<shared_ptr<Entity>> of pooled entities
+// each pointing at a pooled Transform, created interleaved
+// with other pooled objects and visited in an order that
+// doesn't match memory order
+// --------------------------------------------------------
+BENCHMARK(ComponentStoreIteration100k)
+{
+	const unsigned int count = 100000;
+	std::mt19937 random(1);
+	std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+
+	//what Entity used to hold, minus the mesh and material pointers
+	struct LegacyEntity
+	{
+		std::shared_ptr<Transform> transform;
+		AABB worldBounds;
+		unsigned int boundsVersion;
+		bool boundsValid;
+		int bvhProxy;
+		bool occluder;
+		bool important;
+		unsigned int stateVersion;
+		std::vector<int> cells;
+	};
+
+	ComponentStore store;
+	SlotMap<Transform> transforms;
+	std::vector<std::shared_ptr<LegacyEntity>> legacy;
+	std::vector<std::shared_ptr<Body>> between;
+	for (unsigned int i = 0; i < count; i++) {
+		XMFLOAT3 p(position(random), position(random), position(random));
+		AABB bounds = { XMFLOAT3(p.x - 1, p.y - 1, p.z - 1), XMFLOAT3(p.x + 1, p.y + 1, p.z + 1) };
+
+		RenderableComponent renderable;
+		renderable.transform = transforms.Emplace(p.x, p.y, p.z);
+		renderable.worldBounds = bounds;
+		renderable.boundsVersion = transforms.Get(renderable.transform)->GetVersion();
+		renderable.boundsValid = true;
+		store.Add<RenderableComponent>(store.CreateEntity(), renderable);
+
+		std::shared_ptr<LegacyEntity> entity = MakePooled<LegacyEntity>();
+		entity->transform = MakePooled<Transform>(p.x, p.y, p.z);
+		entity->worldBounds = bounds;
+		entity->boundsVersion = entity->transform->GetVersion();
+		entity->boundsValid = true;
+		legacy.push_back(entity);
+
+		//other scene objects allocated in between
+		between.push_back(MakePooled<Body>());
+	}
+	std::shuffle(legacy.begin(), legacy.end(), random);
+
+	unsigned int stale = 0;
+	unsigned int right = 0;
+	double packed = TimePerCall([&]() {
+		store.Each<RenderableComponent>([&](EntityID, RenderableComponent& entity) {
+			if (!entity.boundsValid || entity.boundsVersion != transforms.Get(entity.transform)->GetVersion())
+				stale++;
+			if (entity.worldBounds.max.x > 0.0f)
+				right++;
+		});
+	});
+
+	double pointers = TimePerCall([&]() {
+		for (const std::shared_ptr<LegacyEntity>& entity : legacy) {
+			if (!entity->boundsValid || entity->boundsVersion != entity->transform->GetVersion())
+				stale++;
+			if (entity->worldBounds.max.x > 0.0f)
+				right++;
+		}
+	});
+
+	Transform::ClearChangedThisFrame();
+	CHECK(stale == 0 && right > 0);
+	printf("  component store:      %8.1f ns/entity\n", packed * 1e9 / count);
+	printf("  shared_ptr<Entity>s:  %8.1f ns/entity (%.1fx)\n", pointers * 1e9 / count, pointers / packed);
+}
@@ -0,0 +1,319 @@
+#include "Test.h"
+
+#include "DynamicBVH.h"
+
+//C++
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+using namespace DirectX;
+
+namespace
+{
+	AABB Box(float x, float y, float z, float size)
+	{
+		AABB box;
+		box.min = XMFLOAT3(x, y, z);
+		box.max = XMFLOAT3(x + size, y + size, z + size);
+		return box;
+	}
+
+	AABB Offset(const AABB& box, float dx)
+	{
+		AABB moved = box;
+		moved.min.x += dx;
+		moved.max.x += dx;
+		return moved;
+	}
+
+	bool SameBox(const AABB& a, const AABB& b)
+	{
+		return a.min.x == b.min.x && a.min.y == b.min.y && a.min.z == b.min.z &&
+			a.max.x == b.max.x && a.max.y == b.max.y && a.max.z == b.max.z;
+	}
+
+	//x in [-20, 20], everything else passes
+	Frustum Slab()
+	{
+		Frustum frustum;
+		frustum.planes[0] = XMFLOAT4(1, 0, 0, 20);
+		frustum.planes[1] = XMFLOAT4(-1, 0, 0, 20);
+		for (int p = 2; p < 6; p++)
+			frustum.planes[p] = XMFLOAT4(0, 0, 0, 1);
+		return frustum;
+	}
+
+	//perspective camera at eye looking along yaw (about y)
+	Frustum View(XMFLOAT3 eye, float yaw, float farClip)
+	{
+		XMMATRIX view = XMMatrixLookToLH(XMVectorSet(eye.x, eye.y, eye.z, 0), XMVectorSet(sinf(yaw), 0, cosf(yaw), 0), XMVectorSet(0, 1, 0, 0));
+		XMFLOAT4X4 viewProjection;
+		XMStoreFloat4x4(&viewProjection, XMMatrixMultiply(view, XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, 0.1f, farClip)));
+		return FrustumFromMatrix(viewProjection);
+	}
+
+	//views spread around a small ring near the origin, all looking outwards
+	std::vector<Frustum> RingOfViews(int viewCount, float farClip)
+	{
+		std::vector<Frustum> frustums;
+		for (int v = 0; v < viewCount; v++) {
+			float yaw = XM_2PI * v / viewCount;
+			frustums.push_back(View(XMFLOAT3(sinf(yaw) * 2.0f, 0.0f, cosf(yaw) * 2.0f), yaw, farClip));
+		}
+		return frustums;
+	}
+}
+
+TEST(DynamicBVHSmallMoveKeepsFatBox)
+{
+	DynamicBVH bvh(0.5f);
+	AABB box = Box(0, 0, 0, 1);
+	int proxy = bvh.Insert(box, 7);
+	AABB fat = bvh.GetFatAABB(proxy);
+	CHECK(SameBox(fat, AABBExpand(box, 0.5f)));
+
+	CHECK(!bvh.Refit(proxy, Offset(box, 0.25f)));
+	CHECK(SameBox(bvh.GetFatAABB(proxy), fat));
+	CHECK(bvh.GetUserData(proxy) == 7);
+}
+
+TEST(DynamicBVHEscapedLeafGetsFreshMargin)
+{
+	DynamicBVH bvh(0.5f);
+	AABB box = Box(0, 0, 0, 1);
+	int proxy = bvh.Insert(box, 0);
+	bvh.Insert(Box(10, 0, 0, 1), 1);
+
+	//a step just past the margin: the new fat box is around the new
+	//box alone, not the union of the old and new positions
+	AABB moved = Offset(box, 0.75f);
+	CHECK(bvh.Refit(proxy, moved));
+	CHECK(SameBox(bvh.GetFatAABB(proxy), AABBExpand(moved, 0.5f)));
+
+	//walking back and forth never lets the leaf grow without bound
+	for (int i = 0; i < 100; i++)
+		bvh.Refit(proxy, Offset(box, (i % 2) ? 3.0f : -3.0f));
+	XMFLOAT3 extents = AABBExtents(bvh.GetFatAABB(proxy));
+	CHECK(extents.x <= 1.0f + 1e-4f);
+	CHECK(bvh.GetStats().reinserts == 101);
+}
+
+TEST(DynamicBVHRebuildRefattensLeaves)
+{
+	DynamicBVH bvh(0.5f);
+	AABB box = Box(0, 0, 0, 1);
+	int proxy = bvh.Insert(box, 0);
+	bvh.Insert(Box(5, 0, 0, 1), 1);
+
+	//drifts inside its margin, so the fat box isn't centered on it any more
+	AABB drifted = Offset(box, 0.4f);
+	CHECK(!bvh.Refit(proxy, drifted));
+
+	bvh.Rebuild();
+	CHECK(SameBox(bvh.GetFatAABB(proxy), AABBExpand(drifted, 0.5f)));
+}
+
+// --------------------------------------------------------
+// Random walks, teleports and removals, then every query
+// checked against brute force over the real boxes
+// --------------------------------------------------------
+TEST(DynamicBVHQueriesMatchBruteForce)
+{
+	const int count = 5000;
+	std::mt19937 random(1);
+	std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+	std::uniform_real_distribution<float> step(-0.4f, 0.4f);
+
+	DynamicBVH bvh(0.1f);
+	std::vector<AABB> boxes(count);
+	std::vector<int> proxies(count);
+	for (int i = 0; i < count; i++) {
+		boxes[i] = Box(position(random), position(random), position(random), 1.0f);
+		proxies[i] = bvh.Insert(boxes[i], i);
+	}
+
+	for (int frame = 0; frame < 20; frame++) {
+		for (int i = frame % 3; i < count; i += 3) {
+			boxes[i] = i % 50 == 0 ?
+				Box(position(random), position(random), position(random), 1.0f) :
+				Offset(boxes[i], step(random));
+			bvh.Refit(proxies[i], boxes[i]);
+		}
+		bvh.RebuildIfNeeded();
+	}
+
+	for (int i = 0; i < count; i += 7) {
+		bvh.Remove(proxies[i]);
+		proxies[i] = -1;
+	}
+
+	for (int i = 0; i < count; i++) {
+		if (proxies[i] != -1)
+			CHECK(AABBContains(bvh.GetFatAABB(proxies[i]), boxes[i]));
+	}
+
+	//overlap queries return fat-box hits, so they must include every real hit
+	int missed = 0;
+	for (int q = 0; q < 100; q++) {
+		AABB query = Box(position(random), position(random), position(random), 10.0f);
+		std::vector<int> hits;
+		bvh.QueryOverlap(query, hits);
+		std::sort(hits.begin(), hits.end());
+
+		for (int i = 0; i < count; i++) {
+			if (proxies[i] != -1 && AABBOverlaps(boxes[i], query) && !std::binary_search(hits.begin(), hits.end(), i))
+				missed++;
+		}
+	}
+	CHECK(missed == 0);
+
+	Frustum frustum = Slab();
+	std::vector<int> visible;
+	bvh.QueryFrustum(frustum, visible);
+	std::sort(visible.begin(), visible.end());
+	for (int i = 0; i < count; i++) {
+		if (proxies[i] != -1 && FrustumTestAABB(frustum, boxes[i]) != CullResult::Outside)
+			CHECK(std::binary_search(visible.begin(), visible.end(), i));
+	}
+}
+
+// --------------------------------------------------------
+// Every view of a multi-view query gets exactly what a
+// query with that view alone would, including views that
+// contain whole subtrees and views that see nothing
+// --------------------------------------------------------
+TEST(DynamicBVHQueryFrustumsMatchesSingleQueries)
+{
+	const int count = 5000;
+	std::mt19937 random(3);
+	std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+	std::uniform_real_distribution<float> angle(0.0f, XM_2PI);
+
+	DynamicBVH bvh(0.1f);
+	for (int i = 0; i < count; i++)
+		bvh.Insert(Box(position(random), position(random), position(random), 1.0f), i);
+
+	std::vector<Frustum> frustums = RingOfViews(8, 150.0f);
+	for (int v = (int)frustums.size(); v < MAX_BVH_VIEWS - 3; v++)
+		frustums.push_back(View(XMFLOAT3(position(random), position(random), position(random)), angle(random), 60.0f));
+	Frustum everything = Slab();
+	everything.planes[0].w = everything.planes[1].w = 1000.0f;
+	frustums.push_back(everything);
+	frustums.push_back(Slab());
+	Frustum nothing = Slab();
+	nothing.planes[0].w = -500.0f;
+	frustums.push_back(nothing);
+
+	std::vector<std::vector<int>> results(frustums.size());
+	bvh.QueryFrustums(frustums.data(), (int)frustums.size(), results.data());
+
+	for (size_t v = 0; v < frustums.size(); v++) {
+		std::vector<int> single;
+		bvh.QueryFrustum(frustums[v], single);
+		std::sort(single.begin(), single.end());
+		std::sort(results[v].begin(), results[v].end());
+		CHECK(results[v] == single);
+	}
+	CHECK((int)results[MAX_BVH_VIEWS - 3].size() == count);
+	CHECK(results[MAX_BVH_VIEWS - 1].empty());
+}
+
+// --------------------------------------------------------
+// One QueryFrustums() walk against a QueryFrustum() per
+// view, over 100k entities
+// --------------------------------------------------------
+BENCHMARK(DynamicBVHQueryFrustumsBenchmark)
+{
+	const int count = 100000;
+	std::mt19937 random(1);
+	std::uniform_real_distribution<float> position(-200.0f, 200.0f);
+
+	DynamicBVH bvh(0.1f);
+	for (int i = 0; i < count; i++)
+		bvh.Insert(Box(position(random), position(random) * 0.1f, position(random), 1.0f), i);
+
+	for (int viewCount : { 1, 4, 16, 32 }) {
+		std::vector<Frustum> frustums = RingOfViews(viewCount, 150.0f);
+		std::vector<std::vector<int>> results(viewCount);
+
+		double separate = TimePerCall([&]() {
+			for (int v = 0; v < viewCount; v++) {
+				results[v].clear();
+				bvh.QueryFrustum(frustums[v], results[v]);
+			}
+		});
+
+		size_t visible = 0;
+		for (const std::vector<int>& result : results)
+			visible += result.size();
+
+		double shared = TimePerCall([&]() {
+			for (std::vector<int>& result : results)
+				result.clear();
+			bvh.QueryFrustums(frustums.data(), viewCount, results.data());
+		});
+
+		printf("  %2d views: separate %6.3f ms, QueryFrustums %6.3f ms (%.2fx), %zu visible in all\n",
+			viewCount, separate * 1e3, shared * 1e3, separate / shared, visible);
+	}
+}
+
+// --------------------------------------------------------
+// Build, per-frame refit (10% of entities moving, 1% of
+// those far enough to be reinserted) and query costs from
+// 10k to 1M entities
+// --------------------------------------------------------
+BENCHMARK(DynamicBVHScaling)
+{
+	for (int count : { 10000, 100000, 1000000 }) {
+		std::mt19937 random(1);
+		float worldSize = 2.0f * cbrtf((float)count) * 4.0f;
+		std::uniform_real_distribution<float> position(-worldSize * 0.5f, worldSize * 0.5f);
+		std::uniform_real_distribution<float> step(-0.05f, 0.05f);
+
+		std::vector<AABB> boxes(count);
+		for (int i = 0; i < count; i++)
+			boxes[i] = Box(position(random), position(random), position(random), 1.0f);
+
+		DynamicBVH bvh(0.1f);
+		std::vector<int> proxies(count);
+		double build = TimePerCall([&]() {
+			bvh = DynamicBVH(0.1f);
+			for (int i = 0; i < count; i++)
+				proxies[i] = bvh.Insert(boxes[i], i);
+		}, 0.0);
+
+		int frame = 0;
+		double refit = TimePerCall([&]() {
+			for (int i = frame % 10; i < count; i += 10) {
+				boxes[i] = i % 1000 == 0 ?
+					Box(position(random), position(random), position(random), 1.0f) :
+					Offset(boxes[i], step(random));
+				bvh.Refit(proxies[i], boxes[i]);
+			}
+			bvh.RebuildIfNeeded();
+			frame++;
+		});
+
+		//a frustum covering about a tenth of the world
+		Frustum frustum = Slab();
+		float slab = worldSize * 0.05f;
+		frustum.planes[0].w = slab;
+		frustum.planes[1].w = slab;
+		std::vector<int> visible;
+		double query = TimePerCall([&]() {
+			visible.clear();
+			bvh.QueryFrustum(frustum, visible);
+		});
+
+		std::vector<int> hits;
+		double overlap = TimePerCall([&]() {
+			hits.clear();
+			bvh.QueryOverlap(Box(position(random), position(random), position(random), 5.0f), hits);
+		});
+
+		printf("  %7d entities: build %7.1f ms, refit frame %6.2f ms (%.0f ns/move), frustum %6.2f ms (%zu visible), overlap %5.2f us, height %d\n",
+			count, build * 1e3, refit * 1e3, refit * 1e9 / (count / 10), query * 1e3, visible.size(), overlap * 1e6, bvh.GetHeight());
+	}
+}
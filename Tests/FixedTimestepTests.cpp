@@ -0,0 +1,87 @@
+#include "Test.h"
+
+#include "FixedTimestep.h"
+
+//C++
+#include <cmath>
+
+//quarter-second steps keep every value exact in binary
+TEST(FixedTimestepCountsSteps)
+{
+	FixedTimestep clock(0.25, 5);
+
+	CHECK(clock.Advance(0.1) == 0);
+	CHECK(fabsf(clock.GetAlpha() - 0.4f) < 1e-6f);
+
+	CHECK(clock.Advance(0.2) == 1);
+	CHECK(fabsf(clock.GetAlpha() - 0.2f) < 1e-6f);
+	CHECK(clock.GetSimulationTime() == 0.25);
+
+	CHECK(clock.Advance(0.7) == 3);
+	CHECK(fabsf(clock.GetAlpha() - 0.0f) < 1e-6f);
+	CHECK(clock.GetSimulationTime() == 1.0);
+	CHECK(clock.GetDroppedSteps() == 0);
+}
+
+TEST(FixedTimestepIgnoresNegativeTime)
+{
+	FixedTimestep clock(0.25, 5);
+	clock.Advance(0.1);
+
+	CHECK(clock.Advance(-1.0) == 0);
+	CHECK(fabsf(clock.GetAlpha() - 0.4f) < 1e-6f);
+}
+
+TEST(FixedTimestepClampsLongFrames)
+{
+	FixedTimestep clock(0.25, 5);
+
+	//a 2.6s hitch owes 10 steps - only 5 run, the rest are dropped
+	CHECK(clock.Advance(2.6) == 5);
+	CHECK(clock.GetDroppedSteps() == 5);
+	CHECK(clock.GetSimulationTime() == 1.25);
+
+	//the remainder survives, so alpha stays meaningful
+	CHECK(fabsf(clock.GetAlpha() - 0.4f) < 1e-5f);
+
+	//and the next normal frame isn't still paying for the hitch
+	CHECK(clock.Advance(0.25) == 1);
+	CHECK(clock.GetDroppedSteps() == 5);
+
+	clock.Reset();
+	CHECK(clock.GetDroppedSteps() == 0);
+	CHECK(clock.GetSimulationTime() == 0.0);
+	CHECK(clock.GetAlpha() == 0.0f);
+}
+
+// --------------------------------------------------------
+// Synthetic clock: uneven frame times at 60hz simulation.
+// Every whole step owed has run, and alpha is always the
+// leftover fraction of a step.
+// --------------------------------------------------------
+TEST(FixedTimestepFollowsSyntheticClock)
+{
+	const double step = 1.0 / 60.0;
+	const double frameTimes[] = { 1.0 / 144.0, 1.0 / 30.0, 1.0 / 75.0, 0.0, 1.0 / 59.0 };
+	FixedTimestep clock(step, 5);
+
+	double time = 0.0;
+	long long steps = 0;
+	for (int frame = 0; frame < 10000; frame++) {
+		double delta = frameTimes[frame % 5];
+		time += delta;
+
+		int stepsThisFrame = clock.Advance(delta);
+		CHECK(stepsThisFrame >= 0 && stepsThisFrame <= 5);
+		steps += stepsThisFrame;
+
+		float alpha = clock.GetAlpha();
+		CHECK(alpha >= 0.0f && alpha < 1.0f);
+	}
+
+	long long expected = (long long)floor(time / step);
+	CHECK(steps == expected || steps == expected - 1);
+	CHECK(clock.GetDroppedSteps() == 0);
+	CHECK(fabs(clock.GetSimulationTime() - steps * step) < 1e-6);
+	CHECK(fabs(clock.GetAlpha() - (time - steps * step) / step) < 1e-3);
+}
@@ -0,0 +1,132 @@
+#include "Test.h"
+
+#include "FrustumCuller.h"
+
+//C++
+#include <random>
+
+using namespace DirectX;
+
+namespace
+{
+	//planes that pass everything, so a test can set just the one it cares about
+	Frustum OpenFrustum()
+	{
+		Frustum frustum;
+		for (int p = 0; p < 6; p++)
+			frustum.planes[p] = XMFLOAT4(0, 0, 0, 1);
+		return frustum;
+	}
+
+	AABB Box(XMFLOAT3 min, XMFLOAT3 max)
+	{
+		AABB box;
+		box.min = min;
+		box.max = max;
+		return box;
+	}
+
+	//a tilted camera-ish frustum around the origin
+	Frustum TestFrustum()
+	{
+		Frustum frustum;
+		frustum.planes[0] = XMFLOAT4(1, 0, 0, 20);
+		frustum.planes[1] = XMFLOAT4(-1, 0, 0, 20);
+		frustum.planes[2] = XMFLOAT4(0, 1, 0, 20);
+		frustum.planes[3] = XMFLOAT4(0, -1, 0, 20);
+		frustum.planes[4] = XMFLOAT4(0, 0, 1, 0);
+		frustum.planes[5] = XMFLOAT4(0.6f, 0, -0.8f, 30);
+		return frustum;
+	}
+
+	void FillRandom(FrustumCuller& culler, unsigned int count, unsigned int seed)
+	{
+		std::mt19937 random(seed);
+		std::uniform_real_distribution<float> position(-50.0f, 50.0f);
+		std::uniform_real_distribution<float> size(0.0f, 3.0f);
+
+		culler.Resize(count);
+		for (unsigned int i = 0; i < count; i++) {
+			XMFLOAT3 c(position(random), position(random), position(random));
+			float e = size(random);
+			culler.SetBox(i, Box(XMFLOAT3(c.x - e, c.y - e, c.z - e), XMFLOAT3(c.x + e, c.y + e, c.z + e)));
+		}
+	}
+}
+
+TEST(FrustumCullerSIMDMatchesScalar)
+{
+	printf("  AVX %s\n", FrustumCuller::HasSIMD() ? "available" : "not available - SIMD path runs scalar");
+
+	//around the 8-wide boundaries, and enough to hit every lane pattern
+	for (unsigned int count : { 0u, 1u, 7u, 8u, 9u, 15u, 16u, 17u, 1000u, 100003u }) {
+		FrustumCuller culler;
+		FillRandom(culler, count, count);
+
+		std::vector<unsigned int> scalar, simd, dispatched;
+		culler.CullScalar(TestFrustum(), scalar);
+		culler.CullSIMD(TestFrustum(), simd);
+		culler.Cull(TestFrustum(), dispatched);
+		CHECK(scalar == simd);
+		CHECK(scalar == dispatched);
+	}
+}
+
+TEST(FrustumCullerTouchingPlaneIsVisible)
+{
+	Frustum frustum = OpenFrustum();
+	frustum.planes[0] = XMFLOAT4(1, 0, 0, 0);	// x >= 0
+
+	FrustumCuller culler;
+	culler.Resize(4);
+	culler.SetBox(0, Box(XMFLOAT3(-2, 0, 0), XMFLOAT3(0, 1, 1)));				// touches
+	culler.SetBox(1, Box(XMFLOAT3(-2, 0, 0), XMFLOAT3(-0.001f, 1, 1)));		// just outside
+	culler.SetBox(2, Box(XMFLOAT3(0, 0, 0), XMFLOAT3(0, 0, 0)));				// a point on the plane
+	culler.SetBox(3, Box(XMFLOAT3(-1e30f, -1, -1), XMFLOAT3(1e30f, 1, 1)));	// huge
+
+	std::vector<unsigned int> expected = { 0, 2, 3 };
+	std::vector<unsigned int> scalar, simd;
+	culler.CullScalar(frustum, scalar);
+	culler.CullSIMD(frustum, simd);
+	CHECK(scalar == expected);
+	CHECK(simd == expected);
+}
+
+TEST(FrustumCullerSkipsPaddingAndAppends)
+{
+	FrustumCuller culler;
+	culler.Resize(9);
+	for (unsigned int i = 0; i < 9; i++)
+		culler.SetBox(i, Box(XMFLOAT3((float)i, 0, 0), XMFLOAT3((float)i + 1, 1, 1)));
+
+	//everything passes, so only the 7 padding lanes are left to reject
+	std::vector<unsigned int> visible = { 42 };
+	culler.CullSIMD(OpenFrustum(), visible);
+	CHECK(visible.size() == 10);
+	CHECK(visible[0] == 42);
+	for (unsigned int i = 0; i < 9; i++)
+		CHECK(visible[i + 1] == i);
+
+	//shrinking hides the old boxes again
+	culler.Resize(3);
+	visible.clear();
+	culler.CullSIMD(OpenFrustum(), visible);
+	CHECK(visible.size() == 3);
+}
+
+BENCHMARK(FrustumCullerBoxesPerNanosecond)
+{
+	for (unsigned int count : { 1000u, 100000u, 1000000u }) {
+		FrustumCuller culler;
+		FillRandom(culler, count, 1);
+		Frustum frustum = TestFrustum();
+		std::vector<unsigned int> visible;
+		visible.reserve(count);
+
+		double scalar = TimePerCall([&]() { visible.clear(); culler.CullScalar(frustum, visible); });
+		double simd = TimePerCall([&]() { visible.clear(); culler.CullSIMD(frustum, visible); });
+
+		printf("  %7u boxes: scalar %.3f boxes/ns, SIMD %.3f boxes/ns (%.1fx)%s\n", count,
+			count / (scalar * 1e9), count / (simd * 1e9), scalar / simd, FrustumCuller::HasSIMD() ? "" : " [no AVX]");
+	}
+}
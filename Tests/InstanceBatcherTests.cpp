@@ -0,0 +1,148 @@
+#include "Test.h"
+
+#include "InstanceBatcher.h"
+
+namespace
+{
+	//stand-in entity state: the real material and mesh IDs
+	struct FakeEntity
+	{
+		unsigned int material;
+		unsigned int mesh;
+	};
+
+	std::vector<RenderPacket> SortedPackets(const std::vector<FakeEntity>& entities)
+	{
+		std::vector<RenderPacket> packets;
+		for (unsigned int i = 0; i < entities.size(); i++)
+			packets.push_back({ RenderQueue::MakeKey(RENDER_PASS_OPAQUE, 1, entities[i].material, entities[i].mesh, i * 0.01f), i });
+
+		std::vector<RenderPacket> scratch;
+		RenderQueue::RadixSort(packets, scratch);
+		return packets;
+	}
+}
+
+TEST(InstanceBatcherGroupsMatchingState)
+{
+	std::vector<FakeEntity> entities = { { 3, 4 }, { 3, 4 }, { 3, 4 }, { 3, 5 }, { 2, 4 } };
+	std::vector<RenderPacket> packets = SortedPackets(entities);
+
+	InstanceBatcher batcher(2);
+	batcher.Build(packets, RENDER_KEY_STATE_MASK,
+		[&](unsigned int a, unsigned int b) { return entities[a].material == entities[b].material && entities[a].mesh == entities[b].mesh; },
+		[](unsigned int) { return true; });
+
+	const std::vector<DrawBatch>& batches = batcher.GetBatches();
+	CHECK(batches.size() == 3);
+	CHECK(batcher.GetInstanceCount() == 3);
+
+	unsigned int instanced = 0;
+	for (const DrawBatch& batch : batches) {
+		if (batch.instanced) {
+			CHECK(batch.packetCount == 3);
+			instanced++;
+		}
+	}
+	CHECK(instanced == 1);
+}
+
+TEST(InstanceBatcherSplitsTruncatedIDCollisions)
+{
+	//material and mesh IDs 65536 apart share every bit of the key
+	std::vector<FakeEntity> entities = { { 7, 9 }, { 7 + 65536, 9 }, { 7, 9 + 65536 }, { 7, 9 } };
+	std::vector<RenderPacket> packets = SortedPackets(entities);
+	for (const RenderPacket& packet : packets)
+		CHECK((packet.key & RENDER_KEY_STATE_MASK) == (packets[0].key & RENDER_KEY_STATE_MASK));
+
+	InstanceBatcher batcher(2);
+	batcher.Build(packets, RENDER_KEY_STATE_MASK,
+		[&](unsigned int a, unsigned int b) { return entities[a].material == entities[b].material && entities[a].mesh == entities[b].mesh; },
+		[](unsigned int) { return true; });
+
+	//every batch is one material and mesh, whatever the key says
+	for (const DrawBatch& batch : batcher.GetBatches()) {
+		const FakeEntity& first = entities[packets[batch.firstPacket].entity];
+		for (unsigned int i = 1; i < batch.packetCount; i++) {
+			const FakeEntity& other = entities[packets[batch.firstPacket + i].entity];
+			CHECK(other.material == first.material && other.mesh == first.mesh);
+		}
+	}
+
+	unsigned int packetsInBatches = 0;
+	for (const DrawBatch& batch : batcher.GetBatches())
+		packetsInBatches += batch.packetCount;
+	CHECK(packetsInBatches == entities.size());
+}
+
+// --------------------------------------------------------
+// A run whose entities need different per-draw constants
+// (lights) becomes one instanced batch per group, each in
+// draw order and packed contiguously
+// --------------------------------------------------------
+TEST(InstanceBatcherSplitsRunsByGroup)
+{
+	std::vector<FakeEntity> entities(6, { 3, 4 });
+	const uint32_t groups[] = { 1, 2, 1, 1, 2, 4 };
+	std::vector<RenderPacket> packets = SortedPackets(entities);
+
+	InstanceBatcher batcher(2);
+	batcher.Build(packets, RENDER_KEY_STATE_MASK,
+		[&](unsigned int a, unsigned int b) { return entities[a].material == entities[b].material && entities[a].mesh == entities[b].mesh; },
+		[](unsigned int) { return true; },
+		[&](unsigned int entity) { return groups[entity]; });
+
+	const std::vector<DrawBatch>& batches = batcher.GetBatches();
+	const std::vector<unsigned int>& instanceEntities = batcher.GetInstanceEntities();
+	CHECK(batches.size() == 3);
+	CHECK(batcher.GetInstanceCount() == 6);
+
+	unsigned int next = 0;
+	for (const DrawBatch& batch : batches) {
+		CHECK(batch.instanced);
+		CHECK(batch.firstInstance == next);
+		for (unsigned int i = 0; i < batch.packetCount; i++) {
+			unsigned int entity = instanceEntities[batch.firstInstance + i];
+			CHECK(groups[entity] == batch.group);
+			if (i > 0)
+				CHECK(entity > instanceEntities[batch.firstInstance + i - 1]);
+		}
+		next += batch.packetCount;
+	}
+
+	//instances come out in the same order as the batches' entities
+	batcher.Pack([](unsigned int entity, InstanceData& data) { data.world._11 = (float)entity; });
+	for (unsigned int i = 0; i < batcher.GetInstanceCount(); i++)
+		CHECK(batcher.GetInstances()[i].world._11 == (float)instanceEntities[i]);
+}
+
+// --------------------------------------------------------
+// Build and Pack over 100k sorted packets (64 material and
+// mesh pairs), without splitting and split into 16 light
+// groups by position
+// --------------------------------------------------------
+BENCHMARK(InstanceBatcherBenchmark)
+{
+	const unsigned int count = 100000;
+	std::vector<FakeEntity> entities(count);
+	std::vector<uint32_t> lightMasks(count);
+	for (unsigned int i = 0; i < count; i++) {
+		entities[i] = { (i * 7) % 8, (i * 13) % 8 };
+		lightMasks[i] = 1u << ((i * 2654435761u) >> 28);
+	}
+	std::vector<RenderPacket> packets = SortedPackets(entities);
+
+	InstanceBatcher batcher(2);
+	for (int split = 0; split < 2; split++) {
+		double seconds = TimePerCall([&]() {
+			batcher.Build(packets, RENDER_KEY_STATE_MASK,
+				[&](unsigned int a, unsigned int b) { return entities[a].material == entities[b].material && entities[a].mesh == entities[b].mesh; },
+				[](unsigned int) { return true; },
+				[&](unsigned int entity) { return split ? lightMasks[entity] : 0u; });
+			batcher.Pack([](unsigned int entity, InstanceData& data) { data.world._11 = (float)entity; });
+		});
+
+		printf("  %-20s %6.2f ms (%.1f ns/packet), %zu batches\n", split ? "split by lights:" : "one batch per run:",
+			seconds * 1e3, seconds * 1e9 / count, batcher.GetBatches().size());
+	}
+}
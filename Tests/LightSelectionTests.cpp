@@ -0,0 +1,194 @@
+#include "Test.h"
+
+#include "LightSelection.h"
+#include "SpatialHash.h"
+
+//C++
+#include <algorithm>
+#include <random>
+
+using namespace DirectX;
+
+namespace
+{
+	Light PointLight(XMFLOAT3 position, float range, float intensity = 1.0f)
+	{
+		Light light = {};
+		light.type = LIGHT_TYPE_POINT;
+		light.position = position;
+		light.range = range;
+		light.intensity = intensity;
+		return light;
+	}
+
+	Light DirectionalLight()
+	{
+		Light light = {};
+		light.type = LIGHT_TYPE_DIRECTIONAL;
+		light.direction = XMFLOAT3(0, -1, 0);
+		light.intensity = 1.0f;
+		return light;
+	}
+}
+
+TEST(FrameLightsKeepOrderWhenTheyFit)
+{
+	std::vector<Light> lights;
+	for (int i = 0; i < MAX_SCENE_LIGHTS; i++)
+		lights.push_back(PointLight(XMFLOAT3((float)(MAX_SCENE_LIGHTS - i) * 10.0f, 0, 0), 1.0f));
+
+	std::vector<int> selected;
+	SelectFrameLights(lights, XMFLOAT3(0, 0, 0), MAX_SCENE_LIGHTS, selected);
+	CHECK(selected.size() == MAX_SCENE_LIGHTS);
+	for (int i = 0; i < (int)selected.size(); i++)
+		CHECK(selected[i] == i);
+}
+
+TEST(FrameLightsPreferDirectionalThenNearest)
+{
+	//far lights first in the pool, so an index cap would keep exactly the wrong ones
+	std::vector<Light> lights;
+	for (int i = 0; i < 40; i++)
+		lights.push_back(PointLight(XMFLOAT3(1000.0f + i, 0, 0), 5.0f));
+	for (int i = 0; i < 30; i++)
+		lights.push_back(PointLight(XMFLOAT3((float)i, 0, 0), 5.0f));
+	lights.push_back(DirectionalLight());
+
+	std::vector<int> selected;
+	SelectFrameLights(lights, XMFLOAT3(0, 0, 0), MAX_SCENE_LIGHTS, selected);
+	CHECK(selected.size() == MAX_SCENE_LIGHTS);
+	CHECK(selected[0] == 70);
+
+	//every near light made it, and the nearest far one took the last slot
+	std::vector<int> sorted(selected.begin() + 1, selected.end());
+	std::sort(sorted.begin(), sorted.end());
+	CHECK(sorted[0] == 0);
+	for (int i = 0; i < 30; i++)
+		CHECK(sorted[i + 1] == 40 + i);
+}
+
+TEST(DrawLightsDropUnreachable)
+{
+	std::vector<Light> lights = {
+		PointLight(XMFLOAT3(3, 0, 0), 2.5f),	// reaches a radius-1 sphere at the origin
+		PointLight(XMFLOAT3(4, 0, 0), 2.5f),	// stops short of it
+		DirectionalLight() };
+
+	std::vector<int> candidates = { 0, 1, 2 };
+	SelectDrawLights(lights.data(), candidates, XMFLOAT3(0, 0, 0), 1.0f, MAX_LIGHTS);
+	CHECK(candidates == std::vector<int>({ 0, 2 }));
+}
+
+TEST(DrawLightsKeepBrightest)
+{
+	//the brightest lights are last, past where a first-come cap would stop
+	std::vector<Light> lights;
+	std::vector<int> candidates;
+	for (int i = 0; i < MAX_SCENE_LIGHTS; i++) {
+		lights.push_back(PointLight(XMFLOAT3(0, 0, 0), 10.0f, (float)(i + 1)));
+		candidates.push_back(i);
+	}
+
+	SelectDrawLights(lights.data(), candidates, XMFLOAT3(0, 0, 0), 1.0f, MAX_LIGHTS);
+	CHECK(candidates.size() == MAX_LIGHTS);
+	std::sort(candidates.begin(), candidates.end());
+	for (int i = 0; i < MAX_LIGHTS; i++)
+		CHECK(candidates[i] == MAX_SCENE_LIGHTS - MAX_LIGHTS + i);
+}
+
+TEST(DrawLightsUseFrameLightsPastThePoolCap)
+{
+	//pool index 40 was dropped outright when draws were capped at index MAX_SCENE_LIGHTS
+	std::vector<Light> lights;
+	for (int i = 0; i < 40; i++)
+		lights.push_back(PointLight(XMFLOAT3(500.0f + i * 10.0f, 0, 0), 5.0f));
+	lights.push_back(PointLight(XMFLOAT3(2, 0, 0), 5.0f));
+
+	std::vector<int> frame;
+	SelectFrameLights(lights, XMFLOAT3(0, 0, 0), MAX_SCENE_LIGHTS, frame);
+	CHECK(std::find(frame.begin(), frame.end(), 40) != frame.end());
+
+	std::vector<int> candidates = { 40 };
+	SelectDrawLights(lights.data(), candidates, XMFLOAT3(0, 0, 0), 1.0f, MAX_LIGHTS);
+	CHECK(candidates == std::vector<int>({ 40 }));
+}
+
+// --------------------------------------------------------
+// 500 lights over 10k entities, gathered the way
+// Game::GatherLights does it - first with the old pool
+// index cap (first MAX_LIGHTS reaching lights under index
+// MAX_SCENE_LIGHTS), then with frame and draw selection.
+// "light" is the summed contribution per draw.
+// --------------------------------------------------------
+BENCHMARK(LightSelectionBenchmark)
+{
+	const unsigned int lightCount = 500;
+	const unsigned int entityCount = 10000;
+	std::mt19937 random(11);
+	std::uniform_real_distribution<float> position(-50.0f, 50.0f);
+	std::uniform_real_distribution<float> range(5.0f, 20.0f);
+	std::uniform_real_distribution<float> intensity(0.5f, 2.0f);
+
+	std::vector<Light> lights;
+	lights.push_back(DirectionalLight());
+	SpatialHash grid(8.0f);
+	float maxRange = 0.0f;
+	for (unsigned int i = 1; i < lightCount; i++) {
+		lights.push_back(PointLight(XMFLOAT3(position(random), position(random), position(random)), range(random), intensity(random)));
+		grid.Insert(lights[i].position, i);
+		maxRange = std::max(maxRange, lights[i].range);
+	}
+
+	std::vector<XMFLOAT3> entities(entityCount);
+	for (XMFLOAT3& e : entities)
+		e = XMFLOAT3(position(random) * 0.5f, position(random) * 0.5f, position(random) * 0.5f);
+	const float radius = 1.0f;
+
+	std::vector<int> frameLights;
+	SelectFrameLights(lights, XMFLOAT3(0, 0, 0), MAX_SCENE_LIGHTS, frameLights);
+	std::vector<int> frameSlots(lights.size(), -1);
+	for (int s = 0; s < (int)frameLights.size(); s++)
+		frameSlots[frameLights[s]] = s;
+
+	std::vector<int> nearby;
+	std::vector<int> drawLights;
+	for (int mode = 0; mode < 2; mode++) {
+		bool selection = mode == 1;
+		unsigned int used = 0;
+		float light = 0.0f;
+
+		double seconds = TimePerCall([&]() {
+			used = 0;
+			light = 0.0f;
+			for (const XMFLOAT3& center : entities) {
+				nearby.clear();
+				grid.QueryRadius(center, radius + maxRange, nearby);
+
+				drawLights.clear();
+				if (selection) {
+					if (frameSlots[0] >= 0)
+						drawLights.push_back(0);
+					for (int i : nearby) {
+						if (frameSlots[i] >= 0)
+							drawLights.push_back(i);
+					}
+					SelectDrawLights(lights.data(), drawLights, center, radius, MAX_LIGHTS);
+				}
+				else {
+					drawLights.push_back(0);
+					for (int i : nearby) {
+						if (drawLights.size() < MAX_LIGHTS && i < MAX_SCENE_LIGHTS && LightContribution(lights[i], center, radius) > 0.0f)
+							drawLights.push_back(i);
+					}
+				}
+
+				used += (unsigned int)drawLights.size();
+				for (int i : drawLights)
+					light += LightContribution(lights[i], center, radius);
+			}
+		});
+
+		printf("  %-10s %7.1f ns/draw, %5.2f lights/draw, %5.2f light/draw\n", selection ? "selection" : "index cap",
+			seconds * 1e9 / entityCount, (float)used / entityCount, light / entityCount);
+	}
+}
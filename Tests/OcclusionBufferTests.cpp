@@ -0,0 +1,188 @@
+#include "Test.h"
+
+#include "OcclusionBuffer.h"
+
+//C++
+#include <cmath>
+#include <cstring>
+#include <random>
+
+using namespace DirectX;
+
+namespace
+{
+	// --------------------------------------------------------
+	// Row-vector perspective projection (same layout as
+	// XMMatrixPerspectiveFovLH) for a camera at the origin
+	// looking down +z
+	// --------------------------------------------------------
+	XMFLOAT4X4 Projection(float fovY, float aspect, float nearZ, float farZ)
+	{
+		float ys = 1.0f / tanf(fovY * 0.5f);
+		float range = farZ / (farZ - nearZ);
+
+		XMFLOAT4X4 m = {};
+		m._11 = ys / aspect;
+		m._22 = ys;
+		m._33 = range;
+		m._34 = 1.0f;
+		m._43 = -nearZ * range;
+		return m;
+	}
+
+	XMFLOAT4X4 Identity()
+	{
+		XMFLOAT4X4 m = {};
+		m._11 = m._22 = m._33 = m._44 = 1.0f;
+		return m;
+	}
+
+	Vertex At(float x, float y, float z)
+	{
+		Vertex vertex = {};
+		vertex.Position = XMFLOAT3(x, y, z);
+		return vertex;
+	}
+
+	AABB Box(XMFLOAT3 min, XMFLOAT3 max)
+	{
+		AABB box;
+		box.min = min;
+		box.max = max;
+		return box;
+	}
+
+	//a 10x10 wall facing the camera, 10 units away
+	void AddWall(OcclusionBuffer& buffer)
+	{
+		std::vector<Vertex> vertices = { At(-5, -5, 10), At(-5, 5, 10), At(5, 5, 10), At(5, -5, 10) };
+		std::vector<unsigned int> indices = { 0, 1, 2, 0, 2, 3 };
+		buffer.AddOccluder(vertices, indices, Identity());
+	}
+
+	//count random triangles in front of the camera, either winding
+	void AddRandomTriangles(OcclusionBuffer& buffer, unsigned int count, unsigned int seed)
+	{
+		std::mt19937 random(seed);
+		std::uniform_real_distribution<float> spread(-30.0f, 30.0f);
+		std::uniform_real_distribution<float> depth(2.0f, 60.0f);
+		std::uniform_real_distribution<float> size(-4.0f, 4.0f);
+
+		std::vector<Vertex> vertices;
+		std::vector<unsigned int> indices;
+		for (unsigned int i = 0; i < count; i++) {
+			float x = spread(random), y = spread(random), z = depth(random);
+			for (int v = 0; v < 3; v++) {
+				indices.push_back((unsigned int)vertices.size());
+				vertices.push_back(At(x + size(random), y + size(random), z + size(random)));
+			}
+		}
+		buffer.AddOccluder(vertices, indices, Identity());
+	}
+
+	std::vector<float> RasterizeRandom(unsigned int threads, bool simd)
+	{
+		OcclusionBuffer buffer(256, 128, threads);
+		buffer.SetSIMD(simd);
+		buffer.Begin(Projection(1.5f, 2.0f, 0.1f, 100.0f));
+		AddRandomTriangles(buffer, 2000, 3);
+		buffer.Rasterize();
+		return buffer.GetDepth();
+	}
+}
+
+TEST(OcclusionBufferHidesBoxesBehindOccluder)
+{
+	OcclusionBuffer buffer(256, 128, 1);
+	buffer.Begin(Projection(1.5f, 2.0f, 0.1f, 100.0f));
+	AddWall(buffer);
+	buffer.Rasterize();
+	CHECK(buffer.GetTriangleCount() == 2);
+
+	//behind the wall
+	CHECK(!buffer.IsVisible(Box(XMFLOAT3(-1, -1, 20), XMFLOAT3(1, 1, 21))));
+	//in front of it
+	CHECK(buffer.IsVisible(Box(XMFLOAT3(-1, -1, 5), XMFLOAT3(1, 1, 6))));
+	//behind it, but far enough to the side to be seen past the edge
+	CHECK(buffer.IsVisible(Box(XMFLOAT3(20, -1, 20), XMFLOAT3(22, 1, 21))));
+	//poking out from behind it
+	CHECK(buffer.IsVisible(Box(XMFLOAT3(-1, -1, 20), XMFLOAT3(1, 20, 21))));
+	//crossing the near plane is always visible
+	CHECK(buffer.IsVisible(Box(XMFLOAT3(-1, -1, -1), XMFLOAT3(1, 1, 30))));
+}
+
+TEST(OcclusionBufferEmptyHidesNothing)
+{
+	OcclusionBuffer buffer(256, 128, 1);
+	buffer.Begin(Projection(1.5f, 2.0f, 0.1f, 100.0f));
+	buffer.Rasterize();
+	CHECK(buffer.IsVisible(Box(XMFLOAT3(-1, -1, 90), XMFLOAT3(1, 1, 95))));
+}
+
+// --------------------------------------------------------
+// The AVX and scalar rasterizers evaluate the same
+// expressions in the same order, and tiles own disjoint
+// pixels, so every combination gives the same bits
+// --------------------------------------------------------
+TEST(OcclusionBufferSIMDAndThreadsMatchScalar)
+{
+	std::vector<float> reference = RasterizeRandom(1, false);
+
+	//something was actually drawn
+	unsigned int covered = 0;
+	for (float depth : reference)
+		covered += depth < 1.0f ? 1 : 0;
+	CHECK(covered > reference.size() / 2);
+
+	for (unsigned int threads : { 1u, 4u }) {
+		for (bool simd : { false, true }) {
+			std::vector<float> depth = RasterizeRandom(threads, simd);
+			CHECK(depth.size() == reference.size());
+			CHECK(memcmp(depth.data(), reference.data(), depth.size() * sizeof(float)) == 0);
+		}
+	}
+}
+
+BENCHMARK(OcclusionBufferRasterize)
+{
+	for (unsigned int triangles : { 1000u, 10000u }) {
+		for (unsigned int threads : { 1u, 4u }) {
+			for (bool simd : { false, true }) {
+				OcclusionBuffer buffer(256, 128, threads);
+				buffer.SetSIMD(simd);
+				if (simd && !buffer.GetSIMD())
+					continue;
+
+				double seconds = TimePerCall([&]() {
+					buffer.Begin(Projection(1.5f, 2.0f, 0.1f, 100.0f));
+					AddRandomTriangles(buffer, triangles, 3);
+					buffer.Rasterize();
+				});
+				printf("  %5u triangles, %u thread%s, %s: %.3f ms\n", triangles, threads, threads == 1 ? " " : "s",
+					simd ? "AVX   " : "scalar", seconds * 1e3);
+			}
+		}
+	}
+
+	OcclusionBuffer buffer(256, 128, 1);
+	buffer.Begin(Projection(1.5f, 2.0f, 0.1f, 100.0f));
+	AddRandomTriangles(buffer, 1000, 3);
+	buffer.Rasterize();
+
+	std::mt19937 random(5);
+	std::uniform_real_distribution<float> spread(-30.0f, 30.0f);
+	std::uniform_real_distribution<float> depth(2.0f, 80.0f);
+	std::vector<AABB> boxes;
+	for (int i = 0; i < 10000; i++) {
+		XMFLOAT3 c(spread(random), spread(random), depth(random));
+		boxes.push_back(Box(XMFLOAT3(c.x - 1, c.y - 1, c.z - 1), XMFLOAT3(c.x + 1, c.y + 1, c.z + 1)));
+	}
+
+	unsigned int visible = 0;
+	double seconds = TimePerCall([&]() {
+		visible = 0;
+		for (const AABB& box : boxes)
+			visible += buffer.IsVisible(box) ? 1 : 0;
+	});
+	printf("  IsVisible: %.1f ns/box (%u of %zu visible)\n", seconds * 1e9 / boxes.size(), visible, boxes.size());
+}
@@ -0,0 +1,324 @@
+#pragma once
+
+//C++
+#include <cmath>
+
+// --------------------------------------------------------
+// Stand-in for DirectXMath on machines without the Windows
+// SDK: the storage types plus a plain scalar version of the
+// vector and matrix calls the engine makes, with the same
+// conventions (row vectors, left-handed, angles in
+// radians).  Only what the engine uses is here - add to it
+// as the portable test build grows.
+// --------------------------------------------------------
+namespace DirectX
+{
+	constexpr float XM_PI = 3.141592654f;
+	constexpr float XM_2PI = 6.283185307f;
+	constexpr float XM_PIDIV2 = 1.570796327f;
+	constexpr float XM_PIDIV4 = 0.785398163f;
+
+	struct XMFLOAT2
+	{
+		float x, y;
+		XMFLOAT2() = default;
+		constexpr XMFLOAT2(float x, float y) : x(x), y(y) {}
+	};
+
+	struct XMFLOAT3
+	{
+		float x, y, z;
+		XMFLOAT3() = default;
+		constexpr XMFLOAT3(float x, float y, float z) : x(x), y(y), z(z) {}
+	};
+
+	struct XMFLOAT4
+	{
+		float x, y, z, w;
+		XMFLOAT4() = default;
+		constexpr XMFLOAT4(float x, float y, float z, float w) : x(x), y(y), z(z), w(w) {}
+	};
+
+	struct XMFLOAT4X4
+	{
+		union
+		{
+			struct
+			{
+				float _11, _12, _13, _14;
+				float _21, _22, _23, _24;
+				float _31, _32, _33, _34;
+				float _41, _42, _43, _44;
+			};
+			float m[4][4];
+		};
+		XMFLOAT4X4() = default;
+	};
+
+	// --------------------------------------------------------
+	// Register types, as plain floats
+	// --------------------------------------------------------
+	struct XMVECTOR
+	{
+		float v[4];
+	};
+
+	struct XMMATRIX
+	{
+		XMVECTOR r[4];
+	};
+
+	typedef const XMVECTOR FXMVECTOR;
+	typedef const XMVECTOR GXMVECTOR;
+	typedef const XMVECTOR& CXMVECTOR;
+	typedef const XMMATRIX FXMMATRIX;
+	typedef const XMMATRIX& CXMMATRIX;
+
+	inline XMVECTOR XMVectorSet(float x, float y, float z, float w) { return { { x, y, z, w } }; }
+	inline XMVECTOR XMVectorZero() { return XMVectorSet(0, 0, 0, 0); }
+	inline XMVECTOR XMVectorReplicate(float value) { return XMVectorSet(value, value, value, value); }
+	inline float XMVectorGetX(FXMVECTOR v) { return v.v[0]; }
+	inline float XMVectorGetY(FXMVECTOR v) { return v.v[1]; }
+	inline float XMVectorGetZ(FXMVECTOR v) { return v.v[2]; }
+	inline float XMVectorGetW(FXMVECTOR v) { return v.v[3]; }
+
+	inline XMVECTOR XMLoadFloat3(const XMFLOAT3* source) { return XMVectorSet(source->x, source->y, source->z, 0); }
+	inline XMVECTOR XMLoadFloat4(const XMFLOAT4* source) { return XMVectorSet(source->x, source->y, source->z, source->w); }
+	inline void XMStoreFloat3(XMFLOAT3* dest, FXMVECTOR v) { *dest = XMFLOAT3(v.v[0], v.v[1], v.v[2]); }
+	inline void XMStoreFloat4(XMFLOAT4* dest, FXMVECTOR v) { *dest = XMFLOAT4(v.v[0], v.v[1], v.v[2], v.v[3]); }
+
+	inline XMMATRIX XMLoadFloat4x4(const XMFLOAT4X4* source)
+	{
+		XMMATRIX m;
+		for (int i = 0; i < 4; i++)
+			m.r[i] = XMVectorSet(source->m[i][0], source->m[i][1], source->m[i][2], source->m[i][3]);
+		return m;
+	}
+
+	inline void XMStoreFloat4x4(XMFLOAT4X4* dest, FXMMATRIX m)
+	{
+		for (int i = 0; i < 4; i++)
+			for (int j = 0; j < 4; j++)
+				dest->m[i][j] = m.r[i].v[j];
+	}
+
+	inline XMVECTOR operator+(FXMVECTOR a, FXMVECTOR b) { return XMVectorSet(a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3]); }
+	inline XMVECTOR operator-(FXMVECTOR a, FXMVECTOR b) { return XMVectorSet(a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2], a.v[3] - b.v[3]); }
+	inline XMVECTOR operator*(FXMVECTOR a, FXMVECTOR b) { return XMVectorSet(a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2], a.v[3] * b.v[3]); }
+	inline XMVECTOR operator*(FXMVECTOR a, float s) { return XMVectorSet(a.v[0] * s, a.v[1] * s, a.v[2] * s, a.v[3] * s); }
+	inline XMVECTOR operator*(float s, FXMVECTOR a) { return a * s; }
+	inline XMVECTOR operator-(FXMVECTOR a) { return XMVectorSet(-a.v[0], -a.v[1], -a.v[2], -a.v[3]); }
+	inline XMVECTOR& operator+=(XMVECTOR& a, FXMVECTOR b) { a = a + b; return a; }
+	inline XMVECTOR& operator-=(XMVECTOR& a, FXMVECTOR b) { a = a - b; return a; }
+
+	inline XMVECTOR XMVectorAdd(FXMVECTOR a, FXMVECTOR b) { return a + b; }
+	inline XMVECTOR XMVectorSubtract(FXMVECTOR a, FXMVECTOR b) { return a - b; }
+	inline XMVECTOR XMVectorScale(FXMVECTOR a, float s) { return a * s; }
+	inline XMVECTOR XMVectorLerp(FXMVECTOR a, FXMVECTOR b, float t) { return a + (b - a) * t; }
+
+	inline XMVECTOR XMVector3Dot(FXMVECTOR a, FXMVECTOR b) { return XMVectorReplicate(a.v[0] * b.v[0] + a.v[1] * b.v[1] + a.v[2] * b.v[2]); }
+	inline XMVECTOR XMVector3Length(FXMVECTOR v) { return XMVectorReplicate(sqrtf(XMVectorGetX(XMVector3Dot(v, v)))); }
+
+	inline XMVECTOR XMVector3Cross(FXMVECTOR a, FXMVECTOR b)
+	{
+		return XMVectorSet(a.v[1] * b.v[2] - a.v[2] * b.v[1], a.v[2] * b.v[0] - a.v[0] * b.v[2], a.v[0] * b.v[1] - a.v[1] * b.v[0], 0);
+	}
+
+	inline XMVECTOR XMVector3Normalize(FXMVECTOR v)
+	{
+		float length = XMVectorGetX(XMVector3Length(v));
+		return length > 0.0f ? v * (1.0f / length) : v;
+	}
+
+	inline float XMConvertToRadians(float degrees) { return degrees * (XM_PI / 180.0f); }
+	inline float XMConvertToDegrees(float radians) { return radians * (180.0f / XM_PI); }
+
+	// --------------------------------------------------------
+	// Matrices - rows are basis vectors, vectors multiply on
+	// the left
+	// --------------------------------------------------------
+	inline XMMATRIX XMMatrixSet(
+		float m00, float m01, float m02, float m03,
+		float m10, float m11, float m12, float m13,
+		float m20, float m21, float m22, float m23,
+		float m30, float m31, float m32, float m33)
+	{
+		return { { XMVectorSet(m00, m01, m02, m03), XMVectorSet(m10, m11, m12, m13),
+			XMVectorSet(m20, m21, m22, m23), XMVectorSet(m30, m31, m32, m33) } };
+	}
+
+	inline XMMATRIX XMMatrixIdentity() { return XMMatrixSet(1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1); }
+
+	inline XMMATRIX XMMatrixMultiply(FXMMATRIX a, CXMMATRIX b)
+	{
+		XMMATRIX result;
+		for (int i = 0; i < 4; i++)
+			for (int j = 0; j < 4; j++)
+				result.r[i].v[j] = a.r[i].v[0] * b.r[0].v[j] + a.r[i].v[1] * b.r[1].v[j] + a.r[i].v[2] * b.r[2].v[j] + a.r[i].v[3] * b.r[3].v[j];
+		return result;
+	}
+
+	inline XMMATRIX operator*(FXMMATRIX a, CXMMATRIX b) { return XMMatrixMultiply(a, b); }
+
+	inline XMMATRIX XMMatrixTranspose(FXMMATRIX m)
+	{
+		XMMATRIX result;
+		for (int i = 0; i < 4; i++)
+			for (int j = 0; j < 4; j++)
+				result.r[i].v[j] = m.r[j].v[i];
+		return result;
+	}
+
+	// --------------------------------------------------------
+	// Inverse by cofactors; determinant is optional as in the
+	// real library
+	// --------------------------------------------------------
+	inline XMMATRIX XMMatrixInverse(XMVECTOR* determinant, FXMMATRIX m)
+	{
+		float a[16], inv[16];
+		for (int i = 0; i < 16; i++)
+			a[i] = m.r[i / 4].v[i % 4];
+
+		inv[0] = a[5] * a[10] * a[15] - a[5] * a[11] * a[14] - a[9] * a[6] * a[15] + a[9] * a[7] * a[14] + a[13] * a[6] * a[11] - a[13] * a[7] * a[10];
+		inv[4] = -a[4] * a[10] * a[15] + a[4] * a[11] * a[14] + a[8] * a[6] * a[15] - a[8] * a[7] * a[14] - a[12] * a[6] * a[11] + a[12] * a[7] * a[10];
+		inv[8] = a[4] * a[9] * a[15] - a[4] * a[11] * a[13] - a[8] * a[5] * a[15] + a[8] * a[7] * a[13] + a[12] * a[5] * a[11] - a[12] * a[7] * a[9];
+		inv[12] = -a[4] * a[9] * a[14] + a[4] * a[10] * a[13] + a[8] * a[5] * a[14] - a[8] * a[6] * a[13] - a[12] * a[5] * a[10] + a[12] * a[6] * a[9];
+		inv[1] = -a[1] * a[10] * a[15] + a[1] * a[11] * a[14] + a[9] * a[2] * a[15] - a[9] * a[3] * a[14] - a[13] * a[2] * a[11] + a[13] * a[3] * a[10];
+		inv[5] = a[0] * a[10] * a[15] - a[0] * a[11] * a[14] - a[8] * a[2] * a[15] + a[8] * a[3] * a[14] + a[12] * a[2] * a[11] - a[12] * a[3] * a[10];
+		inv[9] = -a[0] * a[9] * a[15] + a[0] * a[11] * a[13] + a[8] * a[1] * a[15] - a[8] * a[3] * a[13] - a[12] * a[1] * a[11] + a[12] * a[3] * a[9];
+		inv[13] = a[0] * a[9] * a[14] - a[0] * a[10] * a[13] - a[8] * a[1] * a[14] + a[8] * a[2] * a[13] + a[12] * a[1] * a[10] - a[12] * a[2] * a[9];
+		inv[2] = a[1] * a[6] * a[15] - a[1] * a[7] * a[14] - a[5] * a[2] * a[15] + a[5] * a[3] * a[14] + a[13] * a[2] * a[7] - a[13] * a[3] * a[6];
+		inv[6] = -a[0] * a[6] * a[15] + a[0] * a[7] * a[14] + a[4] * a[2] * a[15] - a[4] * a[3] * a[14] - a[12] * a[2] * a[7] + a[12] * a[3] * a[6];
+		inv[10] = a[0] * a[5] * a[15] - a[0] * a[7] * a[13] - a[4] * a[1] * a[15] + a[4] * a[3] * a[13] + a[12] * a[1] * a[7] - a[12] * a[3] * a[5];
+		inv[14] = -a[0] * a[5] * a[14] + a[0] * a[6] * a[13] + a[4] * a[1] * a[14] - a[4] * a[2] * a[13] - a[12] * a[1] * a[6] + a[12] * a[2] * a[5];
+		inv[3] = -a[1] * a[6] * a[11] + a[1] * a[7] * a[10] + a[5] * a[2] * a[11] - a[5] * a[3] * a[10] - a[9] * a[2] * a[7] + a[9] * a[3] * a[6];
+		inv[7] = a[0] * a[6] * a[11] - a[0] * a[7] * a[10] - a[4] * a[2] * a[11] + a[4] * a[3] * a[10] + a[8] * a[2] * a[7] - a[8] * a[3] * a[6];
+		inv[11] = -a[0] * a[5] * a[11] + a[0] * a[7] * a[9] + a[4] * a[1] * a[11] - a[4] * a[3] * a[9] - a[8] * a[1] * a[7] + a[8] * a[3] * a[5];
+		inv[15] = a[0] * a[5] * a[10] - a[0] * a[6] * a[9] - a[4] * a[1] * a[10] + a[4] * a[2] * a[9] + a[8] * a[1] * a[6] - a[8] * a[2] * a[5];
+
+		float det = a[0] * inv[0] + a[1] * inv[4] + a[2] * inv[8] + a[3] * inv[12];
+		if (determinant)
+			*determinant = XMVectorReplicate(det);
+
+		XMMATRIX result;
+		float scale = det != 0.0f ? 1.0f / det : 0.0f;
+		for (int i = 0; i < 16; i++)
+			result.r[i / 4].v[i % 4] = inv[i] * scale;
+		return result;
+	}
+
+	inline XMMATRIX XMMatrixTranslation(float x, float y, float z) { return XMMatrixSet(1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, x, y, z, 1); }
+	inline XMMATRIX XMMatrixTranslationFromVector(FXMVECTOR v) { return XMMatrixTranslation(v.v[0], v.v[1], v.v[2]); }
+	inline XMMATRIX XMMatrixScaling(float x, float y, float z) { return XMMatrixSet(x, 0, 0, 0, 0, y, 0, 0, 0, 0, z, 0, 0, 0, 0, 1); }
+	inline XMMATRIX XMMatrixScalingFromVector(FXMVECTOR v) { return XMMatrixScaling(v.v[0], v.v[1], v.v[2]); }
+
+	//roll about Z, then pitch about X, then yaw about Y
+	inline XMMATRIX XMMatrixRotationRollPitchYaw(float pitch, float yaw, float roll)
+	{
+		float cp = cosf(pitch), sp = sinf(pitch);
+		float cy = cosf(yaw), sy = sinf(yaw);
+		float cr = cosf(roll), sr = sinf(roll);
+		return XMMatrixSet(
+			cr * cy + sr * sp * sy, sr * cp, sr * sp * cy - cr * sy, 0,
+			cr * sp * sy - sr * cy, cr * cp, sr * sy + cr * sp * cy, 0,
+			cp * sy, -sp, cp * cy, 0,
+			0, 0, 0, 1);
+	}
+
+	inline XMMATRIX XMMatrixRotationQuaternion(FXMVECTOR q)
+	{
+		float x = q.v[0], y = q.v[1], z = q.v[2], w = q.v[3];
+		return XMMatrixSet(
+			1 - 2 * (y * y + z * z), 2 * (x * y + z * w), 2 * (x * z - y * w), 0,
+			2 * (x * y - z * w), 1 - 2 * (x * x + z * z), 2 * (y * z + x * w), 0,
+			2 * (x * z + y * w), 2 * (y * z - x * w), 1 - 2 * (x * x + y * y), 0,
+			0, 0, 0, 1);
+	}
+
+	inline XMMATRIX XMMatrixPerspectiveFovLH(float fovY, float aspect, float nearZ, float farZ)
+	{
+		float h = 1.0f / tanf(fovY * 0.5f);
+		float w = h / aspect;
+		float range = farZ / (farZ - nearZ);
+		return XMMatrixSet(w, 0, 0, 0, 0, h, 0, 0, 0, 0, range, 1, 0, 0, -range * nearZ, 0);
+	}
+
+	inline XMMATRIX XMMatrixOrthographicLH(float width, float height, float nearZ, float farZ)
+	{
+		float range = 1.0f / (farZ - nearZ);
+		return XMMatrixSet(2.0f / width, 0, 0, 0, 0, 2.0f / height, 0, 0, 0, 0, range, 0, 0, 0, -range * nearZ, 1);
+	}
+
+	inline XMMATRIX XMMatrixLookToLH(FXMVECTOR eye, FXMVECTOR direction, FXMVECTOR up)
+	{
+		XMVECTOR r2 = XMVector3Normalize(direction);
+		XMVECTOR r0 = XMVector3Normalize(XMVector3Cross(up, r2));
+		XMVECTOR r1 = XMVector3Cross(r2, r0);
+		XMVECTOR negEye = -eye;
+		return XMMatrixSet(
+			r0.v[0], r1.v[0], r2.v[0], 0,
+			r0.v[1], r1.v[1], r2.v[1], 0,
+			r0.v[2], r1.v[2], r2.v[2], 0,
+			XMVectorGetX(XMVector3Dot(r0, negEye)), XMVectorGetX(XMVector3Dot(r1, negEye)), XMVectorGetX(XMVector3Dot(r2, negEye)), 1);
+	}
+
+	inline XMVECTOR XMVector4Transform(FXMVECTOR v, FXMMATRIX m)
+	{
+		XMVECTOR result;
+		for (int j = 0; j < 4; j++)
+			result.v[j] = v.v[0] * m.r[0].v[j] + v.v[1] * m.r[1].v[j] + v.v[2] * m.r[2].v[j] + v.v[3] * m.r[3].v[j];
+		return result;
+	}
+
+	inline XMVECTOR XMVector3TransformCoord(FXMVECTOR v, FXMMATRIX m)
+	{
+		XMVECTOR result = XMVector4Transform(XMVectorSet(v.v[0], v.v[1], v.v[2], 1), m);
+		return result * (1.0f / result.v[3]);
+	}
+
+	inline XMVECTOR XMVector3TransformNormal(FXMVECTOR v, FXMMATRIX m)
+	{
+		return XMVector4Transform(XMVectorSet(v.v[0], v.v[1], v.v[2], 0), m);
+	}
+
+	// --------------------------------------------------------
+	// Quaternions (x, y, z, w)
+	// --------------------------------------------------------
+
+	//angles are (pitch, yaw, roll), applied in the same order as XMMatrixRotationRollPitchYaw
+	inline XMVECTOR XMQuaternionRotationRollPitchYawFromVector(FXMVECTOR angles)
+	{
+		float sp = sinf(angles.v[0] * 0.5f), cp = cosf(angles.v[0] * 0.5f);
+		float sy = sinf(angles.v[1] * 0.5f), cy = cosf(angles.v[1] * 0.5f);
+		float sr = sinf(angles.v[2] * 0.5f), cr = cosf(angles.v[2] * 0.5f);
+		return XMVectorSet(
+			sp * cy * cr + cp * sy * sr,
+			cp * sy * cr - sp * cy * sr,
+			cp * cy * sr - sp * sy * cr,
+			cp * cy * cr + sp * sy * sr);
+	}
+
+	inline XMVECTOR XMVector3Rotate(FXMVECTOR v, FXMVECTOR q)
+	{
+		XMVECTOR result = XMVector3TransformNormal(v, XMMatrixRotationQuaternion(q));
+		result.v[3] = 0;
+		return result;
+	}
+
+	inline XMVECTOR XMQuaternionSlerp(FXMVECTOR q0, FXMVECTOR q1, float t)
+	{
+		float cosOmega = q0.v[0] * q1.v[0] + q0.v[1] * q1.v[1] + q0.v[2] * q1.v[2] + q0.v[3] * q1.v[3];
+		float sign = cosOmega < 0.0f ? -1.0f : 1.0f;
+		cosOmega *= sign;
+
+		float s0 = 1.0f - t;
+		float s1 = t;
+		if (1.0f - cosOmega > 1e-5f) {
+			float omega = acosf(cosOmega);
+			float sinOmega = sinf(omega);
+			s0 = sinf(s0 * omega) / sinOmega;
+			s1 = sinf(s1 * omega) / sinOmega;
+		}
+		return q0 * s0 + q1 * (s1 * sign);
+	}
+}
@@ -0,0 +1,4 @@
+#pragma once
+
+// Everything the stand-in covers lives in d3d11_1.h
+#include "d3d11_1.h"
@@ -0,0 +1,81 @@
+#pragma once
+
+// --------------------------------------------------------
+// Stand-in for the D3D11 headers on machines without the
+// Windows SDK.  Resources are empty types only ever handled
+// by pointer; the context declares just the calls
+// StateCache makes, as pure virtuals, so a test can record
+// what actually reaches the "device".
+// --------------------------------------------------------
+
+typedef unsigned int UINT;
+typedef unsigned long ULONG;
+typedef long HRESULT;
+
+#define S_OK ((HRESULT)0)
+#define E_NOINTERFACE ((HRESULT)0x80004002L)
+
+#define D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT 14
+#define D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT 128
+#define D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT 16
+
+enum DXGI_FORMAT
+{
+	DXGI_FORMAT_UNKNOWN = 0,
+	DXGI_FORMAT_R32_UINT = 42,
+	DXGI_FORMAT_R16_UINT = 57
+};
+
+enum D3D11_PRIMITIVE_TOPOLOGY
+{
+	D3D11_PRIMITIVE_TOPOLOGY_UNDEFINED = 0,
+	D3D11_PRIMITIVE_TOPOLOGY_LINELIST = 2,
+	D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST = 4
+};
+
+struct IUnknown
+{
+	virtual ~IUnknown() {}
+	virtual ULONG Release() { return 0; }
+};
+
+struct ID3D11DeviceChild : IUnknown {};
+struct ID3D11InputLayout : ID3D11DeviceChild {};
+struct ID3D11Buffer : ID3D11DeviceChild {};
+struct ID3D11VertexShader : ID3D11DeviceChild {};
+struct ID3D11PixelShader : ID3D11DeviceChild {};
+struct ID3D11ShaderResourceView : ID3D11DeviceChild {};
+struct ID3D11SamplerState : ID3D11DeviceChild {};
+struct ID3D11ClassInstance : ID3D11DeviceChild {};
+
+struct ID3D11DeviceContext1;
+
+struct ID3D11DeviceContext : ID3D11DeviceChild
+{
+	//the only interface anything asks a context for
+	virtual HRESULT QueryInterface(ID3D11DeviceContext1** context1) = 0;
+
+	virtual void IASetInputLayout(ID3D11InputLayout* layout) = 0;
+	virtual void IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology) = 0;
+	virtual void IASetVertexBuffers(UINT startSlot, UINT count, ID3D11Buffer* const* buffers, const UINT* strides, const UINT* offsets) = 0;
+	virtual void IASetIndexBuffer(ID3D11Buffer* buffer, DXGI_FORMAT format, UINT offset) = 0;
+
+	virtual void VSSetShader(ID3D11VertexShader* shader, ID3D11ClassInstance* const* classInstances, UINT classInstanceCount) = 0;
+	virtual void VSSetConstantBuffers(UINT startSlot, UINT count, ID3D11Buffer* const* buffers) = 0;
+	virtual void VSSetShaderResources(UINT startSlot, UINT count, ID3D11ShaderResourceView* const* srvs) = 0;
+	virtual void VSSetSamplers(UINT startSlot, UINT count, ID3D11SamplerState* const* samplers) = 0;
+
+	virtual void PSSetShader(ID3D11PixelShader* shader, ID3D11ClassInstance* const* classInstances, UINT classInstanceCount) = 0;
+	virtual void PSSetConstantBuffers(UINT startSlot, UINT count, ID3D11Buffer* const* buffers) = 0;
+	virtual void PSSetShaderResources(UINT startSlot, UINT count, ID3D11ShaderResourceView* const* srvs) = 0;
+	virtual void PSSetSamplers(UINT startSlot, UINT count, ID3D11SamplerState* const* samplers) = 0;
+};
+
+struct ID3D11DeviceContext1 : ID3D11DeviceContext
+{
+	virtual void VSSetConstantBuffers1(UINT startSlot, UINT count, ID3D11Buffer* const* buffers, const UINT* firstConstant, const UINT* numConstants) = 0;
+	virtual void PSSetConstantBuffers1(UINT startSlot, UINT count, ID3D11Buffer* const* buffers, const UINT* firstConstant, const UINT* numConstants) = 0;
+};
+
+//the real macro expands to an IID and a void**; here the typed pointer is enough
+#define IID_PPV_ARGS(pp) (pp)
@@ -0,0 +1,30 @@
+#pragma once
+
+// --------------------------------------------------------
+// Stand-in for WRL's ComPtr on machines without the Windows
+// SDK - just enough of the interface for the engine code
+// under test.  No reference counting: test objects outlive
+// every pointer to them.
+// --------------------------------------------------------
+namespace Microsoft
+{
+	namespace WRL
+	{
+		template<typename T>
+		class ComPtr
+		{
+		public:
+			ComPtr() : pointer(nullptr) {}
+			ComPtr(T* pointer) : pointer(pointer) {}
+
+			T* Get() const { return pointer; }
+			T** GetAddressOf() { return &pointer; }
+			T* operator->() const { return pointer; }
+			explicit operator bool() const { return pointer != nullptr; }
+			bool operator!() const { return pointer == nullptr; }
+
+		private:
+			T* pointer;
+		};
+	}
+}
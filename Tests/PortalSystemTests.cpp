@@ -0,0 +1,208 @@
+#include "Test.h"
+
+#include "PortalSystem.h"
+
+//C++
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+using namespace DirectX;
+
+namespace
+{
+	const float RoomSize = 10.0f;
+	const float RoomHeight = 4.0f;
+	const float DoorHalfWidth = 1.0f;
+	const float DoorHeight = 2.5f;
+
+	// --------------------------------------------------------
+	// width x depth rooms on the xz plane, each joined to its
+	// neighbours by a doorway in the middle of the shared wall.
+	// Cell index = x + z * width.
+	// --------------------------------------------------------
+	void BuildRoomGrid(PortalSystem& portals, int width, int depth)
+	{
+		for (int z = 0; z < depth; z++) {
+			for (int x = 0; x < width; x++) {
+				portals.AddCell({ XMFLOAT3(x * RoomSize, 0.0f, z * RoomSize), XMFLOAT3((x + 1) * RoomSize, RoomHeight, (z + 1) * RoomSize) });
+			}
+		}
+
+		for (int z = 0; z < depth; z++) {
+			for (int x = 0; x < width; x++) {
+				float cx = (x + 0.5f) * RoomSize;
+				float cz = (z + 0.5f) * RoomSize;
+
+				if (x + 1 < width) {
+					float wall = (x + 1) * RoomSize;
+					portals.AddPortal(x + z * width, x + 1 + z * width, {
+						XMFLOAT3(wall, 0.0f, cz - DoorHalfWidth), XMFLOAT3(wall, DoorHeight, cz - DoorHalfWidth),
+						XMFLOAT3(wall, DoorHeight, cz + DoorHalfWidth), XMFLOAT3(wall, 0.0f, cz + DoorHalfWidth) });
+				}
+				if (z + 1 < depth) {
+					float wall = (z + 1) * RoomSize;
+					portals.AddPortal(x + z * width, x + (z + 1) * width, {
+						XMFLOAT3(cx - DoorHalfWidth, 0.0f, wall), XMFLOAT3(cx - DoorHalfWidth, DoorHeight, wall),
+						XMFLOAT3(cx + DoorHalfWidth, DoorHeight, wall), XMFLOAT3(cx + DoorHalfWidth, 0.0f, wall) });
+				}
+			}
+		}
+	}
+
+	XMFLOAT4 PlaneThrough(XMFLOAT3 normal, XMFLOAT3 point)
+	{
+		float length = sqrtf(normal.x * normal.x + normal.y * normal.y + normal.z * normal.z);
+		normal = XMFLOAT3(normal.x / length, normal.y / length, normal.z / length);
+		return XMFLOAT4(normal.x, normal.y, normal.z, -(normal.x * point.x + normal.y * point.y + normal.z * point.z));
+	}
+
+	// --------------------------------------------------------
+	// 90 degree frustum from eye looking along (dx, 0, dz),
+	// with the far plane last as the camera builds it
+	// --------------------------------------------------------
+	Frustum LookAlong(XMFLOAT3 eye, float dx, float dz, float farDistance)
+	{
+		XMFLOAT3 side(dz, 0.0f, -dx);
+
+		Frustum frustum;
+		frustum.planes[0] = PlaneThrough(XMFLOAT3(dx + side.x, 0.0f, dz + side.z), eye);
+		frustum.planes[1] = PlaneThrough(XMFLOAT3(dx - side.x, 0.0f, dz - side.z), eye);
+		frustum.planes[2] = PlaneThrough(XMFLOAT3(dx, 1.0f, dz), eye);
+		frustum.planes[3] = PlaneThrough(XMFLOAT3(dx, -1.0f, dz), eye);
+		frustum.planes[4] = PlaneThrough(XMFLOAT3(dx, 0.0f, dz), eye);
+		frustum.planes[5] = PlaneThrough(XMFLOAT3(-dx, 0.0f, -dz), XMFLOAT3(eye.x + dx * farDistance, eye.y, eye.z + dz * farDistance));
+		return frustum;
+	}
+
+	AABB Box(XMFLOAT3 center, float halfSize)
+	{
+		return { XMFLOAT3(center.x - halfSize, center.y - halfSize, center.z - halfSize), XMFLOAT3(center.x + halfSize, center.y + halfSize, center.z + halfSize) };
+	}
+}
+
+TEST(PortalFindCellsReturnsEveryOverlap)
+{
+	PortalSystem portals;
+	BuildRoomGrid(portals, 2, 2);
+
+	std::vector<int> cells;
+	portals.FindCells(Box(XMFLOAT3(5, 1, 5), 1.0f), cells);
+	CHECK(cells.size() == 1 && cells[0] == 0);
+
+	//straddles the wall between rooms 0 and 1
+	portals.FindCells(Box(XMFLOAT3(10, 1, 5), 1.0f), cells);
+	CHECK(cells.size() == 2 && cells[0] == 0 && cells[1] == 1);
+
+	//the corner all four rooms share
+	portals.FindCells(Box(XMFLOAT3(10, 1, 10), 1.0f), cells);
+	CHECK(cells.size() == 4);
+
+	portals.FindCells(Box(XMFLOAT3(50, 1, 50), 1.0f), cells);
+	CHECK(cells.empty());
+}
+
+// The cell tree has to give exactly what a scan over every cell would
+TEST(PortalFindCellsMatchesScan)
+{
+	const int size = 16;
+	PortalSystem portals;
+	BuildRoomGrid(portals, size, size);
+
+	std::mt19937 random(7);
+	std::uniform_real_distribution<float> position(-5.0f, size * RoomSize + 5.0f);
+	std::uniform_real_distribution<float> halfSize(0.0f, 8.0f);
+
+	std::vector<int> cells;
+	for (int i = 0; i < 1000; i++) {
+		AABB box = Box(XMFLOAT3(position(random), 1.0f, position(random)), halfSize(random));
+		portals.FindCells(box, cells);
+
+		std::vector<int> expected;
+		for (int z = 0; z < size; z++) {
+			for (int x = 0; x < size; x++) {
+				AABB room = { XMFLOAT3(x * RoomSize, 0.0f, z * RoomSize), XMFLOAT3((x + 1) * RoomSize, RoomHeight, (z + 1) * RoomSize) };
+				if (AABBOverlaps(room, box))
+					expected.push_back(x + z * size);
+			}
+		}
+		std::sort(expected.begin(), expected.end());
+		CHECK(cells == expected);
+
+		//the first room holding the center, or none outside the grid
+		XMFLOAT3 center = AABBCenter(box);
+		int cell = portals.FindCell(center);
+		int x = (int)floorf(center.x / RoomSize);
+		int z = (int)floorf(center.z / RoomSize);
+		CHECK(cell == (x >= 0 && x < size && z >= 0 && z < size ? x + z * size : -1));
+	}
+}
+
+TEST(PortalVisibilityFollowsDoorways)
+{
+	PortalSystem portals;
+	BuildRoomGrid(portals, 3, 3);
+	XMFLOAT3 eye(1.0f, 1.5f, 5.0f);
+
+	//down the corridor of doorways in the first row
+	portals.ComputeVisibleCells(eye, LookAlong(eye, 1.0f, 0.0f, 100.0f));
+	CHECK(portals.IsCellVisible(0));
+	CHECK(portals.IsCellVisible(1));
+	CHECK(portals.IsCellVisible(2));
+	CHECK(!portals.IsCellVisible(4));
+	CHECK(!portals.IsCellVisible(8));
+
+	//facing the outer wall, nothing but the room itself
+	portals.ComputeVisibleCells(eye, LookAlong(eye, -1.0f, 0.0f, 100.0f));
+	CHECK(portals.GetVisibleCells().size() == 1);
+	CHECK(portals.IsCellVisible(0));
+
+	//an entity across rooms 1 and 4 is kept through room 1 alone
+	portals.ComputeVisibleCells(eye, LookAlong(eye, 1.0f, 0.0f, 100.0f));
+	std::vector<int> cells;
+	portals.FindCells(Box(XMFLOAT3(15, 1, 10), 1.0f), cells);
+	CHECK(cells.size() == 2);
+	CHECK(portals.IsAnyCellVisible(cells));
+
+	//one wholly in the rooms behind the walls isn't
+	portals.FindCells(Box(XMFLOAT3(15, 1, 25), 1.0f), cells);
+	CHECK(!portals.IsAnyCellVisible(cells));
+}
+
+// --------------------------------------------------------
+// Portal traversal and cell assignment on room grids, with
+// the camera in a corner room looking diagonally across
+// --------------------------------------------------------
+BENCHMARK(PortalRoomGridBenchmark)
+{
+	const int sizes[] = { 8, 16, 32 };
+	for (int size : sizes) {
+		PortalSystem portals;
+		BuildRoomGrid(portals, size, size);
+
+		XMFLOAT3 eye(2.0f, 1.5f, 2.0f);
+		Frustum frustum = LookAlong(eye, 0.7071f, 0.7071f, size * RoomSize * 2.0f);
+		double traverse = TimePerCall([&]() { portals.ComputeVisibleCells(eye, frustum); });
+
+		//one box per room, a quarter of them straddling a wall
+		std::mt19937 random(3);
+		std::uniform_real_distribution<float> position(0.0f, size * RoomSize);
+		std::vector<AABB> boxes(size * size * 4);
+		for (AABB& box : boxes)
+			box = Box(XMFLOAT3(position(random), 1.0f, position(random)), 0.5f);
+
+		std::vector<int> cells;
+		unsigned int kept = 0;
+		double assign = TimePerCall([&]() {
+			kept = 0;
+			for (const AABB& box : boxes) {
+				portals.FindCells(box, cells);
+				kept += portals.IsAnyCellVisible(cells);
+			}
+		});
+
+		printf("  %2dx%-2d rooms: traverse %8.2f us (%u cells, %u portals), reassign %6.1f ns per moved entity, %u of %u entities kept\n",
+			size, size, traverse * 1e6, (unsigned int)portals.GetVisibleCells().size(), portals.GetPortalsTraversed(),
+			assign * 1e9 / boxes.size(), kept, (unsigned int)boxes.size());
+	}
+}
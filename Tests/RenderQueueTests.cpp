@@ -0,0 +1,136 @@
+#include "Test.h"
+
+#include "RenderQueue.h"
+
+//C++
+#include <algorithm>
+#include <random>
+
+namespace
+{
+	// --------------------------------------------------------
+	// Keys like a real frame's: a few shaders, materials and
+	// meshes (so lots of equal keys once depth collides) and
+	// entity = submission order, so stability shows
+	// --------------------------------------------------------
+	std::vector<RenderPacket> RandomPackets(unsigned int count, unsigned int seed)
+	{
+		std::mt19937 random(seed);
+		std::uniform_int_distribution<unsigned int> pass(0, 1);
+		std::uniform_int_distribution<unsigned int> shader(0, 7);
+		std::uniform_int_distribution<unsigned int> material(0, 63);
+		std::uniform_int_distribution<unsigned int> mesh(0, 255);
+		std::uniform_real_distribution<float> depth(0.0f, 1.0f);
+
+		std::vector<RenderPacket> packets(count);
+		for (unsigned int i = 0; i < count; i++)
+			packets[i] = { RenderQueue::MakeKey(pass(random), shader(random), material(random), mesh(random), depth(random)), i };
+		return packets;
+	}
+
+	void StableSort(std::vector<RenderPacket>& packets)
+	{
+		std::stable_sort(packets.begin(), packets.end(), [](const RenderPacket& a, const RenderPacket& b) { return a.key < b.key; });
+	}
+
+	bool SameOrder(const std::vector<RenderPacket>& a, const std::vector<RenderPacket>& b)
+	{
+		if (a.size() != b.size())
+			return false;
+		for (size_t i = 0; i < a.size(); i++) {
+			if (a[i].key != b[i].key || a[i].entity != b[i].entity)
+				return false;
+		}
+		return true;
+	}
+}
+
+// --------------------------------------------------------
+// Same order as std::stable_sort - ties included - on one
+// thread and split across a pool, below and above the size
+// where slices start
+// --------------------------------------------------------
+TEST(RenderQueueRadixSortMatchesStableSort)
+{
+	ThreadPool pool(3);
+	for (unsigned int count : { 0u, 1u, 2u, 1000u, 70000u, 300001u }) {
+		std::vector<RenderPacket> expected = RandomPackets(count, count + 1);
+		std::vector<RenderPacket> serial = expected;
+		std::vector<RenderPacket> pooled = expected;
+		StableSort(expected);
+
+		std::vector<RenderPacket> scratch;
+		RenderQueue::RadixSort(serial, scratch);
+		RenderQueue::RadixSort(pooled, scratch, &pool);
+		CHECK(SameOrder(serial, expected));
+		CHECK(SameOrder(pooled, expected));
+	}
+
+	//every key equal: every pass is skipped and submission order stays
+	std::vector<RenderPacket> equal(100000, { 42, 0 });
+	for (unsigned int i = 0; i < equal.size(); i++)
+		equal[i].entity = i;
+	std::vector<RenderPacket> scratch;
+	RenderQueue::RadixSort(equal, scratch, &pool);
+	bool ordered = true;
+	for (unsigned int i = 0; i < equal.size(); i++)
+		ordered = ordered && equal[i].entity == i;
+	CHECK(ordered);
+
+	//and through the queue itself
+	RenderQueue queue(4);
+	std::vector<RenderPacket> packets = RandomPackets(100000, 5);
+	for (const RenderPacket& packet : packets)
+		queue.Add(packet.key, packet.entity);
+	queue.Sort();
+	StableSort(packets);
+	CHECK(SameOrder(queue.GetPackets(), packets));
+}
+
+TEST(RenderQueueShaderIDsAreExact)
+{
+	RenderQueue queue(1);
+	const void* vs = (const void*)0x1000;
+	const void* ps = (const void*)0x2000;
+
+	//a different pair that the old vs * 31 ^ ps hash sent to the same value
+	uintptr_t otherVS = 0x1040;
+	uintptr_t otherPS = (0x1000 * 31 ^ 0x2000) ^ (otherVS * 31);
+
+	unsigned int a = queue.GetShaderID(vs, ps);
+	unsigned int b = queue.GetShaderID((const void*)otherVS, (const void*)otherPS);
+	unsigned int c = queue.GetShaderID(ps, vs);
+	CHECK(a != b);
+	CHECK(a != c && b != c);
+	CHECK(queue.GetShaderID(vs, ps) == a);
+	CHECK(queue.GetShaderID((const void*)otherVS, (const void*)otherPS) == b);
+}
+
+// --------------------------------------------------------
+// 1M packets: std::stable_sort against the radix sort on
+// this thread and across pools of different sizes
+// --------------------------------------------------------
+BENCHMARK(RenderQueueSort1M)
+{
+	const unsigned int count = 1000000;
+	std::vector<RenderPacket> source = RandomPackets(count, 7);
+	std::vector<RenderPacket> packets;
+	std::vector<RenderPacket> scratch;
+
+	double stable = TimePerCall([&]() {
+		packets = source;
+		StableSort(packets);
+	});
+	printf("  std::stable_sort      : %7.2f ms\n", stable * 1e3);
+
+	double copy = TimePerCall([&]() { packets = source; });
+	for (unsigned int threadCount : { 1u, 2u, 4u, 8u }) {
+		ThreadPool pool(threadCount - 1);
+		double radix = TimePerCall([&]() {
+			packets = source;
+			RenderQueue::RadixSort(packets, scratch, &pool);
+		});
+		radix -= copy;
+		printf("  RadixSort, %u thread%s : %7.2f ms (%.1fx)\n", threadCount, threadCount == 1 ? " " : "s", radix * 1e3, (stable - copy) / radix);
+	}
+}
@@ -0,0 +1,102 @@
+#include "Test.h"
+
+#include "RingAllocator.h"
+
+//C++
+#include <vector>
+
+TEST(RingAllocatorAlignsAndAdvances)
+{
+	RingAllocator ring(1024, 256);
+	unsigned int offset;
+	bool wrapped;
+
+	CHECK(ring.Allocate(16, &offset, &wrapped) && offset == 0 && !wrapped);
+	CHECK(ring.Allocate(300, &offset, &wrapped) && offset == 256 && !wrapped);
+	CHECK(ring.GetUsed() == 768);
+	CHECK(!ring.Allocate(0, &offset, &wrapped));
+}
+
+TEST(RingAllocatorFullUntilRetired)
+{
+	RingAllocator ring(1024, 256);
+	unsigned int offset;
+	bool wrapped;
+
+	for (int i = 0; i < 4; i++)
+		CHECK(ring.Allocate(256, &offset, &wrapped) && offset == 256u * i);
+	ring.EndFrame(0);
+
+	//head has caught up with the tail, so a full ring must not look empty
+	CHECK(ring.GetUsed() == 1024);
+	CHECK(!ring.Allocate(16, &offset, &wrapped));
+
+	ring.RetireFrames(0);
+	CHECK(ring.GetUsed() == 0);
+	CHECK(ring.GetFenceCount() == 0);
+	CHECK(ring.Allocate(1024, &offset, &wrapped) && offset == 0);
+}
+
+TEST(RingAllocatorWrapsOnlyOverRetiredFrames)
+{
+	RingAllocator ring(1024, 256);
+	unsigned int offset;
+	bool wrapped;
+
+	//frame 0: [0, 512), frame 1: [512, 768)
+	CHECK(ring.Allocate(512, &offset, &wrapped) && offset == 0);
+	ring.EndFrame(0);
+	CHECK(ring.Allocate(256, &offset, &wrapped) && offset == 512);
+	ring.EndFrame(1);
+
+	//frame 2 doesn't fit in the last 256 bytes, and frame 0 still holds the start
+	CHECK(!ring.Allocate(512, &offset, &wrapped));
+
+	ring.RetireFrames(0);
+	CHECK(ring.GetUsed() == 256);
+
+	//now it wraps, and the skipped end counts as used until frame 2 retires
+	CHECK(ring.Allocate(512, &offset, &wrapped) && offset == 0 && wrapped);
+	CHECK(ring.GetUsed() == 1024);
+	CHECK(!ring.Allocate(256, &offset, &wrapped));
+	ring.EndFrame(2);
+
+	//frame 1 going frees [512, 768) only - the skipped end went with frame 2
+	ring.RetireFrames(1);
+	CHECK(ring.GetUsed() == 768);
+	CHECK(!ring.Allocate(512, &offset, &wrapped));
+	CHECK(ring.Allocate(256, &offset, &wrapped) && offset == 512 && !wrapped);
+
+	ring.RetireFrames(2);
+	CHECK(ring.GetUsed() == 256);
+	CHECK(ring.GetFenceCount() == 0);
+}
+
+TEST(RingAllocatorNeverOverlapsLiveFrames)
+{
+	//many frames of odd-sized allocations, with up to two frames in flight
+	RingAllocator ring(4096, 256);
+	struct Slice { unsigned int offset, size; uint64_t frame; };
+	std::vector<Slice> live;
+
+	for (uint64_t frame = 0; frame < 200; frame++) {
+		if (frame >= 2) {
+			ring.RetireFrames(frame - 2);
+			std::erase_if(live, [&](const Slice& s) { return s.frame <= frame - 2; });
+		}
+
+		for (unsigned int i = 0; i < 1 + frame % 5; i++) {
+			unsigned int size = 100 + (unsigned int)((frame * 37 + i * 91) % 600);
+			unsigned int offset;
+			bool wrapped;
+			if (!ring.Allocate(size, &offset, &wrapped))
+				continue;
+
+			CHECK(offset % 256 == 0 && offset + size <= 4096);
+			for (const Slice& s : live)
+				CHECK(offset + size <= s.offset || s.offset + s.size <= offset);
+			live.push_back({ offset, size, frame });
+		}
+		ring.EndFrame(frame);
+	}
+}
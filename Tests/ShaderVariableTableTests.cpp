@@ -0,0 +1,101 @@
+#include "Test.h"
+
+#include "ShaderVariableTable.h"
+
+namespace
+{
+	//FNV-1a collides on these two
+	const char* collidingA = "var519433";
+	const char* collidingB = "var1027180";
+
+	SimpleShaderVariable Variable(unsigned int offset, unsigned int size)
+	{
+		return SimpleShaderVariable{ offset, size, 0 };
+	}
+}
+
+TEST(ShaderVariableTableFindsByNameAndHash)
+{
+	ShaderVariableTable table;
+	table.Add("world", Variable(0, 64));
+	table.Add("colorTint", Variable(64, 16));
+
+	SimpleShaderVariable* byName = table.Find(std::string("colorTint"));
+	SimpleShaderVariable* byHash = table.Find(SimpleShaderName("colorTint"));
+	CHECK(byName && byName == byHash && byName->ByteOffset == 64);
+
+	CHECK(!table.Find(std::string("roughness")));
+	CHECK(!table.Find(SimpleShaderName("roughness")));
+}
+
+TEST(ShaderVariableTableHashHitChecksName)
+{
+	CHECK(SimpleShaderHash(collidingA) == SimpleShaderHash(collidingB));
+
+	//only one of the pair is in the shader, so the other must not find it
+	ShaderVariableTable table;
+	table.Add(collidingA, Variable(16, 4));
+	CHECK(table.Find(SimpleShaderName(collidingA)) != nullptr);
+	CHECK(table.Find(SimpleShaderName(collidingB)) == nullptr);
+}
+
+TEST(ShaderVariableTableCollidingNamesBothFound)
+{
+	ShaderVariableTable table;
+	table.Add(collidingA, Variable(16, 4));
+	table.Add(collidingB, Variable(32, 8));
+
+	SimpleShaderVariable* a = table.Find(SimpleShaderName(collidingA));
+	SimpleShaderVariable* b = table.Find(SimpleShaderName(collidingB));
+	CHECK(a && a->ByteOffset == 16);
+	CHECK(b && b->ByteOffset == 32);
+
+	table.Clear();
+	CHECK(!table.Find(SimpleShaderName(collidingA)));
+}
+
+// --------------------------------------------------------
+// The three ways a draw can set a variable, for a table
+// the size of the material shaders': by std::string (what
+// SetData(std::string, ...) does), by precomputed name,
+// and through a handle resolved ahead of time (no lookup)
+// --------------------------------------------------------
+BENCHMARK(ShaderVariableLookupBenchmark)
+{
+	const char* names[] = { "world", "worldInvTranspose", "view", "projection", "colorTint", "uvScale",
+		"uvOffset", "roughness", "lightCount", "lightIndices", "cameraPosition", "ambient" };
+	const unsigned int nameCount = sizeof(names) / sizeof(names[0]);
+
+	ShaderVariableTable table;
+	for (unsigned int i = 0; i < nameCount; i++)
+		table.Add(names[i], Variable(i * 16, 16));
+
+	const SimpleShaderName hashed[] = {
+		SimpleShaderName("world"), SimpleShaderName("worldInvTranspose"), SimpleShaderName("view"),
+		SimpleShaderName("projection"), SimpleShaderName("colorTint"), SimpleShaderName("uvScale"),
+		SimpleShaderName("uvOffset"), SimpleShaderName("roughness"), SimpleShaderName("lightCount"),
+		SimpleShaderName("lightIndices"), SimpleShaderName("cameraPosition"), SimpleShaderName("ambient") };
+
+	SimpleShaderVariable* resolved[nameCount];
+	for (unsigned int i = 0; i < nameCount; i++)
+		resolved[i] = table.Find(hashed[i]);
+
+	const unsigned int lookups = 120000;
+	volatile unsigned int sink = 0;
+
+	double byString = TimePerCall([&]() {
+		for (unsigned int i = 0; i < lookups; i++)
+			sink = sink + table.Find(std::string(names[i % nameCount]))->ByteOffset;
+	});
+	double byHash = TimePerCall([&]() {
+		for (unsigned int i = 0; i < lookups; i++)
+			sink = sink + table.Find(hashed[i % nameCount])->ByteOffset;
+	});
+	double byHandle = TimePerCall([&]() {
+		for (unsigned int i = 0; i < lookups; i++)
+			sink = sink + resolved[i % nameCount]->ByteOffset;
+	});
+
+	printf("  std::string %.2f ns, SimpleShaderName %.2f ns, handle %.2f ns per lookup\n",
+		byString * 1e9 / lookups, byHash * 1e9 / lookups, byHandle * 1e9 / lookups);
+}
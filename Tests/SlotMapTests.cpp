@@ -0,0 +1,77 @@
+#include "Test.h"
+
+#include "SlotMap.h"
+#include "Transform.h"
+
+namespace
+{
+	struct Item
+	{
+		int value;
+		Item(int value) : value(value) {}
+	};
+}
+
+TEST(SlotMapRejectsStaleHandleAfterReuse)
+{
+	SlotMap<Item> items;
+	Handle<Item> a = items.Emplace(1);
+	Handle<Item> b = items.Emplace(2);
+
+	items.Remove(a);
+	CHECK(!items.Contains(a));
+	CHECK(items.Size() == 1);
+
+	//the freed slot is reused, but under a new generation
+	Handle<Item> c = items.Emplace(3);
+	CHECK(c.index == a.index);
+	CHECK(c.generation != a.generation);
+	CHECK(c != a);
+
+	CHECK(!items.Contains(a));
+	CHECK(items.Contains(c));
+	CHECK(items.Get(c)->value == 3);
+	CHECK(items.Get(b)->value == 2);
+
+	//a null handle is never contained, and Get() on it just returns null
+	Handle<Item> null;
+	CHECK(null.IsNull());
+	CHECK(!items.Contains(null));
+	CHECK(items.Get(null) == nullptr);
+}
+
+TEST(SlotMapEachVisitsOnlyLiveObjects)
+{
+	SlotMap<Item> items;
+	Handle<Item> handles[5];
+	for (int i = 0; i < 5; i++)
+		handles[i] = items.Emplace(i);
+	items.Remove(handles[1]);
+	items.Remove(handles[3]);
+
+	int sum = 0;
+	int visited = 0;
+	items.Each([&](Handle<Item> handle, Item& item) {
+		CHECK(items.Get(handle) == &item);
+		sum += item.value;
+		visited++;
+	});
+	CHECK(visited == 3);
+	CHECK(sum == 0 + 2 + 4);
+}
+
+// Transforms can't be moved (the changed list points at them), so
+// they're only storable if growing the map leaves objects in place
+TEST(SlotMapObjectsStayPutAsItGrows)
+{
+	SlotMap<Transform> transforms;
+	Handle<Transform> first = transforms.Emplace(1.0f, 2.0f, 3.0f);
+	Transform* address = transforms.Get(first);
+
+	for (int i = 0; i < 10000; i++)
+		transforms.Emplace((float)i, 0.0f, 0.0f);
+
+	CHECK(transforms.Get(first) == address);
+	CHECK(address->GetPosition().y == 2.0f);
+	Transform::ClearChangedThisFrame();
+}
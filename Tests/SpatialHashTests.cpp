@@ -0,0 +1,129 @@
+#include "Test.h"
+
+#include "SpatialHash.h"
+
+//C++
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <limits>
+#include <random>
+
+using namespace DirectX;
+
+namespace
+{
+	std::vector<int> BruteForce(const std::vector<XMFLOAT3>& points, XMFLOAT3 center, float radius)
+	{
+		std::vector<int> result;
+		for (int i = 0; i < (int)points.size(); i++) {
+			float dx = points[i].x - center.x, dy = points[i].y - center.y, dz = points[i].z - center.z;
+			if (dx * dx + dy * dy + dz * dz <= radius * radius)
+				result.push_back(i);
+		}
+		return result;
+	}
+
+	std::vector<int> Query(SpatialHash& hash, XMFLOAT3 center, float radius)
+	{
+		std::vector<int> result;
+		hash.QueryRadius(center, radius, result);
+		std::sort(result.begin(), result.end());
+		return result;
+	}
+
+	std::vector<XMFLOAT3> RandomPoints(unsigned int count, float extent, unsigned int seed)
+	{
+		std::mt19937 random(seed);
+		std::uniform_real_distribution<float> position(-extent, extent);
+		std::vector<XMFLOAT3> points(count);
+		for (XMFLOAT3& p : points)
+			p = XMFLOAT3(position(random), position(random), position(random));
+		return points;
+	}
+}
+
+TEST(SpatialHashMatchesBruteForce)
+{
+	std::vector<XMFLOAT3> points = RandomPoints(2000, 100.0f, 5);
+	SpatialHash hash(4.0f);
+	for (int i = 0; i < (int)points.size(); i++)
+		hash.Insert(points[i], i);
+
+	std::mt19937 random(6);
+	std::uniform_real_distribution<float> position(-120.0f, 120.0f);
+	std::uniform_real_distribution<float> radius(0.0f, 30.0f);
+	for (int q = 0; q < 200; q++) {
+		XMFLOAT3 center(position(random), position(random), position(random));
+		float r = radius(random);
+		CHECK(Query(hash, center, r) == BruteForce(points, center, r));
+	}
+}
+
+TEST(SpatialHashHugeRadiiAndPositions)
+{
+	const float infinity = std::numeric_limits<float>::infinity();
+
+	//points far past what a cell key can hold end up in the edge cells
+	std::vector<XMFLOAT3> points = {
+		XMFLOAT3(0, 0, 0), XMFLOAT3(5, 5, 5), XMFLOAT3(1e30f, 0, 0), XMFLOAT3(-1e30f, -1e30f, 2.0f), XMFLOAT3(FLT_MAX, 0, 0) };
+
+	//enough filler that small queries go through the cells rather than a scan
+	for (int i = 0; i < 64; i++)
+		points.push_back(XMFLOAT3(-20.0f + i * 0.5f, 3.0f, -3.0f));
+
+	SpatialHash hash(1.0f);
+	for (int i = 0; i < (int)points.size(); i++)
+		hash.Insert(points[i], i);
+
+	CHECK(Query(hash, XMFLOAT3(0, 0, 0), infinity).size() == points.size());
+	CHECK(Query(hash, XMFLOAT3(0, 0, 0), FLT_MAX).size() == points.size());
+	CHECK(Query(hash, XMFLOAT3(0, 0, 0), 1e20f) == BruteForce(points, XMFLOAT3(0, 0, 0), 1e20f));
+
+	//small queries out at the far points still find them
+	CHECK(Query(hash, XMFLOAT3(1e30f, 0, 0), 1.0f) == std::vector<int>({ 2 }));
+	CHECK(Query(hash, XMFLOAT3(1e29f, 0, 0), 1.0f).empty());
+
+	//nonsense radii find nothing
+	CHECK(Query(hash, XMFLOAT3(0, 0, 0), -1.0f).empty());
+	CHECK(Query(hash, XMFLOAT3(0, 0, 0), std::numeric_limits<float>::quiet_NaN()).empty());
+	CHECK(Query(hash, XMFLOAT3(std::numeric_limits<float>::quiet_NaN(), 0, 0), 10.0f).empty());
+
+	//and moving a point to infinity and back is fine too
+	hash.Move(1, XMFLOAT3(infinity, 0, 0));
+	hash.Move(1, XMFLOAT3(5, 5, 5));
+	CHECK(Query(hash, XMFLOAT3(5, 5, 5), 0.5f) == std::vector<int>({ 1 }));
+}
+
+// --------------------------------------------------------
+// Light-range queries against 10k to 1M points at the same
+// density (the world grows with the count), from small
+// radii up to one that covers the world, against brute force
+// --------------------------------------------------------
+BENCHMARK(SpatialHashQueryBenchmark)
+{
+	for (unsigned int count : { 10000u, 100000u, 1000000u }) {
+		float extent = 200.0f * cbrtf(count / 10000.0f);
+		std::vector<XMFLOAT3> points = RandomPoints(count, extent, 9);
+		SpatialHash hash(4.0f);
+		double build = TimePerCall([&]() {
+			hash = SpatialHash(4.0f);
+			for (int i = 0; i < (int)points.size(); i++)
+				hash.Insert(points[i], i);
+		}, 0.0);
+		printf("  %7u points: insert %.1f ns/point, %d cells\n", count, build * 1e9 / count, hash.GetCellCount());
+
+		const float radii[] = { 2.0f, 8.0f, 32.0f, 1e6f, std::numeric_limits<float>::infinity() };
+		std::vector<int> result;
+		for (float radius : radii) {
+			double hashed = TimePerCall([&]() {
+				result.clear();
+				hash.QueryRadius(XMFLOAT3(10, 20, 30), radius, result);
+			}, 0.1);
+			size_t found = result.size();
+			double brute = TimePerCall([&]() { result = BruteForce(points, XMFLOAT3(10, 20, 30), radius); }, 0.1);
+
+			printf("    radius %-8g %10.2f us hashed, %10.2f us brute force (%zu found)\n", radius, hashed * 1e6, brute * 1e6, found);
+		}
+	}
+}
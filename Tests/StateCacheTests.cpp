@@ -0,0 +1,158 @@
+#include "Test.h"
+
+#include "StateCache.h"
+
+//C++
+#include <vector>
+
+namespace
+{
+	// --------------------------------------------------------
+	// Context that only counts what gets through to it
+	// --------------------------------------------------------
+	struct MockContext : ID3D11DeviceContext1
+	{
+		unsigned int calls = 0;
+		unsigned int queries = 0;
+		UINT lastFirstConstant = 0;
+
+		HRESULT QueryInterface(ID3D11DeviceContext1** context1) override { queries++; *context1 = this; return S_OK; }
+
+		void IASetInputLayout(ID3D11InputLayout*) override { calls++; }
+		void IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY) override { calls++; }
+		void IASetVertexBuffers(UINT, UINT, ID3D11Buffer* const*, const UINT*, const UINT*) override { calls++; }
+		void IASetIndexBuffer(ID3D11Buffer*, DXGI_FORMAT, UINT) override { calls++; }
+
+		void VSSetShader(ID3D11VertexShader*, ID3D11ClassInstance* const*, UINT) override { calls++; }
+		void VSSetConstantBuffers(UINT, UINT, ID3D11Buffer* const*) override { calls++; }
+		void VSSetShaderResources(UINT, UINT, ID3D11ShaderResourceView* const*) override { calls++; }
+		void VSSetSamplers(UINT, UINT, ID3D11SamplerState* const*) override { calls++; }
+
+		void PSSetShader(ID3D11PixelShader*, ID3D11ClassInstance* const*, UINT) override { calls++; }
+		void PSSetConstantBuffers(UINT, UINT, ID3D11Buffer* const*) override { calls++; }
+		void PSSetShaderResources(UINT, UINT, ID3D11ShaderResourceView* const*) override { calls++; }
+		void PSSetSamplers(UINT, UINT, ID3D11SamplerState* const*) override { calls++; }
+
+		void VSSetConstantBuffers1(UINT, UINT, ID3D11Buffer* const*, const UINT* first, const UINT*) override { calls++; lastFirstConstant = *first; }
+		void PSSetConstantBuffers1(UINT, UINT, ID3D11Buffer* const*, const UINT* first, const UINT*) override { calls++; lastFirstConstant = *first; }
+	};
+}
+
+TEST(StateCacheFiltersRepeatedBinds)
+{
+	MockContext context;
+	StateCache cache(&context);
+	ID3D11VertexShader vs;
+	ID3D11PixelShader ps;
+	ID3D11Buffer buffer;
+
+	cache.VSSetShader(&vs);
+	cache.VSSetShader(&vs);
+	cache.PSSetShader(&ps);
+	cache.PSSetShader(&ps);
+	cache.PSSetConstantBuffer(0, &buffer);
+	cache.PSSetConstantBuffer(0, &buffer);
+	cache.IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	cache.IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
+	CHECK(context.calls == 4);
+	CHECK(cache.GetIssuedCount() == 4);
+	CHECK(cache.GetFilteredCount() == 4);
+
+	//null is a real binding too, distinct from "unknown"
+	cache.PSSetConstantBuffer(0, nullptr);
+	cache.PSSetConstantBuffer(0, nullptr);
+	CHECK(context.calls == 5);
+}
+
+TEST(StateCacheInvalidateReissues)
+{
+	MockContext context;
+	StateCache cache(&context);
+	ID3D11SamplerState sampler;
+
+	cache.PSSetSampler(0, &sampler);
+	cache.Invalidate();
+	cache.PSSetSampler(0, &sampler);
+	CHECK(context.calls == 2);
+
+	//a fresh cache doesn't assume null is bound
+	StateCache other(&context);
+	other.PSSetSampler(1, nullptr);
+	CHECK(context.calls == 3);
+}
+
+TEST(StateCacheConstantRangesAndSlotRuns)
+{
+	MockContext context;
+	StateCache cache(&context);
+	ID3D11Buffer ring;
+	ID3D11Buffer vertices, instances;
+
+	//offset binding: same buffer, different slice is a new binding
+	cache.VSSetConstantBufferRange(1, &ring, 0, 16);
+	cache.VSSetConstantBufferRange(1, &ring, 0, 16);
+	cache.VSSetConstantBufferRange(1, &ring, 16, 16);
+	CHECK(context.calls == 2);
+	CHECK(context.lastFirstConstant == 16);
+	CHECK(context.queries == 1);
+
+	//and a whole-buffer bind of the same buffer differs from a slice
+	cache.VSSetConstantBuffer(1, &ring);
+	CHECK(context.calls == 3);
+
+	ID3D11Buffer* both[2] = { &vertices, &instances };
+	UINT strides[2] = { 32, 128 };
+	UINT offsets[2] = { 0, 0 };
+	cache.IASetVertexBuffers(0, 2, both, strides, offsets);
+	cache.IASetVertexBuffers(0, 1, both, strides, offsets);
+	CHECK(context.calls == 4);
+
+	strides[1] = 64;
+	cache.IASetVertexBuffers(0, 2, both, strides, offsets);
+	CHECK(context.calls == 5);
+
+	ID3D11ShaderResourceView a, b;
+	ID3D11ShaderResourceView* srvs[2] = { &a, &b };
+	cache.PSSetShaderResources(0, 2, srvs);
+	cache.PSSetShaderResource(1, &b);
+	cache.PSSetShaderResources(0, 2, srvs);
+	CHECK(context.calls == 6);
+}
+
+TEST(StateCacheForIsStable)
+{
+	//shaders and meshes keep the pointer For() returns, so it has to survive more contexts arriving
+	std::vector<MockContext> contexts(64);
+	StateCache* first = &StateCache::For(&contexts[0]);
+	for (MockContext& context : contexts)
+		StateCache::For(&context);
+
+	CHECK(&StateCache::For(&contexts[0]) == first);
+	CHECK(&StateCache::For(&contexts[1]) != first);
+}
+
+// --------------------------------------------------------
+// A filtered bind through For() every time, as shaders and
+// meshes used to do, against the pointer they keep now
+// --------------------------------------------------------
+BENCHMARK(StateCacheLookupBenchmark)
+{
+	MockContext context;
+	ID3D11Buffer buffer;
+	const unsigned int binds = 100000;
+
+	StateCache::For(&context).PSSetConstantBuffer(0, &buffer);
+	double lookup = TimePerCall([&]() {
+		for (unsigned int i = 0; i < binds; i++)
+			StateCache::For(&context).PSSetConstantBuffer(0, &buffer);
+	});
+
+	StateCache* cache = &StateCache::For(&context);
+	double kept = TimePerCall([&]() {
+		for (unsigned int i = 0; i < binds; i++)
+			cache->PSSetConstantBuffer(0, &buffer);
+	});
+
+	printf("  For() every bind %.2f ns, kept pointer %.2f ns per filtered bind\n", lookup * 1e9 / binds, kept * 1e9 / binds);
+}
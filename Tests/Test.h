@@ -0,0 +1,54 @@
+#pragma once
+
+//C++
+#include <cstdio>
+#include <chrono>
+#include <vector>
+
+// --------------------------------------------------------
+// Minimal headless test harness - no framework, just a
+// list of functions registered at startup.  Tests run by
+// default; benchmarks only with --bench, since their
+// numbers mean nothing in a debug build.
+// --------------------------------------------------------
+struct TestCase
+{
+	const char* name;
+	void (*run)();
+	bool benchmark;
+};
+
+std::vector<TestCase>& RegisteredTests();
+void CheckFailed(const char* file, int line, const char* expression);
+
+struct TestRegistrar
+{
+	TestRegistrar(const char* name, void (*run)(), bool benchmark) { RegisteredTests().push_back({ name, run, benchmark }); }
+};
+
+#define TEST(name) static void name(); static TestRegistrar name##Registrar(#name, name, false); static void name()
+#define BENCHMARK(name) static void name(); static TestRegistrar name##Registrar(#name, name, true); static void name()
+
+//Records a failure and keeps going, so one run reports everything that's wrong
+#define CHECK(expression) do { if (!(expression)) CheckFailed(__FILE__, __LINE__, #expression); } while (0)
+
+// --------------------------------------------------------
+// Average seconds per call of function, repeated until at
+// least minSeconds have passed (after one warm-up call)
+// --------------------------------------------------------
+template<typename Function>
+double TimePerCall(Function function, double minSeconds = 0.25)
+{
+	function();
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	unsigned int calls = 0;
+	double elapsed = 0.0;
+	do {
+		function();
+		calls++;
+		elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	} while (elapsed < minSeconds);
+
+	return elapsed / calls;
+}
@@ -0,0 +1,49 @@
+#include "Test.h"
+
+//C++
+#include <cstring>
+
+static int failures = 0;
+
+std::vector<TestCase>& RegisteredTests()
+{
+	static std::vector<TestCase> tests;
+	return tests;
+}
+
+void CheckFailed(const char* file, int line, const char* expression)
+{
+	printf("%s(%d): CHECK(%s) failed\n", file, line, expression);
+	failures++;
+}
+
+// --------------------------------------------------------
+// Tests [--bench] [name filter]
+// --------------------------------------------------------
+int main(int argc, char* argv[])
+{
+	bool benchmarks = false;
+	const char* filter = nullptr;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--bench") == 0)
+			benchmarks = true;
+		else
+			filter = argv[i];
+	}
+
+	int run = 0;
+	for (const TestCase& test : RegisteredTests()) {
+		if (test.benchmark != benchmarks || (filter && !strstr(test.name, filter)))
+			continue;
+
+		int before = failures;
+		printf("%s\n", test.name);
+		test.run();
+		if (failures != before)
+			printf("%s FAILED\n", test.name);
+		run++;
+	}
+
+	printf("%d %s, %d failed checks\n", run, benchmarks ? "benchmarks" : "tests", failures);
+	return failures == 0 ? 0 : 1;
+}
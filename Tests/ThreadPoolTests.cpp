@@ -0,0 +1,68 @@
+#include "Test.h"
+
+#include "ThreadPool.h"
+
+//C++
+#include <atomic>
+#include <thread>
+
+TEST(ThreadPoolRunsEveryTaskOnce)
+{
+	for (unsigned int workerCount : { 0u, 1u, 3u }) {
+		ThreadPool pool(workerCount);
+		CHECK(pool.GetWorkerCount() == workerCount);
+
+		//back to back runs, including ones smaller than the pool
+		for (unsigned int taskCount : { 0u, 1u, 2u, 1000u, 3u, 1000u }) {
+			std::vector<std::atomic<int>> hits(taskCount);
+			pool.Run(taskCount, [&](unsigned int i) { hits[i]++; });
+
+			bool once = true;
+			for (std::atomic<int>& hit : hits)
+				once = once && hit == 1;
+			CHECK(once);
+		}
+	}
+}
+
+TEST(ThreadPoolResizes)
+{
+	ThreadPool pool(2);
+	pool.SetWorkerCount(4);
+	CHECK(pool.GetWorkerCount() == 4);
+
+	std::atomic<unsigned int> sum(0);
+	pool.Run(100, [&](unsigned int i) { sum += i; });
+	CHECK(sum == 4950);
+
+	pool.SetWorkerCount(0);
+	sum = 0;
+	pool.Run(100, [&](unsigned int i) { sum += i; });
+	CHECK(sum == 4950);
+}
+
+// --------------------------------------------------------
+// What per-frame parallel work pays just to get going:
+// waking a pool vs creating and joining threads
+// --------------------------------------------------------
+BENCHMARK(ThreadPoolWakeVersusSpawn)
+{
+	const unsigned int threads = 4;
+	ThreadPool pool(threads - 1);
+	std::atomic<unsigned int> sink(0);
+
+	double wake = TimePerCall([&]() {
+		pool.Run(threads, [&](unsigned int i) { sink += i; });
+	});
+
+	double spawn = TimePerCall([&]() {
+		std::vector<std::thread> spawned;
+		for (unsigned int i = 1; i < threads; i++)
+			spawned.emplace_back([&, i]() { sink += i; });
+		sink += 0;
+		for (std::thread& thread : spawned)
+			thread.join();
+	});
+
+	printf("  %u threads: pool Run %.1f us, spawn + join %.1f us\n", threads, wake * 1e6, spawn * 1e6);
+}
@@ -0,0 +1,122 @@
+#include "Test.h"
+
+#include "Transform.h"
+
+//C++
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+
+using namespace DirectX;
+
+namespace
+{
+	bool Listed(Transform* t)
+	{
+		const std::vector<Transform*>& changed = Transform::GetChangedThisFrame();
+		return std::count(changed.begin(), changed.end(), t) == 1;
+	}
+
+	bool Near(const XMFLOAT4X4& a, const XMFLOAT4X4& b)
+	{
+		for (int i = 0; i < 4; i++)
+			for (int j = 0; j < 4; j++)
+				if (fabsf(a.m[i][j] - b.m[i][j]) > 1e-4f)
+					return false;
+		return true;
+	}
+}
+
+static_assert(!std::is_copy_constructible_v<Transform> && !std::is_copy_assignable_v<Transform>,
+	"A copied Transform would inherit the original's changed-list flag");
+
+TEST(TransformVersionBumpsOnEveryChange)
+{
+	Transform::ClearChangedThisFrame();
+	Transform t;
+	unsigned int version = t.GetVersion();
+
+	t.SetPosition(1, 2, 3);
+	CHECK(t.GetVersion() > version);
+	version = t.GetVersion();
+
+	t.SetRotation(0.1f, 0.2f, 0.3f);
+	CHECK(t.GetVersion() > version);
+	version = t.GetVersion();
+
+	t.SetScale(2, 2, 2);
+	t.MoveAbsolute(1, 0, 0);
+	t.MoveRelative(0, 0, 1);
+	t.Rotate(0, 0.5f, 0);
+	t.Scale(0.5f, 1, 1);
+	CHECK(t.GetVersion() == version + 5);
+
+	//reading never counts as a change
+	version = t.GetVersion();
+	t.GetWorldMatrix();
+	t.GetPosition();
+	t.GetForward();
+	CHECK(t.GetVersion() == version);
+
+	Transform::ClearChangedThisFrame();
+}
+
+TEST(TransformChangedListHoldsEachOnceUntilCleared)
+{
+	Transform::ClearChangedThisFrame();
+	Transform moved;
+	Transform still;
+	Transform::ClearChangedThisFrame();
+	CHECK(Transform::GetChangedThisFrame().empty());
+
+	moved.SetPosition(1, 0, 0);
+	moved.Rotate(0, 1, 0);
+	CHECK(Listed(&moved));
+	CHECK(!Listed(&still));
+	CHECK(Transform::GetChangedThisFrame().size() == 1);
+
+	//the version keeps going up across frames, the list starts over
+	unsigned int version = moved.GetVersion();
+	Transform::ClearChangedThisFrame();
+	CHECK(Transform::GetChangedThisFrame().empty());
+	moved.SetPosition(2, 0, 0);
+	CHECK(Listed(&moved));
+	CHECK(moved.GetVersion() > version);
+
+	Transform::ClearChangedThisFrame();
+}
+
+TEST(TransformLeavesChangedListWhenDestroyed)
+{
+	Transform::ClearChangedThisFrame();
+	Transform kept;
+	kept.SetPosition(1, 0, 0);
+	{
+		Transform temporary;
+		temporary.SetPosition(2, 0, 0);
+		CHECK(Transform::GetChangedThisFrame().size() == 2);
+	}
+	CHECK(Transform::GetChangedThisFrame().size() == 1);
+	CHECK(Listed(&kept));
+
+	Transform::ClearChangedThisFrame();
+}
+
+TEST(TransformInterpolationEndsAtCurrentState)
+{
+	Transform::ClearChangedThisFrame();
+	Transform t(1, 2, 3);
+	t.SavePrevious();
+	t.SetRotation(0.3f, -1.1f, 0.7f);
+	t.SetScale(2, 1, 0.5f);
+	t.MoveAbsolute(4, 0, -2);
+
+	//the quaternion path at alpha 1 lands on the matrix path
+	CHECK(Near(t.GetInterpolatedWorldMatrix(1.0f), t.GetWorldMatrix()));
+	CHECK(Near(t.GetInterpolatedWorldInverseTransposeMatrix(1.0f), t.GetWorldInverseTransposeMatrix()));
+
+	XMFLOAT4X4 start = t.GetInterpolatedWorldMatrix(0.0f);
+	CHECK(fabsf(start._41 - 1) < 1e-4f && fabsf(start._42 - 2) < 1e-4f && fabsf(start._43 - 3) < 1e-4f);
+
+	Transform::ClearChangedThisFrame();
+}
@@ -0,0 +1,251 @@
+#include "Test.h"
+
+#include "TriangleBVH.h"
+#include "Transform.h"
+
+//C++
+#include <cfloat>
+#include <cmath>
+#include <memory>
+#include <random>
+
+using namespace DirectX;
+
+namespace
+{
+	// --------------------------------------------------------
+	// Closed UV sphere of radius 1 (rings * segments * 2 tris)
+	// --------------------------------------------------------
+	void Sphere(int rings, int segments, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+	{
+		vertices.clear();
+		indices.clear();
+		for (int r = 0; r <= rings; r++) {
+			float phi = XM_PI * r / rings;
+			for (int s = 0; s <= segments; s++) {
+				float theta = XM_2PI * s / segments;
+				Vertex vertex = {};
+				vertex.Position = XMFLOAT3(sinf(phi) * cosf(theta), cosf(phi), sinf(phi) * sinf(theta));
+				vertices.push_back(vertex);
+			}
+		}
+		for (int r = 0; r < rings; r++) {
+			for (int s = 0; s < segments; s++) {
+				unsigned int a = r * (segments + 1) + s, b = a + segments + 1;
+				indices.insert(indices.end(), { a, b, a + 1, a + 1, b, b + 1 });
+			}
+		}
+	}
+
+	//the old Mesh::Raycast: every triangle, one by one
+	bool EveryTriangle(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, const Ray& ray, float maxT, float* tHit)
+	{
+		bool hit = false;
+		for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+			float t;
+			if (RayIntersectsTriangle(ray, vertices[indices[i]].Position, vertices[indices[i + 1]].Position, vertices[indices[i + 2]].Position, maxT, &t)) {
+				maxT = t;
+				hit = true;
+			}
+		}
+		if (hit) *tHit = maxT;
+		return hit;
+	}
+
+	Ray RandomRay(std::mt19937& random, float extent)
+	{
+		std::uniform_real_distribution<float> position(-extent, extent);
+		std::uniform_real_distribution<float> direction(-1.0f, 1.0f);
+		Ray ray;
+		ray.origin = XMFLOAT3(position(random), position(random), position(random));
+		XMStoreFloat3(&ray.direction, XMVector3Normalize(XMVectorSet(direction(random), direction(random), direction(random), 0)));
+		return ray;
+	}
+
+	// --------------------------------------------------------
+	// Spheres scattered through a cube of the given extent,
+	// all sharing one mesh, in a scene BVH like Game's
+	// --------------------------------------------------------
+	struct Scene
+	{
+		std::vector<Vertex> vertices;
+		std::vector<unsigned int> indices;
+		TriangleBVH triangles;
+		std::vector<std::unique_ptr<Transform>> transforms;
+		std::vector<AABB> bounds;
+		DynamicBVH bvh;
+
+		Scene(int count, float extent, int rings, unsigned int seed)
+		{
+			Sphere(rings, rings * 2, vertices, indices);
+			triangles.Build(vertices, indices);
+
+			AABB local = EmptyAABB();
+			for (const Vertex& vertex : vertices)
+				AABBGrow(local, vertex.Position);
+
+			std::mt19937 random(seed);
+			std::uniform_real_distribution<float> position(-extent, extent);
+			std::uniform_real_distribution<float> size(0.5f, 2.0f);
+			std::uniform_real_distribution<float> angle(0.0f, XM_2PI);
+			for (int i = 0; i < count; i++) {
+				transforms.push_back(std::make_unique<Transform>(position(random), position(random), position(random)));
+				transforms.back()->SetScale(size(random), size(random), size(random));
+				transforms.back()->SetRotation(angle(random), angle(random), angle(random));
+				bounds.push_back(AABBTransform(local, transforms.back()->GetWorldMatrix()));
+				bvh.Insert(bounds.back(), i);
+			}
+			Transform::ClearChangedThisFrame();
+		}
+
+		int Pick(const Ray& ray, float* distance)
+		{
+			return RaycastNearest(bvh, ray, distance, [&](int i) {
+				return RayTarget{ &bounds[i], transforms[i].get(), &triangles };
+			});
+		}
+
+		//every entity, every triangle
+		int BruteForce(const Ray& ray, float* distance)
+		{
+			int picked = -1;
+			float nearest = FLT_MAX;
+			for (int i = 0; i < (int)transforms.size(); i++) {
+				XMFLOAT4X4 world = transforms[i]->GetWorldMatrix();
+				XMMATRIX invWorld = XMMatrixInverse(nullptr, XMLoadFloat4x4(&world));
+				Ray localRay;
+				XMStoreFloat3(&localRay.origin, XMVector3TransformCoord(XMLoadFloat3(&ray.origin), invWorld));
+				XMStoreFloat3(&localRay.direction, XMVector3TransformNormal(XMLoadFloat3(&ray.direction), invWorld));
+
+				float t;
+				if (EveryTriangle(vertices, indices, localRay, nearest, &t)) {
+					nearest = t;
+					picked = i;
+				}
+			}
+			*distance = nearest;
+			return picked;
+		}
+	};
+}
+
+TEST(TriangleBVHMatchesEveryTriangle)
+{
+	std::vector<Vertex> vertices;
+	std::vector<unsigned int> indices;
+	Sphere(16, 32, vertices, indices);
+	TriangleBVH triangles;
+	triangles.Build(vertices, indices);
+	CHECK(triangles.GetTriangleCount() == indices.size() / 3);
+
+	std::mt19937 random(4);
+	int hits = 0;
+	for (int r = 0; r < 2000; r++) {
+		Ray ray = RandomRay(random, 1.5f);
+		float expected = 0.0f, t = 0.0f;
+		bool brute = EveryTriangle(vertices, indices, ray, FLT_MAX, &expected);
+		CHECK(triangles.Raycast(ray, FLT_MAX, &t) == brute);
+		if (brute) {
+			CHECK(t == expected);
+			hits++;
+		}
+	}
+	CHECK(hits > 400);
+
+	//a hit beyond maxT doesn't count
+	Ray ray = { XMFLOAT3(0, 0, -5), XMFLOAT3(0, 0, 1) };
+	float t;
+	CHECK(triangles.Raycast(ray, 10.0f, &t) && fabsf(t - 4.0f) < 0.01f);
+	CHECK(!triangles.Raycast(ray, 3.9f, &t));
+}
+
+// --------------------------------------------------------
+// The entity picked is the nearest one a brute force pass
+// over every triangle of every entity finds, at the same
+// distance - including rays that only pass through boxes
+// and rays that start inside an entity
+// --------------------------------------------------------
+TEST(RaycastNearestPicksNearestEntity)
+{
+	Scene scene(300, 30.0f, 8, 6);
+
+	std::mt19937 random(8);
+	int picks = 0;
+	for (int r = 0; r < 500; r++) {
+		Ray ray = RandomRay(random, 30.0f);
+		float distance, expectedDistance;
+		int picked = scene.Pick(ray, &distance);
+		int expected = scene.BruteForce(ray, &expectedDistance);
+		CHECK(picked == expected);
+		if (expected != -1) {
+			CHECK(distance == expectedDistance);
+			picks++;
+		}
+	}
+	CHECK(picks > 50);
+
+	//two spheres on the ray: the nearer one wins whichever was inserted first
+	Scene pair(0, 0.0f, 8, 0);
+	for (float z : { 20.0f, 10.0f }) {
+		pair.transforms.push_back(std::make_unique<Transform>(0.0f, 0.0f, z));
+		AABB local = { XMFLOAT3(-1, -1, -1), XMFLOAT3(1, 1, 1) };
+		pair.bounds.push_back(AABBTransform(local, pair.transforms.back()->GetWorldMatrix()));
+		pair.bvh.Insert(pair.bounds.back(), (int)pair.bounds.size() - 1);
+	}
+	Transform::ClearChangedThisFrame();
+	float distance;
+	CHECK(pair.Pick({ XMFLOAT3(0, 0, 0), XMFLOAT3(0, 0, 1) }, &distance) == 1);
+	CHECK(fabsf(distance - 9.0f) < 0.01f);
+
+	//through the corner of both boxes, but past the spheres
+	CHECK(pair.Pick({ XMFLOAT3(0.95f, 0.95f, 0), XMFLOAT3(0, 0, 1) }, &distance) == -1);
+}
+
+// --------------------------------------------------------
+// Picking in a dense scene (10k spheres of 4k triangles),
+// against the old path (scene BVH, then every triangle of
+// each candidate)
+// --------------------------------------------------------
+BENCHMARK(RaycastPickBenchmark)
+{
+	Scene scene(10000, 100.0f, 32, 2);
+	printf("  %zu entities, %u triangles each, triangle BVH height %d\n",
+		scene.transforms.size(), scene.triangles.GetTriangleCount(), scene.triangles.GetHeight());
+
+	std::mt19937 random(3);
+	std::vector<Ray> rays;
+	for (int r = 0; r < 256; r++)
+		rays.push_back(RandomRay(random, 100.0f));
+
+	int next = 0, hits = 0;
+	double bvh = TimePerCall([&]() {
+		float distance;
+		hits += scene.Pick(rays[next++ % rays.size()], &distance) != -1;
+	});
+
+	next = 0;
+	double old = TimePerCall([&]() {
+		const Ray& ray = rays[next++ % rays.size()];
+		int picked = -1;
+		float nearest = FLT_MAX;
+		scene.bvh.Raycast(ray, FLT_MAX, [&](int i, float tEntry) {
+			if (tEntry >= nearest || !RayIntersectsAABB(ray, scene.bounds[i], nearest, nullptr))
+				return nearest;
+			XMFLOAT4X4 world = scene.transforms[i]->GetWorldMatrix();
+			XMMATRIX invWorld = XMMatrixInverse(nullptr, XMLoadFloat4x4(&world));
+			Ray localRay;
+			XMStoreFloat3(&localRay.origin, XMVector3TransformCoord(XMLoadFloat3(&ray.origin), invWorld));
+			XMStoreFloat3(&localRay.direction, XMVector3TransformNormal(XMLoadFloat3(&ray.direction), invWorld));
+			float t;
+			if (EveryTriangle(scene.vertices, scene.indices, localRay, nearest, &t)) {
+				nearest = t;
+				picked = i;
+			}
+			return nearest;
+		});
+		hits += picked != -1;
+	});
+
+	printf("  pick: %.2f us with triangle BVHs, %.2f us testing every triangle (%.1fx)\n", bvh * 1e6, old * 1e6, old / bvh);
+	CHECK(bvh < 1e-3);
+}
@@ -0,0 +1,55 @@
+#include "Test.h"
+
+#include "UploadTracker.h"
+
+//C++
+#include <cstring>
+
+TEST(UploadTrackerFirstUploadAlwaysGoesThrough)
+{
+	//even when nothing was written, or the writes matched the zeroed buffer
+	unsigned char local[16] = {};
+	UploadTracker tracker;
+	CHECK(tracker.NeedsUpload());
+
+	unsigned char zeros[16] = {};
+	CHECK(!tracker.Write(local, zeros, sizeof(zeros)));
+	CHECK(tracker.NeedsUpload());
+}
+
+TEST(UploadTrackerSameBytesStayClean)
+{
+	unsigned char local[16] = {};
+	UploadTracker tracker;
+	float value = 2.0f;
+	CHECK(tracker.Write(local + 4, &value, sizeof(value)));
+	tracker.MarkUploaded();
+	CHECK(!tracker.NeedsUpload());
+
+	float same = 2.0f;
+	CHECK(!tracker.Write(local + 4, &same, sizeof(same)));
+	CHECK(!tracker.NeedsUpload());
+}
+
+TEST(UploadTrackerDifferentBytesMarkDirty)
+{
+	unsigned char local[16] = {};
+	UploadTracker tracker;
+	tracker.MarkUploaded();
+
+	//a single changed byte is enough, and it lands where it was written
+	unsigned char data[4] = { 0, 0, 1, 0 };
+	CHECK(tracker.Write(local + 8, data, sizeof(data)));
+	CHECK(tracker.NeedsUpload());
+	CHECK(local[10] == 1);
+	CHECK(local[0] == 0 && local[15] == 0);
+
+	//stays dirty until uploaded, even if later writes match
+	CHECK(!tracker.Write(local + 8, data, sizeof(data)));
+	CHECK(tracker.NeedsUpload());
+	tracker.MarkUploaded();
+	CHECK(!tracker.NeedsUpload());
+
+	tracker.MarkDirty();
+	CHECK(tracker.NeedsUpload());
+}
@@ -0,0 +1,235 @@
+#include "Test.h"
+
+#include "VisibilityCache.h"
+#include "FrustumCuller.h"
+#include "Bounds.h"
+
+//C++
+#include <cmath>
+#include <random>
+
+using namespace DirectX;
+
+namespace
+{
+	// --------------------------------------------------------
+	// View matrix for a camera at position, yawed about y and
+	// rolled about its forward axis (columns 0-2 are its axes)
+	// --------------------------------------------------------
+	XMFLOAT4X4 View(XMFLOAT3 position, float yaw, float roll)
+	{
+		float cy = cosf(yaw), sy = sinf(yaw);
+		float cr = cosf(roll), sr = sinf(roll);
+		XMFLOAT3 forward(sy, 0.0f, cy);
+		XMFLOAT3 right0(cy, 0.0f, -sy);
+		XMFLOAT3 up0(0.0f, 1.0f, 0.0f);
+		XMFLOAT3 right(right0.x * cr + up0.x * sr, right0.y * cr + up0.y * sr, right0.z * cr + up0.z * sr);
+		XMFLOAT3 up(up0.x * cr - right0.x * sr, up0.y * cr - right0.y * sr, up0.z * cr - right0.z * sr);
+
+		const XMFLOAT3 axes[3] = { right, up, forward };
+		XMFLOAT4X4 view = {};
+		for (int a = 0; a < 3; a++) {
+			view.m[0][a] = axes[a].x;
+			view.m[1][a] = axes[a].y;
+			view.m[2][a] = axes[a].z;
+			view.m[3][a] = -(axes[a].x * position.x + axes[a].y * position.y + axes[a].z * position.z);
+		}
+		view._44 = 1.0f;
+		return view;
+	}
+
+	XMFLOAT4X4 Projection()
+	{
+		XMFLOAT4X4 projection = {};
+		projection._11 = 1.0f;
+		projection._22 = 1.5f;
+		projection._33 = 1.0f;
+		projection._34 = 1.0f;
+		projection._43 = -0.1f;
+		return projection;
+	}
+}
+
+TEST(VisibilityCacheKeepsResultsWithinThresholds)
+{
+	VisibilityCache cache(0.01f, 0.0001f);
+	XMFLOAT4X4 projection = Projection();
+
+	CHECK(cache.BeginFrame(View(XMFLOAT3(0, 0, 0), 0.0f, 0.0f), projection, 4));
+	cache.Store(0, 1, 0, true);
+
+	CHECK(!cache.BeginFrame(View(XMFLOAT3(0.005f, 0, 0), 0.0f, 0.0f), projection, 4));
+	CHECK(!cache.IsStale(0, 1, 0));
+	CHECK(cache.IsVisible(0));
+
+	//still within the thresholds of the view the cache was built with
+	CHECK(!cache.BeginFrame(View(XMFLOAT3(0, 0, 0.009f), 0.005f, 0.0f), projection, 4));
+
+	CHECK(cache.BeginFrame(View(XMFLOAT3(0.02f, 0, 0), 0.0f, 0.0f), projection, 4));
+	CHECK(cache.IsStale(0, 1, 0));
+}
+
+TEST(VisibilityCacheRollInvalidates)
+{
+	VisibilityCache cache(0.01f, 0.0001f);
+	XMFLOAT4X4 projection = Projection();
+
+	cache.BeginFrame(View(XMFLOAT3(1, 2, 3), 0.3f, 0.0f), projection, 1);
+	cache.Store(0, 0, 0, true);
+
+	//same position and forward, only the up vector turns
+	CHECK(cache.BeginFrame(View(XMFLOAT3(1, 2, 3), 0.3f, 0.05f), projection, 1));
+	CHECK(cache.IsStale(0, 0, 0));
+}
+
+TEST(VisibilityCacheStateVersionInvalidates)
+{
+	VisibilityCache cache;
+	cache.BeginFrame(View(XMFLOAT3(0, 0, 0), 0.0f, 0.0f), Projection(), 2);
+	cache.Store(0, 5, 0, true);
+	cache.Store(1, 5, 0, false);
+
+	//a flag or material change on entity 1 alone
+	CHECK(!cache.IsStale(0, 5, 0));
+	CHECK(cache.IsStale(1, 5, 1));
+	CHECK(cache.IsStateStale(1, 1));
+	CHECK(!cache.IsStateStale(0, 0));
+
+	//and the state version survives Invalidate(), so the change is still seen
+	cache.Invalidate();
+	CHECK(cache.IsStateStale(1, 1));
+}
+
+TEST(VisibilityCacheReportsEnteredAndExited)
+{
+	VisibilityCache cache;
+	XMFLOAT4X4 view = View(XMFLOAT3(0, 0, 0), 0.0f, 0.0f);
+	cache.BeginFrame(view, Projection(), 3);
+	cache.Store(0, 0, 0, true);
+	cache.Store(1, 0, 0, true);
+	cache.Store(2, 0, 0, false);
+	cache.EndFrame();
+	CHECK(cache.GetEntered().size() == 2);
+	CHECK(cache.GetExited().empty());
+
+	//only entity 1 is retested, the others keep their answer and aren't reported again
+	cache.BeginFrame(view, Projection(), 3);
+	CHECK(cache.IsStale(1, 1, 0));
+	cache.Store(1, 1, 0, false);
+	cache.EndFrame();
+	CHECK(cache.GetEntered().empty());
+	CHECK(cache.GetExited().size() == 1 && cache.GetExited()[0] == 1);
+
+	//after Invalidate() everything is stale, but unchanged answers still aren't deltas
+	cache.BeginFrame(view, Projection(), 3);
+	cache.Invalidate();
+	CHECK(cache.IsStale(0, 0, 0) && cache.IsStale(2, 0, 0));
+	cache.Store(0, 0, 0, true);
+	cache.Store(1, 1, 0, false);
+	cache.Store(2, 0, 0, true);
+	cache.EndFrame();
+	CHECK(cache.GetEntered().size() == 1 && cache.GetEntered()[0] == 2);
+	CHECK(cache.GetExited().empty());
+	CHECK(cache.GetTestedCount() == 3);
+}
+
+TEST(VisibilityCacheSlackCoversThresholds)
+{
+	VisibilityCache cache(0.01f, 0.0001f);
+
+	//turning by acos(1 - 1e-4) swings a point at the far plane about 1.41% of its distance
+	float slack = cache.GetFrustumSlack(1000.0f);
+	CHECK(slack > 0.01f + 1000.0f * sinf(acosf(1.0f - 0.0001f)) * 0.999f);
+	CHECK(slack < 0.01f + 1000.0f * 0.0142f);
+}
+
+// --------------------------------------------------------
+// A frame of Game::CullEntities' frustum stage over 100k
+// scattered boxes: the cached walk (stale entities retested
+// one by one) against FrustumCuller::Cull on every box, and
+// how many more boxes the cache's slack lets through
+// --------------------------------------------------------
+BENCHMARK(VisibilityCacheBenchmark)
+{
+	const unsigned int count = 100000;
+	const float farClip = 1000.0f;
+	const float movedFractions[] = { 0.0f, 0.01f, 0.1f };
+
+	std::mt19937 random(11);
+	std::uniform_real_distribution<float> spread(-farClip, farClip);
+	std::uniform_real_distribution<float> height(-5.0f, 5.0f);
+	std::uniform_real_distribution<float> size(0.5f, 2.0f);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	std::vector<AABB> boxes(count);
+	FrustumCuller culler;
+	culler.Resize(count);
+	for (unsigned int i = 0; i < count; i++) {
+		float s = size(random);
+		XMFLOAT3 center(spread(random), height(random), spread(random));
+		boxes[i].min = XMFLOAT3(center.x - s, center.y - s, center.z - s);
+		boxes[i].max = XMFLOAT3(center.x + s, center.y + s, center.z + s);
+		culler.SetBox(i, boxes[i]);
+	}
+
+	XMFLOAT4X4 view = View(XMFLOAT3(0, 0, 0), 0.3f, 0.0f);
+	XMFLOAT4X4 projection;
+	XMStoreFloat4x4(&projection, XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, 0.1f, farClip));
+	XMFLOAT4X4 viewProjection;
+	XMStoreFloat4x4(&viewProjection, XMMatrixMultiply(XMLoadFloat4x4(&view), XMLoadFloat4x4(&projection)));
+	Frustum frustum = FrustumFromMatrix(viewProjection);
+
+	//what every frame costs without the cache
+	std::vector<unsigned int> visible;
+	visible.reserve(count);
+	double seconds = TimePerCall([&]() {
+		visible.clear();
+		culler.Cull(frustum, visible);
+	});
+	size_t exact = visible.size();
+	printf("  FrustumCuller::Cull      : %6.2f ns/entity, %zu visible\n", seconds * 1e9 / count, exact);
+
+	//the default threshold against the 10x looser one it replaced
+	for (float turnThreshold : { 0.00001f, 0.0001f }) {
+		VisibilityCache cache(0.01f, turnThreshold);
+		float slack = cache.GetFrustumSlack(farClip);
+		Frustum inflated = FrustumInflate(frustum, slack);
+
+		visible.clear();
+		culler.Cull(inflated, visible);
+		printf("  turn threshold %g: slack %.2f at far %.0f, %zu visible (+%.1f%% drawn)\n", turnThreshold, slack, farClip,
+			visible.size(), 100.0 * (double)(visible.size() - exact) / (double)exact);
+
+		for (float moved : movedFractions) {
+			std::vector<unsigned int> versions(count, 0);
+			std::vector<unsigned int> movers;
+			for (unsigned int i = 0; i < count; i++) {
+				if (unit(random) < moved)
+					movers.push_back(i);
+			}
+
+			//same walk as Game::CullEntities when the view holds still
+			cache.BeginFrame(view, projection, count);
+			cache.Invalidate();
+			seconds = TimePerCall([&]() {
+				for (unsigned int i : movers)
+					versions[i]++;
+
+				cache.BeginFrame(view, projection, count);
+				visible.clear();
+				for (unsigned int i = 0; i < count; i++) {
+					if (!cache.IsStale(i, versions[i], 0)) {
+						if (cache.IsVisible(i))
+							visible.push_back(i);
+						continue;
+					}
+					bool inside = FrustumTestAABB(inflated, boxes[i]) != CullResult::Outside;
+					cache.Store(i, versions[i], 0, inside);
+					if (inside)
+						visible.push_back(i);
+				}
+				cache.EndFrame();
+			});
+			printf("    cached %4.0f%% moved   : %6.2f ns/entity, %u retested\n", moved * 100.0f, seconds * 1e9 / count, cache.GetTestedCount());
+		}
+	}
+}
@@ -0,0 +1,109 @@
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(unsigned int workerCount) :
+	task(nullptr),
+	taskCount(0),
+	nextTask(0),
+	generation(0),
+	busyWorkers(0),
+	quit(false)
+{
+	Start(workerCount);
+}
+
+ThreadPool::~ThreadPool()
+{
+	Stop();
+}
+
+void ThreadPool::Run(unsigned int taskCount, const std::function<void(unsigned int)>& task)
+{
+	if (taskCount == 0)
+		return;
+
+	//nothing to share, or one task - skip the wake-up entirely
+	if (workers.empty() || taskCount == 1) {
+		for (unsigned int i = 0; i < taskCount; i++)
+			task(i);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		this->task = &task;
+		this->taskCount = taskCount;
+		nextTask = 0;
+		busyWorkers = (unsigned int)workers.size();
+		generation++;
+	}
+	wake.notify_all();
+
+	RunTasks();
+
+	//every worker has to check in, even ones that found nothing left,
+	//so none of them can still be looking at this Run()'s task
+	std::unique_lock<std::mutex> guard(lock);
+	finished.wait(guard, [&]() { return busyWorkers == 0; });
+	this->task = nullptr;
+}
+
+void ThreadPool::SetWorkerCount(unsigned int workerCount)
+{
+	if (workerCount == workers.size())
+		return;
+
+	Stop();
+	Start(workerCount);
+}
+
+unsigned int ThreadPool::GetWorkerCount() { return (unsigned int)workers.size(); }
+
+void ThreadPool::Start(unsigned int workerCount)
+{
+	quit = false;
+	for (unsigned int i = 0; i < workerCount; i++)
+		workers.emplace_back(&ThreadPool::WorkerLoop, this, generation);
+}
+
+void ThreadPool::Stop()
+{
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		quit = true;
+	}
+	wake.notify_all();
+
+	for (std::thread& worker : workers)
+		worker.join();
+	workers.clear();
+}
+
+// --------------------------------------------------------
+// seen is the generation when the worker was started - read
+// on the starting thread, so a Run() that begins before the
+// worker gets going still counts on it
+// --------------------------------------------------------
+void ThreadPool::WorkerLoop(unsigned int seen)
+{
+	while (true) {
+		{
+			std::unique_lock<std::mutex> guard(lock);
+			wake.wait(guard, [&]() { return quit || generation != seen; });
+			if (quit)
+				return;
+			seen = generation;
+		}
+
+		RunTasks();
+
+		std::lock_guard<std::mutex> guard(lock);
+		if (--busyWorkers == 0)
+			finished.notify_one();
+	}
+}
+
+void ThreadPool::RunTasks()
+{
+	for (unsigned int i = nextTask++; i < taskCount; i = nextTask++)
+		(*task)(i);
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+//C++
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+
+// --------------------------------------------------------
+// Worker threads that live as long as the pool, for work
+// that's split up every frame.  Run() hands out task
+// indices to the workers and the calling thread, and
+// returns once every task has finished - so per-frame work
+// pays for a wake-up instead of creating and joining
+// threads.
+//
+// Run() must only be called from one thread at a time.
+// --------------------------------------------------------
+class ThreadPool
+{
+public:
+	//workerCount threads besides the one calling Run() (0 runs everything inline)
+	ThreadPool(unsigned int workerCount = 0);
+	~ThreadPool();
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	//Calls task(i) for every i in [0, taskCount), spread across the threads
+	void Run(unsigned int taskCount, const std::function<void(unsigned int)>& task);
+
+	//Stops the current workers and starts workerCount new ones
+	void SetWorkerCount(unsigned int workerCount);
+	unsigned int GetWorkerCount();
+
+private:
+	void Start(unsigned int workerCount);
+	void Stop();
+	void WorkerLoop(unsigned int seen);
+	void RunTasks();
+
+	std::vector<std::thread> workers;
+
+	std::mutex lock;
+	std::condition_variable wake;		// Workers wait here for the next Run()
+	std::condition_variable finished;	// Run() waits here for the workers
+
+	//current Run() - tasks are claimed by bumping nextTask
+	const std::function<void(unsigned int)>* task;
+	unsigned int taskCount;
+	std::atomic<unsigned int> nextTask;
+
+	unsigned int generation;	// Bumped by every Run() so workers can tell it's new
+	unsigned int busyWorkers;	// Workers yet to finish the current Run()
+	bool quit;
+};
@@ -2,6 +2,8 @@
 
 using namespace DirectX;
 
+std::vector<Transform*> Transform::changedThisFrame;
+
 Transform::Transform() :
     position(0, 0, 0),
     pitchYawRoll(0, 0, 0),
@@ -10,10 +12,17 @@ Transform::Transform() :
     right(1, 0, 0),
     forward(0, 0, 1),
     matriciesDirty(false),
-    vectorsDirty(false)
+    vectorsDirty(false),
+    prevVersion(0),
+    interpAlpha(-1.0f),
+    interpVersion(0),
+    version(0),
+    inChangedList(false)
 {
     XMStoreFloat4x4(&worldMatrix, DirectX::XMMatrixIdentity());
     XMStoreFloat4x4(&worldITMatrix, DirectX::XMMatrixIdentity());
+
+    SavePrevious();
 }
 
 Transform::Transform(float x, float y, float z) :
@@ -23,16 +32,26 @@ Transform::Transform(float x, float y, float z) :
     right(1, 0, 0),
     forward(0, 0, 1),
     matriciesDirty(false),
-    vectorsDirty(false)
+    vectorsDirty(false),
+    prevVersion(0),
+    interpAlpha(-1.0f),
+    interpVersion(0),
+    version(0),
+    inChangedList(false)
 {
     SetPosition(x, y, z);
 
     XMStoreFloat4x4(&worldMatrix, DirectX::XMMatrixIdentity());
     XMStoreFloat4x4(&worldITMatrix, DirectX::XMMatrixIdentity());
+
+    SavePrevious();
 }
 
 Transform::~Transform()
 {
+    //don't leave a dangling pointer in the changed list
+    if (inChangedList)
+        std::erase(changedThisFrame, this);
 }
 
 void Transform::SetPosition(float x, float y, float z)
@@ -40,7 +59,7 @@ void Transform::SetPosition(float x, float y, float z)
     position.x = x;
     position.y = y;
     position.z = z;
-    matriciesDirty = true;
+    MarkChanged();
 }
 
 void Transform::SetPosition(DirectX::XMFLOAT3 pos)
@@ -53,7 +72,7 @@ void Transform::SetRotation(float p, float y, float r)
     pitchYawRoll.x = p;
     pitchYawRoll.y = y;
     pitchYawRoll.z = r;
-    matriciesDirty = true;
+    MarkChanged();
 }
 
 void Transform::SetRotation(DirectX::XMFLOAT3 rot)
@@ -66,7 +85,7 @@ void Transform::SetScale(float x, float y, float z)
     scale.x = x;
     scale.y = y;
     scale.z = z;
-    matriciesDirty = true;
+    MarkChanged();
 }
 
 void Transform::SetScale(DirectX::XMFLOAT3 scale)
@@ -77,6 +96,7 @@ void Transform::SetScale(DirectX::XMFLOAT3 scale)
 void Transform::MoveAbsolute(float x, float y, float z)
 {
     DirectX::XMStoreFloat3(&position, XMLoadFloat3(&position) + DirectX::XMVectorSet(x, y, z, 0.0f));
+    MarkChanged();
 }
 
 void Transform::MoveAbsolute(DirectX::XMFLOAT3 vector)
@@ -100,6 +120,7 @@ void Transform::MoveRelative(float x, float y, float z)
     //add this "rotated direction" to our position
     DirectX::XMStoreFloat3(&position, XMLoadFloat3(&position) + dir);
     vectorsDirty = true;
+    MarkChanged();
 
 }
 
@@ -113,7 +134,7 @@ void Transform::Rotate(float p, float y, float r)
     pitchYawRoll.x += p;
     pitchYawRoll.y += y;
     pitchYawRoll.z += r;
-    matriciesDirty = true;
+    MarkChanged();
 }
 
 void Transform::Scale(float x, float y, float z)
@@ -121,7 +142,7 @@ void Transform::Scale(float x, float y, float z)
     scale.x *= x;
     scale.y *= y;
     scale.z *= z;
-    matriciesDirty = true;
+    MarkChanged();
 }
 
 DirectX::XMFLOAT3 Transform::GetPosition() { return position; }
@@ -179,3 +200,76 @@ DirectX::XMFLOAT4X4 Transform::GetWorldInverseTransposeMatrix()
 
     return worldITMatrix;
 }
+
+void Transform::SavePrevious()
+{
+    prevPosition = position;
+    prevPitchYawRoll = pitchYawRoll;
+    prevScale = scale;
+    prevVersion = version;
+}
+
+DirectX::XMFLOAT4X4 Transform::GetInterpolatedWorldMatrix(float alpha)
+{
+    //nothing changed since the last step, so there's nothing to blend
+    if (version == prevVersion)
+        return GetWorldMatrix();
+
+    UpdateInterpolatedMatrices(alpha);
+    return interpWorldMatrix;
+}
+
+DirectX::XMFLOAT4X4 Transform::GetInterpolatedWorldInverseTransposeMatrix(float alpha)
+{
+    if (version == prevVersion)
+        return GetWorldInverseTransposeMatrix();
+
+    UpdateInterpolatedMatrices(alpha);
+    return interpWorldITMatrix;
+}
+
+void Transform::UpdateInterpolatedMatrices(float alpha)
+{
+    if (alpha == interpAlpha && version == interpVersion)
+        return;
+
+    //blend position and scale linearly, rotation through a quaternion slerp
+    XMVECTOR pos = XMVectorLerp(XMLoadFloat3(&prevPosition), XMLoadFloat3(&position), alpha);
+    XMVECTOR scl = XMVectorLerp(XMLoadFloat3(&prevScale), XMLoadFloat3(&scale), alpha);
+    XMVECTOR rot = XMQuaternionSlerp(
+        XMQuaternionRotationRollPitchYawFromVector(XMLoadFloat3(&prevPitchYawRoll)),
+        XMQuaternionRotationRollPitchYawFromVector(XMLoadFloat3(&pitchYawRoll)),
+        alpha);
+
+    XMMATRIX world = XMMatrixScalingFromVector(scl) * XMMatrixRotationQuaternion(rot) * XMMatrixTranslationFromVector(pos);
+
+    XMStoreFloat4x4(&interpWorldMatrix, world);
+    XMStoreFloat4x4(&interpWorldITMatrix, XMMatrixInverse(0, XMMatrixTranspose(world)));
+
+    interpAlpha = alpha;
+    interpVersion = version;
+}
+
+unsigned int Transform::GetVersion() { return version; }
+
+const std::vector<Transform*>& Transform::GetChangedThisFrame() { return changedThisFrame; }
+
+void Transform::ClearChangedThisFrame()
+{
+    for (Transform* t : changedThisFrame)
+        t->inChangedList = false;
+
+    changedThisFrame.clear();
+}
+
+void Transform::MarkChanged()
+{
+    matriciesDirty = true;
+    version++;
+
+    //only list each transform once per frame
+    if (!inChangedList) {
+        changedThisFrame.push_back(this);
+        inChangedList = true;
+    }
+}
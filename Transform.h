@@ -1,6 +1,7 @@
 #pragma once
 
 #include<DirectXMath.h>
+#include <vector>
 
 class Transform
 {
@@ -9,6 +10,10 @@ public:
 	Transform(float x, float y, float z);
 	~Transform();
 
+	//a copy would share the original's place in the changed list (or think it had one)
+	Transform(const Transform&) = delete;
+	Transform& operator=(const Transform&) = delete;
+
 	// Setters
 	void SetPosition(float x, float y, float z);
 	void SetPosition(DirectX::XMFLOAT3 pos);
@@ -38,7 +43,21 @@ public:
 	DirectX::XMFLOAT4X4 GetWorldMatrix();
 	DirectX::XMFLOAT4X4 GetWorldInverseTransposeMatrix();
 
+	//Fixed-step interpolation
+	void SavePrevious();
+	DirectX::XMFLOAT4X4 GetInterpolatedWorldMatrix(float alpha);
+	DirectX::XMFLOAT4X4 GetInterpolatedWorldInverseTransposeMatrix(float alpha);
+
+	//Change tracking
+	unsigned int GetVersion();
+
+	static const std::vector<Transform*>& GetChangedThisFrame();
+	static void ClearChangedThisFrame();
+
 private:
+	void MarkChanged();
+	void UpdateInterpolatedMatrices(float alpha);
+
 	DirectX::XMFLOAT3 position;
 	DirectX::XMFLOAT3 pitchYawRoll; //rotation
 	//DirectX::XMFLOAT4 quaternion;
@@ -55,5 +74,24 @@ private:
 	bool matriciesDirty;
 	bool vectorsDirty;
 
+	//state as of the previous simulation step
+	DirectX::XMFLOAT3 prevPosition;
+	DirectX::XMFLOAT3 prevPitchYawRoll;
+	DirectX::XMFLOAT3 prevScale;
+	unsigned int prevVersion;
+
+	//last interpolated result, reused while alpha and version hold still
+	DirectX::XMFLOAT4X4 interpWorldMatrix;
+	DirectX::XMFLOAT4X4 interpWorldITMatrix;
+	float interpAlpha;
+	unsigned int interpVersion;
+
+	//bumped on every change so caches can compare against the last version they saw
+	unsigned int version;
+	bool inChangedList;
+
+	//every transform that changed since the last ClearChangedThisFrame()
+	static std::vector<Transform*> changedThisFrame;
+
 };
 
@@ -0,0 +1,65 @@
+#include "TriangleBVH.h"
+#include "Transform.h"
+
+using namespace DirectX;
+
+// --------------------------------------------------------
+// Inserts every triangle's box, then rebuilds top-down so
+// the tree is split evenly (it never changes after this)
+// --------------------------------------------------------
+void TriangleBVH::Build(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices)
+{
+	tree = DynamicBVH(0.0f);
+	corners.clear();
+	corners.reserve(indices.size() - indices.size() % 3);
+
+	for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+		AABB box = EmptyAABB();
+		for (size_t c = 0; c < 3; c++) {
+			corners.push_back(vertices[indices[i + c]].Position);
+			AABBGrow(box, corners.back());
+		}
+		tree.Insert(box, (int)(i / 3));
+	}
+	tree.Rebuild();
+}
+
+bool TriangleBVH::Raycast(const Ray& localRay, float maxT, float* tHit)
+{
+	bool hit = false;
+	tree.Raycast(localRay, maxT, [&](int triangle, float tEntry) {
+		float t;
+		const XMFLOAT3* c = &corners[triangle * 3];
+		if (tEntry <= maxT && RayIntersectsTriangle(localRay, c[0], c[1], c[2], maxT, &t)) {
+			maxT = t;
+			hit = true;
+		}
+		return maxT;
+	});
+
+	if (hit && tHit) *tHit = maxT;
+	return hit;
+}
+
+unsigned int TriangleBVH::GetTriangleCount() { return (unsigned int)corners.size() / 3; }
+
+int TriangleBVH::GetHeight() { return tree.GetHeight(); }
+
+// --------------------------------------------------------
+// The local ray keeps the unnormalized transformed direction
+// so its t values are still world distances
+// --------------------------------------------------------
+bool RaycastTarget(const RayTarget& target, const Ray& ray, float maxT, float* tHit)
+{
+	if (!RayIntersectsAABB(ray, *target.worldBounds, maxT, nullptr))
+		return false;
+
+	XMFLOAT4X4 world = target.transform->GetWorldMatrix();
+	XMMATRIX invWorld = XMMatrixInverse(nullptr, XMLoadFloat4x4(&world));
+
+	Ray localRay;
+	XMStoreFloat3(&localRay.origin, XMVector3TransformCoord(XMLoadFloat3(&ray.origin), invWorld));
+	XMStoreFloat3(&localRay.direction, XMVector3TransformNormal(XMLoadFloat3(&ray.direction), invWorld));
+
+	return target.triangles->Raycast(localRay, maxT, tHit);
+}
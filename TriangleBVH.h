@@ -0,0 +1,79 @@
+#pragma once
+
+//C++
+#include <cfloat>
+#include <vector>
+
+//DirectX
+#include <DirectXMath.h>
+
+//Program
+#include "Vertex.h"
+#include "Bounds.h"
+#include "DynamicBVH.h"
+
+class Transform;
+
+// --------------------------------------------------------
+// A BVH over one mesh's triangles for ray picking.
+//  - Built once from the CPU copy of the geometry (a static
+//    DynamicBVH with no margin, leaves are triangle numbers)
+//  - A ray walks it nearest-first and only tests triangles
+//    whose boxes it passes through before the nearest hit
+//    so far, instead of every triangle in the mesh
+// Plain C++, so it runs without D3D.
+// --------------------------------------------------------
+class TriangleBVH
+{
+public:
+	void Build(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices);
+
+	//Nearest triangle hit along an object-space ray
+	bool Raycast(const Ray& localRay, float maxT, float* tHit);
+
+	//Getters
+	unsigned int GetTriangleCount();
+	int GetHeight();
+
+private:
+	DynamicBVH tree;
+	std::vector<DirectX::XMFLOAT3> corners;	// 3 per triangle, so a test doesn't chase indices into 44 byte vertices
+};
+
+// --------------------------------------------------------
+// What a scene raycast needs to know about one candidate
+// --------------------------------------------------------
+struct RayTarget
+{
+	const AABB* worldBounds;
+	Transform* transform;
+	TriangleBVH* triangles;
+};
+
+//Hit test for one candidate: its world box, then its triangles in object space
+bool RaycastTarget(const RayTarget& target, const Ray& ray, float maxT, float* tHit);
+
+// --------------------------------------------------------
+// Nearest scene object along a world-space ray.  The scene
+// BVH is walked nearest-first and every hit clips the rest
+// of the search.  target(userData) returns the RayTarget
+// for a leaf.  Returns the userData hit, or -1.
+// --------------------------------------------------------
+template<typename Func>
+int RaycastNearest(DynamicBVH& scene, const Ray& ray, float* distance, Func target)
+{
+	int picked = -1;
+	float nearest = FLT_MAX;
+
+	scene.Raycast(ray, FLT_MAX, [&](int userData, float tEntry) {
+		float t;
+		if (tEntry < nearest && RaycastTarget(target(userData), ray, nearest, &t)) {
+			nearest = t;
+			picked = userData;
+		}
+		return nearest;
+	});
+
+	if (distance) *distance = nearest;
+	return picked;
+}
@@ -22,6 +22,40 @@ namespace {
 	ImGuiWindowFlags next_flags = 0;
 }
 
+//The most recent queued value for one part of a transform, or its current value if nothing is queued
+static XMFLOAT3 QueuedValue(const std::vector<TransformEdit>& edits, Transform* transform, int component, XMFLOAT3 current)
+{
+	for (const TransformEdit& edit : edits) {
+		if (edit.transform == transform && edit.component == component)
+			return edit.value;
+	}
+	return current;
+}
+
+//Replaces an edit already queued for the same thing, so a long drag doesn't pile up
+static void QueueEdit(std::vector<TransformEdit>& edits, const TransformEdit& edit)
+{
+	for (TransformEdit& queued : edits) {
+		if (queued.transform == edit.transform && queued.component == edit.component) {
+			queued.value = edit.value;
+			return;
+		}
+	}
+	edits.push_back(edit);
+}
+
+void ApplyTransformEdits(std::vector<TransformEdit>& transformEdits)
+{
+	for (const TransformEdit& edit : transformEdits) {
+		switch (edit.component) {
+		case TRANSFORM_EDIT_POSITION: edit.transform->SetPosition(edit.value); break;
+		case TRANSFORM_EDIT_ROTATION: edit.transform->SetRotation(edit.value); break;
+		case TRANSFORM_EDIT_SCALE: edit.transform->SetScale(edit.value); break;
+		}
+	}
+	transformEdits.clear();
+}
+
 void UIInfo(float deltaTime) {
 
 	// Feed fresh data to ImGui
@@ -41,11 +75,16 @@ void UIInfo(float deltaTime) {
 }
 
 void UIUpdate(float deltaTime,
-	std::shared_ptr<Camera> currentCamera, std::vector<std::shared_ptr<Camera>> cameras,
-	std::vector<std::shared_ptr<Mesh>> meshes,
-	std::vector<std::shared_ptr<Entity>> entities,
-	std::vector<std::shared_ptr<Material>> materials, 
-	std::vector<Light> lights) {
+	Handle<Camera>& currentCamera, SlotMap<Camera>& cameras,
+	SlotMap<Mesh>& meshes,
+	SlotMap<Transform>& transforms,
+	std::vector<RenderableComponent>& entities,
+	SlotMap<Material>& materials,
+	std::vector<Light>& lights,
+	const RenderStats& renderStats,
+	RenderSettings& renderSettings,
+	int& selectedEntity,
+	std::vector<TransformEdit>& transformEdits) {
 
 	ImGuiWindowFlags window_flags = 0;
 
@@ -73,6 +112,32 @@ void UIUpdate(float deltaTime,
 		std::string s_frametime = std::to_string(deltaTime * 1000) + " ms";
 		ImGui::PlotHistogram(s_frametime.c_str(), &af_frametime[0], int(af_frametime.size()), 0, NULL, 0.0f, 1.0f, ImVec2(0.0f, 50.0f), sizeof(float));
 
+		ImGui::Text("Entities: %u total, %u drawn", renderStats.entitiesTotal, renderStats.entitiesVisible);
+		ImGui::Text("Frustum Culled: %u", renderStats.entitiesFrustumCulled);
+		ImGui::Checkbox("Visibility Caching", &renderSettings.visibilityCaching);
+		ImGui::Text("Retested: %u (+%u / -%u)", renderStats.entitiesRetested, renderStats.entitiesEntered, renderStats.entitiesExited);
+		ImGui::Text("Draws: %u (shader %u, material %u, mesh %u changes)", renderStats.drawCalls,
+			renderStats.shaderChanges, renderStats.materialChanges, renderStats.meshChanges);
+		ImGui::Text("Instanced: %u batches, %u entities", renderStats.instancedBatches, renderStats.instancesDrawn);
+		ImGui::Checkbox("Instancing", &renderSettings.instancing);
+		ImGui::Text("State calls: %u issued, %u filtered", renderStats.stateCallsIssued, renderStats.stateCallsFiltered);
+		ImGui::Checkbox("Light Culling", &renderSettings.lightCulling);
+		ImGui::Text("Lights Uploaded: %u", renderStats.lightsUploaded);
+		ImGui::Text("Constant Bytes Uploaded: %u", renderStats.constantBytesUploaded);
+		ImGui::Text("Constant Uploads: %u issued, %u skipped", renderStats.constantUploadsIssued, renderStats.constantUploadsSkipped);
+		ImGui::Checkbox("Constant Ring", &renderSettings.constantRing);
+		ImGui::Text("Constant Ring Used: %u bytes", renderStats.constantRingUsed);
+		ImGui::Checkbox("Parallel Recording", &renderSettings.parallelRecording);
+		ImGui::Text("Command Buffers: %u (%u bytes)", renderStats.commandBuffers, renderStats.commandBytes);
+		ImGui::Checkbox("Debug: Per-Camera Culling", &renderSettings.debugViewCulling);
+		ImGui::Checkbox("Portal Culling", &renderSettings.portalCulling);
+		ImGui::Text("Portal Culled: %u", renderStats.entitiesPortalCulled);
+		ImGui::Checkbox("Contribution Culling", &renderSettings.contributionCulling);
+		ImGui::DragFloat("Min Pixel Radius", &renderSettings.contributionThreshold, 0.1f, 0.0f, 64.0f);
+		ImGui::Text("Contribution Culled: %u", renderStats.entitiesContributionCulled);
+		ImGui::Checkbox("Occlusion Culling", &renderSettings.occlusionCulling);
+		ImGui::Text("Occlusion Culled: %u (%u occluder tris)", renderStats.entitiesOcclusionCulled, renderStats.occluderTriangles);
+
 		ImGui::Checkbox("Demo Window", &demoVisibility);
 		ImGui::Checkbox("Title Bar", &titleBarViz);
 		ImGui::Checkbox("Lock Window", &windowLock);
@@ -81,26 +146,57 @@ void UIUpdate(float deltaTime,
 		next_flags = window_flags;
 	}
 
+	if (ImGui::CollapsingHeader("Memory")) {
+		for (FixedPool* pool : FixedPool::All()) {
+			AllocatorStats stats = pool->GetStats();
+			if (ImGui::TreeNode(pool, "Pool: %s", stats.name)) {
+				ImGui::Text("Block Size: %zu bytes", stats.blockSize);
+				ImGui::Text("Live: %zu (peak %zu)", stats.live, stats.peak);
+				ImGui::Text("Allocs / Frees: %zu / %zu", stats.allocations, stats.frees);
+				ImGui::Text("Used / Reserved: %zu / %zu bytes", stats.bytesUsed, stats.bytesReserved);
+				ImGui::TreePop();
+			}
+		}
+
+		for (Arena* arena : Arena::All()) {
+			AllocatorStats stats = arena->GetStats();
+			if (ImGui::TreeNode(arena, "Arena: %s", stats.name)) {
+				ImGui::Text("Live: %zu (peak %zu)", stats.live, stats.peak);
+				ImGui::Text("Allocs / Resets: %zu / %zu", stats.allocations, stats.frees);
+				ImGui::Text("Used / Reserved: %zu / %zu bytes", stats.bytesUsed, stats.bytesReserved);
+				ImGui::TreePop();
+			}
+		}
+	}
+
 	if (ImGui::CollapsingHeader("Camera")) {
-		for (unsigned int i = 0; i < cameras.size(); i++) {
-			ImGui::PushID(cameras[i].get());
-			std::string camName = "Camera " + std::to_string(i);
+		cameras.Each([&](Handle<Camera> handle, Camera& camera) {
+			ImGui::PushID(&camera);
+			std::string camName = "Camera " + std::to_string(handle.index);
 			if (ImGui::TreeNode(camName.c_str())) {
-				ImGui::Text("Current?: %s", cameras[i] == currentCamera ? "yes" : "no");
+				ImGui::Text("Current?: %s", handle == currentCamera ? "yes" : "no");
+				if (handle.index < renderStats.entitiesVisiblePerView.size())
+					ImGui::Text("Entities in view: %u", renderStats.entitiesVisiblePerView[handle.index]);
 
 				if (ImGui::Button("Make Current?")) {
-					currentCamera = cameras[i];
+					currentCamera = handle;
 				}
 
-				std::shared_ptr<Transform> transform = cameras[i]->GetTransform();
+				Transform* transform = camera.GetTransform().get();
 
 				DF3("Position", transform->GetPosition(), [&](XMFLOAT3 x) { transform->SetPosition(x); });
 				DF3("Rotation", transform->GetRotation(), [&](XMFLOAT3 x) { transform->SetRotation(x); });
 
+				bool perspective = camera.IsPerspective();
+				if (ImGui::Checkbox("Perspective", &perspective)) { camera.SetPerspective(perspective); }
+				if (!perspective) {
+					DF1("View Height", camera.GetOrthographicHeight(), [&](float x) { camera.SetOrthographicHeight(x); });
+				}
+
 				ImGui::TreePop();
 			}
 			ImGui::PopID();
-		}
+		});
 	}
 
 	if (ImGui::CollapsingHeader("Lights")) {
@@ -130,14 +226,32 @@ void UIUpdate(float deltaTime,
 	}
 
 	if (ImGui::CollapsingHeader("Entities")) {
-		for (unsigned int i = 0; i < entities.size(); i++) {
-			ImGui::PushID(entities[i].get());
-			if (ImGui::TreeNode("Entity")) {
-				std::shared_ptr<Transform> transform = entities[i]->GetTransform();
+		if (selectedEntity >= 0) {
+			ImGui::Text("Selected: Entity %d (%s)", selectedEntity, meshes.Get(entities[selectedEntity].mesh)->GetName());
+			ImGui::SameLine();
+			if (ImGui::Button("Clear")) { selectedEntity = -1; }
+		}
+		else {
+			ImGui::Text("Right click an object to select it");
+		}
 
-				DF3("Position", transform->GetPosition(), [&](XMFLOAT3 x) { transform->SetPosition(x); });
-				DF3("Rotation", transform->GetRotation(), [&](XMFLOAT3 x) { transform->SetRotation(x); });
-				DF3("Scale", transform->GetScale(), [&](XMFLOAT3 x) { transform->SetScale(x); });
+		for (unsigned int i = 0; i < entities.size(); i++) {
+			ImGui::PushID(i);
+			ImGuiTreeNodeFlags flags = (int)i == selectedEntity ? ImGuiTreeNodeFlags_Selected : ImGuiTreeNodeFlags_None;
+			if (ImGui::TreeNodeEx("Entity", flags)) {
+				Transform* transform = transforms.Get(entities[i].transform);
+
+				//show queued values so a drag keeps going on frames where no step ran
+				DF3("Position", QueuedValue(transformEdits, transform, TRANSFORM_EDIT_POSITION, transform->GetPosition()),
+					[&](XMFLOAT3 x) { QueueEdit(transformEdits, { transform, TRANSFORM_EDIT_POSITION, x }); });
+				DF3("Rotation", QueuedValue(transformEdits, transform, TRANSFORM_EDIT_ROTATION, transform->GetRotation()),
+					[&](XMFLOAT3 x) { QueueEdit(transformEdits, { transform, TRANSFORM_EDIT_ROTATION, x }); });
+				DF3("Scale", QueuedValue(transformEdits, transform, TRANSFORM_EDIT_SCALE, transform->GetScale()),
+					[&](XMFLOAT3 x) { QueueEdit(transformEdits, { transform, TRANSFORM_EDIT_SCALE, x }); });
+
+				//flag changes bump the state version so cached visibility gets retested
+				if (ImGui::Checkbox("Occluder", &entities[i].occluder)) { entities[i].stateVersion++; }
+				if (ImGui::Checkbox("Important", &entities[i].important)) { entities[i].stateVersion++; }
 
 				ImGui::TreePop();
 			}
@@ -147,17 +261,17 @@ void UIUpdate(float deltaTime,
 
 	if (ImGui::CollapsingHeader("Materials")) {
 
-		for (unsigned int i = 0; i < materials.size(); i++) {
-			ImGui::PushID(materials[i].get());
-			if (ImGui::TreeNode(materials[i]->GetName())) {
+		materials.Each([&](Handle<Material>, Material& material) {
+			ImGui::PushID(&material);
+			if (ImGui::TreeNode(material.GetName())) {
 
-				#define GETCOLORTINT materials[i]->GetColorTint()
-				DF3("Tint", XMFLOAT3(GETCOLORTINT.x, GETCOLORTINT.y, GETCOLORTINT.z), [&](XMFLOAT3 x) { materials[i]->SetColorTint3(x); });
-				DF2("Scale", materials[i]->GetUvScale(), [&](XMFLOAT2 x) { materials[i]->SetUvScale(x); });
-				DF2("Offset", materials[i]->GetUvOffset(), [&](XMFLOAT2 x) { materials[i]->SetUvOffset(x); });
-				DF1("Roughness", materials[i]->GetRoughness(), [&](float x) { materials[i]->SetRoughness(x); });
+				#define GETCOLORTINT material.GetColorTint()
+				DF3("Tint", XMFLOAT3(GETCOLORTINT.x, GETCOLORTINT.y, GETCOLORTINT.z), [&](XMFLOAT3 x) { material.SetColorTint3(x); });
+				DF2("Scale", material.GetUvScale(), [&](XMFLOAT2 x) { material.SetUvScale(x); });
+				DF2("Offset", material.GetUvOffset(), [&](XMFLOAT2 x) { material.SetUvOffset(x); });
+				DF1("Roughness", material.GetRoughness(), [&](float x) { material.SetRoughness(x); });
 
-				for (auto& [name, ptr] : materials[i]->GetTextureSRVMap()) {
+				for (auto& [name, ptr] : material.GetTextureSRVMap()) {
 					ImGui::Text(name.c_str());
 					ImGui::Image((ImTextureID)(intptr_t)ptr.Get(), ImVec2(256, 256));
 				}
@@ -166,19 +280,19 @@ void UIUpdate(float deltaTime,
 				ImGui::TreePop();
 			}
 			ImGui::PopID();
-		}
+		});
 	}
 
 	if (ImGui::CollapsingHeader("Meshes")) {
-		for (unsigned int i = 0; i < meshes.size(); i++) {
-			if (ImGui::TreeNode(meshes[i]->GetName())) {
-				ImGui::Text("Tris: %d", (meshes[i]->GetIndexCount() / 3));
-				ImGui::Text("Verts: %d", (meshes[i]->GetVertexCount()));
-				ImGui::Text("Indicies: %d", (meshes[i]->GetIndexCount()));
+		meshes.Each([&](Handle<Mesh>, Mesh& mesh) {
+			if (ImGui::TreeNode(mesh.GetName())) {
+				ImGui::Text("Tris: %d", (mesh.GetIndexCount() / 3));
+				ImGui::Text("Verts: %d", (mesh.GetVertexCount()));
+				ImGui::Text("Indicies: %d", (mesh.GetIndexCount()));
 
 				ImGui::TreePop();
 			}
-		}
+		});
 	}
 
 	if (demoVisibility)
@@ -12,7 +12,7 @@
 #include "Material.h"
 #include "Mesh.h"
 #include "Transform.h"
-#include "Entity.h"
+#include "Components.h"
 #include "Graphics.h"
 #include "Vertex.h"
 #include "Input.h"
@@ -21,6 +21,9 @@
 #include "Lights.h"
 #include "Sky.h"
 #include "UI.h"
+#include "SlotMap.h"
+#include "Allocators.h"
+#include "RenderStats.h"
 
 //DirectX
 #include <d3d11.h>
@@ -32,14 +35,38 @@
 #include "ImGui/imgui_impl_dx11.h"
 #include "ImGui/imgui_impl_win32.h"
 
+// --------------------------------------------------------
+// A change to an entity transform made in the UI.  These
+// are queued instead of applied so that, like any other
+// movement, they land on the next simulation step.
+// --------------------------------------------------------
+#define TRANSFORM_EDIT_POSITION 0
+#define TRANSFORM_EDIT_ROTATION 1
+#define TRANSFORM_EDIT_SCALE 2
+
+struct TransformEdit
+{
+	Transform* transform;
+	int component;		// TRANSFORM_EDIT_*
+	DirectX::XMFLOAT3 value;
+};
+
 void UIInfo(float deltatime);
 void UIUpdate(float deltatime,
-	std::shared_ptr<Camera> currentCamera, 
-	std::vector<std::shared_ptr<Camera>> cameras,
-	std::vector<std::shared_ptr<Mesh>> meshes,
-	std::vector<std::shared_ptr<Entity>> entities,
-	std::vector<std::shared_ptr<Material>> materials, 
-	std::vector<Light> lights);
+	Handle<Camera>& currentCamera, 
+	SlotMap<Camera>& cameras,
+	SlotMap<Mesh>& meshes,
+	SlotMap<Transform>& transforms,
+	std::vector<RenderableComponent>& entities,
+	SlotMap<Material>& materials,
+	std::vector<Light>& lights,
+	const RenderStats& renderStats,
+	RenderSettings& renderSettings,
+	int& selectedEntity,
+	std::vector<TransformEdit>& transformEdits);
+
+//Applies (then clears) queued edits - call from the fixed step
+void ApplyTransformEdits(std::vector<TransformEdit>& transformEdits);
 
 void DF1(const char* name, float startValue, std::function<void(float)> endLocation);
 void DF2(const char* name, DirectX::XMFLOAT2 startValue, std::function<void(DirectX::XMFLOAT2)> endLocation);
@@ -0,0 +1,20 @@
+#include "UploadTracker.h"
+
+//C++
+#include <cstring>
+
+bool UploadTracker::Write(unsigned char* dest, const void* data, unsigned int size)
+{
+	if (memcmp(dest, data, size) == 0)
+		return false;
+
+	memcpy(dest, data, size);
+	dirty = true;
+	return true;
+}
+
+void UploadTracker::MarkDirty() { dirty = true; }
+
+void UploadTracker::MarkUploaded() { dirty = false; }
+
+bool UploadTracker::NeedsUpload() const { return dirty; }
@@ -0,0 +1,25 @@
+#pragma once
+
+// --------------------------------------------------------
+// Tracks whether a CPU-side copy of a buffer still matches
+// what was last uploaded from it.  Writes only mark it
+// dirty when they change bytes, and a new tracker starts
+// dirty so the first upload always goes through.
+// --------------------------------------------------------
+class UploadTracker
+{
+public:
+	//Copies size bytes of data to dest if they differ from what's there; returns true if they did
+	bool Write(unsigned char* dest, const void* data, unsigned int size);
+
+	//Forces the next upload (e.g. after the buffer is recreated)
+	void MarkDirty();
+
+	//Call after uploading the local copy
+	void MarkUploaded();
+
+	bool NeedsUpload() const;
+
+private:
+	bool dirty = true;
+};
@@ -1,13 +1,19 @@
 #include "ShaderIncludes.hlsli"
 
-cbuffer vsConstantBuffer : register(b0)
+// Uploaded once per frame
+cbuffer perFrame : register(b0)
 {
-    matrix world;
-    matrix worldInvTranspose;
     matrix view;
     matrix proj;
 }
 
+// Uploaded for every draw
+cbuffer perObject : register(b1)
+{
+    matrix world;
+    matrix worldInvTranspose;
+}
+
 // --------------------------------------------------------
 // The entry point (main method) for our vertex shader
 // 
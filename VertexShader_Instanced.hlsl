@@ -0,0 +1,50 @@
+#include "ShaderIncludes.hlsli"
+
+// Uploaded once per frame (world matrices come per instance)
+cbuffer perFrame : register(b0)
+{
+    matrix view;
+    matrix proj;
+}
+
+// --------------------------------------------------------
+// Regular vertex data plus one set of matrices per instance
+//  - Anything ending in _PER_INSTANCE is read from input
+//    slot 1 by SimpleVertexShader's input layout
+//  - Each matrix arrives as the four rows of the CPU-side
+//    XMFLOAT4X4, so it's transposed to match the cbuffer
+//    matrices the regular vertex shader uses
+// --------------------------------------------------------
+struct VertexShaderInstancedInput
+{
+    float3 localPosition    : POSITION;
+    float2 uv               : TEXCOORD;
+    float3 normal           : NORMAL;
+    float3 tangent          : TANGENT;
+
+    float4 world0           : WORLD_PER_INSTANCE0;
+    float4 world1           : WORLD_PER_INSTANCE1;
+    float4 world2           : WORLD_PER_INSTANCE2;
+    float4 world3           : WORLD_PER_INSTANCE3;
+    float4 worldInvT0       : WORLDINVT_PER_INSTANCE0;
+    float4 worldInvT1       : WORLDINVT_PER_INSTANCE1;
+    float4 worldInvT2       : WORLDINVT_PER_INSTANCE2;
+    float4 worldInvT3       : WORLDINVT_PER_INSTANCE3;
+};
+
+VertexToPixel main(VertexShaderInstancedInput input)
+{
+    VertexToPixel output;
+
+    matrix world = transpose(float4x4(input.world0, input.world1, input.world2, input.world3));
+    matrix worldInvTranspose = transpose(float4x4(input.worldInvT0, input.worldInvT1, input.worldInvT2, input.worldInvT3));
+
+    matrix wvp = mul(mul(proj, view), world);
+    output.screenPosition = mul(wvp, float4(input.localPosition, 1.0f));
+    output.uv = input.uv;
+    output.normal = mul((float3x3) worldInvTranspose, input.normal);
+    output.tangent = mul((float3x3) worldInvTranspose, input.tangent);
+    output.worldPosition = mul(world, float4(input.localPosition, 1.0f)).xyz;
+
+    return output;
+}
@@ -0,0 +1,137 @@
+#include "VisibilityCache.h"
+
+//C++
+#include <cstring>
+#include <cmath>
+
+using namespace DirectX;
+
+VisibilityCache::VisibilityCache(float moveThreshold, float turnThreshold) :
+	hasCamera(false),
+	cameraView(),
+	cameraProjection(),
+	moveThreshold(moveThreshold),
+	turnThreshold(turnThreshold),
+	tested(0),
+	epoch(1)
+{
+}
+
+// --------------------------------------------------------
+// Compares the view against the one the cache was built
+// with.  Columns 0-2 of a view matrix are the camera's
+// right, up and forward axes, so any turn or roll past the
+// threshold shows up in one of them; the translation row is
+// the eye in view space and moves at least as far as the
+// eye does.  Anything over the thresholds, or any change to
+// the projection, starts over from this view.
+// --------------------------------------------------------
+bool VisibilityCache::BeginFrame(const DirectX::XMFLOAT4X4& view, const DirectX::XMFLOAT4X4& projection, unsigned int entityCount)
+{
+	entered.clear();
+	exited.clear();
+	tested = 0;
+
+	if (entries.size() != entityCount) {
+		entries.resize(entityCount, { 0, 0, 0, false, false, false });
+		std::erase_if(stored, [entityCount](unsigned int i) { return i >= entityCount; });
+	}
+
+	bool stale = !hasCamera || memcmp(&projection, &cameraProjection, sizeof(XMFLOAT4X4)) != 0;
+	for (int axis = 0; axis < 3 && !stale; axis++) {
+		float dot = view.m[0][axis] * cameraView.m[0][axis] + view.m[1][axis] * cameraView.m[1][axis] + view.m[2][axis] * cameraView.m[2][axis];
+		stale = 1.0f - dot > turnThreshold;
+	}
+	if (!stale) {
+		float dx = view._41 - cameraView._41;
+		float dy = view._42 - cameraView._42;
+		float dz = view._43 - cameraView._43;
+		stale = dx * dx + dy * dy + dz * dz > moveThreshold * moveThreshold;
+	}
+
+	if (stale) {
+		hasCamera = true;
+		cameraView = view;
+		cameraProjection = projection;
+		Invalidate();
+	}
+
+	return stale;
+}
+
+// --------------------------------------------------------
+// Forces every entity to be retested (the last reported
+// visibility is kept so deltas still come out right).
+// Entries are only valid for the epoch they were stored
+// in, so this doesn't need to walk them.
+// --------------------------------------------------------
+void VisibilityCache::Invalidate()
+{
+	epoch++;
+}
+
+// --------------------------------------------------------
+// An entry's visibility only changes when it's stored, so
+// only those stored since the last call are diffed
+// --------------------------------------------------------
+void VisibilityCache::EndFrame()
+{
+	for (unsigned int i : stored) {
+		Entry& entry = entries[i];
+		entry.stored = false;
+		if (entry.visible == entry.reported)
+			continue;
+
+		if (entry.visible)
+			entered.push_back(i);
+		else
+			exited.push_back(i);
+		entry.reported = entry.visible;
+	}
+	stored.clear();
+}
+
+void VisibilityCache::Store(unsigned int entity, unsigned int version, unsigned int stateVersion, bool visible)
+{
+	Entry& entry = entries[entity];
+	if (IsStale(entity, version, stateVersion))
+		tested++;
+
+	if (!entry.stored) {
+		entry.stored = true;
+		stored.push_back(entity);
+	}
+
+	entry.version = version;
+	entry.stateVersion = stateVersion;
+	entry.epoch = epoch;
+	entry.visible = visible;
+}
+
+// --------------------------------------------------------
+// A move of up to moveThreshold shifts every plane by at
+// most that much; a turn of up to acos(1 - turnThreshold)
+// swings a plane by at most sin(angle) per unit of
+// distance, out to the far plane
+// --------------------------------------------------------
+float VisibilityCache::GetFrustumSlack(float farClip)
+{
+	float sinTurn = sqrtf(turnThreshold * (2.0f - turnThreshold));
+	return moveThreshold + farClip * sinTurn;
+}
+
+const std::vector<unsigned int>& VisibilityCache::GetEntered() { return entered; }
+
+const std::vector<unsigned int>& VisibilityCache::GetExited() { return exited; }
+
+unsigned int VisibilityCache::GetTestedCount() { return tested; }
+
+unsigned int VisibilityCache::GetReusedCount() { return (unsigned int)entries.size() - tested; }
+
+float VisibilityCache::GetMoveThreshold() { return moveThreshold; }
+
+float VisibilityCache::GetTurnThreshold() { return turnThreshold; }
+
+void VisibilityCache::SetMoveThreshold(float moveThreshold) { this->moveThreshold = moveThreshold; }
+
+void VisibilityCache::SetTurnThreshold(float turnThreshold) { this->turnThreshold = turnThreshold; }
@@ -0,0 +1,86 @@
+#pragma once
+
+//C++
+#include <vector>
+
+//DirectX
+#include <DirectXMath.h>
+
+// --------------------------------------------------------
+// Remembers each entity's last visibility result alongside
+// the transform and entity state versions and the camera
+// view that produced it.
+//  - While the view stays within the move/turn thresholds
+//    only entities whose transform or state changed need
+//    retesting; results should be computed against a
+//    frustum grown by GetFrustumSlack() so they hold for
+//    any view within the thresholds
+//  - EndFrame() diffs against the previous frame so other
+//    systems can react to entities entering/leaving view;
+//    only entities stored this frame can have changed, so
+//    it never walks the whole cache
+// --------------------------------------------------------
+class VisibilityCache
+{
+public:
+	VisibilityCache(float moveThreshold = 0.01f, float turnThreshold = 0.00001f);
+
+	//Returns true if every cached result is stale (view moved, turned or rolled, projection changed or resized)
+	bool BeginFrame(const DirectX::XMFLOAT4X4& view, const DirectX::XMFLOAT4X4& projection, unsigned int entityCount);
+	void Invalidate();
+	void EndFrame();
+
+	//Per entity (the checks are here so the walk over every entity inlines them)
+	bool IsStale(unsigned int entity, unsigned int version, unsigned int stateVersion)
+	{
+		const Entry& entry = entries[entity];
+		return entry.epoch != epoch || entry.version != version || entry.stateVersion != stateVersion;
+	}
+	//true if the entity's flags or material changed since its result was stored (valid or not)
+	bool IsStateStale(unsigned int entity, unsigned int stateVersion) { return entries[entity].stateVersion != stateVersion; }
+	bool IsVisible(unsigned int entity) { return entries[entity].visible; }
+	void Store(unsigned int entity, unsigned int version, unsigned int stateVersion, bool visible);
+
+	//How far to push the frustum planes out so a result holds for every view within the thresholds
+	float GetFrustumSlack(float farClip);
+
+	//Visible set changes from the last EndFrame()
+	const std::vector<unsigned int>& GetEntered();
+	const std::vector<unsigned int>& GetExited();
+
+	//Getters
+	unsigned int GetTestedCount();
+	unsigned int GetReusedCount();
+	float GetMoveThreshold();
+	float GetTurnThreshold();
+
+	//Setters
+	void SetMoveThreshold(float moveThreshold);
+	void SetTurnThreshold(float turnThreshold);
+
+private:
+	struct Entry
+	{
+		unsigned int version;		// Transform version
+		unsigned int stateVersion;	// Entity flags and material
+		unsigned int epoch;			// Valid while it matches the cache's epoch
+		bool visible;
+		bool reported;	// Visibility as of the last EndFrame()
+		bool stored;	// Stored since the last EndFrame()
+	};
+
+	std::vector<Entry> entries;
+	std::vector<unsigned int> stored;
+	std::vector<unsigned int> entered;
+	std::vector<unsigned int> exited;
+
+	//camera state the cached results were computed with
+	bool hasCamera;
+	DirectX::XMFLOAT4X4 cameraView;
+	DirectX::XMFLOAT4X4 cameraProjection;
+
+	float moveThreshold;
+	float turnThreshold;	// Allowed 1 - dot(axis, cachedAxis) for each of the view's axes
+	unsigned int tested;
+	unsigned int epoch;	// Bumped by Invalidate() instead of touching every entry
+};